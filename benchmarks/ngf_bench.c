@@ -0,0 +1,758 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Microbenchmarks for nicegraf's internal data structures and command
+// recording. Each benchmark runs with a growing number of operations until it
+// takes long enough to time reliably, then reports the time and the number of
+// host allocations per operation.
+// Usage: ngf_bench [--filter substring] [--min-time-ms ms] [--json path]
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "nicegraf.h"
+#include "nicegraf_util.h"
+#include "nicegraf_internal.h"
+#include "dynamic_array.h"
+#include "metadata_parser.h"
+#include "stack_alloc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(NGF_BENCH_BACKEND)
+#define NGF_BENCH_BACKEND "unknown"
+#endif
+
+#define NGF_BENCH_MAX_RESULTS 64u
+
+typedef struct {
+  uint64_t nops;         // Number of operations to run.
+  uint64_t start_ns;
+  uint64_t elapsed_ns;
+  uint64_t start_allocs;
+  uint64_t allocs;       // Host allocations made while timing.
+  bool     skipped;      // Set by benchmarks that can't run in this setup.
+} bench;
+
+typedef void (*bench_fn)(bench *b, void *userdata);
+
+typedef struct {
+  const char *name;
+  uint64_t    nops;
+  double      ns_per_op;
+  double      allocs_per_op;
+} bench_result;
+
+static bench_result RESULTS[NGF_BENCH_MAX_RESULTS];
+static uint32_t     NRESULTS = 0u;
+static const char  *FILTER = NULL;
+static uint64_t     MIN_TIME_NS = 200000000u;
+
+// Metadata parser allocations don't go through nicegraf's callbacks, so
+// they're counted separately.
+static uint64_t PLMD_ALLOCS = 0u;
+
+// Keeps the compiler from optimizing away results the benchmarks don't use.
+static volatile uintptr_t SINK = 0u;
+
+static uint64_t bench_allocs() {
+  ngf_allocation_stats stats;
+  ngf_get_allocation_stats(&stats);
+  return stats.total.total_allocations + PLMD_ALLOCS;
+}
+
+static void bench_start(bench *b) {
+  b->start_allocs = bench_allocs();
+  b->start_ns = _ngf_stats_now_ns();
+}
+
+static void bench_stop(bench *b) {
+  b->elapsed_ns = _ngf_stats_now_ns() - b->start_ns;
+  b->allocs = bench_allocs() - b->start_allocs;
+}
+
+static bool bench_selected(const char *name) {
+  return FILTER == NULL || strstr(name, FILTER) != NULL;
+}
+
+static void run_bench(const char *name, bench_fn fn, void *userdata) {
+  if (!bench_selected(name)) return;
+  bench b;
+  memset(&b, 0, sizeof(b));
+  b.nops = 1u;
+  for (;;) {
+    fn(&b, userdata);
+    if (b.skipped) {
+      printf("%-28s skipped\n", name);
+      return;
+    }
+    if (b.elapsed_ns >= MIN_TIME_NS || b.nops >= (1ull << 40u)) break;
+    // Aim a bit past the minimum time, growing at least 2x and at most 100x
+    // per round.
+    const double elapsed = b.elapsed_ns > 0u ? (double)b.elapsed_ns : 1.0;
+    double scale = 1.2 * (double)MIN_TIME_NS / elapsed;
+    scale = scale < 2.0 ? 2.0 : (scale > 100.0 ? 100.0 : scale);
+    b.nops = (uint64_t)((double)b.nops * scale);
+  }
+  bench_result *r = &RESULTS[NRESULTS++];
+  r->name = name;
+  r->nops = b.nops;
+  r->ns_per_op = (double)b.elapsed_ns / (double)b.nops;
+  r->allocs_per_op = (double)b.allocs / (double)b.nops;
+  printf("%-28s %12llu ops %10.2f ns/op %10.4f allocs/op\n", name,
+         (unsigned long long)r->nops, r->ns_per_op, r->allocs_per_op);
+}
+
+static bool write_json(const char *path) {
+  FILE *out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+  if (out == NULL) return false;
+  fprintf(out, "{\n  \"backend\": \"%s\",\n  \"benchmarks\": [",
+          NGF_BENCH_BACKEND);
+  for (uint32_t i = 0u; i < NRESULTS; ++i) {
+    const bench_result *r = &RESULTS[i];
+    fprintf(out,
+            "%s\n    {\"name\": \"%s\", \"iterations\": %llu, "
+            "\"ns_per_op\": %.3f, \"allocs_per_op\": %.6f}",
+            i > 0u ? "," : "", r->name, (unsigned long long)r->nops,
+            r->ns_per_op, r->allocs_per_op);
+  }
+  fprintf(out, "\n  ]\n}\n");
+  return out == stdout || fclose(out) == 0;
+}
+
+// xorshift, to keep "random" patterns identical across runs.
+static uint32_t next_rand(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13u;
+  x ^= x >> 17u;
+  x ^= x << 5u;
+  return *state = x;
+}
+
+#pragma region block_allocator
+
+#define BLK_SIZE  64u
+#define BLK_BATCH 64u
+
+typedef enum {
+  BLK_LIFO,
+  BLK_FIFO,
+  BLK_RANDOM
+} blk_pattern;
+
+// One op is one allocation plus one free.
+static void bench_blkalloc(bench *b, void *userdata) {
+  const blk_pattern pattern = *(const blk_pattern*)userdata;
+  _ngf_block_allocator *alloc = _ngf_blkalloc_create(BLK_SIZE, 100u);
+  void *live[BLK_BATCH] = {NULL};
+  uint32_t rand_state = 0x9e3779b9u;
+  bench_start(b);
+  if (pattern == BLK_RANDOM) {
+    // Toggle random slots, so that frees come in no particular order.
+    // Every slot is freed at the end, so allocs and frees balance.
+    for (uint64_t i = 0u; i < b->nops * 2u; ++i) {
+      void **slot = &live[next_rand(&rand_state) % BLK_BATCH];
+      if (*slot == NULL) {
+        *slot = _ngf_blkalloc_alloc(alloc);
+      } else {
+        _ngf_blkalloc_free(alloc, *slot);
+        *slot = NULL;
+      }
+    }
+    for (uint32_t s = 0u; s < BLK_BATCH; ++s) {
+      _ngf_blkalloc_free(alloc, live[s]);
+    }
+  } else {
+    for (uint64_t i = 0u; i < b->nops; i += BLK_BATCH) {
+      const uint32_t n = (uint32_t)NGF_MIN(b->nops - i, BLK_BATCH);
+      for (uint32_t j = 0u; j < n; ++j) live[j] = _ngf_blkalloc_alloc(alloc);
+      for (uint32_t j = 0u; j < n; ++j) {
+        _ngf_blkalloc_free(alloc, live[pattern == BLK_LIFO ? n - j - 1u : j]);
+      }
+    }
+  }
+  bench_stop(b);
+  _ngf_blkalloc_destroy(alloc);
+}
+
+// Block allocators are per-thread, so a block can't be freed on another
+// thread. Instead, batches of blocks are handed to a worker that writes them
+// and hands them back to the owner to free, as happens with command blocks
+// recorded on one thread and retired on another.
+typedef enum {
+  HANDOFF_EMPTY,
+  HANDOFF_FILLED,
+  HANDOFF_DONE
+} handoff_state;
+
+typedef struct {
+  pthread_mutex_t mut;
+  pthread_cond_t  cond;
+  handoff_state   state;
+  uint32_t        nblocks;
+  void           *blocks[BLK_BATCH];
+} handoff;
+
+#if defined(_WIN32) || defined(_WIN64)
+static DWORD WINAPI handoff_worker(LPVOID userdata) {
+#else
+static void* handoff_worker(void *userdata) {
+#endif
+  handoff *h = (handoff*)userdata;
+  pthread_mutex_lock(&h->mut);
+  for (;;) {
+    while (h->state == HANDOFF_EMPTY) pthread_cond_wait(&h->cond, &h->mut);
+    if (h->state == HANDOFF_DONE) break;
+    for (uint32_t i = 0u; i < h->nblocks; ++i) {
+      memset(h->blocks[i], (int)i, BLK_SIZE);
+    }
+    h->state = HANDOFF_EMPTY;
+    pthread_cond_signal(&h->cond);
+  }
+  pthread_mutex_unlock(&h->mut);
+  return 0;
+}
+
+static void bench_blkalloc_cross_thread(bench *b, void *userdata) {
+  _NGF_FAKE_USE(userdata);
+  handoff h;
+  memset(&h, 0, sizeof(h));
+  pthread_mutex_init(&h.mut, NULL);
+  pthread_cond_init(&h.cond, NULL);
+#if defined(_WIN32) || defined(_WIN64)
+  HANDLE worker = CreateThread(NULL, 0u, handoff_worker, &h, 0u, NULL);
+#else
+  pthread_t worker;
+  pthread_create(&worker, NULL, handoff_worker, &h);
+#endif
+  _ngf_block_allocator *alloc = _ngf_blkalloc_create(BLK_SIZE, 100u);
+
+  bench_start(b);
+  for (uint64_t i = 0u; i < b->nops; i += BLK_BATCH) {
+    const uint32_t n = (uint32_t)NGF_MIN(b->nops - i, BLK_BATCH);
+    pthread_mutex_lock(&h.mut);
+    for (uint32_t j = 0u; j < n; ++j) h.blocks[j] = _ngf_blkalloc_alloc(alloc);
+    h.nblocks = n;
+    h.state = HANDOFF_FILLED;
+    pthread_cond_signal(&h.cond);
+    while (h.state != HANDOFF_EMPTY) pthread_cond_wait(&h.cond, &h.mut);
+    for (uint32_t j = 0u; j < n; ++j) _ngf_blkalloc_free(alloc, h.blocks[j]);
+    pthread_mutex_unlock(&h.mut);
+  }
+  bench_stop(b);
+
+  pthread_mutex_lock(&h.mut);
+  h.state = HANDOFF_DONE;
+  pthread_cond_signal(&h.cond);
+  pthread_mutex_unlock(&h.mut);
+#if defined(_WIN32) || defined(_WIN64)
+  WaitForSingleObject(worker, INFINITE);
+  CloseHandle(worker);
+#else
+  pthread_join(worker, NULL);
+#endif
+  _ngf_blkalloc_destroy(alloc);
+  pthread_cond_destroy(&h.cond);
+  pthread_mutex_destroy(&h.mut);
+}
+
+#pragma endregion
+
+#pragma region stack_allocator
+
+// One op is one allocation of the given size. The allocator is reset
+// whenever it runs out, like temp storage at the start of a frame.
+static void bench_stack_alloc(bench *b, void *userdata) {
+  const size_t size = *(const size_t*)userdata;
+  _ngf_sa *sa = _ngf_sa_create(1024u * 1024u);
+  bench_start(b);
+  for (uint64_t i = 0u; i < b->nops; ++i) {
+    uint8_t *ptr = (uint8_t*)_ngf_sa_alloc(sa, size);
+    if (ptr == NULL) {
+      _ngf_sa_reset(sa);
+      ptr = (uint8_t*)_ngf_sa_alloc(sa, size);
+    }
+    ptr[0] = (uint8_t)i;
+  }
+  bench_stop(b);
+  _ngf_sa_destroy(sa);
+}
+
+#pragma endregion
+
+#pragma region dynamic_array
+
+#define DARRAY_LENGTH 65536u
+
+// One op is one append. Arrays are filled up to DARRAY_LENGTH elements,
+// starting either from a capacity of 1, which measures growth, or from their
+// full length, which doesn't grow at all.
+static void bench_darray_append(bench *b, void *userdata) {
+  const bool presized = *(const bool*)userdata;
+  _NGF_DARRAY_OF(uint64_t) arr;
+  bench_start(b);
+  for (uint64_t i = 0u; i < b->nops; i += DARRAY_LENGTH) {
+    const uint32_t n = (uint32_t)NGF_MIN(b->nops - i, DARRAY_LENGTH);
+    _NGF_DARRAY_RESET(arr, presized ? n : 1u);
+    for (uint32_t j = 0u; j < n; ++j) _NGF_DARRAY_APPEND(arr, j);
+    SINK = (uintptr_t)_NGF_DARRAY_AT(arr, n - 1u);
+    _NGF_DARRAY_DESTROY(arr);
+  }
+  bench_stop(b);
+}
+
+#pragma endregion
+
+#pragma region binding_map
+
+// A layout in the style of a typical renderer: per-frame, per-material and
+// per-draw sets.
+static const ngf_descriptor_info FRAME_DESCRIPTORS[] = {
+  {NGF_DESCRIPTOR_UNIFORM_BUFFER, 0u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT},
+  {NGF_DESCRIPTOR_UNIFORM_BUFFER, 1u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER, 2u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+};
+static const ngf_descriptor_info MATERIAL_DESCRIPTORS[] = {
+  {NGF_DESCRIPTOR_UNIFORM_BUFFER, 0u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_TEXTURE, 1u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_TEXTURE, 2u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_TEXTURE, 3u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_TEXTURE, 4u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_SAMPLER, 5u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+  {NGF_DESCRIPTOR_SAMPLER, 6u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT},
+};
+static const ngf_descriptor_info DRAW_DESCRIPTORS[] = {
+  {NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC, 0u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT},
+  {NGF_DESCRIPTOR_STORAGE_BUFFER, 1u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT},
+};
+
+// One op is one lookup.
+static void bench_binding_map_lookup(bench *b, void *userdata) {
+  _NGF_FAKE_USE(userdata);
+  ngf_descriptor_set_layout_info sets[] = {
+    {FRAME_DESCRIPTORS, NGF_ARRAYSIZE(FRAME_DESCRIPTORS)},
+    {MATERIAL_DESCRIPTORS, NGF_ARRAYSIZE(MATERIAL_DESCRIPTORS)},
+    {DRAW_DESCRIPTORS, NGF_ARRAYSIZE(DRAW_DESCRIPTORS)},
+  };
+  const ngf_pipeline_layout_info layout = {
+    NGF_ARRAYSIZE(sets), sets, 0u, 0u
+  };
+  _ngf_native_binding_map map = NULL;
+  if (_ngf_create_native_binding_map(&layout, NULL, NULL, &map) !=
+      NGF_ERROR_OK) {
+    b->skipped = true;
+    return;
+  }
+  // Look up bindings in a random order, like binds from unrelated draws.
+  uint32_t queries[256][2];
+  uint32_t rand_state = 0x2545f491u;
+  for (uint32_t q = 0u; q < NGF_ARRAYSIZE(queries); ++q) {
+    const uint32_t set = next_rand(&rand_state) % NGF_ARRAYSIZE(sets);
+    queries[q][0] = set;
+    queries[q][1] = next_rand(&rand_state) % sets[set].ndescriptors;
+  }
+  uintptr_t acc = 0u;
+  bench_start(b);
+  for (uint64_t i = 0u; i < b->nops; ++i) {
+    const uint32_t *q = queries[i % NGF_ARRAYSIZE(queries)];
+    acc += (uintptr_t)_ngf_binding_map_lookup(map, q[0], q[1]);
+  }
+  bench_stop(b);
+  SINK = acc;
+  _ngf_destroy_binding_map(map);
+}
+
+#pragma endregion
+
+#pragma region metadata_parser
+
+typedef struct {
+  uint32_t *words;
+  uint32_t  nwords;
+  uint32_t  capacity;
+} plmd_builder;
+
+static void plmd_push(plmd_builder *pb, uint32_t v) {
+  assert(pb->nwords < pb->capacity);
+  // Metadata files are in network byte order.
+  uint8_t *bytes = (uint8_t*)&pb->words[pb->nwords++];
+  bytes[0] = (uint8_t)(v >> 24u);
+  bytes[1] = (uint8_t)(v >> 16u);
+  bytes[2] = (uint8_t)(v >> 8u);
+  bytes[3] = (uint8_t)v;
+}
+
+static void plmd_push_string(plmd_builder *pb, const char *str) {
+  const uint32_t len = (uint32_t)strlen(str);
+  const uint32_t nwords = len / 4u + 1u;
+  plmd_push(pb, 0xffffffff);
+  plmd_push(pb, nwords);
+  assert(pb->nwords + nwords <= pb->capacity);
+  memset(&pb->words[pb->nwords], 0, nwords * 4u);
+  memcpy(&pb->words[pb->nwords], str, len);
+  pb->nwords += nwords;
+}
+
+// Builds metadata for a pipeline with 4 sets of 8 descriptors each and a few
+// combined image/sampler entries, which is on the larger side of what the
+// shader pipeline tool emits.
+static void plmd_build(plmd_builder *pb) {
+  const uint32_t nsets = 4u, ndescriptors = 8u, ncis_entries = 4u;
+  pb->nwords = 0u;
+  for (uint32_t i = 0u; i < 8u; ++i) plmd_push(pb, 0u);
+  const uint32_t layout_offset = pb->nwords * 4u;
+  plmd_push(pb, nsets);
+  for (uint32_t s = 0u; s < nsets; ++s) {
+    plmd_push(pb, ndescriptors);
+    for (uint32_t d = 0u; d < ndescriptors; ++d) {
+      plmd_push(pb, d);
+      plmd_push(pb, d % 6u);
+      plmd_push(pb, 0x3u);
+    }
+  }
+  uint32_t cis_offsets[2];
+  for (uint32_t m = 0u; m < 2u; ++m) {
+    cis_offsets[m] = pb->nwords * 4u;
+    plmd_push(pb, ncis_entries);
+    for (uint32_t e = 0u; e < ncis_entries; ++e) {
+      plmd_push(pb, m);
+      plmd_push(pb, e);
+      plmd_push(pb, e + 1u);
+      for (uint32_t c = 0u; c <= e; ++c) plmd_push(pb, 100u * m + c);
+    }
+  }
+  const uint32_t user_offset = pb->nwords * 4u;
+  plmd_push(pb, 2u);
+  plmd_push_string(pb, "entry_point");
+  plmd_push_string(pb, "VSMain");
+  plmd_push_string(pb, "primitive_topology");
+  plmd_push_string(pb, "triangle_list");
+
+  const uint32_t header[] = {
+    0xdeadbeef, 8u * 4u, 0u, 1u,
+    layout_offset, cis_offsets[0], cis_offsets[1], user_offset
+  };
+  const uint32_t nwords = pb->nwords;
+  pb->nwords = 0u;
+  for (uint32_t i = 0u; i < 8u; ++i) plmd_push(pb, header[i]);
+  pb->nwords = nwords;
+}
+
+static void* plmd_alloc(size_t size) {
+  ++PLMD_ALLOCS;
+  return malloc(size);
+}
+
+static void plmd_free(void *ptr) { free(ptr); }
+
+// One op is loading and destroying one metadata file.
+static void bench_plmd_load(bench *b, void *userdata) {
+  _NGF_FAKE_USE(userdata);
+  uint32_t words[512];
+  plmd_builder pb = {words, 0u, NGF_ARRAYSIZE(words)};
+  plmd_build(&pb);
+  const ngf_plmd_alloc_callbacks alloc_cb = {plmd_alloc, plmd_free};
+  bench_start(b);
+  for (uint64_t i = 0u; i < b->nops; ++i) {
+    ngf_plmd *meta = NULL;
+    if (ngf_plmd_load(words, pb.nwords * 4u, &alloc_cb, &meta) !=
+        NGF_PLMD_ERROR_OK) {
+      b->skipped = true;
+      return;
+    }
+    ngf_plmd_destroy(meta, &alloc_cb);
+  }
+  bench_stop(b);
+}
+
+#pragma endregion
+
+#pragma region cmd_recording
+
+#define DRAWS_PER_FRAME 1000u
+
+// GLSL for the GL backend; the null backend ignores shader code.
+static const char VERT_SOURCE[] =
+    "#version 430\n"
+    "out gl_PerVertex { vec4 gl_Position; };\n"
+    "layout(std140, binding = 0) uniform Uniforms { vec4 offset; };\n"
+    "void main() {\n"
+    "  gl_Position = vec4(float(gl_VertexID), 0.0, 0.0, 1.0) + offset;\n"
+    "}\n";
+static const char FRAG_SOURCE[] =
+    "#version 430\n"
+    "layout(binding = 0) uniform sampler2D tex;\n"
+    "layout(location = 0) out vec4 color;\n"
+    "void main() { color = texture(tex, vec2(0.5)); }\n";
+
+typedef struct {
+  bool                 ready;
+  ngf_context          ctx;
+  ngf_shader_stage     stages[2];
+  ngf_util_graphics_pipeline_data pipeline_data;
+  ngf_graphics_pipeline pipeline;
+  ngf_image            color_image;
+  ngf_image            texture;
+  ngf_render_target    rt;
+  ngf_sampler          sampler;
+  ngf_uniform_buffer   ubo;
+  ngf_attrib_buffer    vbuf;
+  ngf_cmd_buffer       cmd_buf;
+  ngf_resource_bind_op bind_ops[2];
+} recording_state;
+
+// Sets up a context and the objects for recording draws. Returns false if
+// that isn't possible, e.g. there's no display or the backend doesn't take
+// GLSL.
+static bool recording_init(recording_state *s) {
+  memset(s, 0, sizeof(*s));
+  if (ngf_initialize(NGF_DEVICE_PREFERENCE_DONTCARE) != NGF_ERROR_OK) {
+    return false;
+  }
+  const ngf_context_info ctx_info = {
+    .swapchain_info = NULL,
+    .shared_context = NULL,
+    .debug = false
+  };
+  if (ngf_create_context(&ctx_info, &s->ctx) != NGF_ERROR_OK ||
+      ngf_set_context(s->ctx) != NGF_ERROR_OK) {
+    return false;
+  }
+  const ngf_shader_stage_info stage_infos[2] = {
+    {.type = NGF_STAGE_VERTEX, .content = VERT_SOURCE,
+     .content_length = sizeof(VERT_SOURCE) - 1u, .debug_name = "bench vs"},
+    {.type = NGF_STAGE_FRAGMENT, .content = FRAG_SOURCE,
+     .content_length = sizeof(FRAG_SOURCE) - 1u, .debug_name = "bench fs"}
+  };
+  for (uint32_t i = 0u; i < 2u; ++i) {
+    if (ngf_create_shader_stage(&stage_infos[i], &s->stages[i]) !=
+        NGF_ERROR_OK) {
+      return false;
+    }
+  }
+
+  const ngf_descriptor_info descriptors[] = {
+    {NGF_DESCRIPTOR_UNIFORM_BUFFER, 0u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT},
+    {NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER, 1u,
+     NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT}
+  };
+  const ngf_irect2d viewport = {0, 0, 256u, 256u};
+  ngf_util_create_default_graphics_pipeline_data(&viewport,
+                                                 &s->pipeline_data);
+  if (ngf_util_create_simple_layout(descriptors, 2u,
+                                    &s->pipeline_data.layout_info) !=
+      NGF_ERROR_OK) {
+    return false;
+  }
+  s->pipeline_data.pipeline_info.shader_stages[0] = s->stages[0];
+  s->pipeline_data.pipeline_info.shader_stages[1] = s->stages[1];
+  s->pipeline_data.pipeline_info.nshader_stages = 2u;
+  // Attribute buffers can only be bound to bindings the pipeline declares,
+  // even though the shader only reads gl_VertexID.
+  static const ngf_vertex_buf_binding_desc vbuf_binding = {
+    0u, 16u, NGF_INPUT_RATE_VERTEX
+  };
+  s->pipeline_data.vertex_input_info.vert_buf_bindings = &vbuf_binding;
+  s->pipeline_data.vertex_input_info.nvert_buf_bindings = 1u;
+  if (ngf_create_graphics_pipeline(&s->pipeline_data.pipeline_info,
+                                   &s->pipeline) != NGF_ERROR_OK) {
+    return false;
+  }
+
+  const ngf_image_info image_info = {
+    .type = NGF_IMAGE_TYPE_IMAGE_2D,
+    .extent = {256u, 256u, 1u},
+    .nmips = 1u,
+    .format = NGF_IMAGE_FORMAT_RGBA8,
+    .nsamples = 1u,
+    .usage_hint = NGF_IMAGE_USAGE_SAMPLE_FROM | NGF_IMAGE_USAGE_ATTACHMENT
+  };
+  if (ngf_create_image(&image_info, &s->color_image) != NGF_ERROR_OK ||
+      ngf_create_image(&image_info, &s->texture) != NGF_ERROR_OK) {
+    return false;
+  }
+  const ngf_attachment attachment = {
+    .image_ref = {s->color_image, 0u, 0u, NGF_CUBEMAP_FACE_POSITIVE_X},
+    .type = NGF_ATTACHMENT_COLOR,
+    .load_op = NGF_LOAD_OP_DONTCARE,
+    .store_op = NGF_STORE_OP_STORE
+  };
+  const ngf_render_target_info rt_info = {&attachment, 1u};
+  const ngf_sampler_info sampler_info = {0};
+  const ngf_uniform_buffer_info ubo_info = {
+    256u, NGF_BUFFER_STORAGE_HOST_WRITEABLE, 0u
+  };
+  const ngf_attrib_buffer_info vbuf_info = {
+    4096u, NGF_BUFFER_STORAGE_PRIVATE, 0u
+  };
+  if (ngf_create_render_target(&rt_info, &s->rt) != NGF_ERROR_OK ||
+      ngf_create_sampler(&sampler_info, &s->sampler) != NGF_ERROR_OK ||
+      ngf_create_uniform_buffer(&ubo_info, &s->ubo) != NGF_ERROR_OK ||
+      ngf_create_attrib_buffer(&vbuf_info, &s->vbuf) != NGF_ERROR_OK ||
+      ngf_create_cmd_buffer(NULL, &s->cmd_buf) != NGF_ERROR_OK) {
+    return false;
+  }
+
+  ngf_resource_bind_op *ops = s->bind_ops;
+  ops[0].target_set = 0u;
+  ops[0].target_binding = 0u;
+  ops[0].type = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+  ops[0].info.uniform_buffer.buffer = s->ubo;
+  ops[0].info.uniform_buffer.offset = 0u;
+  ops[0].info.uniform_buffer.range = 256u;
+  ops[1].target_set = 0u;
+  ops[1].target_binding = 1u;
+  ops[1].type = NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER;
+  ops[1].info.image_sampler.image_subresource.image = s->texture;
+  ops[1].info.image_sampler.sampler = s->sampler;
+  s->ready = true;
+  return true;
+}
+
+// Destroys whatever `recording_init` managed to create.
+static void recording_shutdown(recording_state *s) {
+  if (s->cmd_buf) ngf_destroy_cmd_buffer(s->cmd_buf);
+  if (s->vbuf) ngf_destroy_attrib_buffer(s->vbuf);
+  if (s->ubo) ngf_destroy_uniform_buffer(s->ubo);
+  if (s->sampler) ngf_destroy_sampler(s->sampler);
+  if (s->rt) ngf_destroy_render_target(s->rt);
+  if (s->texture) ngf_destroy_image(s->texture);
+  if (s->color_image) ngf_destroy_image(s->color_image);
+  if (s->pipeline) ngf_destroy_graphics_pipeline(s->pipeline);
+  if (s->pipeline_data.layout_info.descriptor_set_layouts) {
+    ngf_util_destroy_layout(&s->pipeline_data.layout_info);
+  }
+  if (s->stages[0]) ngf_destroy_shader_stage(s->stages[0]);
+  if (s->stages[1]) ngf_destroy_shader_stage(s->stages[1]);
+  if (s->ctx) ngf_destroy_context(s->ctx);
+}
+
+typedef struct {
+  recording_state *state;
+  bool             rebind; // Whether every draw binds resources anew.
+} recording_params;
+
+// One op is one draw. Draws are recorded and submitted in frames of
+// DRAWS_PER_FRAME.
+static void bench_record(bench *b, void *userdata) {
+  const recording_params *params = (const recording_params*)userdata;
+  recording_state *s = params->state;
+  if (!s->ready) {
+    b->skipped = true;
+    return;
+  }
+  bench_start(b);
+  for (uint64_t i = 0u; i < b->nops; i += DRAWS_PER_FRAME) {
+    const uint32_t ndraws = (uint32_t)NGF_MIN(b->nops - i, DRAWS_PER_FRAME);
+    ngf_render_encoder enc;
+    if (ngf_begin_frame() != NGF_ERROR_OK ||
+        ngf_start_cmd_buffer(s->cmd_buf) != NGF_ERROR_OK ||
+        ngf_cmd_buffer_start_render(s->cmd_buf, &enc) != NGF_ERROR_OK) {
+      b->skipped = true;
+      return;
+    }
+    ngf_cmd_begin_pass(enc, s->rt);
+    ngf_cmd_bind_gfx_pipeline(enc, s->pipeline);
+    ngf_cmd_bind_gfx_resources(enc, s->bind_ops, 2u);
+    ngf_cmd_bind_attrib_buffer(enc, s->vbuf, 0u, 0u);
+    for (uint32_t d = 0u; d < ndraws; ++d) {
+      if (params->rebind) {
+        ngf_cmd_bind_gfx_resources(enc, s->bind_ops, 2u);
+        ngf_cmd_bind_attrib_buffer(enc, s->vbuf, 0u, 0u);
+      }
+      ngf_cmd_draw(enc, false, 0u, 3u, 1u);
+    }
+    ngf_cmd_end_pass(enc);
+    ngf_render_encoder_end(enc);
+    ngf_submit_cmd_buffers(1u, &s->cmd_buf);
+    ngf_end_frame();
+  }
+  bench_stop(b);
+}
+
+#pragma endregion
+
+static void report_error(const char *message, const void *userdata) {
+  _NGF_FAKE_USE(userdata);
+  fprintf(stderr, "nicegraf: %s\n", message);
+}
+
+int main(int argc, char **argv) {
+  const char *json_path = NULL;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      FILTER = argv[++i];
+    } else if (strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+      MIN_TIME_NS = (uint64_t)strtoull(argv[++i], NULL, 10) * 1000000u;
+    } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+      json_path = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--filter substring] [--min-time-ms ms] "
+                      "[--json path]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  static const blk_pattern blk_patterns[] = {BLK_LIFO, BLK_FIFO, BLK_RANDOM};
+  static const char *blk_names[] = {
+    "blkalloc/lifo", "blkalloc/fifo", "blkalloc/random"
+  };
+  for (uint32_t i = 0u; i < NGF_ARRAYSIZE(blk_patterns); ++i) {
+    run_bench(blk_names[i], bench_blkalloc, (void*)&blk_patterns[i]);
+  }
+  run_bench("blkalloc/cross_thread", bench_blkalloc_cross_thread, NULL);
+
+  static const size_t sa_sizes[] = {16u, 256u, 4096u};
+  static const char *sa_names[] = {
+    "stack_alloc/16b", "stack_alloc/256b", "stack_alloc/4kb"
+  };
+  for (uint32_t i = 0u; i < NGF_ARRAYSIZE(sa_sizes); ++i) {
+    run_bench(sa_names[i], bench_stack_alloc, (void*)&sa_sizes[i]);
+  }
+
+  static const bool grow = false, presized = true;
+  run_bench("darray/append_grow", bench_darray_append, (void*)&grow);
+  run_bench("darray/append_presized", bench_darray_append, (void*)&presized);
+
+  run_bench("binding_map/lookup", bench_binding_map_lookup, NULL);
+  run_bench("plmd/load", bench_plmd_load, NULL);
+
+  // Only bring up a context if a recording benchmark is going to run.
+  if (bench_selected("record/draw") || bench_selected("record/draw_bind")) {
+    recording_state rec;
+    ngf_debug_message_callback(NULL, report_error);
+    if (!recording_init(&rec)) {
+      fprintf(stderr, "can't set up command recording on the %s backend\n",
+              NGF_BENCH_BACKEND);
+    }
+    const recording_params draw = {&rec, false}, draw_bind = {&rec, true};
+    run_bench("record/draw", bench_record, (void*)&draw);
+    run_bench("record/draw_bind", bench_record, (void*)&draw_bind);
+    recording_shutdown(&rec);
+  }
+
+  if (json_path != NULL && !write_json(json_path)) {
+    fprintf(stderr, "failed to write %s\n", json_path);
+    return 1;
+  }
+  return 0;
+}
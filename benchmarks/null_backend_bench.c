@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Records and submits synthetic frames of N draws against the null backend,
+// measuring the CPU cost of nicegraf's recording and submission paths.
+// Usage: ngf_null_bench [ndraws] [nframes]
+
+#include "nicegraf.h"
+#include "nicegraf_util.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CHECK(expr) \
+  if ((expr) != NGF_ERROR_OK) { \
+    fprintf(stderr, "%s failed\n", #expr); \
+    exit(1); \
+  }
+
+static double now_sec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+// Parses a positive count from a command line argument.
+static bool parse_count(const char *arg, uint32_t *result) {
+  char *end = NULL;
+  const unsigned long value = strtoul(arg, &end, 10);
+  if (end == arg || *end != '\0' || arg[0] == '-' || value == 0ul ||
+      value > UINT32_MAX) {
+    return false;
+  }
+  *result = (uint32_t)value;
+  return true;
+}
+
+static void report_error(const char *message, const void *userdata) {
+  (void)userdata;
+  fprintf(stderr, "nicegraf: %s\n", message);
+}
+
+int main(int argc, char **argv) {
+  uint32_t ndraws = 10000u;
+  uint32_t nframes = 100u;
+  if (argc > 3 || (argc > 1 && !parse_count(argv[1], &ndraws)) ||
+      (argc > 2 && !parse_count(argv[2], &nframes))) {
+    fprintf(stderr, "usage: %s [ndraws] [nframes]\n"
+                    "both counts must be positive integers\n", argv[0]);
+    return 1;
+  }
+
+  ngf_debug_message_callback(NULL, report_error);
+  CHECK(ngf_initialize(NGF_DEVICE_PREFERENCE_DONTCARE));
+  const ngf_context_info ctx_info = {
+    .swapchain_info = NULL,
+    .shared_context = NULL,
+    .debug = false
+  };
+  ngf_context ctx = NULL;
+  CHECK(ngf_create_context(&ctx_info, &ctx));
+  CHECK(ngf_set_context(ctx));
+
+  // A pipeline with one uniform buffer and one combined image/sampler, which
+  // is bound anew for every draw.
+  const ngf_descriptor_info descriptors[] = {
+    {NGF_DESCRIPTOR_UNIFORM_BUFFER, 0u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT},
+    {NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER, 1u,
+     NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT}
+  };
+  const ngf_irect2d viewport = {0, 0, 1024u, 1024u};
+  ngf_util_graphics_pipeline_data pipeline_data;
+  ngf_util_create_default_graphics_pipeline_data(&viewport, &pipeline_data);
+  CHECK(ngf_util_create_simple_layout(descriptors, 2u,
+                                      &pipeline_data.layout_info));
+  ngf_graphics_pipeline pipeline = NULL;
+  CHECK(ngf_create_graphics_pipeline(&pipeline_data.pipeline_info,
+                                     &pipeline));
+
+  const ngf_image_info image_info = {
+    .type = NGF_IMAGE_TYPE_IMAGE_2D,
+    .extent = {1024u, 1024u, 1u},
+    .nmips = 1u,
+    .format = NGF_IMAGE_FORMAT_RGBA8,
+    .nsamples = 1u,
+    .usage_hint = NGF_IMAGE_USAGE_SAMPLE_FROM | NGF_IMAGE_USAGE_ATTACHMENT
+  };
+  ngf_image color_image = NULL, texture = NULL;
+  CHECK(ngf_create_image(&image_info, &color_image));
+  CHECK(ngf_create_image(&image_info, &texture));
+  const ngf_attachment attachment = {
+    .image_ref = {color_image, 0u, 0u, NGF_CUBEMAP_FACE_POSITIVE_X},
+    .type = NGF_ATTACHMENT_COLOR,
+    .load_op = NGF_LOAD_OP_DONTCARE,
+    .store_op = NGF_STORE_OP_STORE
+  };
+  const ngf_render_target_info rt_info = {&attachment, 1u};
+  ngf_render_target rt = NULL;
+  CHECK(ngf_create_render_target(&rt_info, &rt));
+
+  const ngf_sampler_info sampler_info = {0};
+  ngf_sampler sampler = NULL;
+  CHECK(ngf_create_sampler(&sampler_info, &sampler));
+  const ngf_uniform_buffer_info ubo_info = {
+    256u, NGF_BUFFER_STORAGE_HOST_WRITEABLE, 0u
+  };
+  ngf_uniform_buffer ubo = NULL;
+  CHECK(ngf_create_uniform_buffer(&ubo_info, &ubo));
+  const ngf_attrib_buffer_info vbuf_info = {
+    4096u, NGF_BUFFER_STORAGE_PRIVATE, 0u
+  };
+  ngf_attrib_buffer vbuf = NULL;
+  CHECK(ngf_create_attrib_buffer(&vbuf_info, &vbuf));
+
+  ngf_resource_bind_op bind_ops[2];
+  bind_ops[0].target_set = 0u;
+  bind_ops[0].target_binding = 0u;
+  bind_ops[0].type = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+  bind_ops[0].info.uniform_buffer.buffer = ubo;
+  bind_ops[0].info.uniform_buffer.offset = 0u;
+  bind_ops[0].info.uniform_buffer.range = 256u;
+  bind_ops[1].target_set = 0u;
+  bind_ops[1].target_binding = 1u;
+  bind_ops[1].type = NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER;
+  bind_ops[1].info.image_sampler.image_subresource.image = texture;
+  bind_ops[1].info.image_sampler.sampler = sampler;
+
+  ngf_cmd_buffer cmd_buf = NULL;
+  CHECK(ngf_create_cmd_buffer(NULL, &cmd_buf));
+
+  const double start = now_sec();
+  for (uint32_t f = 0u; f < nframes; ++f) {
+    CHECK(ngf_begin_frame());
+    CHECK(ngf_start_cmd_buffer(cmd_buf));
+    ngf_render_encoder enc;
+    CHECK(ngf_cmd_buffer_start_render(cmd_buf, &enc));
+    ngf_cmd_begin_pass(enc, rt);
+    ngf_cmd_bind_gfx_pipeline(enc, pipeline);
+    for (uint32_t d = 0u; d < ndraws; ++d) {
+      ngf_cmd_bind_gfx_resources(enc, bind_ops, 2u);
+      ngf_cmd_bind_attrib_buffer(enc, vbuf, 0u, 0u);
+      ngf_cmd_draw(enc, false, 0u, 3u, 1u);
+    }
+    ngf_cmd_end_pass(enc);
+    CHECK(ngf_render_encoder_end(enc));
+    CHECK(ngf_submit_cmd_buffers(1u, &cmd_buf));
+    CHECK(ngf_end_frame());
+  }
+  const double elapsed = now_sec() - start;
+  const double total_draws = (double)nframes * ndraws;
+
+  ngf_frame_stats stats;
+  CHECK(ngf_get_frame_stats(&stats));
+  printf("%u frames x %u draws: %.3f ms/frame, %.1f ns/draw\n",
+         nframes, ndraws, elapsed * 1e3 / nframes,
+         total_draws > 0.0 ? elapsed * 1e9 / total_draws : 0.0);
+  printf("last frame: %llu draws, %llu resource binds, %llu cmd blocks, "
+         "submit %.3f ms\n",
+         (unsigned long long)stats.draws,
+         (unsigned long long)stats.resource_binds,
+         (unsigned long long)stats.cmd_blocks_allocated,
+         (double)stats.submit_time_ns * 1e-6);
+
+  ngf_destroy_cmd_buffer(cmd_buf);
+  ngf_destroy_attrib_buffer(vbuf);
+  ngf_destroy_uniform_buffer(ubo);
+  ngf_destroy_sampler(sampler);
+  ngf_destroy_render_target(rt);
+  ngf_destroy_image(texture);
+  ngf_destroy_image(color_image);
+  ngf_destroy_graphics_pipeline(pipeline);
+  ngf_util_destroy_layout(&pipeline_data.layout_info);
+  ngf_destroy_context(ctx);
+  return 0;
+}
@@ -27,6 +27,7 @@
 #pragma warning(disable:4200)
 #endif
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -45,6 +46,7 @@ typedef struct ngf_plmd ngf_plmd;
 
 #define NGF_PLMD_STAGE_VISIBILITY_VERTEX_BIT   (0x01)
 #define NGF_PLMD_STAGE_VISIBILITY_FRAGMENT_BIT (0x02)
+#define NGF_PLMD_STAGE_VISIBILITY_COMPUTE_BIT  (0x04)
 
 /**
  * Pipeline metadata header.
@@ -167,7 +169,9 @@ typedef enum ngf_plmd_error {
   NGF_PLMD_ERROR_OUTOFMEM,
   NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH,
   NGF_PLMD_ERROR_BUFFER_TOO_SMALL,
-  NGF_PLMD_ERROR_WEIRD_BUFFER_SIZE
+  NGF_PLMD_ERROR_WEIRD_BUFFER_SIZE,
+  NGF_PLMD_ERROR_ENTRY_NOT_FOUND,
+  NGF_PLMD_ERROR_VERSION_MISMATCH
 } ngf_plmd_error;
 
 typedef struct ngf_plmd_alloc_callbacks {
@@ -183,10 +187,160 @@ const ngf_plmd_layout* ngf_plmd_get_layout(const ngf_plmd *m);
 const ngf_plmd_cis_map* ngf_plmd_get_image_to_cis_map(const ngf_plmd *m);
 const ngf_plmd_cis_map* ngf_plmd_get_sampler_to_cis_map(const ngf_plmd *m);
 const ngf_plmd_user* ngf_plmd_get_user(const ngf_plmd *m);
+
+/**
+ * Looks up the value of the user metadata entry with the given key.
+ * Metadata with more than a few user entries gets a hash index over the keys
+ * when it is loaded, so this doesn't have to compare against every key.
+ * @return the value, or NULL if there is no such entry.
+ */
+const char* ngf_plmd_find_user(const ngf_plmd *m, const char *key);
 const ngf_plmd_header* ngf_plmd_get_header(const ngf_plmd *m);
 
 const char* ngf_plmd_get_error_name(const ngf_plmd_error err);
 
+/**
+ * A read-only view of pipeline metadata stored in a buffer owned by the
+ * caller, such as a memory-mapped file. Unlike \ref ngf_plmd_load, creating a
+ * view doesn't copy the buffer or allocate any memory, and records are located
+ * only when they are accessed. The buffer must outlive the view and all the
+ * pointers obtained from it.
+ */
+typedef struct ngf_plmd_view {
+  const uint8_t *data;
+  size_t size;
+} ngf_plmd_view;
+
+/**
+ * Initializes a view of the pipeline metadata in the given buffer.
+ * The buffer must be 4-byte aligned. If the metadata in it is already in host
+ * byte order, the buffer is never written to, so it may be mapped read-only.
+ * Otherwise, it is converted to host byte order in place, and must be
+ * writable (a private copy-on-write mapping works). Initializing another view
+ * of a buffer that has already been converted doesn't convert it again.
+ */
+ngf_plmd_error ngf_plmd_view_init(void *buf, size_t buf_size,
+                                  ngf_plmd_view *view);
+
+const ngf_plmd_header* ngf_plmd_view_get_header(const ngf_plmd_view *view);
+
+/**
+ * Returns the first descriptor set layout in the pipeline layout record, and
+ * writes the number of descriptor sets to `nsets`. Use
+ * \ref ngf_plmd_next_set_layout to get to the other sets.
+ */
+const ngf_plmd_descriptor_set_layout* ngf_plmd_view_get_set_layouts(
+    const ngf_plmd_view *view,
+    uint32_t *nsets);
+
+const ngf_plmd_descriptor_set_layout* ngf_plmd_next_set_layout(
+    const ngf_plmd_descriptor_set_layout *set_layout);
+
+/**
+ * Returns the first entry of the image to combined image/sampler map, and
+ * writes the number of entries to `nentries`. Use
+ * \ref ngf_plmd_next_cis_map_entry to get to the other entries.
+ */
+const ngf_plmd_cis_map_entry* ngf_plmd_view_get_image_to_cis_map(
+    const ngf_plmd_view *view,
+    uint32_t *nentries);
+
+/**
+ * Same as \ref ngf_plmd_view_get_image_to_cis_map, for the sampler to combined
+ * image/sampler map.
+ */
+const ngf_plmd_cis_map_entry* ngf_plmd_view_get_sampler_to_cis_map(
+    const ngf_plmd_view *view,
+    uint32_t *nentries);
+
+const ngf_plmd_cis_map_entry* ngf_plmd_next_cis_map_entry(
+    const ngf_plmd_cis_map_entry *entry);
+
+/**
+ * Looks up the value of the user metadata entry with the given key.
+ * @return the value, or NULL if there is no such entry.
+ */
+const char* ngf_plmd_view_find_user_value(const ngf_plmd_view *view,
+                                          const char *key);
+
+/**
+ * Pipeline metadata archive header.
+ * An archive packs the metadata of many pipelines into a single buffer, so
+ * that all of it can be brought in with one read (or mapping). It consists of
+ * the header, followed by the index, a table of null-terminated pipeline
+ * names, and the metadata of each pipeline. Everything in an archive is in the
+ * byte order of the host that packed it.
+ */
+typedef struct ngf_plmd_archive_header {
+  uint32_t magic_number; /**< must always be 0xdeadbabe */
+  uint32_t version; /**< version of the archive format in use. */
+  uint32_t nentries; /**< number of pipelines in the archive. */
+  uint32_t index_offset; /**< Offset, in bytes, of the index. */
+} ngf_plmd_archive_header;
+
+/**
+ * Pipeline metadata archive index entry. The index is sorted by name hash.
+ */
+typedef struct ngf_plmd_archive_entry {
+  uint32_t name_hash; /**< see \ref ngf_plmd_archive_hash_name. */
+  uint32_t name_offset; /**< Offset, in bytes, of the pipeline name. */
+  uint32_t data_offset; /**< Offset, in bytes, of the pipeline metadata. */
+  uint32_t data_size; /**< Size, in bytes, of the pipeline metadata. */
+} ngf_plmd_archive_entry;
+
+/**
+ * A read-only view of a pipeline metadata archive stored in a buffer owned by
+ * the caller, such as a memory-mapped file.
+ */
+typedef struct ngf_plmd_archive {
+  const uint8_t *data;
+  size_t size;
+  const ngf_plmd_archive_entry *index;
+  uint32_t nentries;
+} ngf_plmd_archive;
+
+/**
+ * Hash of a pipeline name, as stored in the archive index (32-bit FNV-1a).
+ */
+uint32_t ngf_plmd_archive_hash_name(const char *name);
+
+/**
+ * Packs the metadata of the given pipelines into an archive.
+ * The metadata is converted to host byte order while packing, so archives can
+ * be viewed from read-only buffers.
+ * @param nentries number of pipelines.
+ * @param names names of the pipelines.
+ * @param blobs metadata of the pipelines, as accepted by \ref ngf_plmd_load.
+ * @param blob_sizes sizes of the metadata blobs, in bytes.
+ * @param out buffer to write the archive into, must be 4-byte aligned. May be
+ *            NULL, in which case only the required size is computed.
+ * @param out_size on input, the size of `out`. On output, the size of the
+ *                 archive.
+ */
+ngf_plmd_error ngf_plmd_archive_pack(uint32_t nentries,
+                                     const char *const *names,
+                                     const void *const *blobs,
+                                     const size_t *blob_sizes,
+                                     void *out,
+                                     size_t *out_size);
+
+/**
+ * Initializes a view of the archive in the given buffer, which must be 4-byte
+ * aligned. Neither the buffer nor the metadata in it is copied or parsed.
+ * @return NGF_PLMD_ERROR_VERSION_MISMATCH if the archive was packed with an
+ *         unsupported version of the archive format.
+ */
+ngf_plmd_error ngf_plmd_archive_init(const void *buf, size_t buf_size,
+                                     ngf_plmd_archive *archive);
+
+/**
+ * Looks up the metadata of the pipeline with the given name, in O(log n).
+ * @return NGF_PLMD_ERROR_ENTRY_NOT_FOUND if there is no such pipeline.
+ */
+ngf_plmd_error ngf_plmd_archive_find(const ngf_plmd_archive *archive,
+                                     const char *name,
+                                     ngf_plmd_view *view);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -177,7 +177,7 @@ typedef struct ngf_offset3d {
 typedef enum ngf_stage_type {
   NGF_STAGE_VERTEX = 0,
   NGF_STAGE_FRAGMENT,
-  // TODO: compute pipelines
+  NGF_STAGE_COMPUTE,
   NGF_STAGE_COUNT
 } ngf_stage_type;
 
@@ -480,8 +480,49 @@ typedef enum ngf_buffer_usage {
   NGF_BUFFER_USAGE_XFER_DST = 0x02, /** < Buffer may be used as a destination
                                           for transfer operations.
                                       */
+  NGF_BUFFER_USAGE_DRAW_INDIRECT = 0x04, /** < Buffer may be used as a source
+                                               of arguments for indirect draws
+                                               and dispatches.
+                                           */
+  NGF_BUFFER_USAGE_STORAGE = 0x08, /** < Buffer may be bound as a storage
+                                         buffer, and read or written by
+                                         shaders.
+                                     */
 } ngf_buffer_usage;
 
+/**
+ * Layout of the arguments for a single non-indexed indirect draw, as they
+ * need to appear in the argument buffer.
+ */
+typedef struct ngf_draw_indirect_args {
+  uint32_t nvertices; /**< Number of vertices to draw. */
+  uint32_t ninstances; /**< Number of instances to draw. */
+  uint32_t first_vertex; /**< Index of the first vertex. */
+  uint32_t first_instance; /**< Index of the first instance. */
+} ngf_draw_indirect_args;
+
+/**
+ * Layout of the arguments for a single indexed indirect draw, as they need to
+ * appear in the argument buffer.
+ */
+typedef struct ngf_draw_indexed_indirect_args {
+  uint32_t nindices; /**< Number of indices to draw. */
+  uint32_t ninstances; /**< Number of instances to draw. */
+  uint32_t first_index; /**< Position of the first index in index buffer. */
+  int32_t  vertex_offset; /**< Value added to each index. */
+  uint32_t first_instance; /**< Index of the first instance. */
+} ngf_draw_indexed_indirect_args;
+
+/**
+ * Layout of the arguments for a single indirect dispatch, as they need to
+ * appear in the argument buffer.
+ */
+typedef struct ngf_dispatch_indirect_args {
+  uint32_t ngroups_x; /**< Number of workgroups along the X axis. */
+  uint32_t ngroups_y; /**< Number of workgroups along the Y axis. */
+  uint32_t ngroups_z; /**< Number of workgroups along the Z axis. */
+} ngf_dispatch_indirect_args;
+
 
 /**
  * Information required for buffer creation.
@@ -515,6 +556,11 @@ typedef ngf_buffer_info ngf_uniform_buffer_info;
  */
 typedef struct ngf_uniform_buffer_t* ngf_uniform_buffer;
 
+/**
+ * A vertex attribute buffer.
+ */
+typedef struct ngf_attrib_buffer_t* ngf_attrib_buffer;
+
 /**
  * Possible usages of a pixel buffer object.
  */
@@ -605,8 +651,10 @@ typedef enum ngf_image_format {
  */
 typedef enum ngf_image_usage {
   NGF_IMAGE_USAGE_SAMPLE_FROM = 0x01, /**< Can be read from in a shader.*/
-  NGF_IMAGE_USAGE_ATTACHMENT = 0x02   /**< Can be used as an attachment for a
+  NGF_IMAGE_USAGE_ATTACHMENT = 0x02,  /**< Can be used as an attachment for a
                                            render target.*/
+  NGF_IMAGE_USAGE_STORAGE = 0x04      /**< Can be read from and written to by
+                                           shaders as a storage image.*/
 } ngf_image_usage;
 
 /**
@@ -626,6 +674,39 @@ typedef struct ngf_image_info {
 
 typedef struct ngf_image_t* ngf_image;
 
+/**
+ * Pool of transient images, e.g. intermediate render targets that are only
+ * needed for a part of each frame. See \ref ngf_acquire_transient_image.
+ */
+typedef struct ngf_transient_pool_t* ngf_transient_pool;
+
+/**
+ * Describes a transient image and the part of the frame it is needed for.
+ * Lifetimes are expressed in caller-defined steps, e.g. render pass indices,
+ * and restart from zero on every \ref ngf_reset_transient_pool.
+ */
+typedef struct ngf_transient_image_info {
+  ngf_image_info image_info; /**< Configuration of the image. */
+  uint32_t first_use; /**< First step at which the image is used. */
+  uint32_t last_use; /**< Last step at which the image is used. */
+} ngf_transient_image_info;
+
+/**
+ * Information about the images held by a transient pool.
+ */
+typedef struct ngf_transient_pool_stats {
+  uint32_t nimages; /**< Number of images held by the pool. */
+  uint32_t nacquired; /**< Images acquired since the last reset. */
+  uint32_t nmemory_blocks; /**< Device memory blocks that images share. */
+
+  /**
+   * Size of the device memory blocks in bytes. Images that don't share memory
+   * aren't accounted for, so this stays at zero on back-ends that don't
+   * support aliasing.
+   */
+  uint64_t memory_bytes;
+} ngf_transient_pool_stats;
+
 /**
  * Indicates the face of a cubemap.
  */
@@ -806,6 +887,16 @@ typedef enum {
   NGF_DESCRIPTOR_TEXTURE,
   NGF_DESCRIPTOR_SAMPLER,
   NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER,
+  NGF_DESCRIPTOR_STORAGE_BUFFER,
+  NGF_DESCRIPTOR_STORAGE_IMAGE,
+
+  /**
+   * Uniform buffer whose offset can be changed after the descriptor has been
+   * bound, see \ref ngf_cmd_set_dynamic_offsets. Bind operations for this
+   * type use \ref ngf_uniform_buffer_bind_info. Shares native bindings with
+   * \ref NGF_DESCRIPTOR_UNIFORM_BUFFER on back-ends without descriptor sets.
+   */
+  NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC,
   NGF_DESCRIPTOR_TYPE_COUNT
 } ngf_descriptor_type;
 
@@ -815,6 +906,7 @@ typedef enum {
 typedef enum ngf_descriptor_stage {
   NGF_DESCRIPTOR_VERTEX_STAGE_BIT = 0x01,
   NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT = 0x02,
+  NGF_DESCRIPTOR_COMPUTE_STAGE_BIT = 0x04,
 } ngf_descriptor_stage_flags;
 
 /**
@@ -846,14 +938,35 @@ typedef struct {
   uint32_t ndescriptors;
 } ngf_descriptor_set_layout_info;
 
+/**
+ * Maximum size, in bytes, of a pipeline's push constant block.
+ */
+#define NGF_MAX_PUSH_CONSTANTS_SIZE 128u
+
 /**
  * Pipeline layout description.
  * Specifies layouts for descriptor sets that are required to be bound by a
- * pipeline.
+ * pipeline, and the size of its push constant block.
  */
 typedef struct {
   uint32_t ndescriptor_set_layouts;
   ngf_descriptor_set_layout_info *descriptor_set_layouts;
+
+  /**
+   * Size, in bytes, of the push constant block. Zero if the pipeline doesn't
+   * use push constants. Must be a multiple of 4 and not exceed
+   * \ref NGF_MAX_PUSH_CONSTANTS_SIZE.
+   * On backends without native push constants (GL, Metal), the block is
+   * exposed to shaders as a uniform buffer at the binding right after the
+   * last one assigned to the uniform buffers of this layout.
+   */
+  uint32_t push_constants_size;
+
+  /**
+   * Specifies which stage(s) the push constant block is accessible from.
+   * This needs to be a combination of \ref ngf_descriptor_stage flags.
+   */
+  uint32_t push_constants_stage_flags;
 } ngf_pipeline_layout_info;
 
 /**
@@ -873,6 +986,16 @@ typedef struct {
   ngf_sampler sampler; /**< Sampler to use.*/
 } ngf_image_sampler_bind_info;
 
+/**
+ * Specifies a storage buffer bind operation.
+ */
+typedef struct {
+  ngf_attrib_buffer buffer; /**< Which buffer to bind. Must have been created
+                                 with \ref NGF_BUFFER_USAGE_STORAGE.*/
+  size_t offset; /**< Offset at which to bind the buffer.*/
+  size_t range;  /**< Bound range.*/
+} ngf_storage_buffer_bind_info;
+
 typedef struct {
   uint32_t target_set;
   uint32_t target_binding;
@@ -880,6 +1003,9 @@ typedef struct {
   union {
     ngf_uniform_buffer_bind_info uniform_buffer;
     ngf_image_sampler_bind_info image_sampler;
+    ngf_storage_buffer_bind_info storage_buffer;
+    ngf_image_ref storage_image; /**< Image must have been created with
+                                      \ref NGF_IMAGE_USAGE_STORAGE.*/
   } info;
 } ngf_resource_bind_op;
 
@@ -962,6 +1088,26 @@ typedef struct ngf_graphics_pipeline_info {
   const ngf_plmd_cis_map *sampler_to_combined_map;
 } ngf_graphics_pipeline_info;
 
+/**
+ * Compute pipeline object.
+ */
+typedef struct ngf_compute_pipeline_t* ngf_compute_pipeline;
+
+/**
+ * Specifies information for creation of a compute pipeline.
+ */
+typedef struct ngf_compute_pipeline_info {
+  ngf_shader_stage shader_stage; /**< Must be a \ref NGF_STAGE_COMPUTE stage.*/
+  const ngf_pipeline_layout_info *layout;
+  const ngf_specialization_info *spec_info; /**< May be NULL. */
+
+  /**
+   * Workgroup size declared by the compute shader. Backends that can obtain it
+   * from the shader itself (GL, Vulkan) ignore this field.
+   */
+  uint32_t workgroup_size[3];
+} ngf_compute_pipeline_info;
+
 /**
  * Specifies host memory allocation callbacks for the library's internal needs.
  */
@@ -971,6 +1117,41 @@ typedef struct ngf_allocation_callbacks {
   void (*free)(void *ptr, size_t obj_size, size_t nobjs);
 } ngf_allocation_callbacks;
 
+/**
+ * Categories that the library's host memory allocations are tracked under.
+ */
+typedef enum ngf_allocation_category {
+  NGF_ALLOCATION_GENERAL = 0, /**< Anything not covered by other categories.*/
+  NGF_ALLOCATION_PIPELINE, /**< Graphics and compute pipeline objects. */
+
+  /** Maps from nicegraf's bindings to the backend's native bindings. */
+  NGF_ALLOCATION_BINDING_MAP,
+
+  NGF_ALLOCATION_CMD_BLOCK, /**< Storage for recorded commands. */
+  NGF_ALLOCATION_DESCRIPTOR_POOL, /**< Descriptor pool bookkeeping. */
+  NGF_ALLOCATION_DYNAMIC_ARRAY, /**< Internal growable arrays. */
+  NGF_ALLOCATION_TEMP_STORE, /**< Per-thread scratch memory. */
+  NGF_ALLOCATION_CATEGORY_COUNT
+} ngf_allocation_category;
+
+/**
+ * Host memory usage of a single allocation category.
+ */
+typedef struct ngf_allocation_counters {
+  uint64_t live_bytes; /**< Bytes currently allocated. */
+  uint64_t peak_bytes; /**< Highest value that `live_bytes` has reached. */
+  uint64_t live_allocations; /**< Allocations that haven't been freed. */
+  uint64_t total_allocations; /**< Allocations made since startup. */
+} ngf_allocation_counters;
+
+/**
+ * Host memory usage of the library, per category and in total.
+ */
+typedef struct ngf_allocation_stats {
+  ngf_allocation_counters categories[NGF_ALLOCATION_CATEGORY_COUNT];
+  ngf_allocation_counters total;
+} ngf_allocation_stats;
+
 /**
  * Nicegraf rendering context.
  * 
@@ -1005,7 +1186,10 @@ typedef struct ngf_context_t* ngf_context;
 typedef struct ngf_context_info {
   /**
    * Configures the swapchain that the context will be presenting to. This
-   * can be NULL if all rendering is done off-screen.
+   * can be NULL if all rendering is done off-screen. On the OpenGL backend,
+   * such contexts use a display that doesn't require a window system (Mesa's
+   * surfaceless platform or an EGL device) when the EGL implementation
+   * provides one.
    */
   const ngf_swapchain_info *swapchain_info;
 
@@ -1018,6 +1202,221 @@ typedef struct ngf_context_info {
   bool debug; /**< Whether to enable debug features. */
 } ngf_context_info;
 
+/**
+ * Limits and capabilities of the device used by the current context.
+ * See \ref ngf_get_device_capabilities.
+ */
+typedef struct ngf_device_capabilities {
+  /**
+   * Required alignment, in bytes, of the offsets of uniform buffer bindings
+   * (including dynamic offsets).
+   */
+  size_t uniform_buffer_offset_alignment;
+
+  /** Maximum size, in bytes, of a uniform buffer binding's range. */
+  size_t max_uniform_buffer_range;
+
+  /**
+   * Alignment, in bytes, of source buffer offsets that gives the best
+   * performance for buffer copies and \ref ngf_cmd_write_image. This is a
+   * power of two. Backends without a device-specific value report 16.
+   * Offsets for \ref ngf_cmd_write_image additionally have to be a multiple
+   * of the texel size of the target image's format.
+   */
+  size_t optimal_copy_offset_alignment;
+
+  /** Maximum number of uniform buffers accessible from a single stage. */
+  uint32_t max_uniform_buffers_per_stage;
+
+  /** Maximum number of sampled images accessible from a single stage. */
+  uint32_t max_sampled_images_per_stage;
+
+  /** Maximum number of samplers accessible from a single stage. */
+  uint32_t max_samplers_per_stage;
+
+  /** Maximum number of color attachments in a render target. */
+  uint32_t max_color_attachments;
+
+  /** Maximum width and height of a 2D image. */
+  uint32_t max_image_dimension_2d;
+
+  /** Maximum number of samples per pixel for a multisampled image. */
+  uint32_t max_sample_count;
+
+  /** Number of nanoseconds per tick of a GPU timestamp. */
+  float timestamp_period;
+
+  /**
+   * Whether \ref ngf_cmd_draw_indirect performs several draws with a single
+   * GPU command. If false, draws are still performed, but issued one by one.
+   */
+  bool multi_draw_indirect;
+
+  /**
+   * Whether the arguments of indirect draws may specify a non-zero first
+   * instance. If false, the first instance must be zero.
+   */
+  bool draw_indirect_first_instance;
+} ngf_device_capabilities;
+
+/**
+ * Maximum number of GPU timing scopes recorded per frame. Scopes beyond this
+ * limit are not timed.
+ */
+#define NGF_MAX_GPU_TIMING_SCOPES 256u
+
+/**
+ * Size of the buffer holding a GPU timing scope's name, including the
+ * terminator. Longer names are truncated.
+ */
+#define NGF_GPU_TIMING_SCOPE_NAME_SIZE 48u
+
+/**
+ * Parent index of GPU timing scopes that aren't nested within another scope.
+ */
+#define NGF_GPU_TIMING_NO_PARENT (~0u)
+
+/**
+ * GPU time spent executing the commands within a scope.
+ * Scopes are opened and closed around every encoder, every render pass and
+ * every debug group (see \ref ngf_cmd_begin_debug_group).
+ */
+typedef struct ngf_gpu_timing_scope {
+  char name[NGF_GPU_TIMING_SCOPE_NAME_SIZE]; /**< Name of the scope. */
+
+  /**
+   * Index of the enclosing scope, or \ref NGF_GPU_TIMING_NO_PARENT.
+   */
+  uint32_t parent;
+
+  uint32_t depth; /**< Nesting depth, 0 for scopes without a parent. */
+
+  /**
+   * Time at which the scope started, in nanoseconds, relative to the start
+   * of the frame's first scope.
+   */
+  uint64_t start_ns;
+
+  uint64_t duration_ns; /**< Duration of the scope in nanoseconds. */
+} ngf_gpu_timing_scope;
+
+/**
+ * GPU timings for a single frame, as a tree of scopes.
+ */
+typedef struct ngf_gpu_frame_timings {
+  uint64_t frame; /**< Index of the frame that the timings belong to. */
+  uint32_t nscopes; /**< Number of scopes. */
+
+  /**
+   * The scopes, in the order in which they were opened. Each scope comes
+   * after its parent.
+   */
+  const ngf_gpu_timing_scope *scopes;
+} ngf_gpu_frame_timings;
+
+/**
+ * CPU-side counters for a single frame. Counters are accumulated by every
+ * thread that records or creates objects, and are collected when the frame
+ * ends (see \ref ngf_end_frame).
+ */
+typedef struct ngf_frame_stats {
+  uint64_t frame; /**< Index of the frame that the counters belong to. */
+  uint64_t draws; /**< Number of draw calls recorded. */
+  uint64_t instances; /**< Number of instances drawn by direct draw calls. */
+  uint64_t pipeline_binds; /**< Number of pipeline binds recorded. */
+  uint64_t resource_binds; /**< Number of resources bound. */
+  uint64_t descriptor_sets_allocated; /**< Descriptor sets allocated. */
+  uint64_t descriptor_pools_created; /**< Number of descriptor pools created. */
+  uint64_t buffers_created; /**< Number of buffers created. */
+  uint64_t buffers_destroyed; /**< Number of buffers destroyed. */
+  uint64_t images_created; /**< Number of images created. */
+  uint64_t images_destroyed; /**< Number of images destroyed. */
+  uint64_t bytes_mapped; /**< Number of bytes in mapped buffer ranges. */
+
+  /**
+   * Number of bytes copied between buffers by transfer commands.
+   */
+  uint64_t bytes_uploaded;
+
+  /**
+   * Number of blocks allocated for storing recorded commands. On backends
+   * that record into native command buffers, this is the number of native
+   * command buffers allocated.
+   */
+  uint64_t cmd_blocks_allocated;
+
+  uint64_t submit_time_ns; /**< Time spent in \ref ngf_submit_cmd_buffers. */
+  uint64_t end_frame_time_ns; /**< Time spent in \ref ngf_end_frame. */
+
+  /**
+   * Time the CPU spent blocked waiting for the GPU to finish earlier frames,
+   * whether to enforce frame pacing (see \ref ngf_set_frame_pacing) or to
+   * reuse per-frame resources.
+   */
+  uint64_t pacing_wait_time_ns;
+
+  /**
+   * Number of frames, including this one, that had been submitted to the GPU
+   * but not finished by it when the frame ended.
+   */
+  uint64_t queued_frames;
+
+  /**
+   * GPU time spent on the most recent frame that the GPU is known to have
+   * finished. Backends measure it with GPU timing (see
+   * \ref ngf_enable_gpu_timing), as the total duration of the frame's
+   * top-level scopes, and report zero when it's disabled.
+   */
+  uint64_t gpu_busy_time_ns;
+} ngf_frame_stats;
+
+/**
+ * Largest allowed value of \ref ngf_frame_pacing_info::max_queued_frames.
+ */
+#define NGF_MAX_QUEUED_FRAMES 8u
+
+/**
+ * Where the CPU waits for the GPU to keep the number of queued frames in
+ * check.
+ */
+typedef enum ngf_frame_pacing_mode {
+  /**
+   * Frames are only limited by the backend's own resources, such as the
+   * number of swapchain images.
+   */
+  NGF_FRAME_PACING_DEFAULT = 0,
+
+  /**
+   * \ref ngf_end_frame waits after presenting until no more than the maximum
+   * number of frames are queued. This keeps the GPU busy, but input that is
+   * sampled at the start of the next frame takes longer to reach the screen.
+   */
+  NGF_FRAME_PACING_END_FRAME,
+
+  /**
+   * \ref ngf_begin_frame waits for the GPU to finish the frame submitted
+   * `max_queued_frames` frames earlier. Input sampled after
+   * \ref ngf_begin_frame returns reaches the screen sooner, but the GPU may
+   * idle between frames.
+   */
+  NGF_FRAME_PACING_BEGIN_FRAME
+} ngf_frame_pacing_mode;
+
+/**
+ * Frame pacing settings, see \ref ngf_set_frame_pacing.
+ */
+typedef struct ngf_frame_pacing_info {
+  ngf_frame_pacing_mode mode; /**< Where to wait for the GPU. */
+
+  /**
+   * Maximum number of frames submitted to the GPU and not yet finished by it,
+   * from 1 to \ref NGF_MAX_QUEUED_FRAMES. Lower values trade throughput for
+   * latency. Backends that keep a fixed number of per-frame resources may
+   * impose a lower limit. Ignored in \ref NGF_FRAME_PACING_DEFAULT mode.
+   */
+  uint32_t max_queued_frames;
+} ngf_frame_pacing_info;
+
 typedef struct ngf_cmd_buffer_info {
   uint32_t flags; /**< Reserved for future use. */
 } ngf_cmd_buffer_info;
@@ -1100,13 +1499,18 @@ typedef struct { uintptr_t __handle; } ngf_render_encoder;
  */
 typedef struct { uintptr_t __handle; } ngf_xfer_encoder;
 
-typedef ngf_buffer_info ngf_attrib_buffer_info;
-typedef ngf_buffer_info ngf_index_buffer_info;
-
 /**
- * A vertex attribute buffer.
+ * A compute encoder records compute dispatches into its corresponding command
+ * buffer.
+ * Dispatches recorded within the same encoder may execute concurrently.
+ * Writes performed by them become visible to commands recorded after the
+ * encoder is ended, so dispatches that consume the results of other
+ * dispatches must be recorded in a separate encoder.
  */
-typedef struct ngf_attrib_buffer_t* ngf_attrib_buffer;
+typedef struct { uintptr_t __handle; } ngf_compute_encoder;
+
+typedef ngf_buffer_info ngf_attrib_buffer_info;
+typedef ngf_buffer_info ngf_index_buffer_info;
 
 /**
  * A vertex index buffer.
@@ -1126,6 +1530,26 @@ typedef struct ngf_index_buffer_t* ngf_index_buffer;
  */
 void ngf_set_allocation_callbacks(const ngf_allocation_callbacks *callbacks);
 
+/**
+ * Obtains the amount of host memory that the library has allocated through
+ * the allocation callbacks. Every allocation is counted, regardless of which
+ * callbacks were used to make it.
+ * @param result pointer to a structure that will be populated by this
+ *               function.
+ */
+void ngf_get_allocation_stats(ngf_allocation_stats *result);
+
+/**
+ * Formats the current allocation stats as a human-readable table.
+ * @param buffer the report is written into this buffer, and truncated if it
+ *               doesn't fit. It is always null-terminated, unless
+ *               `buffer_size` is zero.
+ * @param buffer_size size of the buffer in bytes.
+ * @return the length of the full report, not counting the terminating null
+ *  character.
+ */
+size_t ngf_format_allocation_report(char *buffer, size_t buffer_size);
+
 void ngf_debug_message_callback(void *userdata,
                                 void (*callback)(const char*, const void*));
 
@@ -1180,6 +1604,18 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
  */
 void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline p);
 
+/**
+ * Creates a compute pipeline object.
+ * @param info Configuration for the compute pipeline.
+ */
+ngf_error ngf_create_compute_pipeline(const ngf_compute_pipeline_info *info,
+                                      ngf_compute_pipeline *result);
+
+/**
+ * Destroys the given compute pipeline object.
+ */
+void ngf_destroy_compute_pipeline(ngf_compute_pipeline p);
+
 /**
  * Creates a new image object.
  * @param info Configuration of the image.
@@ -1191,6 +1627,48 @@ ngf_error ngf_create_image(const ngf_image_info *info, ngf_image *result);
  */
 void ngf_destroy_image(ngf_image image);
 
+/**
+ * Creates a new, empty pool of transient images.
+ */
+ngf_error ngf_create_transient_pool(ngf_transient_pool *result);
+
+/**
+ * Destroys the given transient pool along with all of its images. Commands
+ * using the images must have finished executing.
+ */
+void ngf_destroy_transient_pool(ngf_transient_pool pool);
+
+/**
+ * Obtains an image from the given pool. Images are shared between requests
+ * with the same configuration whose lifetimes don't overlap, and are kept
+ * around for later frames. On back-ends that support it, images with
+ * different configurations may share device memory, too.
+ *
+ * The contents of a transient image are undefined at its first use, so it
+ * should be attached with NGF_LOAD_OP_CLEAR or NGF_LOAD_OP_DONTCARE. Requests
+ * are best made in the order of their first use. The returned image belongs
+ * to the pool and must not be destroyed by the caller.
+ *
+ * @return Error codes: NGF_ERROR_OUT_OF_BOUNDS if the lifetime ends before it
+ *  starts, NGF_ERROR_OUTOFMEM, NGF_ERROR_IMAGE_CREATION_FAILED
+ */
+ngf_error ngf_acquire_transient_image(ngf_transient_pool pool,
+                                      const ngf_transient_image_info *info,
+                                      ngf_image *result);
+
+/**
+ * Makes all images of the given pool available again, usually once per
+ * frame. Images that haven't been acquired for a few resets, e.g. ones that
+ * no longer match the size of the screen, are destroyed.
+ */
+void ngf_reset_transient_pool(ngf_transient_pool pool);
+
+/**
+ * Reports on the images held by the given pool.
+ */
+void ngf_get_transient_pool_stats(ngf_transient_pool pool,
+                                  ngf_transient_pool_stats *result);
+
 /**
  * Create a sampler object with the given configuration.
  */
@@ -1458,6 +1936,15 @@ ngf_error ngf_cmd_buffer_start_render(ngf_cmd_buffer buf,
 ngf_error ngf_cmd_buffer_start_xfer(ngf_cmd_buffer buf,
                                     ngf_xfer_encoder *enc);
 
+/**
+ * Starts a new encoder for compute commands associated with the given
+ * command buffer.
+ * @param buf The buffer to create the encoder for. Must be in the "ready"
+ *            state, will be transitioned to the "recording" state.
+ */
+ngf_error ngf_cmd_buffer_start_compute(ngf_cmd_buffer buf,
+                                       ngf_compute_encoder *enc);
+
 /**
  * Disposes of the given render cmd encoder, transitioning its corresponding
  * command buffer to the "ready" state.
@@ -1470,6 +1957,12 @@ ngf_error ngf_render_encoder_end(ngf_render_encoder enc);
  */
 ngf_error ngf_xfer_encoder_end(ngf_xfer_encoder enc);
 
+/**
+ * Disposes of the given compute cmd encoder, transitioning its corresponding
+ * command buffer to the "ready" state.
+ */
+ngf_error ngf_compute_encoder_end(ngf_compute_encoder enc);
+
 void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder buf,
                                const ngf_graphics_pipeline pipeline);
 void ngf_cmd_viewport(ngf_render_encoder buf, const ngf_irect2d *r);
@@ -1487,6 +1980,21 @@ void ngf_cmd_blend_factors(ngf_render_encoder buf,
 void ngf_cmd_bind_gfx_resources(ngf_render_encoder buf,
                                 const ngf_resource_bind_op *bind_operations,
                                 uint32_t nbind_operations);
+
+/**
+ * Changes the offsets of the dynamic uniform buffers in a descriptor set,
+ * without rewriting any descriptors.
+ * The set's \ref NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC descriptors must have
+ * been bound earlier on the same command buffer.
+ * @param set index of the descriptor set.
+ * @param offsets offsets, in bytes, added to the offsets that the buffers were
+ *                bound with. There must be one per dynamic uniform buffer in
+ *                the set, in order of increasing binding id, and each must be
+ *                suitably aligned for uniform buffer bindings.
+ * @param noffsets number of elements in `offsets`.
+ */
+void ngf_cmd_set_dynamic_offsets(ngf_render_encoder buf, uint32_t set,
+                                 const uint32_t *offsets, uint32_t noffsets);
 void ngf_cmd_bind_attrib_buffer(ngf_render_encoder buf,
                                 const ngf_attrib_buffer vbuf,
                                 uint32_t binding, uint32_t offset);
@@ -1498,30 +2006,156 @@ void ngf_cmd_end_pass(ngf_render_encoder buf);
 void ngf_cmd_draw(ngf_render_encoder buf, bool indexed,
                   uint32_t first_element, uint32_t nelements,
                   uint32_t ninstances);
+
+/**
+ * Updates a range of the bound graphics pipeline's push constant block.
+ * Unlike uniform buffer updates, this doesn't require binding any resources.
+ * @param data the new contents of the range.
+ * @param offset offset, in bytes, of the range within the block. Must be a
+ *               multiple of 4.
+ * @param size size of the range in bytes. Must be a multiple of 4, and the
+ *             range must fit within the block.
+ */
+void ngf_cmd_push_constants(ngf_render_encoder buf, const void *data,
+                            uint32_t offset, uint32_t size);
+
+/**
+ * Records one or more draws whose arguments are sourced from a buffer.
+ * @param indexed whether to perform indexed draws. The arguments for indexed
+ *                draws are laid out as \ref ngf_draw_indexed_indirect_args,
+ *                and as \ref ngf_draw_indirect_args otherwise.
+ * @param args buffer containing the draw arguments. It must have been created
+ *             with the \ref NGF_BUFFER_USAGE_DRAW_INDIRECT usage flag.
+ * @param offset offset, in bytes, of the first set of arguments within the
+ *               buffer. Must be a multiple of 4.
+ * @param ndraws number of draws to perform. See
+ *               \ref ngf_device_capabilities::multi_draw_indirect.
+ * @param stride distance, in bytes, between consecutive sets of arguments.
+ *               Zero means the arguments are tightly packed.
+ */
+void ngf_cmd_draw_indirect(ngf_render_encoder buf, bool indexed,
+                           const ngf_attrib_buffer args, size_t offset,
+                           uint32_t ndraws, uint32_t stride);
+
+/**
+ * Binds a compute pipeline. Subsequent dispatches recorded into the encoder
+ * use it.
+ */
+void ngf_cmd_bind_compute_pipeline(ngf_compute_encoder enc,
+                                   const ngf_compute_pipeline pipeline);
+
+/**
+ * Binds resources to the bound compute pipeline.
+ * @param bind_operations the resources to bind. Storage images refer to a
+ *                        single mip level of their image.
+ * @param nbind_operations number of elements in `bind_operations`.
+ */
+void ngf_cmd_bind_compute_resources(ngf_compute_encoder enc,
+                                    const ngf_resource_bind_op *bind_operations,
+                                    uint32_t nbind_operations);
+
+/**
+ * Records a dispatch of the bound compute pipeline. Dispatches within the
+ * same compute encoder may execute concurrently. Their writes are visible to
+ * commands recorded after the encoder ends.
+ * @param ngroups_x number of workgroups along the X axis.
+ * @param ngroups_y number of workgroups along the Y axis.
+ * @param ngroups_z number of workgroups along the Z axis.
+ */
+void ngf_cmd_dispatch(ngf_compute_encoder enc, uint32_t ngroups_x,
+                      uint32_t ngroups_y, uint32_t ngroups_z);
+
+/**
+ * Same as \ref ngf_cmd_push_constants, but for the bound compute pipeline.
+ */
+void ngf_cmd_push_compute_constants(ngf_compute_encoder enc, const void *data,
+                                    uint32_t offset, uint32_t size);
+
+/**
+ * Records a dispatch whose workgroup counts are sourced from a buffer.
+ * @param args buffer containing the arguments, laid out as
+ *             \ref ngf_dispatch_indirect_args. It must have been created
+ *             with the \ref NGF_BUFFER_USAGE_DRAW_INDIRECT usage flag.
+ * @param offset offset, in bytes, of the arguments within the buffer. Must be
+ *               a multiple of 4.
+ */
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc,
+                               const ngf_attrib_buffer args, size_t offset);
+
+/**
+ * Copies a range of bytes from one attribute buffer to another.
+ * @param size number of bytes to copy.
+ * @param src_offset offset, in bytes, of the range within `src`.
+ * @param dst_offset offset, in bytes, at which to write within `dst`.
+ */
 void ngf_cmd_copy_attrib_buffer(ngf_xfer_encoder enc,
                                 const ngf_attrib_buffer src,
                                 ngf_attrib_buffer dst,
                                 size_t size,
                                 size_t src_offset,
                                 size_t dst_offset);
+
+/**
+ * Same as \ref ngf_cmd_copy_attrib_buffer, but for index buffers.
+ */
 void ngf_cmd_copy_index_buffer(ngf_xfer_encoder buf,
                                const ngf_index_buffer src,
                                ngf_index_buffer dst,
                                size_t size,
                                size_t src_offset,
                                size_t dst_offset);
+
+/**
+ * Same as \ref ngf_cmd_copy_attrib_buffer, but for uniform buffers.
+ */
 void ngf_cmd_copy_uniform_buffer(ngf_xfer_encoder enc,
                                  const ngf_uniform_buffer src,
                                  ngf_uniform_buffer dst,
                                  size_t size,
                                  size_t src_offset,
                                  size_t dst_offset);
+
+/**
+ * Copies pixel data from a pixel buffer into a region of an image.
+ * @param src_offset offset, in bytes, of the pixel data within `src`.
+ * @param dst the mip level and layer to write to.
+ * @param offset position of the region within the image.
+ * @param extent size of the region.
+ */
 void ngf_cmd_write_image(ngf_xfer_encoder buf,
                          const ngf_pixel_buffer src,
                          size_t src_offset,
                          ngf_image_ref dst,
                          const ngf_offset3d *offset,
                          const ngf_extent3d *extent);
+
+/**
+ * Opens a named debug group. Debug groups show up in graphics debuggers, and
+ * are timed when GPU timing is enabled (see \ref ngf_enable_gpu_timing).
+ * Every debug group must be closed by \ref ngf_cmd_end_debug_group before
+ * the encoder ends.
+ * @param name name of the group. It needs to remain valid until the command
+ *             buffer is submitted.
+ */
+void ngf_cmd_begin_debug_group(ngf_render_encoder buf, const char *name);
+
+/**
+ * Closes the debug group most recently opened with
+ * \ref ngf_cmd_begin_debug_group.
+ */
+void ngf_cmd_end_debug_group(ngf_render_encoder buf);
+
+/**
+ * Same as \ref ngf_cmd_begin_debug_group, but for compute encoders.
+ */
+void ngf_cmd_begin_compute_debug_group(ngf_compute_encoder enc,
+                                       const char *name);
+
+/**
+ * Same as \ref ngf_cmd_end_debug_group, but for compute encoders.
+ */
+void ngf_cmd_end_compute_debug_group(ngf_compute_encoder enc);
+
 /**
  * Initialize Nicegraf.
  * @param dev_pref specifies what type of GPU to prefer. Note that this setting
@@ -1572,6 +2206,17 @@ ngf_error ngf_resize_context(ngf_context ctx,
  */
 ngf_error ngf_set_context(ngf_context ctx);
 
+/**
+ * Obtains the limits and capabilities of the device used by the calling
+ * thread's current context. Allocators and ring buffers should use these
+ * instead of assuming worst-case values.
+ * @param result pointer to a structure that will be populated by this
+ *               function.
+ * @return Error codes: NGF_ERROR_INVALID_CONTEXT if there is no current
+ *  context.
+ */
+ngf_error ngf_get_device_capabilities(ngf_device_capabilities *result);
+
 /**
  * Begin a frame of rendering. This functions starts a frame of rendering in
  * the thread's current context. It acquires an image from the context's
@@ -1587,6 +2232,79 @@ ngf_error ngf_begin_frame();
  * @return Error codes: NGF_ERROR_END_FRAME_FAILED
  */
 ngf_error ngf_end_frame();
+
+/**
+ * Sets how frames are paced on the current context. Contexts start out with
+ * \ref NGF_FRAME_PACING_DEFAULT. The wait time, queue depth and GPU time of
+ * each frame are reported in \ref ngf_frame_stats.
+ * @param info the new frame pacing settings.
+ * @return Error codes: NGF_ERROR_INVALID_CONTEXT, NGF_ERROR_OUT_OF_BOUNDS if
+ *  `max_queued_frames` is out of range.
+ */
+ngf_error ngf_set_frame_pacing(const ngf_frame_pacing_info *info);
+
+/**
+ * Enables or disables GPU timing for the current context. When enabled,
+ * timestamps are written at the start and end of each timing scope in the
+ * submitted command buffers. They are read back a few frames later, once the
+ * GPU is done with them, so timing never stalls the CPU.
+ * @return Error codes: NGF_ERROR_INVALID_CONTEXT, NGF_ERROR_OUTOFMEM,
+ *  NGF_ERROR_INVALID_OPERATION if the backend doesn't support GPU timing.
+ */
+ngf_error ngf_enable_gpu_timing(bool enable);
+
+/**
+ * Obtains the GPU timings of the most recent frame whose timestamps have been
+ * read back.
+ * @param result pointer to a structure that will be populated by this
+ *               function. The scopes it points to are owned by the context,
+ *               and remain valid until the next call to \ref ngf_end_frame.
+ * @return Error codes: NGF_ERROR_INVALID_CONTEXT, NGF_ERROR_NO_FRAME if no
+ *  timings are available yet.
+ */
+ngf_error ngf_get_gpu_frame_timings(ngf_gpu_frame_timings *result);
+
+/**
+ * Obtains the CPU-side counters of the most recently completed frame.
+ * @param result pointer to a structure that will be populated by this
+ *               function.
+ * @return Error codes: NGF_ERROR_NO_FRAME if no frame has been completed yet.
+ */
+ngf_error ngf_get_frame_stats(ngf_frame_stats *result);
+
+/**
+ * Starts writing a timeline of nicegraf's work to a file in the Chrome trace
+ * event format, which can be viewed in chrome://tracing or Perfetto.
+ * The timeline has a track for every thread that calls into nicegraf, with
+ * scopes for pipeline creation, shader compilation, command buffer
+ * submission, waits for the GPU and presentation. While GPU timing is enabled
+ * (see \ref ngf_enable_gpu_timing), the GPU scopes of each frame are placed on
+ * a separate track, once they have been read back.
+ * Scopes are buffered in memory until \ref ngf_flush_timeline_trace is
+ * called. Each thread can buffer a limited number of scopes, and drops the
+ * ones that don't fit.
+ * @param file_path path to the file that the trace gets written to.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if a trace is already
+ *  being written, NGF_ERROR_INITIALIZATION_FAILED if the file couldn't be
+ *  opened.
+ */
+ngf_error ngf_begin_timeline_trace(const char *file_path);
+
+/**
+ * Writes the scopes buffered by all threads to the trace file. Flushing
+ * once per frame is usually enough to keep scopes from getting dropped.
+ * Must not be called from more than one thread at a time.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if no trace is being
+ *  written.
+ */
+ngf_error ngf_flush_timeline_trace();
+
+/**
+ * Flushes the remaining scopes and closes the trace file.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if no trace is being
+ *  written.
+ */
+ngf_error ngf_end_timeline_trace();
 #ifdef _MSC_VER
 #pragma endregion
 #endif
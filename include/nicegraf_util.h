@@ -62,14 +62,14 @@ void ngf_util_create_default_graphics_pipeline_data(
 
 /**
  * Creates a simple pipeline layout with just a single descriptor set.
- * This function allocates memory for the descriptor_set_layout_info and
- * descriptor_info objects, and it is up to the caller to free that memory.
+ * The descriptor_set_layout_info and descriptor_info objects are allocated as
+ * a single block, which the caller must free with
+ * \ref ngf_util_destroy_layout when it is no longer necessary.
  * @param desc pointer to an array of descriptor configurations. All of these
  *  descriptors will be added to the set.
  * @param ndesc number of descriptors in the array.
  * @param result a pointer to a `ngf_pipeline_layout_info` structyre that will
- *               be populated by this function. The descriptor set within it
- *               must be freed by the caller when it is no longer necessary.
+ *               be populated by this function.
  */
 ngf_error ngf_util_create_simple_layout(const ngf_descriptor_info *desc,
                                         uint32_t ndesc,
@@ -77,20 +77,376 @@ ngf_error ngf_util_create_simple_layout(const ngf_descriptor_info *desc,
 
 /**
  * Creates a pipeline layout from shader metadata produced by ngf_shaderc.
- * This function allocates memory for the descriptor_set_layout_info and
- * descriptor_info objects, and it is up to the caller to free that memory.
+ * The descriptor_set_layout_info and descriptor_info objects are allocated as
+ * a single block, which the caller must free with
+ * \ref ngf_util_destroy_layout when it is no longer necessary.
  * @param layout_metadata pointer to pipeline layout metadata obtained from an
  *                        ngf_plmd object.
  * @param result a pointer to a `ngf_pipeline_layout_info` structyre that will
- *               be populated by this function. The descriptor sets within it
- *               must be freed by the caller when it is no longer necessary.
+ *               be populated by this function.
  */
 ngf_error ngf_util_create_pipeline_layout_from_metadata(
     const ngf_plmd_layout *layout_metadata,
     ngf_pipeline_layout_info *result);
 
+/**
+ * Frees the memory allocated by \ref ngf_util_create_simple_layout or
+ * \ref ngf_util_create_pipeline_layout_from_metadata.
+ */
+void ngf_util_destroy_layout(ngf_pipeline_layout_info *layout);
+
+/**
+ * @return the number of bytes of storage required by
+ * \ref ngf_util_create_simple_layout_in_storage.
+ */
+size_t ngf_util_simple_layout_storage_size(uint32_t ndesc);
+
+/**
+ * @return the number of bytes of storage required by
+ * \ref ngf_util_create_pipeline_layout_from_metadata_in_storage.
+ */
+size_t ngf_util_pipeline_layout_storage_size(
+    const ngf_plmd_layout *layout_metadata);
+
+/**
+ * Same as \ref ngf_util_create_simple_layout, but places the descriptor set
+ * and descriptor information into storage provided by the caller (for
+ * example, carved out of an arena) instead of allocating it.
+ * @param storage pointer-aligned storage, at least
+ *                \ref ngf_util_simple_layout_storage_size bytes large.
+ *                It must outlive the layout.
+ */
+void ngf_util_create_simple_layout_in_storage(
+    const ngf_descriptor_info *desc,
+    uint32_t ndesc,
+    void *storage,
+    ngf_pipeline_layout_info *result);
+
+/**
+ * Same as \ref ngf_util_create_pipeline_layout_from_metadata, but places the
+ * descriptor set and descriptor information into storage provided by the
+ * caller instead of allocating it.
+ * @param storage pointer-aligned storage, at least
+ *                \ref ngf_util_pipeline_layout_storage_size bytes large.
+ *                It must outlive the layout. May be NULL if the layout has
+ *                no descriptor sets.
+ */
+void ngf_util_create_pipeline_layout_from_metadata_in_storage(
+    const ngf_plmd_layout *layout_metadata,
+    void *storage,
+    ngf_pipeline_layout_info *result);
+
 const char* ngf_util_get_error_name(const ngf_error err);
 
+/**
+ * Describes how the fields of a draw sort key are laid out. Fields are packed
+ * from the most significant bit down in the following order: pass, pipeline,
+ * material, depth. Draws are emitted in ascending key order, so the fields
+ * placed higher take precedence. The sum of all bit counts may not exceed 64.
+ */
+typedef struct ngf_util_sort_key_layout {
+  uint8_t pass_bits;     /**< Number of bits for the pass index.*/
+  uint8_t pipeline_bits; /**< Number of bits for the pipeline id.*/
+  uint8_t material_bits; /**< Number of bits for the material id.*/
+  uint8_t depth_bits;    /**< Number of bits for the quantized depth.*/
+} ngf_util_sort_key_layout;
+
+/**
+ * Builds a 64-bit sort key according to the given layout. Each value is
+ * truncated to the number of bits allotted to it by the layout. 
+ * @param layout the layout of the key.
+ * @param pass index of the pass that the draw belongs to.
+ * @param pipeline an id for the pipeline used by the draw (it is up to the
+ *                 caller to keep these small and stable).
+ * @param material an id for the set of resources used by the draw.
+ * @param depth quantized view-space depth of the draw. Invert it to get
+ *              back-to-front ordering.
+ */
+uint64_t ngf_util_make_sort_key(const ngf_util_sort_key_layout *layout,
+                                uint32_t pass,
+                                uint32_t pipeline,
+                                uint32_t material,
+                                uint32_t depth);
+
+/**
+ * An attribute buffer to bind for a draw.
+ */
+typedef struct ngf_util_attrib_buffer_bind_op {
+  ngf_attrib_buffer buffer;
+  uint32_t binding;
+  uint32_t offset;
+} ngf_util_attrib_buffer_bind_op;
+
+/**
+ * Everything necessary to record a single draw.
+ */
+typedef struct ngf_util_draw_info {
+  uint64_t sort_key; /**< Draws are emitted in ascending key order. */
+  ngf_graphics_pipeline pipeline; /**< Pipeline to draw with. */
+  const ngf_resource_bind_op *bind_ops; /**< Resources used by the draw. */
+  uint32_t nbind_ops; /**< Number of resource bind operations. */
+  const ngf_util_attrib_buffer_bind_op *attrib_buffers; /**< Vertex data. */
+  uint32_t nattrib_buffers; /**< Number of attribute buffers. */
+  ngf_index_buffer index_buffer; /**< Index buffer, NULL if not indexed. */
+  ngf_type index_type; /**< Type of indices in the index buffer. */
+  uint32_t first_element; /**< Index of the first element to draw. */
+  uint32_t nelements; /**< Number of elements to draw. */
+  uint32_t ninstances; /**< Number of instances to draw. */
+} ngf_util_draw_info;
+
+/**
+ * A draw queue collects draws and records them into a render encoder sorted
+ * by their keys, eliding redundant pipeline and resource binds.
+ */
+typedef struct ngf_util_draw_queue_t* ngf_util_draw_queue;
+
+/**
+ * Creates a new draw queue.
+ * @param capacity_hint the number of draws expected per flush.
+ * @param result the new draw queue will be stored here.
+ */
+ngf_error ngf_util_create_draw_queue(uint32_t capacity_hint,
+                                     ngf_util_draw_queue *result);
+
+/**
+ * Destroys the given draw queue.
+ */
+void ngf_util_destroy_draw_queue(ngf_util_draw_queue queue);
+
+/**
+ * Adds a draw to the queue. The bind operations and attribute buffer
+ * bindings referenced by the draw are copied, so the caller does not have to
+ * keep them alive.
+ */
+ngf_error ngf_util_draw_queue_add(ngf_util_draw_queue queue,
+                                  const ngf_util_draw_info *draw);
+
+/**
+ * Sorts all draws in the queue by their keys and records them into the given
+ * render encoder, which must be within a render pass. Draws with equal keys
+ * retain their submission order. The queue is empty afterwards.
+ */
+void ngf_util_draw_queue_flush(ngf_util_draw_queue queue,
+                               ngf_render_encoder enc);
+
+/**
+ * A render graph records a frame as a sequence of passes that declare the
+ * resources they read and write. Compiling the graph culls passes whose
+ * results are never used, works out when each transient image is needed so
+ * that images can share memory, and batches consecutive compute and transfer
+ * passes into as few encoders as possible (each render pass gets an encoder
+ * of its own). Executing it records the passes into a command buffer in
+ * declaration order.
+ */
+typedef struct ngf_util_render_graph_t* ngf_util_render_graph;
+
+/**
+ * Identifies an image or a buffer within a render graph.
+ */
+typedef uint32_t ngf_util_rg_resource;
+
+/**
+ * Maximum number of attachments of a render graph pass.
+ */
+#define NGF_UTIL_RG_MAX_ATTACHMENTS 8u
+
+/**
+ * Types of render graph passes, which determine the type of encoder that the
+ * pass is recorded into.
+ */
+typedef enum ngf_util_rg_pass_type {
+  NGF_UTIL_RG_PASS_RENDER = 0,
+  NGF_UTIL_RG_PASS_COMPUTE,
+  NGF_UTIL_RG_PASS_XFER
+} ngf_util_rg_pass_type;
+
+/**
+ * An image that a render pass renders to.
+ */
+typedef struct ngf_util_rg_attachment {
+  ngf_util_rg_resource image; /**< Image to render to. */
+  ngf_attachment_type type; /**< Attachment type. */
+
+  /**
+   * What to do with the attachment at the beginning of the pass. Prior
+   * contents are only kept if a previous pass has written to the image.
+   */
+  ngf_attachment_load_op load_op;
+
+  /**
+   * Value to clear the attachment to if `load_op` is NGF_LOAD_OP_CLEAR. The
+   * store operation is derived from whether any later pass uses the image.
+   */
+  ngf_clear clear;
+} ngf_util_rg_attachment;
+
+/**
+ * Callbacks that record the commands of a pass. Transient images can be
+ * looked up with \ref ngf_util_render_graph_get_image from within them.
+ */
+typedef void (*ngf_util_rg_render_fn)(ngf_util_render_graph graph,
+                                      ngf_render_encoder enc,
+                                      void *userdata);
+typedef void (*ngf_util_rg_compute_fn)(ngf_util_render_graph graph,
+                                       ngf_compute_encoder enc,
+                                       void *userdata);
+typedef void (*ngf_util_rg_xfer_fn)(ngf_util_render_graph graph,
+                                    ngf_xfer_encoder enc,
+                                    void *userdata);
+
+/**
+ * Describes a render graph pass. The arrays are copied, so the caller does
+ * not have to keep them alive.
+ */
+typedef struct ngf_util_rg_pass_info {
+  const char *name; /**< Debug group name, may be NULL. Must stay alive. */
+  ngf_util_rg_pass_type type; /**< Type of the pass. */
+  const ngf_util_rg_attachment *attachments; /**< Render pass attachments. */
+  uint32_t nattachments; /**< Number of attachments. */
+
+  /**
+   * Render target to use instead of `attachments`, e.g. the default render
+   * target. Such passes should write to an imported resource standing in for
+   * the render target, or have side effects, so they aren't culled.
+   */
+  ngf_render_target render_target;
+  const ngf_util_rg_resource *reads; /**< Resources read by the pass. */
+  uint32_t nreads; /**< Number of resources read by the pass. */
+
+  /**
+   * Resources written by the pass other than its attachments, e.g. storage
+   * images or the destinations of copies.
+   */
+  const ngf_util_rg_resource *writes;
+  uint32_t nwrites; /**< Number of resources written by the pass. */
+  bool side_effects; /**< If true, the pass is never culled. */
+  ngf_util_rg_render_fn render; /**< Records render passes. */
+  ngf_util_rg_compute_fn compute; /**< Records compute passes. */
+  ngf_util_rg_xfer_fn xfer; /**< Records transfer passes. */
+  void *userdata; /**< Passed to the callback. */
+} ngf_util_rg_pass_info;
+
+/**
+ * Information about the latest compiled render graph.
+ */
+typedef struct ngf_util_rg_stats {
+  uint32_t npasses; /**< Number of passes declared. */
+  uint32_t nculled_passes; /**< Passes that weren't needed. */
+  uint32_t nencoders; /**< Encoders that the remaining passes are batched in.*/
+  uint32_t ntransient_images; /**< Transient images used by the passes. */
+} ngf_util_rg_stats;
+
+/**
+ * Outcome of compiling a single pass of a render graph.
+ */
+typedef struct ngf_util_rg_compiled_pass {
+  bool culled; /**< Whether the pass was culled. */
+  bool new_encoder; /**< Whether the pass starts a new encoder. */
+
+  /**
+   * Load operations used for the attachments. Prior contents of transient
+   * images aren't loaded if no earlier pass has written to them.
+   */
+  ngf_attachment_load_op load_ops[NGF_UTIL_RG_MAX_ATTACHMENTS];
+
+  /**
+   * Store operations used for the attachments. Contents of transient images
+   * aren't stored if no later pass uses them.
+   */
+  ngf_attachment_store_op store_ops[NGF_UTIL_RG_MAX_ATTACHMENTS];
+} ngf_util_rg_compiled_pass;
+
+/**
+ * Creates a new, empty render graph. Transient images and render targets are
+ * kept by the graph from one execution to the next.
+ */
+ngf_error ngf_util_create_render_graph(ngf_util_render_graph *result);
+
+/**
+ * Destroys the given render graph, along with its transient images and render
+ * targets. Commands using them must have finished executing.
+ */
+void ngf_util_destroy_render_graph(ngf_util_render_graph graph);
+
+/**
+ * Removes all passes and resources from the graph, so that the next frame
+ * can be declared.
+ */
+void ngf_util_render_graph_reset(ngf_util_render_graph graph);
+
+/**
+ * Declares a transient image, which only lives within the graph. Its
+ * contents are undefined before the first pass that writes to it.
+ */
+ngf_util_rg_resource ngf_util_render_graph_create_image(
+    ngf_util_render_graph graph,
+    const ngf_image_info *info);
+
+/**
+ * Declares an image or a buffer that lives outside of the graph. Passes that
+ * write to imported resources are never culled.
+ * @param handle The image or buffer. May be NULL for resources that only
+ *  stand in for something, e.g. the default render target.
+ */
+ngf_util_rg_resource ngf_util_render_graph_import(ngf_util_render_graph graph,
+                                                  const void *handle);
+
+/**
+ * Adds a pass to the graph. Passes execute in the order they are added, so
+ * passes have to be added after the passes producing their inputs.
+ */
+ngf_error ngf_util_render_graph_add_pass(ngf_util_render_graph graph,
+                                         const ngf_util_rg_pass_info *info);
+
+/**
+ * Compiles the graph for execution.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if a pass reads a
+ *  transient image that no earlier pass has written to,
+ *  NGF_ERROR_OUT_OF_BOUNDS if a pass refers to an unknown resource or has too
+ *  many attachments.
+ */
+ngf_error ngf_util_render_graph_compile(ngf_util_render_graph graph,
+                                        ngf_util_rg_stats *stats);
+
+/**
+ * Records the passes of the compiled graph into the given command buffer,
+ * which must be ready for recording. Must be called once per frame at most,
+ * since transient images are reused in later frames.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if the graph hasn't been
+ *  compiled, errors from creating images, render targets and encoders.
+ */
+ngf_error ngf_util_render_graph_execute(ngf_util_render_graph graph,
+                                        ngf_cmd_buffer cmd_buf);
+
+/**
+ * Retrieves how the pass with the given index (in the order the passes were
+ * added) has been compiled. Operations of culled passes are left zeroed.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if the graph hasn't been
+ *  compiled, NGF_ERROR_OUT_OF_BOUNDS if there's no such pass.
+ */
+ngf_error ngf_util_render_graph_get_compiled_pass(
+    ngf_util_render_graph      graph,
+    uint32_t                   pass_index,
+    ngf_util_rg_compiled_pass *result);
+
+/**
+ * Retrieves the indices of the first and the last pass using the given
+ * resource. Both are ~0u if no pass that hasn't been culled uses it.
+ * @return Error codes: NGF_ERROR_INVALID_OPERATION if the graph hasn't been
+ *  compiled, NGF_ERROR_OUT_OF_BOUNDS if there's no such resource.
+ */
+ngf_error ngf_util_render_graph_get_lifetime(ngf_util_render_graph graph,
+                                             ngf_util_rg_resource  resource,
+                                             uint32_t             *first_use,
+                                             uint32_t             *last_use);
+
+/**
+ * Looks up the image behind a resource. For transient images, this only
+ * works while the graph is executing.
+ */
+ngf_image ngf_util_render_graph_get_image(ngf_util_render_graph graph,
+                                          ngf_util_rg_resource resource);
+
 #ifdef __cplusplus
 }
 #endif
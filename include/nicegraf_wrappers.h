@@ -22,11 +22,13 @@
 #pragma once
 
 #include "nicegraf.h"
+#include <numeric>
 #include <optional>
 #include <string.h>
 #include <tuple>
 #include <utility>
 #include <queue>
+#include <vector>
 
 namespace ngf {
 
@@ -95,6 +97,7 @@ private:
 
 NGF_DEFINE_WRAPPER_TYPE(shader_stage);
 NGF_DEFINE_WRAPPER_TYPE(graphics_pipeline);
+NGF_DEFINE_WRAPPER_TYPE(compute_pipeline);
 NGF_DEFINE_WRAPPER_TYPE(image);
 NGF_DEFINE_WRAPPER_TYPE(sampler);
 NGF_DEFINE_WRAPPER_TYPE(render_target);
@@ -158,6 +161,33 @@ private:
   ngf_xfer_encoder enc_;
 };
 
+class compute_encoder {
+public:
+  explicit compute_encoder(ngf_cmd_buffer cmd_buf) {
+    ngf_cmd_buffer_start_compute(cmd_buf, &enc_);
+  }
+
+  ~compute_encoder() { ngf_compute_encoder_end(enc_); }
+
+  compute_encoder(compute_encoder &&other) {
+    *this = std::move(other);
+  }
+
+  compute_encoder& operator=(compute_encoder &&other) {
+    enc_ = other.enc_;
+    other.enc_.__handle = 0u;
+    return *this;
+  }
+
+  compute_encoder(const compute_encoder&) = delete;
+  compute_encoder& operator=(const compute_encoder&) = delete;
+
+  operator ngf_compute_encoder() { return enc_; }
+
+private:
+  ngf_compute_encoder enc_;
+};
+
 template <uint32_t S>
 struct descriptor_set {
   template <uint32_t B>
@@ -183,6 +213,15 @@ struct descriptor_set {
       return op;
     }
 
+    static ngf_resource_bind_op dynamic_uniform_buffer(
+        const ngf_uniform_buffer buf,
+        size_t offset,
+        size_t range) {
+      ngf_resource_bind_op op = uniform_buffer(buf, offset, range);
+      op.type = NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC;
+      return op;
+    }
+
     static ngf_resource_bind_op sampler(const ngf_sampler sampler) {
       ngf_resource_bind_op op;
       op.type = NGF_DESCRIPTOR_SAMPLER;
@@ -203,6 +242,27 @@ struct descriptor_set {
       op.info.image_sampler.sampler = sampler;
       return op;
     }
+
+    static ngf_resource_bind_op storage_buffer(const ngf_attrib_buffer buf,
+                                               size_t offset, size_t range) {
+      ngf_resource_bind_op op;
+      op.type = NGF_DESCRIPTOR_STORAGE_BUFFER;
+      op.target_binding = B;
+      op.target_set = S;
+      op.info.storage_buffer.buffer = buf;
+      op.info.storage_buffer.offset = offset;
+      op.info.storage_buffer.range = range;
+      return op;
+    }
+
+    static ngf_resource_bind_op storage_image(const ngf_image_ref &image) {
+      ngf_resource_bind_op op;
+      op.type = NGF_DESCRIPTOR_STORAGE_IMAGE;
+      op.target_binding = B;
+      op.target_set = S;
+      op.info.storage_image = image;
+      return op;
+    }
   };
 };
 
@@ -212,6 +272,13 @@ void cmd_bind_resources(ngf_render_encoder enc, const Args&&... args) {
   ngf_cmd_bind_gfx_resources(enc, ops, sizeof(ops)/sizeof(ngf_resource_bind_op));
 }
 
+template <class ...Args>
+void cmd_bind_resources(ngf_compute_encoder enc, const Args&&... args) {
+  const ngf_resource_bind_op ops[] = { args... };
+  ngf_cmd_bind_compute_resources(enc, ops,
+                                 sizeof(ops)/sizeof(ngf_resource_bind_op));
+}
+
 inline void* buffer_map_range(ngf_attrib_buffer buf,
                               size_t offset,
                               size_t size,
@@ -351,13 +418,46 @@ inline ngf_image_ref image_ref(const ngf_image img, uint32_t mip,
   };
 }
 
+template <class ...Args>
+void cmd_set_dynamic_offsets(ngf_render_encoder enc, uint32_t set,
+                             Args... offsets) {
+  const uint32_t offsets_array[] = { static_cast<uint32_t>(offsets)... };
+  ngf_cmd_set_dynamic_offsets(enc, set, offsets_array,
+                              (uint32_t)(sizeof(offsets_array) /
+                                         sizeof(uint32_t)));
+}
+
+/**
+ * @return the optimal copy offset alignment of the current context's device,
+ *         or a conservative 256 bytes if it can't be queried.
+ */
+inline size_t optimal_copy_offset_alignment() {
+  ngf_device_capabilities caps;
+  return ngf_get_device_capabilities(&caps) == NGF_ERROR_OK
+             ? caps.optimal_copy_offset_alignment
+             : 256u;
+}
+
+/**
+ * @return the uniform buffer offset alignment of the current context's device,
+ *         or a conservative 256 bytes if it can't be queried.
+ */
+inline size_t uniform_buffer_offset_alignment() {
+  ngf_device_capabilities caps;
+  return ngf_get_device_capabilities(&caps) == NGF_ERROR_OK
+             ? caps.uniform_buffer_offset_alignment
+             : 256u;
+}
+
 /**
  * A convenience class for streaming uniform data.
+ * If the target descriptor is a dynamic uniform buffer, bind the result of
+ * `bind_op` once, and after each write only update the offset with
+ * `dynamic_offset`, which avoids rewriting descriptors on every draw.
+ * Otherwise, bind the result of `bind_op_at_current_offset` after each write.
  */
 template <typename T>
 class streamed_uniform {
-  // TODO: replace 256 with real alignment
-  static constexpr uint32_t ALIGNED_SIZE = sizeof(T) + (256u - sizeof(T)%256u);
 public:
   streamed_uniform() = default;
   streamed_uniform(streamed_uniform &&other) { *this = std::move(other); }
@@ -371,6 +471,8 @@ public:
     other.current_offset_ = 0u;
     nframes_ = other.nframes_;
     other.nframes_ = 0u;
+    aligned_size_ = other.aligned_size_;
+    other.aligned_size_ = 0u;
     return *this;
   }
 
@@ -378,8 +480,11 @@ public:
 
   static std::tuple<std::optional<streamed_uniform>, ngf_error> create(
       const uint32_t frames) {
+    const size_t alignment = uniform_buffer_offset_alignment();
+    const size_t aligned_size =
+        (sizeof(T) + alignment - 1u) & ~(alignment - 1u);
     const ngf_buffer_info buffer_info = {
-      ALIGNED_SIZE * frames,
+      aligned_size * frames,
       NGF_BUFFER_STORAGE_HOST_READABLE_WRITEABLE,
       0
     };
@@ -388,25 +493,39 @@ public:
     if (err != NGF_ERROR_OK) {
       return std::make_tuple(std::nullopt, err);
     }
-    return std::make_tuple(streamed_uniform(std::move(buf), frames), err);
+    return std::make_tuple(
+        streamed_uniform(std::move(buf), frames, aligned_size), err);
   }
 
   void write(const T &data) {
-    current_offset_ = (frame_) * ALIGNED_SIZE;
+    current_offset_ = (frame_) * aligned_size_;
     const uint32_t flags =
       (current_offset_ == 0u)
           ? (NGF_BUFFER_MAP_WRITE_BIT | NGF_BUFFER_MAP_DISCARD_BIT)
           :  NGF_BUFFER_MAP_WRITE_BIT;
     void *mapped_buf = ngf_uniform_buffer_map_range(buf_.get(),
                                                     current_offset_,
-                                                    ALIGNED_SIZE,
+                                                    aligned_size_,
                                                     flags);
     memcpy(mapped_buf, (void*)&data, sizeof(T));
-    ngf_uniform_buffer_flush_range(buf_.get(), 0, ALIGNED_SIZE);
+    ngf_uniform_buffer_flush_range(buf_.get(), 0, aligned_size_);
     ngf_uniform_buffer_unmap(buf_.get());
     frame_ = (frame_ + 1u) % nframes_;
   }
 
+  ngf_resource_bind_op bind_op(uint32_t set, uint32_t binding) const {
+    ngf_resource_bind_op op;
+    op.type = NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC;
+    op.target_binding = binding;
+    op.target_set = set;
+    op.info.uniform_buffer.buffer = buf_.get();
+    op.info.uniform_buffer.offset = 0u;
+    op.info.uniform_buffer.range = aligned_size_;
+    return op;
+  }
+
+  uint32_t dynamic_offset() const { return (uint32_t)current_offset_; }
+
   ngf_resource_bind_op bind_op_at_current_offset(
       uint32_t set,
       uint32_t binding,
@@ -418,26 +537,307 @@ public:
     op.target_set = set;
     op.info.uniform_buffer.buffer = buf_.get();
     op.info.uniform_buffer.offset = current_offset_ + additional_offset;
-    op.info.uniform_buffer.range = (range == 0) ? ALIGNED_SIZE : range;
+    op.info.uniform_buffer.range = (range == 0) ? aligned_size_ : range;
     return op;
   }
 
 private:
-  streamed_uniform(ngf::uniform_buffer buf, uint32_t nframes) :
+  streamed_uniform(ngf::uniform_buffer buf, uint32_t nframes,
+                   size_t aligned_size) :
     buf_(std::move(buf)),
     frame_(0u),
     current_offset_(0u),
-    nframes_(nframes) {}
+    nframes_(nframes),
+    aligned_size_(aligned_size) {}
 
   uniform_buffer buf_;
   uint32_t frame_;
   size_t current_offset_;
   uint32_t nframes_;
+  size_t aligned_size_;
+};
+
+/**
+ * A convenience class for streaming many blocks of uniform data per frame.
+ * The arena is made up of one region per frame in flight. Between
+ * `begin_frame` and `end_frame`, the current frame's region stays mapped, and
+ * `allocate` hands out sub-allocations from it, aligned to the device's
+ * uniform buffer offset alignment. A frame's uniform data therefore costs a
+ * single map, no matter how many blocks are allocated.
+ * `end_frame` must be called before submitting any commands that read the
+ * allocations.
+ */
+class streamed_uniform_arena {
+public:
+  /**
+   * A sub-allocation made from the arena.
+   */
+  struct allocation {
+    void              *data;   /**< Host pointer to write the data to. */
+    ngf_uniform_buffer buffer; /**< The buffer backing the allocation. */
+    size_t             offset; /**< Offset of the allocation in `buffer`. */
+    size_t             size;   /**< Size of the allocation in bytes. */
+
+    /**
+     * @return a bind operation binding this allocation to a
+     *         \ref NGF_DESCRIPTOR_UNIFORM_BUFFER descriptor.
+     */
+    ngf_resource_bind_op bind_op(uint32_t set, uint32_t binding) const {
+      ngf_resource_bind_op op;
+      op.type = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+      op.target_binding = binding;
+      op.target_set = set;
+      op.info.uniform_buffer.buffer = buffer;
+      op.info.uniform_buffer.offset = offset;
+      op.info.uniform_buffer.range = size;
+      return op;
+    }
+
+    /**
+     * @return the offset to pass to \ref ngf_cmd_set_dynamic_offsets when the
+     *         descriptor was bound with \ref streamed_uniform_arena::bind_op.
+     */
+    uint32_t dynamic_offset() const { return (uint32_t)offset; }
+  };
+
+  streamed_uniform_arena() = default;
+  streamed_uniform_arena(streamed_uniform_arena &&other) {
+    *this = std::move(other);
+  }
+  streamed_uniform_arena(const streamed_uniform_arena&) = delete;
+
+  streamed_uniform_arena& operator=(streamed_uniform_arena &&other) {
+    buf_ = std::move(other.buf_);
+    mapped_ = other.mapped_;
+    other.mapped_ = nullptr;
+    frame_capacity_ = other.frame_capacity_;
+    alignment_ = other.alignment_;
+    nframes_ = other.nframes_;
+    frame_ = other.frame_;
+    used_ = other.used_;
+    other.frame_capacity_ = other.used_ = 0u;
+    other.nframes_ = other.frame_ = 0u;
+    return *this;
+  }
+
+  streamed_uniform_arena& operator=(const streamed_uniform_arena&) = delete;
+
+  ~streamed_uniform_arena() { end_frame(); }
+
+  /**
+   * Creates a new arena.
+   * @param frame_capacity number of bytes that may be allocated per frame.
+   * @param nframes number of frames in flight.
+   * @param alignment alignment of each allocation. This must be a power of two
+   *                  and a multiple of the device's uniform buffer offset
+   *                  alignment. If zero, the device's uniform buffer offset
+   *                  alignment is used.
+   */
+  static std::tuple<std::optional<streamed_uniform_arena>, ngf_error> create(
+      size_t   frame_capacity,
+      uint32_t nframes,
+      size_t   alignment = 0u) {
+    if (alignment == 0u) alignment = uniform_buffer_offset_alignment();
+    frame_capacity = (frame_capacity + alignment - 1u) & ~(alignment - 1u);
+    const ngf_buffer_info buffer_info = {
+      frame_capacity * nframes,
+      NGF_BUFFER_STORAGE_HOST_READABLE_WRITEABLE,
+      0
+    };
+    ngf::uniform_buffer buf;
+    ngf_error err = buf.initialize(buffer_info);
+    if (err != NGF_ERROR_OK) {
+      return std::make_tuple(std::nullopt, err);
+    }
+    return std::make_tuple(
+        streamed_uniform_arena(std::move(buf), frame_capacity, nframes,
+                               alignment),
+        err);
+  }
+
+  /**
+   * Moves on to the next frame's region and maps it. All allocations made
+   * within that region during earlier frames become invalid.
+   */
+  ngf_error begin_frame() {
+    end_frame();
+    frame_ = (frame_ + 1u) % nframes_;
+    used_ = 0u;
+    mapped_ = (uint8_t*)ngf_uniform_buffer_map_range(buf_.get(),
+                                                     frame_ * frame_capacity_,
+                                                     frame_capacity_,
+                                                     NGF_BUFFER_MAP_WRITE_BIT);
+    return mapped_ == nullptr ? NGF_ERROR_INVALID_OPERATION
+                              : NGF_ERROR_OK;
+  }
+
+  /**
+   * Flushes the data written during the current frame and unmaps the
+   * current frame's region.
+   */
+  void end_frame() {
+    if (mapped_ != nullptr) {
+      if (used_ > 0u) ngf_uniform_buffer_flush_range(buf_.get(), 0, used_);
+      ngf_uniform_buffer_unmap(buf_.get());
+      mapped_ = nullptr;
+    }
+  }
+
+  /**
+   * Allocates `size` bytes from the current frame's region.
+   * @return the allocation, or an allocation with null `data` if the region
+   *         is exhausted or not mapped.
+   */
+  allocation allocate(size_t size) {
+    const size_t offset = (used_ + alignment_ - 1u) & ~(alignment_ - 1u);
+    if (mapped_ == nullptr || offset + size > frame_capacity_) {
+      return allocation { nullptr, buf_.get(), 0u, 0u };
+    }
+    used_ = offset + size;
+    return allocation {
+      mapped_ + offset,
+      buf_.get(),
+      frame_ * frame_capacity_ + offset,
+      size
+    };
+  }
+
+  /**
+   * Allocates space for `data` from the current frame's region and copies it
+   * there.
+   */
+  template <typename T>
+  allocation push(const T &data) {
+    allocation a = allocate(sizeof(T));
+    if (a.data != nullptr) memcpy(a.data, &data, sizeof(T));
+    return a;
+  }
+
+  /**
+   * @return a bind operation binding the arena to a
+   *         \ref NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC descriptor. Each
+   *         allocation of at most `range` bytes can then be selected with its
+   *         `dynamic_offset`.
+   */
+  ngf_resource_bind_op bind_op(uint32_t set, uint32_t binding,
+                               size_t range) const {
+    ngf_resource_bind_op op;
+    op.type = NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC;
+    op.target_binding = binding;
+    op.target_set = set;
+    op.info.uniform_buffer.buffer = buf_.get();
+    op.info.uniform_buffer.offset = 0u;
+    op.info.uniform_buffer.range = range;
+    return op;
+  }
+
+private:
+  streamed_uniform_arena(ngf::uniform_buffer buf,
+                         size_t frame_capacity,
+                         uint32_t nframes,
+                         size_t alignment) :
+    buf_(std::move(buf)),
+    frame_capacity_(frame_capacity),
+    alignment_(alignment),
+    nframes_(nframes),
+    frame_(nframes - 1u) {}
+
+  uniform_buffer buf_;
+  uint8_t *mapped_ = nullptr;
+  size_t frame_capacity_ = 0u;
+  size_t alignment_ = 256u;
+  uint32_t nframes_ = 0u;
+  uint32_t frame_ = 0u;
+  size_t used_ = 0u;
 };
 
-// This is a helper for disposing of staging buffers at an appropriate time.
-// After a buffer is enqueued, it will be destroyed once it is no
-// longer needed.
+// Sub-allocates upload regions from one host-writeable buffer per in-flight
+// frame. A frame's buffer is only reused after `next_frame` has been called
+// enough times for the frame that last wrote to it to retire, so writes never
+// have to wait for the GPU, and no buffers are created or destroyed in the
+// steady state. Regions are aligned to the device's optimal copy offset
+// alignment, which is queried when the first region is written.
+template <class BufferT>
+class staging_ring {
+public:
+  using handle_type = decltype(std::declval<BufferT>().get());
+
+  struct region {
+    handle_type buffer;
+    size_t      offset;
+  };
+
+  staging_ring(uint32_t nframes, size_t capacity) :
+    slots_(nframes > 0u ? nframes : 1u),
+    capacity_(capacity) {}
+
+  // Copies `size` bytes of `data` into the current frame's buffer. The region
+  // starts at a multiple of both the copy offset alignment and `granularity`.
+  // Returns false if the region doesn't fit, in which case the caller has to
+  // stage the data some other way.
+  bool write(const void *data, size_t size, region &result,
+             size_t granularity = 1u) {
+    slot &s = slots_[current_slot_];
+    if (alignment_ == 0u) alignment_ = optimal_copy_offset_alignment();
+    const size_t alignment = std::lcm(alignment_, granularity);
+    const size_t offset = (s.used + alignment - 1u) / alignment * alignment;
+    if (size == 0u || offset + size > capacity_) return false;
+    if (s.buffer.get() == nullptr) {
+      if (s.buffer.initialize(info(capacity_, (typename BufferT::init_type*)0))
+          != NGF_ERROR_OK) {
+        return false;
+      }
+    }
+    void *mapped = buffer_map_range(s.buffer.get(), offset, size,
+                                    NGF_BUFFER_MAP_WRITE_BIT);
+    if (mapped == nullptr) return false;
+    memcpy(mapped, data, size);
+    buffer_flush_range(s.buffer.get(), 0, size);
+    buffer_unmap(s.buffer.get());
+    s.used = offset + size;
+    result.buffer = s.buffer.get();
+    result.offset = offset;
+    return true;
+  }
+
+  // Moves on to the next frame's buffer, recycling all of its regions.
+  void next_frame() {
+    current_slot_ = (current_slot_ + 1u) % (uint32_t)slots_.size();
+    slots_[current_slot_].used = 0u;
+  }
+
+private:
+  struct slot {
+    BufferT buffer;
+    size_t  used = 0u;
+  };
+
+  static ngf_buffer_info info(size_t size, ngf_buffer_info*) {
+    return ngf_buffer_info {
+      size,
+      NGF_BUFFER_STORAGE_HOST_WRITEABLE,
+      NGF_BUFFER_USAGE_XFER_SRC
+    };
+  }
+
+  static ngf_pixel_buffer_info info(size_t size, ngf_pixel_buffer_info*) {
+    return ngf_pixel_buffer_info {
+      size,
+      NGF_PIXEL_BUFFER_USAGE_WRITE
+    };
+  }
+
+  std::vector<slot> slots_;
+  size_t capacity_;
+  size_t alignment_ = 0u;
+  uint32_t current_slot_ = 0u;
+};
+
+// This is a helper for staging uploads and disposing of staging buffers at an
+// appropriate time.
+// Uploads are sub-allocated from per-frame staging rings. Uploads that don't
+// fit into a ring get a dedicated staging buffer which is destroyed once it is
+// no longer needed, as are buffers passed to `enqueue`.
 class resource_dispose_queue {
   template <class ResHandleType>
   struct entry {
@@ -445,15 +845,33 @@ class resource_dispose_queue {
     ResHandleType handle;
   };
 public:
+  static constexpr uint32_t DEFAULT_MAX_INFLIGHT_FRAMES = 3u;
+  static constexpr size_t DEFAULT_STAGING_CAPACITY = 4u * 1024u * 1024u;
+
+  // `max_inflight_frames` is the number of calls to `update` after which the
+  // GPU is guaranteed to have finished consuming a frame's uploads.
+  // `staging_capacity` is the size of each frame's staging buffer, allocated
+  // lazily per buffer type on first use.
+  explicit resource_dispose_queue(
+      uint32_t max_inflight_frames = DEFAULT_MAX_INFLIGHT_FRAMES,
+      size_t   staging_capacity = DEFAULT_STAGING_CAPACITY) :
+    idx_staging_(max_inflight_frames, staging_capacity),
+    attr_staging_(max_inflight_frames, staging_capacity),
+    uniform_staging_(max_inflight_frames, staging_capacity),
+    pixel_staging_(max_inflight_frames, staging_capacity) {}
 
   // Disposes of previously enqueued buffers that are no longer needed by
-  // any commands.
+  // any commands, and moves on to the next frame's staging buffers.
   // Do not call this more than once per frame.
   void update() {
     update_queue(idx_buf_queue_);
     update_queue(attr_buf_queue_);
     update_queue(uniform_buf_queue_);
     update_queue(pixel_buf_queue_);
+    idx_staging_.next_frame();
+    attr_staging_.next_frame();
+    uniform_staging_.next_frame();
+    pixel_staging_.next_frame();
     frame_++;
   }
 
@@ -480,6 +898,16 @@ public:
                          size_t           source_size,
                          size_t           source_offset,
                          size_t           target_offset) {
+    typename staging_ring<T>::region staged;
+    if (staging(target_buffer).write(source_data, source_size, staged)) {
+      cmd_copy_buffer(enc,
+                      staged.buffer,
+                      target_buffer.get(),
+                      source_size,
+                      staged.offset + source_offset,
+                      target_offset);
+      return NGF_ERROR_OK;
+    }
     ngf_buffer_info staging_buffer_info {
       source_size,
       NGF_BUFFER_STORAGE_HOST_WRITEABLE,
@@ -512,6 +940,21 @@ public:
                         ngf_image_ref   target,
                         ngf_offset3d    target_offset,
                         ngf_extent3d    target_extent) {
+    // Image copies need source offsets that are a multiple of the texel size.
+    // The texel sizes of all image formats (1, 2, 3, 4, 6, 8, 12 and 16 bytes)
+    // divide 48, so a multiple of it works for any target image.
+    constexpr size_t TEXEL_SIZE_MULTIPLE = 48u;
+    staging_ring<pixel_buffer>::region staged;
+    if (pixel_staging_.write(source_data, source_size, staged,
+                             TEXEL_SIZE_MULTIPLE)) {
+      ngf_cmd_write_image(enc,
+                          staged.buffer,
+                          staged.offset + source_offset,
+                          target,
+                         &target_offset,
+                         &target_extent);
+      return NGF_ERROR_OK;
+    }
     const ngf_pixel_buffer_info staging_buffer_info {
       source_size,
       NGF_PIXEL_BUFFER_USAGE_WRITE
@@ -548,10 +991,20 @@ private:
     }
   }
 
+  staging_ring<index_buffer>& staging(index_buffer&) { return idx_staging_; }
+  staging_ring<attrib_buffer>& staging(attrib_buffer&) { return attr_staging_; }
+  staging_ring<uniform_buffer>& staging(uniform_buffer&) {
+    return uniform_staging_;
+  }
+
   std::queue<entry<index_buffer>> idx_buf_queue_;
   std::queue<entry<attrib_buffer>> attr_buf_queue_;
   std::queue<entry<uniform_buffer>> uniform_buf_queue_;
   std::queue<entry<pixel_buffer>> pixel_buf_queue_;
+  staging_ring<index_buffer> idx_staging_;
+  staging_ring<attrib_buffer> attr_staging_;
+  staging_ring<uniform_buffer> uniform_staging_;
+  staging_ring<pixel_buffer> pixel_staging_;
   uint32_t frame_ = 0u;
 };
 
@@ -22,6 +22,21 @@ SOFTWARE.
 #include <stdint.h>
 #include <stdlib.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Dynamic array storage goes through the user-provided allocation callbacks
+// and is counted under NGF_ALLOCATION_DYNAMIC_ARRAY.
+void* _ngf_darray_alloc(size_t elem_size, uint32_t capacity);
+void* _ngf_darray_realloc(void    *data,
+                          size_t   elem_size,
+                          uint32_t old_capacity,
+                          uint32_t new_capacity);
+void _ngf_darray_free(void *data, size_t elem_size, uint32_t capacity);
+#ifdef __cplusplus
+}
+#endif
+
 #define _NGF_DARRAY_OF(type) struct  { \
   type *data; \
   type *endptr; \
@@ -33,21 +48,23 @@ SOFTWARE.
 #endif
 
 #define _NGF_DARRAY_RESET(a, c) { \
-  a.data = (decltype(a.data))malloc(sizeof(a.data[0]) * c); \
+  a.data = (decltype(a.data))_ngf_darray_alloc(sizeof(a.data[0]), c); \
   a.endptr = a.data; \
   a.capacity = c; \
 }
 
 #define _NGF_DARRAY_DESTROY(a) if(a.data != NULL) { \
-  free(a.data); \
+  _ngf_darray_free(a.data, sizeof(a.data[0]), a.capacity); \
   a.data = a.endptr = NULL; \
 }
 
 #define _NGF_DARRAY_APPEND(a, v) { \
   ptrdiff_t cur_size = a.endptr - a.data; \
   if (cur_size >= a.capacity) { \
+    uint32_t old_capacity = a.capacity; \
     a.capacity <<= 1u; \
-    decltype(a.data) tmp = (decltype(a.data)) realloc(a.data, sizeof(a.data[0]) * a.capacity); \
+    decltype(a.data) tmp = (decltype(a.data)) _ngf_darray_realloc( \
+        a.data, sizeof(a.data[0]), old_capacity, a.capacity); \
     assert(tmp != NULL); \
     a.data = tmp; \
     a.endptr = &a.data[cur_size]; \
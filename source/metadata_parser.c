@@ -37,6 +37,22 @@ static const ngf_plmd_alloc_callbacks stdlib_alloc = {
   .free = free
 };
 
+static const uint32_t START_OF_RAW_BYTE_BLOCK = 0xffffffff;
+static const uint32_t MAGIC_NUMBER = 0xdeadbeef;
+static const uint32_t SWAPPED_MAGIC_NUMBER = 0xefbeadde;
+static const uint32_t ARCHIVE_MAGIC_NUMBER = 0xdeadbabe;
+static const uint32_t ARCHIVE_VERSION = 1u;
+
+// Slot of the open-addressing hash index over user metadata keys.
+typedef struct _user_index_slot {
+  uint32_t hash;
+  uint32_t entry; // index of the entry plus one, zero for empty slots.
+} _user_index_slot;
+
+// Metadata with at most this many user entries doesn't get a hash index, a
+// linear scan is just as fast for it.
+#define _MAX_UNINDEXED_USER_ENTRIES 8u
+
 struct ngf_plmd {
   uint8_t *raw_data;
   const ngf_plmd_header *header;
@@ -44,8 +60,41 @@ struct ngf_plmd {
   ngf_plmd_cis_map images_to_cis_map;
   ngf_plmd_cis_map samplers_to_cis_map;
   ngf_plmd_user user;
+  _user_index_slot *user_index;
+  uint32_t user_index_mask;
 };
 
+static uint32_t _hash_string(const char *str) {
+  uint32_t hash = 2166136261u;
+  for (const uint8_t *c = (const uint8_t*)str; *c != '\0'; ++c) {
+    hash = (hash ^ *c) * 16777619u;
+  }
+  return hash;
+}
+
+static ngf_plmd_error _create_user_index(const ngf_plmd_alloc_callbacks *cb,
+                                         ngf_plmd *meta) {
+  // Keep the load factor at or below one half.
+  uint32_t nslots = 1u;
+  while (nslots < 2u * meta->user.nentries) nslots <<= 1u;
+  meta->user_index = cb->alloc(sizeof(_user_index_slot) * nslots);
+  if (meta->user_index == NULL) {
+    return NGF_PLMD_ERROR_OUTOFMEM;
+  }
+  memset(meta->user_index, 0, sizeof(_user_index_slot) * nslots);
+  meta->user_index_mask = nslots - 1u;
+  for (uint32_t e = 0u; e < meta->user.nentries; ++e) {
+    const uint32_t hash = _hash_string(meta->user.entries[e].key);
+    uint32_t slot = hash & meta->user_index_mask;
+    while (meta->user_index[slot].entry != 0u) {
+      slot = (slot + 1u) & meta->user_index_mask;
+    }
+    meta->user_index[slot].hash = hash;
+    meta->user_index[slot].entry = e + 1u;
+  }
+  return NGF_PLMD_ERROR_OK;
+}
+
 static ngf_plmd_error _create_cis_map(uint8_t *ptr,
                                   const ngf_plmd_alloc_callbacks *cb,
                                   ngf_plmd_cis_map *map) {
@@ -65,12 +114,90 @@ static ngf_plmd_error _create_cis_map(uint8_t *ptr,
   return NGF_PLMD_ERROR_OK;
 }
 
+// Metadata files are written in network byte order, but may have been
+// converted to host byte order already (or written in it to begin with).
+// The magic number tells which one it is.
+static ngf_plmd_error _check_byte_order(const uint32_t *fields,
+                                        uint32_t nfields,
+                                        bool *needs_conversion) {
+  if (nfields == 0u) {
+    return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  }
+  if (fields[0] == MAGIC_NUMBER) {
+    *needs_conversion = false;
+  } else if (fields[0] == SWAPPED_MAGIC_NUMBER) {
+    *needs_conversion = true;
+  } else {
+    return NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH;
+  }
+  return NGF_PLMD_ERROR_OK;
+}
+
+// Converts each field from network to host byte order, but skips over raw
+// byte blocks.
+static ngf_plmd_error _convert_to_host_byte_order(uint32_t *fields,
+                                                  uint32_t nfields) {
+  for (uint32_t field_idx = 0u; field_idx < nfields; ++field_idx) {
+    const uint32_t field_value = fields[field_idx];
+    if (field_value == START_OF_RAW_BYTE_BLOCK) {
+      if (field_idx >= nfields - 1u) {
+        return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+      }
+      field_idx += 1u; // skip over the raw byte block start mark.
+      // Convert the length of raw byte block from network to host byte order,
+      // and write it back to the buffer.
+      const uint32_t raw_blk_size = ntohl(fields[field_idx]);
+      fields[field_idx] = raw_blk_size;
+      field_idx += raw_blk_size; // skip over the raw byte block contents.
+    } else {
+      fields[field_idx] = ntohl(field_value);
+    }
+  }
+  return NGF_PLMD_ERROR_OK;
+}
+
+// Locates the contents of the raw byte block at `ptr`, which consists of a
+// start mark, followed by the size of the block in 4-byte words, followed by
+// the contents. Returns a pointer just past the block, or NULL if the block
+// doesn't fit before `end`.
+static const uint8_t* _read_raw_byte_block(const uint8_t *ptr,
+                                           const uint8_t *end,
+                                           const char **contents) {
+  // Make sure the start mark and size are there before reading the size.
+  if (ptr > end || (size_t)(end - ptr) < 2u * sizeof(uint32_t)) {
+    return NULL;
+  }
+  const size_t nwords = ((const uint32_t*)ptr)[1];
+  ptr += 2u * sizeof(uint32_t);
+  if (nwords > (size_t)(end - ptr) / sizeof(uint32_t)) {
+    return NULL;
+  }
+  *contents = (const char*)ptr;
+  return ptr + nwords * sizeof(uint32_t);
+}
+
+static ngf_plmd_error _check_header(const ngf_plmd_header *header,
+                                    size_t buf_size) {
+  if (buf_size < sizeof(ngf_plmd_header)) {
+    return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  }
+  if (header->magic_number != MAGIC_NUMBER) {
+    return NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH;
+  }
+  // Sanity-check offsets in the header.
+  if (header->pipeline_layout_offset >= buf_size ||
+      header->image_to_cis_map_offset >= buf_size ||
+      header->sampler_to_cis_map_offset >= buf_size ||
+      header->user_metadata_offset >= buf_size) {
+    return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  }
+  return NGF_PLMD_ERROR_OK;
+}
+
 ngf_plmd_error ngf_plmd_load(const void *buf,
                              size_t buf_size,
                              const ngf_plmd_alloc_callbacks *alloc_cb,
                              ngf_plmd **result) {
-  static const uint32_t START_OF_RAW_BYTE_BLOCK = 0xffffffff;
-  static const uint32_t MAGIC_NUMBER = 0xdeadbeef;
   ngf_plmd_error err = NGF_PLMD_ERROR_OK;
   ngf_plmd *meta = NULL;
   assert(buf);
@@ -106,41 +233,25 @@ ngf_plmd_error ngf_plmd_load(const void *buf,
   }
   memcpy(meta->raw_data, buf, buf_size);
 
-  // Convert each field from network to host byte order, but skip
-  // over raw byte blocks.
+  // Bring the fields into host byte order, unless they already are.
   uint32_t *fields = (uint32_t*)meta->raw_data;
-  for (uint32_t field_idx = 0u; field_idx < nfields; ++field_idx) {
-    const uint32_t field_value = fields[field_idx];
-    if (field_value == START_OF_RAW_BYTE_BLOCK) {
-      if (field_idx >= nfields - 1u) {
-        err = NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
-        goto ngf_plmd_load_cleanup;
-      }
-      field_idx += 1u; // skip over the raw byte block start mark.
-      // Convert the length of raw byte block from network to host byte order,
-      // and write it back to the buffer.
-      const uint32_t raw_blk_size = ntohl(fields[field_idx]);
-      fields[field_idx] = raw_blk_size;
-      field_idx += raw_blk_size; // skip over the raw byte block contents.
-    } else {
-      fields[field_idx] = ntohl(field_value);
+  bool needs_conversion = false;
+  err = _check_byte_order(fields, nfields, &needs_conversion);
+  if (err != NGF_PLMD_ERROR_OK) {
+    goto ngf_plmd_load_cleanup;
+  }
+  if (needs_conversion) {
+    err = _convert_to_host_byte_order(fields, nfields);
+    if (err != NGF_PLMD_ERROR_OK) {
+      goto ngf_plmd_load_cleanup;
     }
   }
 
   // Process header.
   meta->header = (const ngf_plmd_header*)meta->raw_data;
   const ngf_plmd_header *header = meta->header;
-  if (header->magic_number != MAGIC_NUMBER) {
-    err = NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH;
-    goto ngf_plmd_load_cleanup;
-  }
-
-  // Sanity-check offsets in the header.
-  if (header->pipeline_layout_offset >= buf_size ||
-      header->image_to_cis_map_offset >= buf_size ||
-      header->sampler_to_cis_map_offset >= buf_size ||
-      header->user_metadata_offset >= buf_size) {
-    err = NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  err = _check_header(header, buf_size);
+  if (err != NGF_PLMD_ERROR_OK) {
     goto ngf_plmd_load_cleanup;
   }
 
@@ -180,17 +291,22 @@ ngf_plmd_error ngf_plmd_load(const void *buf,
     err = NGF_PLMD_ERROR_OUTOFMEM;
     goto ngf_plmd_load_cleanup;
   }
-  uint8_t *blk_ptr = &meta->raw_data[header->user_metadata_offset + 4u];
-  for (uint32_t e = 0u; e < meta->user.nentries; ++e) {
-    uint32_t *size_ptr = (uint32_t*)(blk_ptr + sizeof(uint32_t));
-    blk_ptr += 2 * sizeof(uint32_t);
-    meta->user.entries[e].key = (const char*)(blk_ptr);
-    blk_ptr += *size_ptr * sizeof(uint32_t);
-
-    size_ptr = (uint32_t*)(blk_ptr + sizeof(uint32_t));
-    blk_ptr += 2 * sizeof(uint32_t);
-    meta->user.entries[e].value = (const char*)(blk_ptr);
-    blk_ptr += *size_ptr * sizeof(uint32_t);
+  const uint8_t *blk_ptr = &meta->raw_data[header->user_metadata_offset + 4u];
+  const uint8_t *blk_end = meta->raw_data + buf_size;
+  for (uint32_t e = 0u; e < meta->user.nentries && blk_ptr != NULL; ++e) {
+    blk_ptr = _read_raw_byte_block(blk_ptr, blk_end,
+                                   &meta->user.entries[e].key);
+    if (blk_ptr != NULL) {
+      blk_ptr = _read_raw_byte_block(blk_ptr, blk_end,
+                                     &meta->user.entries[e].value);
+    }
+  }
+  if (blk_ptr == NULL) {
+    err = NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+    goto ngf_plmd_load_cleanup;
+  }
+  if (meta->user.nentries > _MAX_UNINDEXED_USER_ENTRIES) {
+    err = _create_user_index(alloc_cb, meta);
   }
 
 ngf_plmd_load_cleanup:
@@ -220,6 +336,9 @@ void ngf_plmd_destroy(ngf_plmd *m, const ngf_plmd_alloc_callbacks *alloc_cb) {
     if (m->user.entries != NULL) {
       alloc_cb->free((void*)m->user.entries);
     }
+    if (m->user_index != NULL) {
+      alloc_cb->free(m->user_index);
+    }
     alloc_cb->free(m);
   }
 }
@@ -240,10 +359,277 @@ const ngf_plmd_user* ngf_plmd_get_user(const ngf_plmd *m) {
   return &m->user;
 }
 
+const char* ngf_plmd_find_user(const ngf_plmd *m, const char *key) {
+  if (m->user_index == NULL) {
+    for (uint32_t e = 0u; e < m->user.nentries; ++e) {
+      if (strcmp(m->user.entries[e].key, key) == 0) {
+        return m->user.entries[e].value;
+      }
+    }
+    return NULL;
+  }
+  const uint32_t hash = _hash_string(key);
+  for (uint32_t slot = hash & m->user_index_mask;
+       m->user_index[slot].entry != 0u;
+       slot = (slot + 1u) & m->user_index_mask) {
+    const _user_index_slot *s = &m->user_index[slot];
+    if (s->hash == hash &&
+        strcmp(m->user.entries[s->entry - 1u].key, key) == 0) {
+      return m->user.entries[s->entry - 1u].value;
+    }
+  }
+  return NULL;
+}
+
 const ngf_plmd_header* ngf_plmd_get_header(const ngf_plmd *m) {
   return m->header;
 }
 
+ngf_plmd_error ngf_plmd_view_init(void *buf, size_t buf_size,
+                                  ngf_plmd_view *view) {
+  assert(buf);
+  assert(view);
+  assert(((uintptr_t)buf & 0b11) == 0u);
+  if ((buf_size & 0b11) != 0) {
+    return NGF_PLMD_ERROR_WEIRD_BUFFER_SIZE;
+  }
+  uint32_t *fields = (uint32_t*)buf;
+  const uint32_t nfields = ((uint32_t)buf_size) >> 2u;
+  bool needs_conversion = false;
+  ngf_plmd_error err = _check_byte_order(fields, nfields, &needs_conversion);
+  if (err == NGF_PLMD_ERROR_OK && needs_conversion) {
+    err = _convert_to_host_byte_order(fields, nfields);
+  }
+  if (err == NGF_PLMD_ERROR_OK) {
+    err = _check_header((const ngf_plmd_header*)buf, buf_size);
+  }
+  if (err == NGF_PLMD_ERROR_OK) {
+    view->data = (const uint8_t*)buf;
+    view->size = buf_size;
+  }
+  return err;
+}
+
+const ngf_plmd_header* ngf_plmd_view_get_header(const ngf_plmd_view *view) {
+  return (const ngf_plmd_header*)view->data;
+}
+
+const ngf_plmd_descriptor_set_layout* ngf_plmd_view_get_set_layouts(
+    const ngf_plmd_view *view,
+    uint32_t *nsets) {
+  const uint8_t *ptr =
+      view->data + ngf_plmd_view_get_header(view)->pipeline_layout_offset;
+  *nsets = *(const uint32_t*)ptr;
+  return (const ngf_plmd_descriptor_set_layout*)(ptr + sizeof(uint32_t));
+}
+
+const ngf_plmd_descriptor_set_layout* ngf_plmd_next_set_layout(
+    const ngf_plmd_descriptor_set_layout *set_layout) {
+  return (const ngf_plmd_descriptor_set_layout*)
+      &set_layout->descriptors[set_layout->ndescriptors];
+}
+
+const ngf_plmd_cis_map_entry* ngf_plmd_view_get_image_to_cis_map(
+    const ngf_plmd_view *view,
+    uint32_t *nentries) {
+  const uint8_t *ptr =
+      view->data + ngf_plmd_view_get_header(view)->image_to_cis_map_offset;
+  *nentries = *(const uint32_t*)ptr;
+  return (const ngf_plmd_cis_map_entry*)(ptr + sizeof(uint32_t));
+}
+
+const ngf_plmd_cis_map_entry* ngf_plmd_view_get_sampler_to_cis_map(
+    const ngf_plmd_view *view,
+    uint32_t *nentries) {
+  const uint8_t *ptr =
+      view->data + ngf_plmd_view_get_header(view)->sampler_to_cis_map_offset;
+  *nentries = *(const uint32_t*)ptr;
+  return (const ngf_plmd_cis_map_entry*)(ptr + sizeof(uint32_t));
+}
+
+const ngf_plmd_cis_map_entry* ngf_plmd_next_cis_map_entry(
+    const ngf_plmd_cis_map_entry *entry) {
+  return (const ngf_plmd_cis_map_entry*)
+      &entry->combined_ids[entry->ncombined_ids];
+}
+
+const char* ngf_plmd_view_find_user_value(const ngf_plmd_view *view,
+                                          const char *key) {
+  const uint8_t *ptr =
+      view->data + ngf_plmd_view_get_header(view)->user_metadata_offset;
+  const uint8_t *end = view->data + view->size;
+  if ((size_t)(end - ptr) < sizeof(uint32_t)) {
+    return NULL;
+  }
+  const uint32_t nentries = *(const uint32_t*)ptr;
+  ptr += sizeof(uint32_t);
+  // Each entry is a pair of raw byte blocks, the key and the value.
+  for (uint32_t e = 0u; e < nentries; ++e) {
+    const char *entry_key = NULL, *entry_value = NULL;
+    ptr = _read_raw_byte_block(ptr, end, &entry_key);
+    if (ptr != NULL) {
+      ptr = _read_raw_byte_block(ptr, end, &entry_value);
+    }
+    if (ptr == NULL) {
+      break;
+    }
+    if (strcmp(entry_key, key) == 0) {
+      return entry_value;
+    }
+  }
+  return NULL;
+}
+
+uint32_t ngf_plmd_archive_hash_name(const char *name) {
+  return _hash_string(name);
+}
+
+static int _compare_archive_entries(const void *a, const void *b) {
+  const uint32_t ha = ((const ngf_plmd_archive_entry*)a)->name_hash;
+  const uint32_t hb = ((const ngf_plmd_archive_entry*)b)->name_hash;
+  return ha < hb ? -1 : (ha > hb ? 1 : 0);
+}
+
+ngf_plmd_error ngf_plmd_archive_pack(uint32_t nentries,
+                                     const char *const *names,
+                                     const void *const *blobs,
+                                     const size_t *blob_sizes,
+                                     void *out,
+                                     size_t *out_size) {
+  assert(out_size);
+  // Compute the layout of the archive.
+  const size_t index_offset = sizeof(ngf_plmd_archive_header);
+  const size_t names_offset =
+      index_offset + nentries * sizeof(ngf_plmd_archive_entry);
+  size_t names_size = 0u;
+  size_t blobs_size = 0u;
+  for (uint32_t e = 0u; e < nentries; ++e) {
+    if ((blob_sizes[e] & 0b11) != 0) {
+      return NGF_PLMD_ERROR_WEIRD_BUFFER_SIZE;
+    }
+    names_size += strlen(names[e]) + 1u;
+    blobs_size += blob_sizes[e];
+  }
+  const size_t blobs_offset = (names_offset + names_size + 3u) & ~(size_t)3u;
+  const size_t archive_size = blobs_offset + blobs_size;
+  if (out == NULL) {
+    *out_size = archive_size;
+    return NGF_PLMD_ERROR_OK;
+  }
+  if (*out_size < archive_size) {
+    return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  }
+  assert(((uintptr_t)out & 0b11) == 0u);
+  *out_size = archive_size;
+
+  uint8_t *dst = (uint8_t*)out;
+  memset(dst, 0, blobs_offset);
+  ngf_plmd_archive_header *header = (ngf_plmd_archive_header*)dst;
+  header->magic_number = ARCHIVE_MAGIC_NUMBER;
+  header->version = ARCHIVE_VERSION;
+  header->nentries = nentries;
+  header->index_offset = (uint32_t)index_offset;
+
+  ngf_plmd_archive_entry *index =
+      (ngf_plmd_archive_entry*)(dst + index_offset);
+  size_t name_offset = names_offset;
+  size_t blob_offset = blobs_offset;
+  for (uint32_t e = 0u; e < nentries; ++e) {
+    const size_t name_size = strlen(names[e]) + 1u;
+    memcpy(dst + name_offset, names[e], name_size);
+    memcpy(dst + blob_offset, blobs[e], blob_sizes[e]);
+
+    // Store metadata in host byte order, so that it can be viewed directly.
+    uint32_t *fields = (uint32_t*)(dst + blob_offset);
+    const uint32_t nfields = (uint32_t)(blob_sizes[e] >> 2u);
+    bool needs_conversion = false;
+    ngf_plmd_error err = _check_byte_order(fields, nfields, &needs_conversion);
+    if (err == NGF_PLMD_ERROR_OK && needs_conversion) {
+      err = _convert_to_host_byte_order(fields, nfields);
+    }
+    if (err != NGF_PLMD_ERROR_OK) {
+      return err;
+    }
+
+    index[e].name_hash = ngf_plmd_archive_hash_name(names[e]);
+    index[e].name_offset = (uint32_t)name_offset;
+    index[e].data_offset = (uint32_t)blob_offset;
+    index[e].data_size = (uint32_t)blob_sizes[e];
+    name_offset += name_size;
+    blob_offset += blob_sizes[e];
+  }
+  qsort(index, nentries, sizeof(ngf_plmd_archive_entry),
+        _compare_archive_entries);
+  return NGF_PLMD_ERROR_OK;
+}
+
+ngf_plmd_error ngf_plmd_archive_init(const void *buf, size_t buf_size,
+                                     ngf_plmd_archive *archive) {
+  assert(buf);
+  assert(archive);
+  assert(((uintptr_t)buf & 0b11) == 0u);
+  if (buf_size < sizeof(ngf_plmd_archive_header)) {
+    return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  }
+  const ngf_plmd_archive_header *header = (const ngf_plmd_archive_header*)buf;
+  if (header->magic_number != ARCHIVE_MAGIC_NUMBER) {
+    return NGF_PLMD_ERROR_MAGIC_NUMBER_MISMATCH;
+  }
+  // The layout of everything past the header depends on the version.
+  if (header->version != ARCHIVE_VERSION) {
+    return NGF_PLMD_ERROR_VERSION_MISMATCH;
+  }
+  if ((size_t)header->index_offset +
+      (size_t)header->nentries * sizeof(ngf_plmd_archive_entry) > buf_size) {
+    return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+  }
+  archive->data = (const uint8_t*)buf;
+  archive->size = buf_size;
+  archive->index =
+      (const ngf_plmd_archive_entry*)(archive->data + header->index_offset);
+  archive->nentries = header->nentries;
+  return NGF_PLMD_ERROR_OK;
+}
+
+ngf_plmd_error ngf_plmd_archive_find(const ngf_plmd_archive *archive,
+                                     const char *name,
+                                     ngf_plmd_view *view) {
+  const uint32_t hash = ngf_plmd_archive_hash_name(name);
+
+  // Find the first entry with a matching hash.
+  uint32_t lo = 0u, hi = archive->nentries;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2u;
+    if (archive->index[mid].name_hash < hash) {
+      lo = mid + 1u;
+    } else {
+      hi = mid;
+    }
+  }
+
+  // Different names may have the same hash, check each one of them.
+  for (uint32_t e = lo;
+       e < archive->nentries && archive->index[e].name_hash == hash;
+       ++e) {
+    const ngf_plmd_archive_entry *entry = &archive->index[e];
+    if (entry->name_offset >= archive->size ||
+        (size_t)entry->data_offset + entry->data_size > archive->size) {
+      return NGF_PLMD_ERROR_BUFFER_TOO_SMALL;
+    }
+    if (strcmp((const char*)archive->data + entry->name_offset, name) == 0) {
+      const ngf_plmd_header *header =
+          (const ngf_plmd_header*)(archive->data + entry->data_offset);
+      const ngf_plmd_error err = _check_header(header, entry->data_size);
+      if (err == NGF_PLMD_ERROR_OK) {
+        view->data = (const uint8_t*)header;
+        view->size = entry->data_size;
+      }
+      return err;
+    }
+  }
+  return NGF_PLMD_ERROR_ENTRY_NOT_FOUND;
+}
+
 const char* ngf_plmd_get_error_name(const ngf_plmd_error err) {
   static const char* ngf_plmd_error_names[] = {
     "OK",
@@ -251,6 +637,8 @@ const char* ngf_plmd_get_error_name(const ngf_plmd_error err) {
     "MAGIC_NUMBER_MISMATCH",
     "BUFFER_TOO_SMALL",
     "WEIRD_BUFFER_SIZE",
+    "ENTRY_NOT_FOUND",
+    "VERSION_MISMATCH",
   };
   return ngf_plmd_error_names[err];
 }
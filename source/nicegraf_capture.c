@@ -0,0 +1,1164 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Capture layer. When built with NGF_CAPTURE, this file provides nicegraf's
+// public entry points. Each of them forwards to the backend and, if the
+// NGF_CAPTURE_FILE environment variable named a trace file when ngf_initialize
+// was called, appends a record of the call to that file. See nicegraf_trace.h
+// for the format and tools/ngf_replay.c for the consumer.
+//
+// Queries that have no effect on rendering (binary shader readback, device
+// capabilities, GPU timing) are forwarded without being recorded.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "nicegraf_capture_names.h"
+#include "nicegraf.h"
+#include "nicegraf_internal.h"
+#include "nicegraf_trace.h"
+#define _NGF_CAPTURE_UNDO_RENAMES
+#include "nicegraf_capture_names.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma region ngf_capture_serialization
+
+static FILE *TRACE_FILE = NULL;
+
+// The record being assembled by the current thread. Each finished record is
+// written with a single fwrite, so records from different threads don't
+// interleave.
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+  bool failed;
+} _ngf_trace_record;
+
+static NGF_THREADLOCAL _ngf_trace_record RECORD = {NULL, 0u, 0u, false};
+
+// Buffer ranges currently mapped by this thread, needed to read back the data
+// when a range is flushed.
+#define _NGF_TRACE_MAX_MAPPINGS 32u
+
+typedef struct {
+  const void *buffer;
+  const uint8_t *ptr;
+} _ngf_trace_mapping;
+
+static NGF_THREADLOCAL _ngf_trace_mapping MAPPINGS[_NGF_TRACE_MAX_MAPPINGS];
+
+static void _ngf_trace_close() {
+  if (TRACE_FILE != NULL) {
+    fclose(TRACE_FILE);
+    TRACE_FILE = NULL;
+  }
+}
+
+static void _ngf_trace_open() {
+  const char *path = getenv("NGF_CAPTURE_FILE");
+  if (path == NULL || TRACE_FILE != NULL) {
+    return;
+  }
+  TRACE_FILE = fopen(path, "wb");
+  if (TRACE_FILE == NULL) {
+    return;
+  }
+  const _ngf_trace_header header = {
+    _NGF_TRACE_MAGIC,
+    _NGF_TRACE_VERSION,
+    (uint32_t)sizeof(void*)
+  };
+  fwrite(&header, sizeof(header), 1u, TRACE_FILE);
+  atexit(_ngf_trace_close);
+}
+
+static void _ngf_trace_put(const void *data, size_t size) {
+  if (RECORD.size + size > RECORD.capacity) {
+    const size_t new_capacity =
+        NGF_MAX(RECORD.capacity * 2u, NGF_MAX(RECORD.size + size, 256u));
+    uint8_t *new_data = (uint8_t*)realloc(RECORD.data, new_capacity);
+    if (new_data == NULL) {
+      RECORD.failed = true;
+      return;
+    }
+    RECORD.data = new_data;
+    RECORD.capacity = new_capacity;
+  }
+  if (size > 0u) {
+    memcpy(RECORD.data + RECORD.size, data, size);
+  }
+  RECORD.size += size;
+}
+
+#define _NGF_TRACE_PUT(value) _ngf_trace_put(&(value), sizeof(value))
+
+static void _ngf_trace_u32(uint32_t value) {
+  _NGF_TRACE_PUT(value);
+}
+
+static void _ngf_trace_u64(uint64_t value) {
+  _NGF_TRACE_PUT(value);
+}
+
+static void _ngf_trace_handle(const void *handle) {
+  _ngf_trace_u64((uint64_t)(uintptr_t)handle);
+}
+
+static void _ngf_trace_blob(const void *data, size_t size) {
+  _ngf_trace_u64(size);
+  _ngf_trace_put(data, size);
+}
+
+static void _ngf_trace_string(const char *str) {
+  if (str == NULL) {
+    _ngf_trace_u32(_NGF_TRACE_NULL_STRING);
+  } else {
+    const uint32_t len = (uint32_t)strlen(str);
+    _ngf_trace_u32(len);
+    _ngf_trace_put(str, len);
+  }
+}
+
+static void _ngf_trace_optional(const void *data, size_t size) {
+  _ngf_trace_u32(data != NULL ? 1u : 0u);
+  if (data != NULL) {
+    _ngf_trace_put(data, size);
+  }
+}
+
+// Starts a new record, returns false if capture is disabled.
+static bool _ngf_trace_begin(_ngf_trace_op op) {
+  if (TRACE_FILE == NULL) {
+    return false;
+  }
+  RECORD.size = 0u;
+  RECORD.failed = false;
+  const _ngf_trace_record_header header = {(uint32_t)op, 0u};
+  _NGF_TRACE_PUT(header);
+  return true;
+}
+
+static void _ngf_trace_end() {
+  if (RECORD.failed) {
+    return;
+  }
+  _ngf_trace_record_header *header = (_ngf_trace_record_header*)RECORD.data;
+  header->payload_size =
+      (uint32_t)(RECORD.size - sizeof(_ngf_trace_record_header));
+  fwrite(RECORD.data, RECORD.size, 1u, TRACE_FILE);
+}
+
+static void _ngf_trace_image_ref(const ngf_image_ref *ref) {
+  _ngf_trace_handle(ref->image);
+  _ngf_trace_u32(ref->mip_level);
+  _ngf_trace_u32(ref->layer);
+  _ngf_trace_u32((uint32_t)ref->cubemap_face);
+}
+
+static void _ngf_trace_layout(const ngf_pipeline_layout_info *layout) {
+  _ngf_trace_u32(layout->ndescriptor_set_layouts);
+  for (uint32_t s = 0u; s < layout->ndescriptor_set_layouts; ++s) {
+    const ngf_descriptor_set_layout_info *set =
+        &layout->descriptor_set_layouts[s];
+    _ngf_trace_u32(set->ndescriptors);
+    _ngf_trace_put(set->descriptors,
+                   sizeof(ngf_descriptor_info) * set->ndescriptors);
+  }
+  _ngf_trace_u32(layout->push_constants_size);
+  _ngf_trace_u32(layout->push_constants_stage_flags);
+}
+
+static size_t _ngf_trace_type_size(ngf_type type) {
+  switch (type) {
+  case NGF_TYPE_INT8:
+  case NGF_TYPE_UINT8: return 1u;
+  case NGF_TYPE_INT16:
+  case NGF_TYPE_UINT16:
+  case NGF_TYPE_HALF_FLOAT: return 2u;
+  case NGF_TYPE_DOUBLE: return 8u;
+  default: return 4u;
+  }
+}
+
+static void _ngf_trace_spec_info(const ngf_specialization_info *spec) {
+  _ngf_trace_u32(spec != NULL ? 1u : 0u);
+  if (spec == NULL) {
+    return;
+  }
+  _ngf_trace_u32(spec->nspecializations);
+  _ngf_trace_put(spec->specializations,
+                 sizeof(ngf_constant_specialization) *
+                 spec->nspecializations);
+  size_t value_buffer_size = 0u;
+  for (uint32_t i = 0u; i < spec->nspecializations; ++i) {
+    const ngf_constant_specialization *s = &spec->specializations[i];
+    value_buffer_size =
+        NGF_MAX(value_buffer_size, s->offset + _ngf_trace_type_size(s->type));
+  }
+  _ngf_trace_blob(spec->value_buffer, value_buffer_size);
+}
+
+static void _ngf_trace_cis_map(const ngf_plmd_cis_map *map) {
+  _ngf_trace_u32(map != NULL ? 1u : 0u);
+  if (map == NULL) {
+    return;
+  }
+  _ngf_trace_u32(map->nentries);
+  for (uint32_t e = 0u; e < map->nentries; ++e) {
+    const ngf_plmd_cis_map_entry *entry = map->entries[e];
+    _ngf_trace_u32(entry->separate_set_id);
+    _ngf_trace_u32(entry->separate_binding_id);
+    _ngf_trace_u32(entry->ncombined_ids);
+    _ngf_trace_put(entry->combined_ids,
+                   sizeof(uint32_t) * entry->ncombined_ids);
+  }
+}
+
+static void _ngf_trace_bind_ops(const ngf_resource_bind_op *ops,
+                                uint32_t nops) {
+  _ngf_trace_u32(nops);
+  for (uint32_t o = 0u; o < nops; ++o) {
+    const ngf_resource_bind_op *op = &ops[o];
+    _ngf_trace_u32(op->target_set);
+    _ngf_trace_u32(op->target_binding);
+    _ngf_trace_u32((uint32_t)op->type);
+    switch (op->type) {
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER:
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC:
+      _ngf_trace_handle(op->info.uniform_buffer.buffer);
+      _ngf_trace_u64(op->info.uniform_buffer.offset);
+      _ngf_trace_u64(op->info.uniform_buffer.range);
+      break;
+    case NGF_DESCRIPTOR_TEXTURE:
+    case NGF_DESCRIPTOR_SAMPLER:
+    case NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER:
+      _ngf_trace_image_ref(&op->info.image_sampler.image_subresource);
+      _ngf_trace_handle(op->info.image_sampler.sampler);
+      break;
+    case NGF_DESCRIPTOR_STORAGE_BUFFER:
+      _ngf_trace_handle(op->info.storage_buffer.buffer);
+      _ngf_trace_u64(op->info.storage_buffer.offset);
+      _ngf_trace_u64(op->info.storage_buffer.range);
+      break;
+    case NGF_DESCRIPTOR_STORAGE_IMAGE:
+      _ngf_trace_image_ref(&op->info.storage_image);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+// Records a call that takes nothing but a handle (or an encoder).
+static void _ngf_trace_handle_call(_ngf_trace_op op, const void *handle) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_handle(handle);
+    _ngf_trace_end();
+  }
+}
+
+static void _ngf_trace_encoder_call(_ngf_trace_op op, uintptr_t encoder) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_u64(encoder);
+    _ngf_trace_end();
+  }
+}
+
+#pragma endregion
+
+#pragma region ngf_capture_context
+
+ngf_error ngf_initialize(ngf_device_preference dev_pref) {
+  _ngf_trace_open();
+  const ngf_error err = _ngf_backend_initialize(dev_pref);
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_INITIALIZE)) {
+    _ngf_trace_u32((uint32_t)dev_pref);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_debug_message_callback(void *userdata,
+                                void (*callback)(const char*, const void*)) {
+  _ngf_backend_debug_message_callback(userdata, callback);
+}
+
+ngf_error ngf_create_context(const ngf_context_info *info,
+                             ngf_context *result) {
+  const ngf_error err = _ngf_backend_create_context(info, result);
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_CREATE_CONTEXT)) {
+    _ngf_trace_handle(*result);
+    _ngf_trace_optional(info->swapchain_info, sizeof(ngf_swapchain_info));
+    _ngf_trace_handle(info->shared_context);
+    _ngf_trace_u32(info->debug ? 1u : 0u);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_destroy_context(ngf_context ctx) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_CONTEXT, ctx);
+  _ngf_backend_destroy_context(ctx);
+}
+
+ngf_error ngf_resize_context(ngf_context ctx,
+                             uint32_t new_width,
+                             uint32_t new_height) {
+  const ngf_error err =
+      _ngf_backend_resize_context(ctx, new_width, new_height);
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_RESIZE_CONTEXT)) {
+    _ngf_trace_handle(ctx);
+    _ngf_trace_u32(new_width);
+    _ngf_trace_u32(new_height);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+ngf_error ngf_set_context(ngf_context ctx) {
+  const ngf_error err = _ngf_backend_set_context(ctx);
+  if (err == NGF_ERROR_OK) {
+    _ngf_trace_handle_call(_NGF_TRACE_SET_CONTEXT, ctx);
+  }
+  return err;
+}
+
+ngf_error ngf_get_device_capabilities(ngf_device_capabilities *result) {
+  return _ngf_backend_get_device_capabilities(result);
+}
+
+ngf_error ngf_begin_frame() {
+  const ngf_error err = _ngf_backend_begin_frame();
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_BEGIN_FRAME)) {
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+ngf_error ngf_end_frame() {
+  const ngf_error err = _ngf_backend_end_frame();
+  if (_ngf_trace_begin(_NGF_TRACE_END_FRAME)) {
+    _ngf_trace_end();
+    fflush(TRACE_FILE);
+  }
+  return err;
+}
+
+void ngf_finish() {
+  _ngf_backend_finish();
+  if (_ngf_trace_begin(_NGF_TRACE_FINISH)) {
+    _ngf_trace_end();
+  }
+}
+
+ngf_error ngf_set_frame_pacing(const ngf_frame_pacing_info *info) {
+  return _ngf_backend_set_frame_pacing(info);
+}
+
+ngf_error ngf_enable_gpu_timing(bool enable) {
+  return _ngf_backend_enable_gpu_timing(enable);
+}
+
+ngf_error ngf_get_gpu_frame_timings(ngf_gpu_frame_timings *result) {
+  return _ngf_backend_get_gpu_frame_timings(result);
+}
+
+#pragma endregion
+
+#pragma region ngf_capture_objects
+
+ngf_error ngf_create_shader_stage(const ngf_shader_stage_info *info,
+                                  ngf_shader_stage *result) {
+  const ngf_error err = _ngf_backend_create_shader_stage(info, result);
+  if (err == NGF_ERROR_OK &&
+      _ngf_trace_begin(_NGF_TRACE_CREATE_SHADER_STAGE)) {
+    _ngf_trace_handle(*result);
+    _ngf_trace_u32((uint32_t)info->type);
+    _ngf_trace_blob(info->content, info->content_length);
+    _ngf_trace_string(info->debug_name);
+    _ngf_trace_u32(info->is_binary ? 1u : 0u);
+    _ngf_trace_string(info->entry_point_name);
+    _ngf_trace_u32(info->binary_format);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+ngf_error ngf_get_binary_shader_stage_size(const ngf_shader_stage stage,
+                                           size_t *size) {
+  return _ngf_backend_get_binary_shader_stage_size(stage, size);
+}
+
+ngf_error ngf_get_binary_shader_stage(const ngf_shader_stage stage,
+                                      size_t buf_size,
+                                      void *buffer,
+                                      uint32_t *format) {
+  return _ngf_backend_get_binary_shader_stage(stage, buf_size, buffer,
+                                              format);
+}
+
+void ngf_destroy_shader_stage(ngf_shader_stage stage) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_SHADER_STAGE, stage);
+  _ngf_backend_destroy_shader_stage(stage);
+}
+
+ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
+                                       ngf_graphics_pipeline *result) {
+  const ngf_error err = _ngf_backend_create_graphics_pipeline(info, result);
+  if (err != NGF_ERROR_OK ||
+      !_ngf_trace_begin(_NGF_TRACE_CREATE_GRAPHICS_PIPELINE)) {
+    return err;
+  }
+  _ngf_trace_handle(*result);
+  _ngf_trace_u32(info->nshader_stages);
+  for (uint32_t s = 0u; s < info->nshader_stages; ++s) {
+    _ngf_trace_handle(info->shader_stages[s]);
+  }
+  _ngf_trace_optional(info->viewport, sizeof(ngf_irect2d));
+  _ngf_trace_optional(info->scissor, sizeof(ngf_irect2d));
+  _ngf_trace_optional(info->rasterization, sizeof(ngf_rasterization_info));
+  _ngf_trace_optional(info->multisample, sizeof(ngf_multisample_info));
+  _ngf_trace_optional(info->depth_stencil, sizeof(ngf_depth_stencil_info));
+  _ngf_trace_optional(info->blend, sizeof(ngf_blend_info));
+  _ngf_trace_u32(info->dynamic_state_mask);
+  const ngf_vertex_input_info *input = info->input_info;
+  _ngf_trace_u32(input->nvert_buf_bindings);
+  _ngf_trace_put(input->vert_buf_bindings,
+                 sizeof(ngf_vertex_buf_binding_desc) *
+                 input->nvert_buf_bindings);
+  _ngf_trace_u32(input->nattribs);
+  _ngf_trace_put(input->attribs,
+                 sizeof(ngf_vertex_attrib_desc) * input->nattribs);
+  _ngf_trace_u32((uint32_t)info->primitive_type);
+  _ngf_trace_layout(info->layout);
+  _ngf_trace_spec_info(info->spec_info);
+  _ngf_trace_handle(info->compatible_render_target);
+  _ngf_trace_cis_map(info->image_to_combined_map);
+  _ngf_trace_cis_map(info->sampler_to_combined_map);
+  _ngf_trace_end();
+  return err;
+}
+
+void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline p) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_GRAPHICS_PIPELINE, p);
+  _ngf_backend_destroy_graphics_pipeline(p);
+}
+
+ngf_error ngf_create_compute_pipeline(const ngf_compute_pipeline_info *info,
+                                      ngf_compute_pipeline *result) {
+  const ngf_error err = _ngf_backend_create_compute_pipeline(info, result);
+  if (err == NGF_ERROR_OK &&
+      _ngf_trace_begin(_NGF_TRACE_CREATE_COMPUTE_PIPELINE)) {
+    _ngf_trace_handle(*result);
+    _ngf_trace_handle(info->shader_stage);
+    _ngf_trace_layout(info->layout);
+    _ngf_trace_spec_info(info->spec_info);
+    _ngf_trace_put(info->workgroup_size, sizeof(info->workgroup_size));
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_destroy_compute_pipeline(ngf_compute_pipeline p) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_COMPUTE_PIPELINE, p);
+  _ngf_backend_destroy_compute_pipeline(p);
+}
+
+ngf_error ngf_create_image(const ngf_image_info *info, ngf_image *result) {
+  const ngf_error err = _ngf_backend_create_image(info, result);
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_CREATE_IMAGE)) {
+    _ngf_trace_handle(*result);
+    _NGF_TRACE_PUT(*info);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_destroy_image(ngf_image image) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_IMAGE, image);
+  _ngf_backend_destroy_image(image);
+}
+
+ngf_error ngf_create_transient_pool(ngf_transient_pool *result) {
+  return _ngf_backend_create_transient_pool(result);
+}
+
+void ngf_destroy_transient_pool(ngf_transient_pool pool) {
+  _ngf_backend_destroy_transient_pool(pool);
+}
+
+// Images created by a transient pool are traced as regular images, so that
+// replays don't depend on pooling. Images that the pool destroys aren't
+// traced, replays keep them around until the end.
+ngf_error ngf_acquire_transient_image(ngf_transient_pool pool,
+                                      const ngf_transient_image_info *info,
+                                      ngf_image *result) {
+  ngf_transient_pool_stats before;
+  _ngf_backend_get_transient_pool_stats(pool, &before);
+  const ngf_error err = _ngf_backend_acquire_transient_image(pool, info,
+                                                             result);
+  ngf_transient_pool_stats after;
+  _ngf_backend_get_transient_pool_stats(pool, &after);
+  if (err == NGF_ERROR_OK && after.nimages > before.nimages &&
+      _ngf_trace_begin(_NGF_TRACE_CREATE_IMAGE)) {
+    _ngf_trace_handle(*result);
+    _NGF_TRACE_PUT(info->image_info);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_reset_transient_pool(ngf_transient_pool pool) {
+  _ngf_backend_reset_transient_pool(pool);
+}
+
+void ngf_get_transient_pool_stats(ngf_transient_pool pool,
+                                  ngf_transient_pool_stats *result) {
+  _ngf_backend_get_transient_pool_stats(pool, result);
+}
+
+ngf_error ngf_create_sampler(const ngf_sampler_info *info,
+                             ngf_sampler *result) {
+  const ngf_error err = _ngf_backend_create_sampler(info, result);
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_CREATE_SAMPLER)) {
+    _ngf_trace_handle(*result);
+    _NGF_TRACE_PUT(*info);
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_destroy_sampler(ngf_sampler sampler) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_SAMPLER, sampler);
+  _ngf_backend_destroy_sampler(sampler);
+}
+
+ngf_error ngf_default_render_target(ngf_attachment_load_op color_load_op,
+                                    ngf_attachment_load_op depth_load_op,
+                                    ngf_attachment_store_op color_store_op,
+                                    ngf_attachment_store_op depth_store_op,
+                                    const ngf_clear *clear_color,
+                                    const ngf_clear *clear_depth,
+                                    ngf_render_target *result) {
+  const ngf_error err =
+      _ngf_backend_default_render_target(color_load_op, depth_load_op,
+                                         color_store_op, depth_store_op,
+                                         clear_color, clear_depth, result);
+  if (err == NGF_ERROR_OK &&
+      _ngf_trace_begin(_NGF_TRACE_DEFAULT_RENDER_TARGET)) {
+    _ngf_trace_handle(*result);
+    _ngf_trace_u32((uint32_t)color_load_op);
+    _ngf_trace_u32((uint32_t)depth_load_op);
+    _ngf_trace_u32((uint32_t)color_store_op);
+    _ngf_trace_u32((uint32_t)depth_store_op);
+    _ngf_trace_optional(clear_color, sizeof(ngf_clear));
+    _ngf_trace_optional(clear_depth, sizeof(ngf_clear));
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+ngf_error ngf_create_render_target(const ngf_render_target_info *info,
+                                   ngf_render_target *result) {
+  const ngf_error err = _ngf_backend_create_render_target(info, result);
+  if (err == NGF_ERROR_OK &&
+      _ngf_trace_begin(_NGF_TRACE_CREATE_RENDER_TARGET)) {
+    _ngf_trace_handle(*result);
+    _ngf_trace_u32(info->nattachments);
+    for (uint32_t a = 0u; a < info->nattachments; ++a) {
+      const ngf_attachment *attachment = &info->attachments[a];
+      _ngf_trace_image_ref(&attachment->image_ref);
+      _ngf_trace_u32((uint32_t)attachment->type);
+      _ngf_trace_u32((uint32_t)attachment->load_op);
+      _ngf_trace_u32((uint32_t)attachment->store_op);
+      _NGF_TRACE_PUT(attachment->clear);
+    }
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+ngf_error ngf_resolve_render_target(const ngf_render_target src,
+                                    ngf_render_target dst,
+                                    const ngf_irect2d *src_rect) {
+  const ngf_error err = _ngf_backend_resolve_render_target(src, dst,
+                                                           src_rect);
+  if (err == NGF_ERROR_OK &&
+      _ngf_trace_begin(_NGF_TRACE_RESOLVE_RENDER_TARGET)) {
+    _ngf_trace_handle(src);
+    _ngf_trace_handle(dst);
+    _ngf_trace_optional(src_rect, sizeof(ngf_irect2d));
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_destroy_render_target(ngf_render_target target) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_RENDER_TARGET, target);
+  _ngf_backend_destroy_render_target(target);
+}
+
+#pragma endregion
+
+#pragma region ngf_capture_buffers
+
+static void _ngf_trace_mapped(const void *buffer, const void *ptr) {
+  for (uint32_t m = 0u; m < _NGF_TRACE_MAX_MAPPINGS; ++m) {
+    if (MAPPINGS[m].buffer == NULL) {
+      MAPPINGS[m].buffer = buffer;
+      MAPPINGS[m].ptr = (const uint8_t*)ptr;
+      return;
+    }
+  }
+}
+
+static _ngf_trace_mapping* _ngf_trace_find_mapping(const void *buffer) {
+  for (uint32_t m = 0u; m < _NGF_TRACE_MAX_MAPPINGS; ++m) {
+    if (MAPPINGS[m].buffer == buffer) {
+      return &MAPPINGS[m];
+    }
+  }
+  return NULL;
+}
+
+static void _ngf_trace_map(_ngf_trace_buffer_kind kind, const void *buffer,
+                           void *ptr, size_t offset, size_t size,
+                           uint32_t flags) {
+  if (ptr != NULL && _ngf_trace_begin(_NGF_TRACE_MAP_BUFFER)) {
+    _ngf_trace_mapped(buffer, ptr);
+    _ngf_trace_u32((uint32_t)kind);
+    _ngf_trace_handle(buffer);
+    _ngf_trace_u64(offset);
+    _ngf_trace_u64(size);
+    _ngf_trace_u32(flags);
+    _ngf_trace_end();
+  }
+}
+
+// Flushed data is the only data guaranteed to reach the buffer, so it is what
+// gets recorded. Ranges mapped on another thread are recorded without data.
+static void _ngf_trace_flush(_ngf_trace_buffer_kind kind, const void *buffer,
+                             size_t offset, size_t size) {
+  if (_ngf_trace_begin(_NGF_TRACE_FLUSH_BUFFER)) {
+    const _ngf_trace_mapping *mapping = _ngf_trace_find_mapping(buffer);
+    _ngf_trace_u32((uint32_t)kind);
+    _ngf_trace_handle(buffer);
+    _ngf_trace_u64(offset);
+    _ngf_trace_u64(size);
+    if (mapping != NULL) {
+      _ngf_trace_blob(mapping->ptr + offset, size);
+    } else {
+      _ngf_trace_blob(NULL, 0u);
+    }
+    _ngf_trace_end();
+  }
+}
+
+static void _ngf_trace_unmap(_ngf_trace_buffer_kind kind,
+                             const void *buffer) {
+  if (_ngf_trace_begin(_NGF_TRACE_UNMAP_BUFFER)) {
+    _ngf_trace_mapping *mapping = _ngf_trace_find_mapping(buffer);
+    if (mapping != NULL) {
+      mapping->buffer = NULL;
+    }
+    _ngf_trace_u32((uint32_t)kind);
+    _ngf_trace_handle(buffer);
+    _ngf_trace_end();
+  }
+}
+
+// Defines the capturing versions of a buffer type's entry points.
+#define _NGF_CAPTURE_BUFFER_FUNCS(type, info_type, kind) \
+ngf_error ngf_create_##type(const info_type *info, ngf_##type *result) { \
+  const ngf_error err = _ngf_backend_create_##type(info, result); \
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_CREATE_BUFFER)) { \
+    _ngf_trace_u32((uint32_t)kind); \
+    _ngf_trace_handle(*result); \
+    _NGF_TRACE_PUT(*info); \
+    _ngf_trace_end(); \
+  } \
+  return err; \
+} \
+void ngf_destroy_##type(ngf_##type buf) { \
+  if (_ngf_trace_begin(_NGF_TRACE_DESTROY_BUFFER)) { \
+    _ngf_trace_u32((uint32_t)kind); \
+    _ngf_trace_handle(buf); \
+    _ngf_trace_end(); \
+  } \
+  _ngf_backend_destroy_##type(buf); \
+} \
+void* ngf_##type##_map_range(ngf_##type buf, size_t offset, size_t size, \
+                             uint32_t flags) { \
+  void *ptr = _ngf_backend_##type##_map_range(buf, offset, size, flags); \
+  _ngf_trace_map(kind, buf, ptr, offset, size, flags); \
+  return ptr; \
+} \
+void ngf_##type##_flush_range(ngf_##type buf, size_t offset, size_t size) { \
+  _ngf_trace_flush(kind, buf, offset, size); \
+  _ngf_backend_##type##_flush_range(buf, offset, size); \
+} \
+void ngf_##type##_unmap(ngf_##type buf) { \
+  _ngf_trace_unmap(kind, buf); \
+  _ngf_backend_##type##_unmap(buf); \
+}
+
+_NGF_CAPTURE_BUFFER_FUNCS(attrib_buffer, ngf_attrib_buffer_info,
+                          _NGF_TRACE_ATTRIB_BUFFER)
+_NGF_CAPTURE_BUFFER_FUNCS(index_buffer, ngf_index_buffer_info,
+                          _NGF_TRACE_INDEX_BUFFER)
+_NGF_CAPTURE_BUFFER_FUNCS(uniform_buffer, ngf_uniform_buffer_info,
+                          _NGF_TRACE_UNIFORM_BUFFER)
+_NGF_CAPTURE_BUFFER_FUNCS(pixel_buffer, ngf_pixel_buffer_info,
+                          _NGF_TRACE_PIXEL_BUFFER)
+
+#pragma endregion
+
+#pragma region ngf_capture_cmd_buffers
+
+ngf_error ngf_create_cmd_buffer(const ngf_cmd_buffer_info *info,
+                                ngf_cmd_buffer *result) {
+  const ngf_error err = _ngf_backend_create_cmd_buffer(info, result);
+  if (err == NGF_ERROR_OK && _ngf_trace_begin(_NGF_TRACE_CREATE_CMD_BUFFER)) {
+    _ngf_trace_handle(*result);
+    _ngf_trace_optional(info, sizeof(ngf_cmd_buffer_info));
+    _ngf_trace_end();
+  }
+  return err;
+}
+
+void ngf_destroy_cmd_buffer(ngf_cmd_buffer buffer) {
+  _ngf_trace_handle_call(_NGF_TRACE_DESTROY_CMD_BUFFER, buffer);
+  _ngf_backend_destroy_cmd_buffer(buffer);
+}
+
+ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer buf) {
+  const ngf_error err = _ngf_backend_start_cmd_buffer(buf);
+  if (err == NGF_ERROR_OK) {
+    _ngf_trace_handle_call(_NGF_TRACE_START_CMD_BUFFER, buf);
+  }
+  return err;
+}
+
+ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
+  if (_ngf_trace_begin(_NGF_TRACE_SUBMIT_CMD_BUFFERS)) {
+    _ngf_trace_u32(nbuffers);
+    for (uint32_t b = 0u; b < nbuffers; ++b) {
+      _ngf_trace_handle(bufs[b]);
+    }
+    _ngf_trace_end();
+  }
+  return _ngf_backend_submit_cmd_buffers(nbuffers, bufs);
+}
+
+static void _ngf_trace_start_encoder(_ngf_trace_op op, ngf_cmd_buffer buf,
+                                     uintptr_t encoder) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_handle(buf);
+    _ngf_trace_u64(encoder);
+    _ngf_trace_end();
+  }
+}
+
+ngf_error ngf_cmd_buffer_start_render(ngf_cmd_buffer buf,
+                                      ngf_render_encoder *enc) {
+  const ngf_error err = _ngf_backend_cmd_buffer_start_render(buf, enc);
+  if (err == NGF_ERROR_OK) {
+    _ngf_trace_start_encoder(_NGF_TRACE_START_RENDER, buf, enc->__handle);
+  }
+  return err;
+}
+
+ngf_error ngf_cmd_buffer_start_xfer(ngf_cmd_buffer buf,
+                                    ngf_xfer_encoder *enc) {
+  const ngf_error err = _ngf_backend_cmd_buffer_start_xfer(buf, enc);
+  if (err == NGF_ERROR_OK) {
+    _ngf_trace_start_encoder(_NGF_TRACE_START_XFER, buf, enc->__handle);
+  }
+  return err;
+}
+
+ngf_error ngf_cmd_buffer_start_compute(ngf_cmd_buffer buf,
+                                       ngf_compute_encoder *enc) {
+  const ngf_error err = _ngf_backend_cmd_buffer_start_compute(buf, enc);
+  if (err == NGF_ERROR_OK) {
+    _ngf_trace_start_encoder(_NGF_TRACE_START_COMPUTE, buf, enc->__handle);
+  }
+  return err;
+}
+
+ngf_error ngf_render_encoder_end(ngf_render_encoder enc) {
+  _ngf_trace_encoder_call(_NGF_TRACE_RENDER_ENCODER_END, enc.__handle);
+  return _ngf_backend_render_encoder_end(enc);
+}
+
+ngf_error ngf_xfer_encoder_end(ngf_xfer_encoder enc) {
+  _ngf_trace_encoder_call(_NGF_TRACE_XFER_ENCODER_END, enc.__handle);
+  return _ngf_backend_xfer_encoder_end(enc);
+}
+
+ngf_error ngf_compute_encoder_end(ngf_compute_encoder enc) {
+  _ngf_trace_encoder_call(_NGF_TRACE_COMPUTE_ENCODER_END, enc.__handle);
+  return _ngf_backend_compute_encoder_end(enc);
+}
+
+void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc,
+                               const ngf_graphics_pipeline pipeline) {
+  if (_ngf_trace_begin(_NGF_TRACE_BIND_GFX_PIPELINE)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(pipeline);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_bind_gfx_pipeline(enc, pipeline);
+}
+
+static void _ngf_trace_rect_cmd(_ngf_trace_op op, uintptr_t encoder,
+                                const ngf_irect2d *r) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_u64(encoder);
+    _NGF_TRACE_PUT(*r);
+    _ngf_trace_end();
+  }
+}
+
+void ngf_cmd_viewport(ngf_render_encoder enc, const ngf_irect2d *r) {
+  _ngf_trace_rect_cmd(_NGF_TRACE_VIEWPORT, enc.__handle, r);
+  _ngf_backend_cmd_viewport(enc, r);
+}
+
+void ngf_cmd_scissor(ngf_render_encoder enc, const ngf_irect2d *r) {
+  _ngf_trace_rect_cmd(_NGF_TRACE_SCISSOR, enc.__handle, r);
+  _ngf_backend_cmd_scissor(enc, r);
+}
+
+static void _ngf_trace_u32_pair_cmd(_ngf_trace_op op, uintptr_t encoder,
+                                    uint32_t a, uint32_t b) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_u64(encoder);
+    _ngf_trace_u32(a);
+    _ngf_trace_u32(b);
+    _ngf_trace_end();
+  }
+}
+
+void ngf_cmd_stencil_reference(ngf_render_encoder enc, uint32_t front,
+                               uint32_t back) {
+  _ngf_trace_u32_pair_cmd(_NGF_TRACE_STENCIL_REFERENCE, enc.__handle, front,
+                          back);
+  _ngf_backend_cmd_stencil_reference(enc, front, back);
+}
+
+void ngf_cmd_stencil_compare_mask(ngf_render_encoder enc, uint32_t front,
+                                  uint32_t back) {
+  _ngf_trace_u32_pair_cmd(_NGF_TRACE_STENCIL_COMPARE_MASK, enc.__handle,
+                          front, back);
+  _ngf_backend_cmd_stencil_compare_mask(enc, front, back);
+}
+
+void ngf_cmd_stencil_write_mask(ngf_render_encoder enc, uint32_t front,
+                                uint32_t back) {
+  _ngf_trace_u32_pair_cmd(_NGF_TRACE_STENCIL_WRITE_MASK, enc.__handle, front,
+                          back);
+  _ngf_backend_cmd_stencil_write_mask(enc, front, back);
+}
+
+void ngf_cmd_line_width(ngf_render_encoder enc, float line_width) {
+  if (_ngf_trace_begin(_NGF_TRACE_LINE_WIDTH)) {
+    _ngf_trace_u64(enc.__handle);
+    _NGF_TRACE_PUT(line_width);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_line_width(enc, line_width);
+}
+
+void ngf_cmd_blend_factors(ngf_render_encoder enc,
+                           ngf_blend_factor sfactor,
+                           ngf_blend_factor dfactor) {
+  _ngf_trace_u32_pair_cmd(_NGF_TRACE_BLEND_FACTORS, enc.__handle,
+                          (uint32_t)sfactor, (uint32_t)dfactor);
+  _ngf_backend_cmd_blend_factors(enc, sfactor, dfactor);
+}
+
+void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
+                                const ngf_resource_bind_op *bind_operations,
+                                uint32_t nbind_operations) {
+  if (_ngf_trace_begin(_NGF_TRACE_BIND_GFX_RESOURCES)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_bind_ops(bind_operations, nbind_operations);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_bind_gfx_resources(enc, bind_operations,
+                                      nbind_operations);
+}
+
+void ngf_cmd_set_dynamic_offsets(ngf_render_encoder enc, uint32_t set,
+                                 const uint32_t *offsets, uint32_t noffsets) {
+  if (_ngf_trace_begin(_NGF_TRACE_SET_DYNAMIC_OFFSETS)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_u32(set);
+    _ngf_trace_u32(noffsets);
+    _ngf_trace_put(offsets, sizeof(uint32_t) * noffsets);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_set_dynamic_offsets(enc, set, offsets, noffsets);
+}
+
+void ngf_cmd_bind_attrib_buffer(ngf_render_encoder enc,
+                                const ngf_attrib_buffer vbuf,
+                                uint32_t binding, uint32_t offset) {
+  if (_ngf_trace_begin(_NGF_TRACE_BIND_ATTRIB_BUFFER)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(vbuf);
+    _ngf_trace_u32(binding);
+    _ngf_trace_u32(offset);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_bind_attrib_buffer(enc, vbuf, binding, offset);
+}
+
+void ngf_cmd_bind_index_buffer(ngf_render_encoder enc,
+                               const ngf_index_buffer idxbuf,
+                               ngf_type index_type) {
+  if (_ngf_trace_begin(_NGF_TRACE_BIND_INDEX_BUFFER)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(idxbuf);
+    _ngf_trace_u32((uint32_t)index_type);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_bind_index_buffer(enc, idxbuf, index_type);
+}
+
+void ngf_cmd_begin_pass(ngf_render_encoder enc,
+                        const ngf_render_target target) {
+  if (_ngf_trace_begin(_NGF_TRACE_BEGIN_PASS)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(target);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_begin_pass(enc, target);
+}
+
+void ngf_cmd_end_pass(ngf_render_encoder enc) {
+  _ngf_trace_encoder_call(_NGF_TRACE_END_PASS, enc.__handle);
+  _ngf_backend_cmd_end_pass(enc);
+}
+
+void ngf_cmd_draw(ngf_render_encoder enc, bool indexed,
+                  uint32_t first_element, uint32_t nelements,
+                  uint32_t ninstances) {
+  if (_ngf_trace_begin(_NGF_TRACE_DRAW)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_u32(indexed ? 1u : 0u);
+    _ngf_trace_u32(first_element);
+    _ngf_trace_u32(nelements);
+    _ngf_trace_u32(ninstances);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_draw(enc, indexed, first_element, nelements, ninstances);
+}
+
+static void _ngf_trace_push_constants(_ngf_trace_op op, uintptr_t encoder,
+                                      const void *data, uint32_t offset,
+                                      uint32_t size) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_u64(encoder);
+    _ngf_trace_u32(offset);
+    _ngf_trace_blob(data, size);
+    _ngf_trace_end();
+  }
+}
+
+void ngf_cmd_push_constants(ngf_render_encoder enc, const void *data,
+                            uint32_t offset, uint32_t size) {
+  _ngf_trace_push_constants(_NGF_TRACE_PUSH_CONSTANTS, enc.__handle, data,
+                            offset, size);
+  _ngf_backend_cmd_push_constants(enc, data, offset, size);
+}
+
+void ngf_cmd_draw_indirect(ngf_render_encoder enc, bool indexed,
+                           const ngf_attrib_buffer args, size_t offset,
+                           uint32_t ndraws, uint32_t stride) {
+  if (_ngf_trace_begin(_NGF_TRACE_DRAW_INDIRECT)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_u32(indexed ? 1u : 0u);
+    _ngf_trace_handle(args);
+    _ngf_trace_u64(offset);
+    _ngf_trace_u32(ndraws);
+    _ngf_trace_u32(stride);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_draw_indirect(enc, indexed, args, offset, ndraws, stride);
+}
+
+void ngf_cmd_bind_compute_pipeline(ngf_compute_encoder enc,
+                                   const ngf_compute_pipeline pipeline) {
+  if (_ngf_trace_begin(_NGF_TRACE_BIND_COMPUTE_PIPELINE)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(pipeline);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_bind_compute_pipeline(enc, pipeline);
+}
+
+void ngf_cmd_bind_compute_resources(ngf_compute_encoder enc,
+                                    const ngf_resource_bind_op *bind_ops,
+                                    uint32_t nbind_ops) {
+  if (_ngf_trace_begin(_NGF_TRACE_BIND_COMPUTE_RESOURCES)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_bind_ops(bind_ops, nbind_ops);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_bind_compute_resources(enc, bind_ops, nbind_ops);
+}
+
+void ngf_cmd_dispatch(ngf_compute_encoder enc, uint32_t ngroups_x,
+                      uint32_t ngroups_y, uint32_t ngroups_z) {
+  if (_ngf_trace_begin(_NGF_TRACE_DISPATCH)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_u32(ngroups_x);
+    _ngf_trace_u32(ngroups_y);
+    _ngf_trace_u32(ngroups_z);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_dispatch(enc, ngroups_x, ngroups_y, ngroups_z);
+}
+
+void ngf_cmd_push_compute_constants(ngf_compute_encoder enc, const void *data,
+                                    uint32_t offset, uint32_t size) {
+  _ngf_trace_push_constants(_NGF_TRACE_PUSH_COMPUTE_CONSTANTS, enc.__handle,
+                            data, offset, size);
+  _ngf_backend_cmd_push_compute_constants(enc, data, offset, size);
+}
+
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc,
+                               const ngf_attrib_buffer args, size_t offset) {
+  if (_ngf_trace_begin(_NGF_TRACE_DISPATCH_INDIRECT)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(args);
+    _ngf_trace_u64(offset);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_dispatch_indirect(enc, args, offset);
+}
+
+static void _ngf_trace_copy(_ngf_trace_buffer_kind kind, uintptr_t encoder,
+                            const void *src, const void *dst, size_t size,
+                            size_t src_offset, size_t dst_offset) {
+  if (_ngf_trace_begin(_NGF_TRACE_COPY_BUFFER)) {
+    _ngf_trace_u32((uint32_t)kind);
+    _ngf_trace_u64(encoder);
+    _ngf_trace_handle(src);
+    _ngf_trace_handle(dst);
+    _ngf_trace_u64(size);
+    _ngf_trace_u64(src_offset);
+    _ngf_trace_u64(dst_offset);
+    _ngf_trace_end();
+  }
+}
+
+void ngf_cmd_copy_attrib_buffer(ngf_xfer_encoder enc,
+                                const ngf_attrib_buffer src,
+                                ngf_attrib_buffer dst,
+                                size_t size,
+                                size_t src_offset,
+                                size_t dst_offset) {
+  _ngf_trace_copy(_NGF_TRACE_ATTRIB_BUFFER, enc.__handle, src, dst, size,
+                  src_offset, dst_offset);
+  _ngf_backend_cmd_copy_attrib_buffer(enc, src, dst, size, src_offset,
+                                      dst_offset);
+}
+
+void ngf_cmd_copy_index_buffer(ngf_xfer_encoder enc,
+                               const ngf_index_buffer src,
+                               ngf_index_buffer dst,
+                               size_t size,
+                               size_t src_offset,
+                               size_t dst_offset) {
+  _ngf_trace_copy(_NGF_TRACE_INDEX_BUFFER, enc.__handle, src, dst, size,
+                  src_offset, dst_offset);
+  _ngf_backend_cmd_copy_index_buffer(enc, src, dst, size, src_offset,
+                                     dst_offset);
+}
+
+void ngf_cmd_copy_uniform_buffer(ngf_xfer_encoder enc,
+                                 const ngf_uniform_buffer src,
+                                 ngf_uniform_buffer dst,
+                                 size_t size,
+                                 size_t src_offset,
+                                 size_t dst_offset) {
+  _ngf_trace_copy(_NGF_TRACE_UNIFORM_BUFFER, enc.__handle, src, dst, size,
+                  src_offset, dst_offset);
+  _ngf_backend_cmd_copy_uniform_buffer(enc, src, dst, size, src_offset,
+                                       dst_offset);
+}
+
+void ngf_cmd_write_image(ngf_xfer_encoder enc,
+                         const ngf_pixel_buffer src,
+                         size_t src_offset,
+                         ngf_image_ref dst,
+                         const ngf_offset3d *offset,
+                         const ngf_extent3d *extent) {
+  if (_ngf_trace_begin(_NGF_TRACE_WRITE_IMAGE)) {
+    _ngf_trace_u64(enc.__handle);
+    _ngf_trace_handle(src);
+    _ngf_trace_u64(src_offset);
+    _ngf_trace_image_ref(&dst);
+    _NGF_TRACE_PUT(*offset);
+    _NGF_TRACE_PUT(*extent);
+    _ngf_trace_end();
+  }
+  _ngf_backend_cmd_write_image(enc, src, src_offset, dst, offset, extent);
+}
+
+static void _ngf_trace_debug_group(_ngf_trace_op op, uintptr_t encoder,
+                                   const char *name) {
+  if (_ngf_trace_begin(op)) {
+    _ngf_trace_u64(encoder);
+    _ngf_trace_string(name);
+    _ngf_trace_end();
+  }
+}
+
+void ngf_cmd_begin_debug_group(ngf_render_encoder enc, const char *name) {
+  _ngf_trace_debug_group(_NGF_TRACE_BEGIN_DEBUG_GROUP, enc.__handle, name);
+  _ngf_backend_cmd_begin_debug_group(enc, name);
+}
+
+void ngf_cmd_end_debug_group(ngf_render_encoder enc) {
+  _ngf_trace_encoder_call(_NGF_TRACE_END_DEBUG_GROUP, enc.__handle);
+  _ngf_backend_cmd_end_debug_group(enc);
+}
+
+void ngf_cmd_begin_compute_debug_group(ngf_compute_encoder enc,
+                                       const char *name) {
+  _ngf_trace_debug_group(_NGF_TRACE_BEGIN_COMPUTE_DEBUG_GROUP, enc.__handle,
+                         name);
+  _ngf_backend_cmd_begin_compute_debug_group(enc, name);
+}
+
+void ngf_cmd_end_compute_debug_group(ngf_compute_encoder enc) {
+  _ngf_trace_encoder_call(_NGF_TRACE_END_COMPUTE_DEBUG_GROUP, enc.__handle);
+  _ngf_backend_cmd_end_compute_debug_group(enc);
+}
+
+#pragma endregion
@@ -0,0 +1,223 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// When the capture layer is enabled, the backend's implementations of the
+// public entry points are renamed so that nicegraf_capture.c can provide the
+// public symbols and forward to them. Included (without include guards) ahead
+// of nicegraf.h by the backend and by nicegraf_capture.c to apply the renames,
+// and by nicegraf_capture.c again with _NGF_CAPTURE_UNDO_RENAMES defined to
+// remove them after the declarations.
+// Entry points implemented in nicegraf_internal.c are not renamed.
+
+#if !defined(_NGF_CAPTURE_UNDO_RENAMES)
+#define ngf_debug_message_callback _ngf_backend_debug_message_callback
+#define ngf_create_shader_stage _ngf_backend_create_shader_stage
+#define ngf_get_binary_shader_stage_size \
+    _ngf_backend_get_binary_shader_stage_size
+#define ngf_get_binary_shader_stage _ngf_backend_get_binary_shader_stage
+#define ngf_destroy_shader_stage _ngf_backend_destroy_shader_stage
+#define ngf_create_graphics_pipeline _ngf_backend_create_graphics_pipeline
+#define ngf_destroy_graphics_pipeline _ngf_backend_destroy_graphics_pipeline
+#define ngf_create_compute_pipeline _ngf_backend_create_compute_pipeline
+#define ngf_destroy_compute_pipeline _ngf_backend_destroy_compute_pipeline
+#define ngf_create_image _ngf_backend_create_image
+#define ngf_destroy_image _ngf_backend_destroy_image
+#define ngf_create_transient_pool _ngf_backend_create_transient_pool
+#define ngf_destroy_transient_pool _ngf_backend_destroy_transient_pool
+#define ngf_acquire_transient_image _ngf_backend_acquire_transient_image
+#define ngf_reset_transient_pool _ngf_backend_reset_transient_pool
+#define ngf_get_transient_pool_stats _ngf_backend_get_transient_pool_stats
+#define ngf_create_sampler _ngf_backend_create_sampler
+#define ngf_destroy_sampler _ngf_backend_destroy_sampler
+#define ngf_default_render_target _ngf_backend_default_render_target
+#define ngf_create_render_target _ngf_backend_create_render_target
+#define ngf_resolve_render_target _ngf_backend_resolve_render_target
+#define ngf_destroy_render_target _ngf_backend_destroy_render_target
+#define ngf_create_attrib_buffer _ngf_backend_create_attrib_buffer
+#define ngf_destroy_attrib_buffer _ngf_backend_destroy_attrib_buffer
+#define ngf_attrib_buffer_map_range _ngf_backend_attrib_buffer_map_range
+#define ngf_attrib_buffer_flush_range _ngf_backend_attrib_buffer_flush_range
+#define ngf_attrib_buffer_unmap _ngf_backend_attrib_buffer_unmap
+#define ngf_create_index_buffer _ngf_backend_create_index_buffer
+#define ngf_destroy_index_buffer _ngf_backend_destroy_index_buffer
+#define ngf_index_buffer_map_range _ngf_backend_index_buffer_map_range
+#define ngf_index_buffer_flush_range _ngf_backend_index_buffer_flush_range
+#define ngf_index_buffer_unmap _ngf_backend_index_buffer_unmap
+#define ngf_create_uniform_buffer _ngf_backend_create_uniform_buffer
+#define ngf_destroy_uniform_buffer _ngf_backend_destroy_uniform_buffer
+#define ngf_uniform_buffer_map_range _ngf_backend_uniform_buffer_map_range
+#define ngf_uniform_buffer_flush_range _ngf_backend_uniform_buffer_flush_range
+#define ngf_uniform_buffer_unmap _ngf_backend_uniform_buffer_unmap
+#define ngf_create_pixel_buffer _ngf_backend_create_pixel_buffer
+#define ngf_destroy_pixel_buffer _ngf_backend_destroy_pixel_buffer
+#define ngf_pixel_buffer_map_range _ngf_backend_pixel_buffer_map_range
+#define ngf_pixel_buffer_flush_range _ngf_backend_pixel_buffer_flush_range
+#define ngf_pixel_buffer_unmap _ngf_backend_pixel_buffer_unmap
+#define ngf_finish _ngf_backend_finish
+#define ngf_create_cmd_buffer _ngf_backend_create_cmd_buffer
+#define ngf_destroy_cmd_buffer _ngf_backend_destroy_cmd_buffer
+#define ngf_start_cmd_buffer _ngf_backend_start_cmd_buffer
+#define ngf_submit_cmd_buffers _ngf_backend_submit_cmd_buffers
+#define ngf_cmd_buffer_start_render _ngf_backend_cmd_buffer_start_render
+#define ngf_cmd_buffer_start_xfer _ngf_backend_cmd_buffer_start_xfer
+#define ngf_cmd_buffer_start_compute _ngf_backend_cmd_buffer_start_compute
+#define ngf_render_encoder_end _ngf_backend_render_encoder_end
+#define ngf_xfer_encoder_end _ngf_backend_xfer_encoder_end
+#define ngf_compute_encoder_end _ngf_backend_compute_encoder_end
+#define ngf_cmd_bind_gfx_pipeline _ngf_backend_cmd_bind_gfx_pipeline
+#define ngf_cmd_viewport _ngf_backend_cmd_viewport
+#define ngf_cmd_scissor _ngf_backend_cmd_scissor
+#define ngf_cmd_stencil_reference _ngf_backend_cmd_stencil_reference
+#define ngf_cmd_stencil_compare_mask _ngf_backend_cmd_stencil_compare_mask
+#define ngf_cmd_stencil_write_mask _ngf_backend_cmd_stencil_write_mask
+#define ngf_cmd_line_width _ngf_backend_cmd_line_width
+#define ngf_cmd_blend_factors _ngf_backend_cmd_blend_factors
+#define ngf_cmd_bind_gfx_resources _ngf_backend_cmd_bind_gfx_resources
+#define ngf_cmd_set_dynamic_offsets _ngf_backend_cmd_set_dynamic_offsets
+#define ngf_cmd_bind_attrib_buffer _ngf_backend_cmd_bind_attrib_buffer
+#define ngf_cmd_bind_index_buffer _ngf_backend_cmd_bind_index_buffer
+#define ngf_cmd_begin_pass _ngf_backend_cmd_begin_pass
+#define ngf_cmd_end_pass _ngf_backend_cmd_end_pass
+#define ngf_cmd_draw _ngf_backend_cmd_draw
+#define ngf_cmd_push_constants _ngf_backend_cmd_push_constants
+#define ngf_cmd_draw_indirect _ngf_backend_cmd_draw_indirect
+#define ngf_cmd_bind_compute_pipeline _ngf_backend_cmd_bind_compute_pipeline
+#define ngf_cmd_bind_compute_resources _ngf_backend_cmd_bind_compute_resources
+#define ngf_cmd_dispatch _ngf_backend_cmd_dispatch
+#define ngf_cmd_push_compute_constants _ngf_backend_cmd_push_compute_constants
+#define ngf_cmd_dispatch_indirect _ngf_backend_cmd_dispatch_indirect
+#define ngf_cmd_copy_attrib_buffer _ngf_backend_cmd_copy_attrib_buffer
+#define ngf_cmd_copy_index_buffer _ngf_backend_cmd_copy_index_buffer
+#define ngf_cmd_copy_uniform_buffer _ngf_backend_cmd_copy_uniform_buffer
+#define ngf_cmd_write_image _ngf_backend_cmd_write_image
+#define ngf_cmd_begin_debug_group _ngf_backend_cmd_begin_debug_group
+#define ngf_cmd_end_debug_group _ngf_backend_cmd_end_debug_group
+#define ngf_cmd_begin_compute_debug_group \
+    _ngf_backend_cmd_begin_compute_debug_group
+#define ngf_cmd_end_compute_debug_group _ngf_backend_cmd_end_compute_debug_group
+#define ngf_initialize _ngf_backend_initialize
+#define ngf_create_context _ngf_backend_create_context
+#define ngf_destroy_context _ngf_backend_destroy_context
+#define ngf_resize_context _ngf_backend_resize_context
+#define ngf_set_context _ngf_backend_set_context
+#define ngf_get_device_capabilities _ngf_backend_get_device_capabilities
+#define ngf_begin_frame _ngf_backend_begin_frame
+#define ngf_end_frame _ngf_backend_end_frame
+#define ngf_set_frame_pacing _ngf_backend_set_frame_pacing
+#define ngf_enable_gpu_timing _ngf_backend_enable_gpu_timing
+#define ngf_get_gpu_frame_timings _ngf_backend_get_gpu_frame_timings
+#else
+#undef ngf_debug_message_callback
+#undef ngf_create_shader_stage
+#undef ngf_get_binary_shader_stage_size
+#undef ngf_get_binary_shader_stage
+#undef ngf_destroy_shader_stage
+#undef ngf_create_graphics_pipeline
+#undef ngf_destroy_graphics_pipeline
+#undef ngf_create_compute_pipeline
+#undef ngf_destroy_compute_pipeline
+#undef ngf_create_image
+#undef ngf_destroy_image
+#undef ngf_create_transient_pool
+#undef ngf_destroy_transient_pool
+#undef ngf_acquire_transient_image
+#undef ngf_reset_transient_pool
+#undef ngf_get_transient_pool_stats
+#undef ngf_create_sampler
+#undef ngf_destroy_sampler
+#undef ngf_default_render_target
+#undef ngf_create_render_target
+#undef ngf_resolve_render_target
+#undef ngf_destroy_render_target
+#undef ngf_create_attrib_buffer
+#undef ngf_destroy_attrib_buffer
+#undef ngf_attrib_buffer_map_range
+#undef ngf_attrib_buffer_flush_range
+#undef ngf_attrib_buffer_unmap
+#undef ngf_create_index_buffer
+#undef ngf_destroy_index_buffer
+#undef ngf_index_buffer_map_range
+#undef ngf_index_buffer_flush_range
+#undef ngf_index_buffer_unmap
+#undef ngf_create_uniform_buffer
+#undef ngf_destroy_uniform_buffer
+#undef ngf_uniform_buffer_map_range
+#undef ngf_uniform_buffer_flush_range
+#undef ngf_uniform_buffer_unmap
+#undef ngf_create_pixel_buffer
+#undef ngf_destroy_pixel_buffer
+#undef ngf_pixel_buffer_map_range
+#undef ngf_pixel_buffer_flush_range
+#undef ngf_pixel_buffer_unmap
+#undef ngf_finish
+#undef ngf_create_cmd_buffer
+#undef ngf_destroy_cmd_buffer
+#undef ngf_start_cmd_buffer
+#undef ngf_submit_cmd_buffers
+#undef ngf_cmd_buffer_start_render
+#undef ngf_cmd_buffer_start_xfer
+#undef ngf_cmd_buffer_start_compute
+#undef ngf_render_encoder_end
+#undef ngf_xfer_encoder_end
+#undef ngf_compute_encoder_end
+#undef ngf_cmd_bind_gfx_pipeline
+#undef ngf_cmd_viewport
+#undef ngf_cmd_scissor
+#undef ngf_cmd_stencil_reference
+#undef ngf_cmd_stencil_compare_mask
+#undef ngf_cmd_stencil_write_mask
+#undef ngf_cmd_line_width
+#undef ngf_cmd_blend_factors
+#undef ngf_cmd_bind_gfx_resources
+#undef ngf_cmd_set_dynamic_offsets
+#undef ngf_cmd_bind_attrib_buffer
+#undef ngf_cmd_bind_index_buffer
+#undef ngf_cmd_begin_pass
+#undef ngf_cmd_end_pass
+#undef ngf_cmd_draw
+#undef ngf_cmd_push_constants
+#undef ngf_cmd_draw_indirect
+#undef ngf_cmd_bind_compute_pipeline
+#undef ngf_cmd_bind_compute_resources
+#undef ngf_cmd_dispatch
+#undef ngf_cmd_push_compute_constants
+#undef ngf_cmd_dispatch_indirect
+#undef ngf_cmd_copy_attrib_buffer
+#undef ngf_cmd_copy_index_buffer
+#undef ngf_cmd_copy_uniform_buffer
+#undef ngf_cmd_write_image
+#undef ngf_cmd_begin_debug_group
+#undef ngf_cmd_end_debug_group
+#undef ngf_cmd_begin_compute_debug_group
+#undef ngf_cmd_end_compute_debug_group
+#undef ngf_initialize
+#undef ngf_create_context
+#undef ngf_destroy_context
+#undef ngf_resize_context
+#undef ngf_set_context
+#undef ngf_get_device_capabilities
+#undef ngf_begin_frame
+#undef ngf_end_frame
+#undef ngf_set_frame_pacing
+#undef ngf_enable_gpu_timing
+#undef ngf_get_gpu_frame_timings
+#endif
@@ -20,6 +20,9 @@
  * IN THE SOFTWARE.
  */
 #define _CRT_SECURE_NO_WARNINGS
+#if defined(NGF_CAPTURE_BACKEND)
+#include "nicegraf_capture_names.h"
+#endif
 #include "nicegraf.h"
 #include "nicegraf_internal.h"
 #include "dynamic_array.h"
@@ -29,6 +32,7 @@
 #include "EGL/eglext.h"
 #if defined(WIN32)
 #include <malloc.h>
+#include <intrin.h>
 #else
 #include <alloca.h>
 #endif
@@ -50,8 +54,63 @@
 
 #pragma region ngf_impl_type_definitions
 
+// Groups of GL state that are set together when a pipeline is bound. Each
+// group corresponds to one bit in a state mask and one setter function.
+typedef enum {
+  _NGF_GL_STATE_PROGRAM = 0,
+  _NGF_GL_STATE_VIEWPORT,
+  _NGF_GL_STATE_SCISSOR,
+  _NGF_GL_STATE_RASTERIZER_DISCARD,
+  _NGF_GL_STATE_POLYGON_MODE,
+  _NGF_GL_STATE_CULL_MODE,
+  _NGF_GL_STATE_FRONT_FACE,
+  _NGF_GL_STATE_LINE_WIDTH,
+  _NGF_GL_STATE_MULTISAMPLE,
+  _NGF_GL_STATE_ALPHA_TO_COVERAGE,
+  _NGF_GL_STATE_DEPTH_TEST,
+  _NGF_GL_STATE_DEPTH_WRITE,
+  _NGF_GL_STATE_STENCIL,
+  _NGF_GL_STATE_DEPTH_RANGE,
+  _NGF_GL_STATE_BLEND,
+  _NGF_GL_STATE_VERTEX_INPUT,
+  _NGF_GL_STATE_GROUP_COUNT
+} _ngf_gl_state_group;
+
+#define _NGF_GL_STATE_BIT(g) (1u << (uint32_t)(g))
+#define _NGF_GL_STATE_ALL_GROUPS \
+  (_NGF_GL_STATE_BIT(_NGF_GL_STATE_GROUP_COUNT) - 1u)
+
+// Offsets of each state group within the packed state vector.
+typedef enum {
+  _NGF_GL_WORD_PROGRAM            = 0,
+  _NGF_GL_WORD_VIEWPORT           = 1,  // x, y, width, height
+  _NGF_GL_WORD_SCISSOR            = 5,  // x, y, width, height
+  _NGF_GL_WORD_RASTERIZER_DISCARD = 9,
+  _NGF_GL_WORD_POLYGON_MODE       = 10,
+  _NGF_GL_WORD_CULL_MODE          = 11,
+  _NGF_GL_WORD_FRONT_FACE         = 12,
+  _NGF_GL_WORD_LINE_WIDTH         = 13,
+  _NGF_GL_WORD_MULTISAMPLE        = 14,
+  _NGF_GL_WORD_ALPHA_TO_COVERAGE  = 15,
+  _NGF_GL_WORD_DEPTH_TEST         = 16,
+  _NGF_GL_WORD_DEPTH_WRITE        = 17,
+  _NGF_GL_WORD_STENCIL            = 18, // enable, front (4), back (4)
+  _NGF_GL_WORD_DEPTH_RANGE        = 27, // min, max
+  _NGF_GL_WORD_BLEND              = 29,
+  _NGF_GL_WORD_VERTEX_INPUT       = 30,
+  _NGF_GL_STATE_NWORDS            = 31
+} _ngf_gl_state_word;
+
+// Fixed-function GL state of a pipeline, packed into a flat vector of words so
+// that two states can be diffed without inspecting individual fields.
+typedef struct {
+  uint32_t words[_NGF_GL_STATE_NWORDS];
+} _ngf_gl_pipeline_state;
+
 struct ngf_graphics_pipeline_t {
   uint32_t id;
+  _ngf_gl_pipeline_state state;
+  uint32_t dynamic_state_groups;
   GLuint program_pipeline;
   GLuint vao;
   ngf_irect2d viewport;
@@ -68,6 +127,16 @@ struct ngf_graphics_pipeline_t {
   _ngf_native_binding_map binding_map;
   GLuint owned_stages[NGF_STAGE_COUNT];
   uint32_t nowned_stages;
+  GLuint push_constants_binding;
+  uint32_t push_constants_size;
+};
+
+struct ngf_compute_pipeline_t {
+  GLuint program_pipeline;
+  _ngf_native_binding_map binding_map;
+  GLuint owned_stage;
+  GLuint push_constants_binding;
+  uint32_t push_constants_size;
 };
 
 #define _NGF_MAX_DRAW_BUFFERS 5
@@ -87,19 +156,57 @@ typedef struct _ngf_vbuf_binding_info_t {
   size_t offset;
 } _ngf_vbuf_binding_info;
 
+// GPU timing state of a context. Each of the last few frames gets its own set
+// of timestamp queries, which are read back when the frame's slot comes up for
+// reuse. By then they are normally available, and if they aren't, the frame's
+// timings are dropped rather than waiting for them.
+typedef struct {
+  _ngf_gpu_timing_frame frames[_NGF_GPU_TIMING_LATENCY];
+  GLuint queries[_NGF_GPU_TIMING_LATENCY][2u * NGF_MAX_GPU_TIMING_SCOPES];
+  uint64_t timestamps[2u * NGF_MAX_GPU_TIMING_SCOPES];
+  _ngf_gpu_timing_results results;
+  uint32_t current_frame;
+} _ngf_gl_gpu_timing;
+
 struct ngf_context_t {
   EGLDisplay dpy;
   EGLContext ctx;
   EGLConfig cfg;
   EGLSurface surface;
   struct {
-    struct ngf_graphics_pipeline_t pipeline;
+    ngf_graphics_pipeline bound_pipeline;
+    _ngf_gl_pipeline_state pipeline_state;
+    uint32_t clobbered_state_groups;
     _NGF_DARRAY_OF(_ngf_vbuf_binding_info) vbuf_table;
      GLuint bound_index_buffer;
+     GLuint bound_indirect_buffer;
   } cached_state;
-  bool has_bound_pipeline;
+  // Push constants are emulated with a uniform buffer. Their current values
+  // are shadowed here, and uploaded into a streaming ring buffer right before
+  // a draw or dispatch if they have changed.
+  struct {
+    uint8_t data[NGF_MAX_PUSH_CONSTANTS_SIZE];
+    GLuint binding;
+    uint32_t block_size;
+    bool dirty;
+    GLuint ring_buffer;
+    GLintptr ring_offset;
+    GLint offset_alignment;
+  } push_constants;
+  _ngf_gl_gpu_timing *gpu_timing; // NULL unless GPU timing is enabled.
+  // Every frame ends with a fence, which tells how many frames the GPU has
+  // yet to finish and lets the CPU wait for them to pace frames. Fences of
+  // frames from `oldest_pending_frame` onwards may not have signaled yet.
+  struct {
+    ngf_frame_pacing_info info;
+    GLsync fences[NGF_MAX_QUEUED_FRAMES];
+    uint64_t oldest_pending_frame;
+  } pacing;
+  uint64_t frame;
   bool has_swapchain;
+  bool headless; // Uses a display that needs no window system.
   bool has_depth;
+  bool debug; // Created with debugging enabled.
   bool srgb_surface;
   ngf_present_mode present_mode;
   ngf_type bound_index_buffer_type;
@@ -139,6 +246,7 @@ struct ngf_image_t {
   bool is_multisample;
   bool is_srgb;
   GLenum glformat;
+  GLenum glinternalformat;
   GLenum gltype;
 };
 
@@ -170,15 +278,30 @@ typedef enum {
   _NGF_CMD_BIND_INDEX_BUFFER,
   _NGF_CMD_DRAW,
   _NGF_CMD_DRAW_INDEXED,
+  _NGF_CMD_DRAW_INDIRECT,
+  _NGF_CMD_BIND_COMPUTE_PIPELINE,
+  _NGF_CMD_BIND_STORAGE_BUFFER,
+  _NGF_CMD_BIND_STORAGE_IMAGE,
+  _NGF_CMD_DISPATCH,
+  _NGF_CMD_DISPATCH_INDIRECT,
+  _NGF_CMD_MEMORY_BARRIER,
+  _NGF_CMD_PUSH_CONSTANTS,
   _NGF_CMD_COPY,
   _NGF_CMD_WRITE_IMAGE,
+  _NGF_CMD_BEGIN_SCOPE,
+  _NGF_CMD_END_SCOPE,
   _NGF_CMD_NONE
 } _ngf_emulated_cmd_type;
 
+// Push constant updates larger than this are split into several commands, so
+// that they don't bloat the size of every command.
+#define _NGF_PUSH_CONSTANTS_CHUNK_SIZE 32u
+
 typedef struct _ngf_emulated_cmd {
   _ngf_emulated_cmd_type type;
   union {
     ngf_graphics_pipeline pipeline;
+    ngf_compute_pipeline compute_pipeline;
     ngf_irect2d viewport;
     ngf_irect2d scissor;
     float line_width;
@@ -204,10 +327,22 @@ typedef struct _ngf_emulated_cmd {
       GLsizei offset;
       GLsizei range;
     } uniform_buffer_bind_op;
+    struct {
+      GLuint buffer;
+      GLuint index;
+      size_t offset;
+      size_t range;
+    } storage_buffer_bind_op;
     struct {
       ngf_image texture;
       GLuint unit;
     } texture_bind_op;
+    struct {
+      ngf_image image;
+      GLuint unit;
+      GLint level;
+      GLint layer;
+    } storage_image_bind_op;
     struct {
       ngf_sampler sampler;
       GLuint unit;
@@ -230,6 +365,29 @@ typedef struct _ngf_emulated_cmd {
       uint32_t first_element;
       bool indexed;
     } draw;
+    struct {
+      GLuint args_buffer;
+      size_t offset;
+      uint32_t ndraws;
+      uint32_t stride;
+      bool indexed;
+    } draw_indirect;
+    struct {
+      uint32_t ngroups_x;
+      uint32_t ngroups_y;
+      uint32_t ngroups_z;
+    } dispatch;
+    struct {
+      GLuint args_buffer;
+      size_t offset;
+    } dispatch_indirect;
+    struct {
+      uint8_t data[_NGF_PUSH_CONSTANTS_CHUNK_SIZE];
+      uint16_t offset;
+      uint16_t size;
+      uint16_t block_size;
+      uint16_t binding;
+    } push_constants;
     struct {
       GLuint src;
       GLuint dst;
@@ -244,6 +402,7 @@ typedef struct _ngf_emulated_cmd {
       ngf_offset3d offset;
       ngf_extent3d dimensions;
     } write_image;
+    const char *scope_name;
   };
 } _ngf_emulated_cmd;
 
@@ -255,8 +414,22 @@ typedef struct _ngf_cmd_block {
    uint32_t               next_cmd_idx;
 } _ngf_cmd_block;
 
+// A dynamic uniform buffer bound on a command buffer. Changing its dynamic
+// offset re-records the bind with the new offset added to the base one.
+typedef struct {
+  uint32_t set;
+  uint32_t binding;
+  GLuint native_binding;
+  GLuint buffer;
+  GLsizei base_offset;
+  GLsizei range;
+} _ngf_dynamic_ubo_binding;
+
 struct ngf_cmd_buffer_t {
   ngf_graphics_pipeline bound_pipeline;
+  ngf_compute_pipeline bound_compute_pipeline;
+  // Sorted by set, then binding.
+  _NGF_DARRAY_OF(_ngf_dynamic_ubo_binding) dynamic_ubos;
   _ngf_cmd_block *first_cmd_block;
   _ngf_cmd_block *last_cmd_block;
   bool renderpass_active;
@@ -268,7 +441,8 @@ struct ngf_cmd_buffer_t {
 static GLenum gl_shader_stage(ngf_stage_type stage) {
   static const GLenum stages[NGF_STAGE_COUNT] = {
     GL_VERTEX_SHADER,
-    GL_FRAGMENT_SHADER
+    GL_FRAGMENT_SHADER,
+    GL_COMPUTE_SHADER
   };
   return stages[stage];
 }
@@ -276,7 +450,8 @@ static GLenum gl_shader_stage(ngf_stage_type stage) {
 static GLenum get_gl_shader_stage_bit(ngf_stage_type stage) {
   static const GLenum stages[NGF_STAGE_COUNT] = {
     GL_VERTEX_SHADER_BIT,
-    GL_FRAGMENT_SHADER_BIT
+    GL_FRAGMENT_SHADER_BIT,
+    GL_COMPUTE_SHADER_BIT
   };
   return stages[stage];
 }
@@ -486,6 +661,134 @@ static GLenum get_gl_cubemap_face(ngf_cubemap_face face) {
 
 #pragma endregion
 
+#pragma region ngf_impl_pipeline_state
+
+// Maps each word of the packed state vector to the state group it belongs to.
+static const uint32_t _NGF_GL_WORD_GROUP_BITS[_NGF_GL_STATE_NWORDS] = {
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_PROGRAM),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_VIEWPORT),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_VIEWPORT),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_VIEWPORT),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_VIEWPORT),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_SCISSOR),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_SCISSOR),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_SCISSOR),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_SCISSOR),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_RASTERIZER_DISCARD),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_POLYGON_MODE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_CULL_MODE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_FRONT_FACE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_LINE_WIDTH),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_MULTISAMPLE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_ALPHA_TO_COVERAGE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_DEPTH_TEST),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_DEPTH_WRITE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_DEPTH_RANGE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_DEPTH_RANGE),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_BLEND),
+  _NGF_GL_STATE_BIT(_NGF_GL_STATE_VERTEX_INPUT),
+};
+
+static uint32_t _ngf_float_bits(float f) {
+  uint32_t result;
+  memcpy(&result, &f, sizeof(result));
+  return result;
+}
+
+static void _ngf_pack_stencil_state(const ngf_stencil_info *stencil,
+                                    uint32_t               *words) {
+  words[0] = (uint32_t)stencil->fail_op              |
+             (uint32_t)stencil->pass_op       <<  8u |
+             (uint32_t)stencil->depth_fail_op << 16u |
+             (uint32_t)stencil->compare_op    << 24u;
+  words[1] = stencil->compare_mask;
+  words[2] = stencil->write_mask;
+  words[3] = stencil->reference;
+}
+
+// Packs the fixed-function state of the given pipeline into a state vector.
+// Fields that have no effect (e.g. the depth compare op when depth testing is
+// disabled) are zeroed out so that they don't cause spurious state changes.
+static void _ngf_pack_pipeline_state(const ngf_graphics_pipeline pipeline,
+                                     _ngf_gl_pipeline_state     *state) {
+  uint32_t *w = state->words;
+  memset(state, 0, sizeof(*state));
+  w[_NGF_GL_WORD_PROGRAM]      = pipeline->program_pipeline;
+  w[_NGF_GL_WORD_VIEWPORT + 0] = (uint32_t)pipeline->viewport.x;
+  w[_NGF_GL_WORD_VIEWPORT + 1] = (uint32_t)pipeline->viewport.y;
+  w[_NGF_GL_WORD_VIEWPORT + 2] = pipeline->viewport.width;
+  w[_NGF_GL_WORD_VIEWPORT + 3] = pipeline->viewport.height;
+  w[_NGF_GL_WORD_SCISSOR + 0]  = (uint32_t)pipeline->scissor.x;
+  w[_NGF_GL_WORD_SCISSOR + 1]  = (uint32_t)pipeline->scissor.y;
+  w[_NGF_GL_WORD_SCISSOR + 2]  = pipeline->scissor.width;
+  w[_NGF_GL_WORD_SCISSOR + 3]  = pipeline->scissor.height;
+
+  const ngf_rasterization_info *rast = &pipeline->rasterization;
+  w[_NGF_GL_WORD_RASTERIZER_DISCARD] = rast->discard;
+  w[_NGF_GL_WORD_POLYGON_MODE]       = (uint32_t)rast->polygon_mode;
+  w[_NGF_GL_WORD_CULL_MODE]          = (uint32_t)rast->cull_mode;
+  w[_NGF_GL_WORD_FRONT_FACE]         = (uint32_t)rast->front_face;
+  w[_NGF_GL_WORD_LINE_WIDTH]         = _ngf_float_bits(rast->line_width);
+
+  w[_NGF_GL_WORD_MULTISAMPLE]       = pipeline->multisample.multisample;
+  w[_NGF_GL_WORD_ALPHA_TO_COVERAGE] = pipeline->multisample.alpha_to_coverage;
+
+  const ngf_depth_stencil_info *ds = &pipeline->depth_stencil;
+  if (ds->depth_test) {
+    w[_NGF_GL_WORD_DEPTH_TEST] = 1u | (uint32_t)ds->depth_compare << 1u;
+  }
+  w[_NGF_GL_WORD_DEPTH_WRITE] = ds->depth_write;
+  if (ds->stencil_test) {
+    w[_NGF_GL_WORD_STENCIL] = 1u;
+    _ngf_pack_stencil_state(&ds->front_stencil, &w[_NGF_GL_WORD_STENCIL + 1]);
+    _ngf_pack_stencil_state(&ds->back_stencil, &w[_NGF_GL_WORD_STENCIL + 5]);
+  }
+  w[_NGF_GL_WORD_DEPTH_RANGE + 0] = _ngf_float_bits(ds->min_depth);
+  w[_NGF_GL_WORD_DEPTH_RANGE + 1] = _ngf_float_bits(ds->max_depth);
+
+  const ngf_blend_info *blend = &pipeline->blend;
+  if (blend->enable) {
+    w[_NGF_GL_WORD_BLEND] = 1u |
+                            (uint32_t)blend->sfactor <<  8u |
+                            (uint32_t)blend->dfactor << 16u;
+  }
+  w[_NGF_GL_WORD_VERTEX_INPUT] = pipeline->vao;
+}
+
+// Returns a mask with the bits of all state groups that differ between the two
+// given state vectors.
+static uint32_t _ngf_diff_pipeline_state(const _ngf_gl_pipeline_state *a,
+                                         const _ngf_gl_pipeline_state *b) {
+  uint32_t changed_groups = 0u;
+  for (uint32_t w = 0u; w < _NGF_GL_STATE_NWORDS; ++w) {
+    changed_groups |=
+        (a->words[w] ^ b->words[w]) != 0u ? _NGF_GL_WORD_GROUP_BITS[w] : 0u;
+  }
+  return changed_groups;
+}
+
+static uint32_t _ngf_ctz32(uint32_t x) {
+  assert(x != 0u);
+#if defined(_MSC_VER)
+  unsigned long idx;
+  _BitScanForward(&idx, x);
+  return (uint32_t)idx;
+#else
+  return (uint32_t)__builtin_ctz(x);
+#endif
+}
+
+#pragma endregion
+
 void (*NGF_DEBUG_CALLBACK)(const char *message, const void *userdata) = NULL;
 void *NGF_DEBUG_USERDATA = NULL;
 
@@ -507,6 +810,70 @@ ngf_error ngf_initialize(ngf_device_preference dev_pref) {
   return NGF_ERROR_OK;
 }
 
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static bool _ngf_egl_has_extension(const char *extensions, const char *name) {
+  if (extensions == NULL) {
+    return false;
+  }
+  const size_t name_len = strlen(name);
+  for (const char *e = strstr(extensions, name); e != NULL;
+       e = strstr(e + name_len, name)) {
+    const bool starts_word = (e == extensions || e[-1] == ' ');
+    const bool ends_word = (e[name_len] == ' ' || e[name_len] == '\0');
+    if (starts_word && ends_word) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static EGLDisplay _ngf_egl_initialize_display(EGLDisplay dpy) {
+  if (dpy != EGL_NO_DISPLAY && eglInitialize(dpy, NULL, NULL) == EGL_FALSE) {
+    dpy = EGL_NO_DISPLAY;
+  }
+  return dpy;
+}
+
+// Connects to a display that doesn't need a window system, so that contexts
+// without a swapchain can be created on machines with no X server. Mesa's
+// surfaceless platform is tried first (it is available with llvmpipe), then
+// the first EGL device. Returns EGL_NO_DISPLAY if neither is available.
+static EGLDisplay _ngf_egl_get_headless_display() {
+  const char *client_exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (!_ngf_egl_has_extension(client_exts, "EGL_EXT_platform_base")) {
+    return EGL_NO_DISPLAY;
+  }
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+          eglGetProcAddress("eglGetPlatformDisplayEXT");
+  if (get_platform_display == NULL) {
+    return EGL_NO_DISPLAY;
+  }
+  EGLDisplay dpy = EGL_NO_DISPLAY;
+  if (_ngf_egl_has_extension(client_exts, "EGL_MESA_platform_surfaceless")) {
+    dpy = _ngf_egl_initialize_display(
+        get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                             (void*)EGL_DEFAULT_DISPLAY, NULL));
+  }
+  if (dpy == EGL_NO_DISPLAY &&
+      _ngf_egl_has_extension(client_exts, "EGL_EXT_platform_device") &&
+      _ngf_egl_has_extension(client_exts, "EGL_EXT_device_enumeration")) {
+    PFNEGLQUERYDEVICESEXTPROC query_devices =
+        (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+    EGLDeviceEXT device;
+    EGLint ndevices = 0;
+    if (query_devices != NULL && query_devices(1, &device, &ndevices) &&
+        ndevices > 0) {
+      dpy = _ngf_egl_initialize_display(
+          get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, NULL));
+    }
+  }
+  return dpy;
+}
+
 ngf_error ngf_create_context(const ngf_context_info *info,
                              ngf_context *result) {
   assert(info);
@@ -522,17 +889,43 @@ ngf_error ngf_create_context(const ngf_context_info *info,
     err_code = NGF_ERROR_OUTOFMEM;
     goto ngf_create_context_cleanup;
   }
+  // Zeroed, so that destroying a half-created context is safe.
+  memset(ctx, 0, sizeof(*ctx));
 
-  // Connect to a display.
+  ctx->ctx = EGL_NO_CONTEXT;
+  ctx->surface = EGL_NO_SURFACE;
+
+  // Connect to a display. Contexts without a swapchain (and contexts sharing
+  // with them) use a headless display when one is available.
   eglBindAPI(EGL_OPENGL_API);
-  ctx->dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
-  assert(ctx->dpy != EGL_NO_DISPLAY);
+  ctx->headless = false;
+  if (shared != NULL) {
+    ctx->dpy = shared->dpy;
+    ctx->headless = shared->headless;
+  } else if (swapchain_info == NULL) {
+    ctx->dpy = _ngf_egl_get_headless_display();
+    ctx->headless = (ctx->dpy != EGL_NO_DISPLAY);
+  }
+  if (!ctx->headless) {
+    ctx->dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (ctx->dpy == EGL_NO_DISPLAY) {
+      err_code = NGF_ERROR_CONTEXT_CREATION_FAILED;
+      goto ngf_create_context_cleanup;
+    }
+  }
   int egl_maj, egl_min;
   if (eglInitialize(ctx->dpy, &egl_maj, &egl_min) == EGL_FALSE) {
     err_code = NGF_ERROR_CONTEXT_CREATION_FAILED;
     goto ngf_create_context_cleanup;
   }
 
+  // Headless displays need either surfaceless contexts or a pbuffer to make
+  // the context current.
+  const bool use_pbuffer =
+      ctx->headless && swapchain_info == NULL &&
+      !_ngf_egl_has_extension(eglQueryString(ctx->dpy, EGL_EXTENSIONS),
+                              "EGL_KHR_surfaceless_context");
+
   // Set present mode.
   if (swapchain_info != NULL) {
     ctx->has_swapchain = true;
@@ -568,16 +961,24 @@ ngf_error ngf_create_context(const ngf_context_info *info,
     config_attribs[a++] = swapchain_info->nsamples;
     config_attribs[a++] = EGL_SURFACE_TYPE;
     config_attribs[a++] = EGL_WINDOW_BIT;
-  } 
+  } else if (ctx->headless) {
+    config_attribs[a++] = EGL_RENDERABLE_TYPE;
+    config_attribs[a++] = EGL_OPENGL_BIT;
+    config_attribs[a++] = EGL_SURFACE_TYPE;
+    config_attribs[a++] = use_pbuffer ? EGL_PBUFFER_BIT : 0;
+  }
   config_attribs[a++] = EGL_NONE;
   EGLint num = 0;
-  if(!eglChooseConfig(ctx->dpy, config_attribs, &ctx->cfg, 1, &num)) {
+  if(!eglChooseConfig(ctx->dpy, config_attribs, &ctx->cfg, 1, &num) ||
+     num == 0) {
     err_code = NGF_ERROR_CONTEXT_CREATION_FAILED;
     goto ngf_create_context_cleanup;
   }
-  ctx->has_depth = (swapchain_info->dfmt != NGF_IMAGE_FORMAT_UNDEFINED);
+  ctx->has_depth = swapchain_info != NULL &&
+                   swapchain_info->dfmt != NGF_IMAGE_FORMAT_UNDEFINED;
 
   // Create context with chosen config.
+  ctx->debug = info->debug;
   EGLint is_debug = info->debug;
   EGLint context_attribs[] = {
     EGL_CONTEXT_MAJOR_VERSION, 4,
@@ -615,17 +1016,42 @@ ngf_error ngf_create_context(const ngf_context_info *info,
       err_code = NGF_ERROR_SWAPCHAIN_CREATION_FAILED;
       goto ngf_create_context_cleanup;
     }
-  } else {
-    ctx->surface = EGL_NO_SURFACE;
+  } else if (use_pbuffer) {
+    // The pbuffer is never rendered to, all rendering goes to render targets.
+    const EGLint pbuffer_attribs[] = {
+      EGL_WIDTH, 1,
+      EGL_HEIGHT, 1,
+      EGL_NONE
+    };
+    ctx->surface = eglCreatePbufferSurface(ctx->dpy, ctx->cfg,
+                                           pbuffer_attribs);
+    if (ctx->surface == EGL_NO_SURFACE) {
+      err_code = NGF_ERROR_CONTEXT_CREATION_FAILED;
+      goto ngf_create_context_cleanup;
+    }
   }
 
-  ctx->has_bound_pipeline = false;
+  // Actual GL state is unknown until the first pipeline gets bound.
+  ctx->cached_state.bound_pipeline = NULL;
+  memset(&ctx->cached_state.pipeline_state, 0,
+         sizeof(ctx->cached_state.pipeline_state));
+  ctx->cached_state.clobbered_state_groups = _NGF_GL_STATE_ALL_GROUPS;
   _NGF_DARRAY_RESET(ctx->cached_state.vbuf_table, 10);
   ctx->cached_state.bound_index_buffer = GL_NONE;
+  ctx->cached_state.bound_indirect_buffer = GL_NONE;
+  ctx->push_constants.binding = 0u;
+  ctx->push_constants.block_size = 0u;
+  ctx->push_constants.dirty = false;
+  ctx->push_constants.ring_buffer = GL_NONE;
+  ctx->push_constants.ring_offset = 0;
+  ctx->push_constants.offset_alignment = 0;
+  ctx->gpu_timing = NULL;
+  ctx->frame = 0u;
 
 ngf_create_context_cleanup:
   if (err_code != NGF_ERROR_OK) {
     ngf_destroy_context(ctx);
+    ctx = NULL;
   }
   *result = ctx;
   return err_code;
@@ -666,6 +1092,42 @@ ngf_error ngf_set_context(ngf_context ctx) {
   return result ? NGF_ERROR_OK : NGF_ERROR_INVALID_CONTEXT;
 }
 
+ngf_error ngf_get_device_capabilities(ngf_device_capabilities *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  GLint ubo_alignment = 0, max_ubo_size = 0, max_vert_ubos = 0,
+        max_frag_ubos = 0, max_texture_units = 0, max_color_attachments = 0,
+        max_texture_size = 0, max_samples = 0;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+  glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &max_ubo_size);
+  glGetIntegerv(GL_MAX_VERTEX_UNIFORM_BLOCKS, &max_vert_ubos);
+  glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_BLOCKS, &max_frag_ubos);
+  glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_texture_units);
+  glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &max_color_attachments);
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+  glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+  result->uniform_buffer_offset_alignment = (size_t)NGF_MAX(ubo_alignment, 1);
+  result->max_uniform_buffer_range = (size_t)max_ubo_size;
+  result->optimal_copy_offset_alignment = 16u;
+  result->max_uniform_buffers_per_stage =
+      (uint32_t)NGF_MIN(max_vert_ubos, max_frag_ubos);
+  // Textures and samplers are combined in GL, so both limits are the number
+  // of texture units.
+  result->max_sampled_images_per_stage = (uint32_t)max_texture_units;
+  result->max_samplers_per_stage = (uint32_t)max_texture_units;
+  result->max_color_attachments = (uint32_t)max_color_attachments;
+  result->max_image_dimension_2d = (uint32_t)max_texture_size;
+  result->max_sample_count = (uint32_t)NGF_MAX(max_samples, 1);
+  // GL timestamps are always in nanoseconds.
+  result->timestamp_period = 1.0f;
+  // Both are core in GL 4.3 (glMultiDraw*Indirect and base instance).
+  result->multi_draw_indirect = true;
+  result->draw_indirect_first_instance = true;
+  return NGF_ERROR_OK;
+}
+
 void ngf_destroy_context(ngf_context ctx) {
   if (ctx) {
     if (ctx->ctx != EGL_NO_CONTEXT) {
@@ -674,6 +1136,24 @@ void ngf_destroy_context(ngf_context ctx) {
     if (ctx->surface != EGL_NO_SURFACE) {
       eglDestroySurface(ctx->dpy, ctx->surface);
     }
+    if (CURRENT_CONTEXT == ctx && ctx->push_constants.ring_buffer != GL_NONE) {
+      glDeleteBuffers(1, &ctx->push_constants.ring_buffer);
+    }
+    if (ctx->gpu_timing != NULL) {
+      if (CURRENT_CONTEXT == ctx) {
+        glDeleteQueries((GLsizei)(NGF_ARRAYSIZE(ctx->gpu_timing->queries) *
+                                  NGF_ARRAYSIZE(ctx->gpu_timing->queries[0])),
+                        &ctx->gpu_timing->queries[0][0]);
+      }
+      NGF_FREE(ctx->gpu_timing);
+    }
+    if (CURRENT_CONTEXT == ctx) {
+      for (uint32_t f = 0u; f < NGF_MAX_QUEUED_FRAMES; ++f) {
+        if (ctx->pacing.fences[f] != NULL) {
+          glDeleteSync(ctx->pacing.fences[f]);
+        }
+      }
+    }
     eglTerminate(ctx->dpy);
     _NGF_DARRAY_DESTROY(ctx->cached_state.vbuf_table);
     NGF_FREE(ctx);
@@ -711,6 +1191,7 @@ ngf_error _ngf_compile_shader(const char *source, GLint source_len,
                               GLenum stage,
                               const ngf_specialization_info *spec_info,
                               GLuint *result) {
+  const uint64_t start_ns = _ngf_timeline_now();
   ngf_error err = NGF_ERROR_OK;
   *result = GL_NONE;
   GLuint shader = GL_NONE;
@@ -866,6 +1347,7 @@ _ngf_compile_shader_cleanup:
   if (err != NGF_ERROR_OK && *result != GL_NONE) {
     glDeleteProgram(*result);
   }
+  _ngf_timeline_scope("shader compile", start_ns);
   return err;
 }
 
@@ -957,9 +1439,11 @@ const ngf_plmd_cis_map_entry * _lookup_cis_map(uint32_t set, uint32_t binding,
 ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
                                        ngf_graphics_pipeline *result) {
   static uint32_t global_id = 0;
+  const uint64_t start_ns = _ngf_timeline_now();
   ngf_error err = NGF_ERROR_OK;
 
-  *result = NGF_ALLOC(struct ngf_graphics_pipeline_t);
+  *result = NGF_ALLOC_AS(struct ngf_graphics_pipeline_t,
+                         NGF_ALLOCATION_PIPELINE);
   ngf_graphics_pipeline pipeline = *result;
   if (pipeline == NULL) {
     err = NGF_ERROR_OUTOFMEM;
@@ -980,8 +1464,9 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
   pipeline->nvert_buf_bindings = input->nvert_buf_bindings;
   if (input->nvert_buf_bindings > 0) {
     ngf_vertex_buf_binding_desc *vert_buf_bindings =
-        NGF_ALLOCN(ngf_vertex_buf_binding_desc,
-                   input->nvert_buf_bindings);
+        NGF_ALLOCN_AS(ngf_vertex_buf_binding_desc,
+                      input->nvert_buf_bindings,
+                      NGF_ALLOCATION_PIPELINE);
     pipeline->vert_buf_bindings = vert_buf_bindings;
     if (pipeline->vert_buf_bindings == NULL) {
       err = NGF_ERROR_OUTOFMEM;
@@ -1004,6 +1489,9 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
   if (err != NGF_ERROR_OK) {
     goto ngf_create_pipeline_cleanup;
   }
+  pipeline->push_constants_binding =
+      _ngf_push_constants_native_binding(pipeline_layout);
+  pipeline->push_constants_size = pipeline_layout->push_constants_size;
 
   // Store attribute format in VAO.
   glGenVertexArrays(1, &pipeline->vao);
@@ -1062,6 +1550,22 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
 
   // Set dynamic state mask.
   pipeline->dynamic_state_mask = info->dynamic_state_mask;
+  pipeline->dynamic_state_groups = 0u;
+  if (pipeline->dynamic_state_mask & NGF_DYNAMIC_STATE_VIEWPORT) {
+    pipeline->dynamic_state_groups |=
+        _NGF_GL_STATE_BIT(_NGF_GL_STATE_VIEWPORT);
+  }
+  if (pipeline->dynamic_state_mask & NGF_DYNAMIC_STATE_SCISSOR) {
+    pipeline->dynamic_state_groups |=
+        _NGF_GL_STATE_BIT(_NGF_GL_STATE_SCISSOR);
+  }
+  if (pipeline->dynamic_state_mask & NGF_DYNAMIC_STATE_LINE_WIDTH) {
+    pipeline->dynamic_state_groups |=
+        _NGF_GL_STATE_BIT(_NGF_GL_STATE_LINE_WIDTH);
+  }
+
+  // Pack fixed-function state for fast diffing at bind time.
+  _ngf_pack_pipeline_state(pipeline, &pipeline->state);
 
   // Assign a unique id to the pipeline.
   pipeline->id = ++global_id;
@@ -1070,6 +1574,7 @@ ngf_create_pipeline_cleanup:
   if (err != NGF_ERROR_OK) {
     ngf_destroy_graphics_pipeline(pipeline);
   } 
+  _ngf_timeline_scope("ngf_create_graphics_pipeline", start_ns);
   return err;
 }
 
@@ -1077,15 +1582,100 @@ void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline pipeline) {
   if (pipeline) {
     if (pipeline->nvert_buf_bindings > 0 &&
         pipeline->vert_buf_bindings) {
-      NGF_FREEN(pipeline->vert_buf_bindings, pipeline->nvert_buf_bindings);
+      NGF_FREEN_AS(pipeline->vert_buf_bindings, pipeline->nvert_buf_bindings,
+                   NGF_ALLOCATION_PIPELINE);
     }
     _ngf_destroy_binding_map(pipeline->binding_map);
+    if (CURRENT_CONTEXT &&
+        CURRENT_CONTEXT->cached_state.bound_pipeline == pipeline) {
+      // Deleting bound objects reverts the bindings to zero.
+      CURRENT_CONTEXT->cached_state.bound_pipeline = NULL;
+      CURRENT_CONTEXT->cached_state.pipeline_state
+          .words[_NGF_GL_WORD_PROGRAM] = 0u;
+      CURRENT_CONTEXT->cached_state.pipeline_state
+          .words[_NGF_GL_WORD_VERTEX_INPUT] = 0u;
+    }
     glDeleteProgramPipelines(1, &pipeline->program_pipeline);
     glDeleteVertexArrays(1, &pipeline->vao);
     for (uint32_t s = 0u; s < pipeline->nowned_stages; ++s) {
       glDeleteProgram(pipeline->owned_stages[s]);
     }
-    NGF_FREEN(pipeline, 1);
+    NGF_FREE_AS(pipeline, NGF_ALLOCATION_PIPELINE);
+  }
+}
+
+ngf_error ngf_create_compute_pipeline(const ngf_compute_pipeline_info *info,
+                                      ngf_compute_pipeline *result) {
+  assert(info);
+  assert(result);
+  const uint64_t start_ns = _ngf_timeline_now();
+  ngf_error err = NGF_ERROR_OK;
+
+  *result = NGF_ALLOC_AS(struct ngf_compute_pipeline_t,
+                         NGF_ALLOCATION_PIPELINE);
+  ngf_compute_pipeline pipeline = *result;
+  if (pipeline == NULL) {
+    err = NGF_ERROR_OUTOFMEM;
+    goto ngf_create_compute_pipeline_cleanup;
+  }
+  pipeline->program_pipeline = GL_NONE;
+  pipeline->binding_map = NULL;
+  pipeline->owned_stage = GL_NONE;
+
+  const ngf_shader_stage stage = info->shader_stage;
+  if (stage->gltype != GL_COMPUTE_SHADER) {
+    err = NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+    goto ngf_create_compute_pipeline_cleanup;
+  }
+
+  err = _ngf_create_native_binding_map(info->layout, NULL, NULL,
+                                       &pipeline->binding_map);
+  if (err != NGF_ERROR_OK) {
+    goto ngf_create_compute_pipeline_cleanup;
+  }
+  pipeline->push_constants_binding =
+      _ngf_push_constants_native_binding(info->layout);
+  pipeline->push_constants_size = info->layout->push_constants_size;
+
+  glGenProgramPipelines(1, &pipeline->program_pipeline);
+  if (info->spec_info == NULL || info->spec_info->nspecializations == 0u) {
+    glUseProgramStages(pipeline->program_pipeline, stage->glstagebit,
+                       stage->glprogram);
+  } else if (stage->source_code != NULL) {
+    err = _ngf_compile_shader(stage->source_code, stage->source_code_size, "",
+                              stage->gltype, info->spec_info,
+                              &pipeline->owned_stage);
+    if (err != NGF_ERROR_OK) {
+      goto ngf_create_compute_pipeline_cleanup;
+    }
+    glUseProgramStages(pipeline->program_pipeline, stage->glstagebit,
+                       pipeline->owned_stage);
+  } else {
+    err = NGF_ERROR_CANNOT_SPECIALIZE_SHADER_STAGE_BINARY;
+  }
+
+ngf_create_compute_pipeline_cleanup:
+  if (err != NGF_ERROR_OK) {
+    ngf_destroy_compute_pipeline(pipeline);
+  }
+  _ngf_timeline_scope("ngf_create_compute_pipeline", start_ns);
+  return err;
+}
+
+void ngf_destroy_compute_pipeline(ngf_compute_pipeline pipeline) {
+  if (pipeline) {
+    _ngf_destroy_binding_map(pipeline->binding_map);
+    if (CURRENT_CONTEXT &&
+        CURRENT_CONTEXT->cached_state.pipeline_state
+            .words[_NGF_GL_WORD_PROGRAM] == pipeline->program_pipeline) {
+      CURRENT_CONTEXT->cached_state.pipeline_state
+          .words[_NGF_GL_WORD_PROGRAM] = 0u;
+    }
+    glDeleteProgramPipelines(1, &pipeline->program_pipeline);
+    if (pipeline->owned_stage != GL_NONE) {
+      glDeleteProgram(pipeline->owned_stage);
+    }
+    NGF_FREE_AS(pipeline, NGF_ALLOCATION_PIPELINE);
   }
 }
 
@@ -1101,12 +1691,14 @@ ngf_error ngf_create_image(const ngf_image_info *info, ngf_image *result) {
 
   const glformat glf = get_gl_format(info->format);
   image->glformat = glf.format;
+  image->glinternalformat = glf.internal_format;
   image->is_srgb = glf.srgb;
   image->gltype = glf.type;
   image->is_multisample = info->nsamples > 1;
 
   const bool cant_use_renderbuffer =
       info->usage_hint & NGF_IMAGE_USAGE_SAMPLE_FROM ||
+      info->usage_hint & NGF_IMAGE_USAGE_STORAGE ||
       info->nmips > 1 ||
       info->extent.depth > 1 ||
       info->type != NGF_IMAGE_TYPE_IMAGE_2D;
@@ -1191,6 +1783,7 @@ ngf_error ngf_create_image(const ngf_image_info *info, ngf_image *result) {
                                        (GLsizei)info->extent.height);
     }
   }
+  _NGF_STAT_ADD(_NGF_STAT_IMAGES_CREATED, 1u);
   return NGF_ERROR_OK;
 }
 
@@ -1201,10 +1794,47 @@ void ngf_destroy_image(ngf_image image) {
     } else {
       glDeleteRenderbuffers(1, &(image->glimage));
     }
+    _NGF_STAT_ADD(_NGF_STAT_IMAGES_DESTROYED, 1u);
     NGF_FREE(image);
   }
 }
 
+// Every image has memory of its own, so images can only be shared between
+// requests with the same configuration.
+static ngf_error _ngf_create_transient_image(
+    ngf_transient_pool              pool,
+    const ngf_transient_image_info *info,
+    ngf_image                      *result,
+    uint32_t                       *block) {
+  _NGF_FAKE_USE(pool);
+  *block = _NGF_TRANSIENT_NO_BLOCK;
+  return ngf_create_image(&info->image_info, result);
+}
+
+ngf_error ngf_create_transient_pool(ngf_transient_pool *result) {
+  return _ngf_transient_pool_create(result);
+}
+
+void ngf_destroy_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_destroy(pool, ngf_destroy_image, NULL);
+}
+
+ngf_error ngf_acquire_transient_image(ngf_transient_pool pool,
+                                      const ngf_transient_image_info *info,
+                                      ngf_image *result) {
+  return _ngf_transient_acquire(pool, info, _ngf_create_transient_image,
+                                result);
+}
+
+void ngf_reset_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_reset(pool, ngf_destroy_image, NULL);
+}
+
+void ngf_get_transient_pool_stats(ngf_transient_pool pool,
+                                  ngf_transient_pool_stats *result) {
+  _ngf_transient_pool_stats(pool, result);
+}
+
 ngf_error ngf_create_sampler(const ngf_sampler_info *info,
                              ngf_sampler *result) {
   assert(info);
@@ -1424,6 +2054,7 @@ GLuint _ngf_create_buffer(GLenum type,
   GLuint buf;
   glGenBuffers(1u, &buf);
   glBindBuffer(type, buf);
+  _NGF_STAT_ADD(_NGF_STAT_BUFFERS_CREATED, 1u);
   GLenum gl_buffer_usage = GL_NONE;
   switch (info->storage_type) {
   case NGF_BUFFER_STORAGE_HOST_READABLE:
@@ -1448,6 +2079,7 @@ void* _ngf_buffer_map_range(GLenum bind_target,
                             uint32_t flags) {
   // TODO: return NULL if buffer uses private storage.
   glBindBuffer(bind_target, gl_buffer);
+  _NGF_STAT_ADD(_NGF_STAT_BYTES_MAPPED, size);
   GLbitfield map_access = GL_MAP_UNSYNCHRONIZED_BIT;
   if (flags & NGF_BUFFER_MAP_READ_BIT) map_access |= GL_MAP_READ_BIT;
   if (flags & NGF_BUFFER_MAP_WRITE_BIT) map_access |= GL_MAP_WRITE_BIT |
@@ -1490,7 +2122,11 @@ ngf_error ngf_create_attrib_buffer(const ngf_attrib_buffer_info *info,
 
 void ngf_destroy_attrib_buffer(ngf_attrib_buffer buf) {
   if (buf != NULL) {
+    if (CURRENT_CONTEXT->cached_state.bound_indirect_buffer == buf->glbuffer) {
+      CURRENT_CONTEXT->cached_state.bound_indirect_buffer = GL_NONE;
+    }
     glDeleteBuffers(1u, &buf->glbuffer);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buf);
   }
 }
@@ -1534,6 +2170,7 @@ ngf_error ngf_create_index_buffer(const ngf_index_buffer_info *info,
 void ngf_destroy_index_buffer(ngf_index_buffer buf) {
   if (buf != NULL) {
     glDeleteBuffers(1u, &buf->glbuffer);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buf);
   }
 }
@@ -1577,6 +2214,7 @@ ngf_error ngf_create_uniform_buffer(const ngf_uniform_buffer_info *info,
 void ngf_destroy_uniform_buffer(ngf_uniform_buffer buf) {
   if (buf != NULL) {
     glDeleteBuffers(1u, &buf->glbuffer);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buf);
   }
 }
@@ -1654,6 +2292,7 @@ void ngf_pixel_buffer_unmap(ngf_pixel_buffer buf) {
 void ngf_destroy_pixel_buffer(ngf_pixel_buffer buf) {
   if (buf != NULL) {
     glDeleteBuffers(1, &buf->glbuffer);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buf);
   }
 }
@@ -1674,6 +2313,7 @@ ngf_error ngf_create_cmd_buffer(const ngf_cmd_buffer_info *info,
   buf->first_cmd_block = buf->last_cmd_block = NULL;
   buf->state = _NGF_CMD_BUFFER_READY;
   buf->renderpass_active = false;
+  _NGF_DARRAY_RESET(buf->dynamic_ubos, 4u);
   return err;
 }
 
@@ -1692,6 +2332,7 @@ void _ngf_cmd_buffer_free_cmds(ngf_cmd_buffer buf) {
 void ngf_destroy_cmd_buffer(ngf_cmd_buffer buf) {
   if (buf != NULL) {
     _ngf_cmd_buffer_free_cmds(buf);
+    _NGF_DARRAY_DESTROY(buf->dynamic_ubos);
     NGF_FREE(buf);
   }
 }
@@ -1706,6 +2347,7 @@ ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer buf) {
     _ngf_cmd_buffer_free_cmds(buf);
   }
   buf->first_cmd_block = _ngf_blkalloc_alloc(COMMAND_POOL);
+  _NGF_STAT_ADD(_NGF_STAT_CMD_BLOCKS_ALLOCATED, 1u);
   if (buf->first_cmd_block == NULL) {
     err = NGF_ERROR_OUTOFMEM;
     NGF_FREE(buf);
@@ -1715,8 +2357,31 @@ ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer buf) {
     buf->last_cmd_block = buf->first_cmd_block;
   }
   buf->bound_pipeline = NULL;
+  buf->bound_compute_pipeline = NULL;
+  _NGF_DARRAY_CLEAR(buf->dynamic_ubos);
   return err;
 }
+#define _NGF_NEWCMD(enc, cmd) {\
+  ngf_cmd_buffer buf = (ngf_cmd_buffer)(void*)enc.__handle; \
+  if (buf->last_cmd_block->next_cmd_idx == _NGF_CMDS_PER_CMD_BLOCK) { \
+    buf->last_cmd_block->next = _ngf_blkalloc_alloc(COMMAND_POOL); \
+    _NGF_STAT_ADD(_NGF_STAT_CMD_BLOCKS_ALLOCATED, 1u); \
+    buf->last_cmd_block = buf->last_cmd_block->next; \
+    buf->last_cmd_block->next = NULL; \
+    buf->last_cmd_block->next_cmd_idx = 0u; \
+  } \
+  cmd = &buf->last_cmd_block->cmds[buf->last_cmd_block->next_cmd_idx++]; \
+}
+
+// Records a command opening or closing a timing scope (which is also a debug
+// group).
+#define _NGF_NEWSCOPECMD(enc, cmd_type, name) {\
+  _ngf_emulated_cmd *scope_cmd = NULL; \
+  _NGF_NEWCMD(enc, scope_cmd); \
+  scope_cmd->type = cmd_type; \
+  scope_cmd->scope_name = name; \
+}
+
 ngf_error ngf_cmd_buffer_start_render(ngf_cmd_buffer buf,
                                       ngf_render_encoder *enc) {
   if (buf->state != _NGF_CMD_BUFFER_READY) {
@@ -1724,6 +2389,7 @@ ngf_error ngf_cmd_buffer_start_render(ngf_cmd_buffer buf,
     return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
   }
   enc->__handle = (uintptr_t)buf;
+  _NGF_NEWSCOPECMD((*enc), _NGF_CMD_BEGIN_SCOPE, "render encoder");
   return NGF_ERROR_OK;
 }
 
@@ -1734,6 +2400,18 @@ ngf_error ngf_cmd_buffer_start_xfer(ngf_cmd_buffer buf,
     return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
   }
   enc->__handle = (uintptr_t)buf;
+  _NGF_NEWSCOPECMD((*enc), _NGF_CMD_BEGIN_SCOPE, "xfer encoder");
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_cmd_buffer_start_compute(ngf_cmd_buffer buf,
+                                       ngf_compute_encoder *enc) {
+  if (buf->state != _NGF_CMD_BUFFER_READY) {
+    enc->__handle = 0u;
+    return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
+  }
+  enc->__handle = (uintptr_t)buf;
+  _NGF_NEWSCOPECMD((*enc), _NGF_CMD_BEGIN_SCOPE, "compute encoder");
   return NGF_ERROR_OK;
 }
 
@@ -1741,26 +2419,28 @@ ngf_error ngf_render_encoder_end(ngf_render_encoder enc) {
   if (((ngf_cmd_buffer)enc.__handle)->renderpass_active) {
     return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
   }
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_END_SCOPE, NULL);
   enc.__handle = 0u;
   return NGF_ERROR_OK;
 }
 
 ngf_error ngf_xfer_encoder_end(ngf_xfer_encoder enc) {
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_END_SCOPE, NULL);
   enc.__handle = 0u;
   return NGF_ERROR_OK;
 }
 
-#define _NGF_NEWCMD(enc, cmd) {\
-  ngf_cmd_buffer buf = (ngf_cmd_buffer)(void*)enc.__handle; \
-  if (buf->last_cmd_block->next_cmd_idx == _NGF_CMDS_PER_CMD_BLOCK) { \
-    buf->last_cmd_block->next = _ngf_blkalloc_alloc(COMMAND_POOL); \
-    buf->last_cmd_block = buf->last_cmd_block->next; \
-    buf->last_cmd_block->next = NULL; \
-    buf->last_cmd_block->next_cmd_idx = 0u; \
-  } \
-  cmd = &buf->last_cmd_block->cmds[buf->last_cmd_block->next_cmd_idx++]; \
-}
 
+ngf_error ngf_compute_encoder_end(ngf_compute_encoder enc) {
+  // Make the writes done by the dispatches in this encoder visible to
+  // subsequent commands.
+  _ngf_emulated_cmd *cmd = NULL;
+  _NGF_NEWCMD(enc, cmd);
+  cmd->type = _NGF_CMD_MEMORY_BARRIER;
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_END_SCOPE, NULL);
+  enc.__handle = 0u;
+  return NGF_ERROR_OK;
+}
 
 void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc,
                                const ngf_graphics_pipeline pipeline) {
@@ -1770,6 +2450,7 @@ void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc,
   cmd->type = _NGF_CMD_BIND_PIPELINE;
   cmd->pipeline = pipeline;
   ((ngf_cmd_buffer)enc.__handle)->bound_pipeline = pipeline;
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
 }
 
 void ngf_cmd_viewport(ngf_render_encoder enc, const ngf_irect2d *viewport) {
@@ -1830,14 +2511,41 @@ void ngf_cmd_blend_factors(ngf_render_encoder enc,
   cmd->blend_factors.dfactor = dfactor;
 }
 
-void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
-                                const ngf_resource_bind_op *bind_ops,
-                                uint32_t nbind_ops) {
-  ngf_cmd_buffer cmdbuf = (ngf_cmd_buffer)enc.__handle;
+// Adds or replaces an entry in the command buffer's table of bound dynamic
+// uniform buffers, keeping it sorted.
+static void _ngf_record_dynamic_ubo(ngf_cmd_buffer buf,
+                                    const _ngf_dynamic_ubo_binding *binding) {
+  const uint32_t nentries = (uint32_t)_NGF_DARRAY_SIZE(buf->dynamic_ubos);
+  for (uint32_t e = 0u; e < nentries; ++e) {
+    _ngf_dynamic_ubo_binding *entry = &_NGF_DARRAY_AT(buf->dynamic_ubos, e);
+    if (entry->set == binding->set && entry->binding == binding->binding) {
+      *entry = *binding;
+      return;
+    }
+  }
+  _NGF_DARRAY_APPEND(buf->dynamic_ubos, *binding);
+  for (uint32_t e = nentries; e > 0u; --e) {
+    _ngf_dynamic_ubo_binding *prev = &_NGF_DARRAY_AT(buf->dynamic_ubos, e - 1u);
+    _ngf_dynamic_ubo_binding *curr = &_NGF_DARRAY_AT(buf->dynamic_ubos, e);
+    if (prev->set < curr->set ||
+        (prev->set == curr->set && prev->binding < curr->binding)) {
+      break;
+    }
+    const _ngf_dynamic_ubo_binding tmp = *prev;
+    *prev = *curr;
+    *curr = tmp;
+  }
+}
+
+static void _ngf_cmd_bind_resources(ngf_render_encoder enc,
+                                    const _ngf_native_binding_map binding_map,
+                                    const ngf_resource_bind_op *bind_ops,
+                                    uint32_t nbind_ops) {
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, nbind_ops);
   for (uint32_t o = 0u; o < nbind_ops; ++o) {
     const ngf_resource_bind_op *bind_op = &bind_ops[o];
     const _ngf_native_binding *native_binding =
-        _ngf_binding_map_lookup(cmdbuf->bound_pipeline->binding_map,
+        _ngf_binding_map_lookup(binding_map,
                                 bind_op->target_set,
                                 bind_op->target_binding);
     if (native_binding == NULL) {
@@ -1852,6 +2560,18 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
       continue;
     }
     switch (bind_op->type) {
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC: {
+      const _ngf_dynamic_ubo_binding dynamic_ubo = {
+        .set = bind_op->target_set,
+        .binding = bind_op->target_binding,
+        .native_binding = native_binding->native_binding_id,
+        .buffer = bind_op->info.uniform_buffer.buffer->glbuffer,
+        .base_offset = (GLsizei)bind_op->info.uniform_buffer.offset,
+        .range = (GLsizei)bind_op->info.uniform_buffer.range
+      };
+      _ngf_record_dynamic_ubo((ngf_cmd_buffer)enc.__handle, &dynamic_ubo);
+    }
+    // Fall through.
     case NGF_DESCRIPTOR_UNIFORM_BUFFER: {
       _ngf_emulated_cmd *uniform_buffer_bind_cmd = NULL;
       _NGF_NEWCMD(enc, uniform_buffer_bind_cmd);
@@ -1906,13 +2626,151 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
       sampler_bind_cmd->sampler_bind_op.unit =
           native_binding->native_binding_id;
       break;
-    default:
+    }
+    case NGF_DESCRIPTOR_STORAGE_BUFFER: {
+      _ngf_emulated_cmd *storage_buffer_bind_cmd = NULL;
+      _NGF_NEWCMD(enc, storage_buffer_bind_cmd);
+      storage_buffer_bind_cmd->type = _NGF_CMD_BIND_STORAGE_BUFFER;
+      storage_buffer_bind_cmd->storage_buffer_bind_op.buffer =
+          bind_op->info.storage_buffer.buffer->glbuffer;
+      storage_buffer_bind_cmd->storage_buffer_bind_op.index =
+          native_binding->native_binding_id;
+      storage_buffer_bind_cmd->storage_buffer_bind_op.offset =
+          bind_op->info.storage_buffer.offset;
+      storage_buffer_bind_cmd->storage_buffer_bind_op.range =
+          bind_op->info.storage_buffer.range;
+      break;
+    }
+    case NGF_DESCRIPTOR_STORAGE_IMAGE: {
+      _ngf_emulated_cmd *storage_image_bind_cmd = NULL;
+      _NGF_NEWCMD(enc, storage_image_bind_cmd);
+      storage_image_bind_cmd->type = _NGF_CMD_BIND_STORAGE_IMAGE;
+      storage_image_bind_cmd->storage_image_bind_op.image =
+          bind_op->info.storage_image.image;
+      storage_image_bind_cmd->storage_image_bind_op.unit =
+          native_binding->native_binding_id;
+      storage_image_bind_cmd->storage_image_bind_op.level =
+          (GLint)bind_op->info.storage_image.mip_level;
+      storage_image_bind_cmd->storage_image_bind_op.layer =
+          (GLint)bind_op->info.storage_image.layer;
       break;
     }
+    default:
+      break;
     }
   }
 }
 
+void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
+                                const ngf_resource_bind_op *bind_ops,
+                                uint32_t nbind_ops) {
+  ngf_cmd_buffer cmdbuf = (ngf_cmd_buffer)enc.__handle;
+  _ngf_cmd_bind_resources(enc, cmdbuf->bound_pipeline->binding_map,
+                          bind_ops, nbind_ops);
+}
+
+void ngf_cmd_set_dynamic_offsets(ngf_render_encoder enc, uint32_t set,
+                                 const uint32_t *offsets, uint32_t noffsets) {
+  const ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  const uint32_t nentries = (uint32_t)_NGF_DARRAY_SIZE(buf->dynamic_ubos);
+  uint32_t o = 0u;
+  for (uint32_t e = 0u; e < nentries && o < noffsets; ++e) {
+    const _ngf_dynamic_ubo_binding *entry =
+        &_NGF_DARRAY_AT(buf->dynamic_ubos, e);
+    if (entry->set != set) continue;
+    _ngf_emulated_cmd *cmd = NULL;
+    _NGF_NEWCMD(enc, cmd);
+    cmd->type = _NGF_CMD_BIND_UNIFORM_BUFFER;
+    cmd->uniform_buffer_bind_op.buffer = entry->buffer;
+    cmd->uniform_buffer_bind_op.index = entry->native_binding;
+    cmd->uniform_buffer_bind_op.offset =
+        entry->base_offset + (GLsizei)offsets[o++];
+    cmd->uniform_buffer_bind_op.range = entry->range;
+  }
+  assert(o == noffsets);
+}
+
+void ngf_cmd_bind_compute_pipeline(ngf_compute_encoder enc,
+                                   const ngf_compute_pipeline pipeline) {
+  _ngf_emulated_cmd *cmd = NULL;
+  _NGF_NEWCMD(enc, cmd);
+  cmd->type = _NGF_CMD_BIND_COMPUTE_PIPELINE;
+  cmd->compute_pipeline = pipeline;
+  ((ngf_cmd_buffer)enc.__handle)->bound_compute_pipeline = pipeline;
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
+}
+
+void ngf_cmd_bind_compute_resources(ngf_compute_encoder enc,
+                                    const ngf_resource_bind_op *bind_ops,
+                                    uint32_t nbind_ops) {
+  ngf_cmd_buffer cmdbuf = (ngf_cmd_buffer)enc.__handle;
+  const ngf_render_encoder cmd_enc = {enc.__handle};
+  _ngf_cmd_bind_resources(cmd_enc, cmdbuf->bound_compute_pipeline->binding_map,
+                          bind_ops, nbind_ops);
+}
+
+static void _ngf_cmd_push_constants(ngf_cmd_buffer buf, GLuint binding,
+                                    uint32_t block_size, const void *data,
+                                    uint32_t offset, uint32_t size) {
+  assert(offset % 4u == 0u && size % 4u == 0u);
+  assert(offset + size <= block_size);
+  const ngf_render_encoder enc = {(uintptr_t)(void*)buf};
+  const uint8_t *src = (const uint8_t*)data;
+  while (size > 0u) {
+    const uint32_t chunk_size = NGF_MIN(size, _NGF_PUSH_CONSTANTS_CHUNK_SIZE);
+    _ngf_emulated_cmd *cmd = NULL;
+    _NGF_NEWCMD(enc, cmd);
+    cmd->type = _NGF_CMD_PUSH_CONSTANTS;
+    memcpy(cmd->push_constants.data, src, chunk_size);
+    cmd->push_constants.offset = (uint16_t)offset;
+    cmd->push_constants.size = (uint16_t)chunk_size;
+    cmd->push_constants.block_size = (uint16_t)block_size;
+    cmd->push_constants.binding = (uint16_t)binding;
+    src += chunk_size;
+    offset += chunk_size;
+    size -= chunk_size;
+  }
+}
+
+void ngf_cmd_push_constants(ngf_render_encoder enc, const void *data,
+                            uint32_t offset, uint32_t size) {
+  const ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  assert(buf->bound_pipeline);
+  _ngf_cmd_push_constants(buf, buf->bound_pipeline->push_constants_binding,
+                          buf->bound_pipeline->push_constants_size, data,
+                          offset, size);
+}
+
+void ngf_cmd_push_compute_constants(ngf_compute_encoder enc, const void *data,
+                                    uint32_t offset, uint32_t size) {
+  const ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  assert(buf->bound_compute_pipeline);
+  _ngf_cmd_push_constants(buf,
+                          buf->bound_compute_pipeline->push_constants_binding,
+                          buf->bound_compute_pipeline->push_constants_size,
+                          data, offset, size);
+}
+
+void ngf_cmd_dispatch(ngf_compute_encoder enc, uint32_t ngroups_x,
+                      uint32_t ngroups_y, uint32_t ngroups_z) {
+  _ngf_emulated_cmd *cmd = NULL;
+  _NGF_NEWCMD(enc, cmd);
+  cmd->type = _NGF_CMD_DISPATCH;
+  cmd->dispatch.ngroups_x = ngroups_x;
+  cmd->dispatch.ngroups_y = ngroups_y;
+  cmd->dispatch.ngroups_z = ngroups_z;
+}
+
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc,
+                               const ngf_attrib_buffer args, size_t offset) {
+  assert(offset % 4u == 0u);
+  _ngf_emulated_cmd *cmd = NULL;
+  _NGF_NEWCMD(enc, cmd);
+  cmd->type = _NGF_CMD_DISPATCH_INDIRECT;
+  cmd->dispatch_indirect.args_buffer = args->glbuffer;
+  cmd->dispatch_indirect.offset = offset;
+}
+
 void ngf_cmd_bind_attrib_buffer(ngf_render_encoder enc,
                                 const ngf_attrib_buffer vbuf,
                                 uint32_t binding, uint32_t offset) {
@@ -1922,6 +2780,7 @@ void ngf_cmd_bind_attrib_buffer(ngf_render_encoder enc,
   cmd->attrib_buffer_bind_op.binding = binding;
   cmd->attrib_buffer_bind_op.buf = vbuf;
   cmd->attrib_buffer_bind_op.offset = offset;
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, 1u);
 }
 
 void ngf_cmd_bind_index_buffer(ngf_render_encoder enc,
@@ -1932,9 +2791,11 @@ void ngf_cmd_bind_index_buffer(ngf_render_encoder enc,
   cmd->type = _NGF_CMD_BIND_INDEX_BUFFER;
   cmd->index_buffer_bind.index_buffer = idxbuf;
   cmd->index_buffer_bind.type = index_type;
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, 1u);
 }
 
 void ngf_cmd_begin_pass(ngf_render_encoder enc, const ngf_render_target target) {
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_BEGIN_SCOPE, "pass");
   _ngf_emulated_cmd *cmd = NULL;
   _NGF_NEWCMD(enc, cmd);
   cmd->type = _NGF_CMD_BEGIN_PASS;
@@ -1947,6 +2808,26 @@ void ngf_cmd_end_pass(ngf_render_encoder enc) {
   _ngf_emulated_cmd *cmd = NULL;
   _NGF_NEWCMD(enc, cmd);
   cmd->type = _NGF_CMD_END_PASS;
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_END_SCOPE, NULL);
+}
+
+void ngf_cmd_begin_debug_group(ngf_render_encoder enc, const char *name) {
+  assert(name);
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_BEGIN_SCOPE, name);
+}
+
+void ngf_cmd_end_debug_group(ngf_render_encoder enc) {
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_END_SCOPE, NULL);
+}
+
+void ngf_cmd_begin_compute_debug_group(ngf_compute_encoder enc,
+                                       const char *name) {
+  assert(name);
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_BEGIN_SCOPE, name);
+}
+
+void ngf_cmd_end_compute_debug_group(ngf_compute_encoder enc) {
+  _NGF_NEWSCOPECMD(enc, _NGF_CMD_END_SCOPE, NULL);
 }
 
 void ngf_cmd_draw(ngf_render_encoder enc, bool indexed,
@@ -1959,6 +2840,23 @@ void ngf_cmd_draw(ngf_render_encoder enc, bool indexed,
   cmd->draw.nelements = nelements;
   cmd->draw.ninstances = ninstances;
   cmd->draw.indexed = indexed;
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, 1u);
+  _NGF_STAT_ADD(_NGF_STAT_INSTANCES, ninstances);
+}
+
+void ngf_cmd_draw_indirect(ngf_render_encoder enc, bool indexed,
+                           const ngf_attrib_buffer args, size_t offset,
+                           uint32_t ndraws, uint32_t stride) {
+  assert(offset % 4u == 0u);
+  _ngf_emulated_cmd *cmd = NULL;
+  _NGF_NEWCMD(enc, cmd);
+  cmd->type = _NGF_CMD_DRAW_INDIRECT;
+  cmd->draw_indirect.args_buffer = args->glbuffer;
+  cmd->draw_indirect.offset = offset;
+  cmd->draw_indirect.ndraws = ndraws;
+  cmd->draw_indirect.stride = stride;
+  cmd->draw_indirect.indexed = indexed;
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, ndraws);
 }
 
 void _ngf_cmd_copy_buffer(ngf_xfer_encoder enc,
@@ -1975,7 +2873,7 @@ void _ngf_cmd_copy_buffer(ngf_xfer_encoder enc,
   cmd->copy.size = size;
   cmd->copy.src_offset = src_offset;
   cmd->copy.dst_offset = dst_offset;
-
+  _NGF_STAT_ADD(_NGF_STAT_BYTES_UPLOADED, size);
 }
 
 void ngf_cmd_write_image(ngf_xfer_encoder enc,
@@ -2026,9 +2924,477 @@ void ngf_cmd_copy_uniform_buffer(ngf_xfer_encoder enc,
                        size, src_offset, dst_offset);
  }
 
+#pragma region ngf_impl_pipeline_state_setters
+
+typedef void (*_ngf_gl_state_setter)(const ngf_graphics_pipeline);
+
+static void _ngf_set_program_state(const ngf_graphics_pipeline pipeline) {
+  glBindProgramPipeline(pipeline->program_pipeline);
+}
+
+static void _ngf_set_viewport_state(const ngf_graphics_pipeline pipeline) {
+  glViewport((GLsizei)pipeline->viewport.x,
+             (GLsizei)pipeline->viewport.y,
+             (GLsizei)pipeline->viewport.width,
+             (GLsizei)pipeline->viewport.height);
+}
+
+static void _ngf_set_scissor_state(const ngf_graphics_pipeline pipeline) {
+  glScissor((GLsizei)pipeline->scissor.x,
+            (GLsizei)pipeline->scissor.y,
+            (GLsizei)pipeline->scissor.width,
+            (GLsizei)pipeline->scissor.height);
+}
+
+static void _ngf_set_discard_state(const ngf_graphics_pipeline pipeline) {
+  if (pipeline->rasterization.discard) {
+    glEnable(GL_RASTERIZER_DISCARD);
+  } else {
+    glDisable(GL_RASTERIZER_DISCARD);
+  }
+}
+
+static void _ngf_set_polygon_mode_state(const ngf_graphics_pipeline pipeline) {
+  glPolygonMode(GL_FRONT_AND_BACK,
+                get_gl_poly_mode(pipeline->rasterization.polygon_mode));
+}
+
+static void _ngf_set_cull_mode_state(const ngf_graphics_pipeline pipeline) {
+  if (pipeline->rasterization.cull_mode != NGF_CULL_MODE_NONE) {
+    glEnable(GL_CULL_FACE);
+    glCullFace(get_gl_cull_mode(pipeline->rasterization.cull_mode));
+  } else {
+    glDisable(GL_CULL_FACE);
+  }
+}
+
+static void _ngf_set_front_face_state(const ngf_graphics_pipeline pipeline) {
+  glFrontFace(get_gl_face(pipeline->rasterization.front_face));
+}
+
+static void _ngf_set_line_width_state(const ngf_graphics_pipeline pipeline) {
+  glLineWidth(pipeline->rasterization.line_width);
+}
+
+static void _ngf_set_multisample_state(const ngf_graphics_pipeline pipeline) {
+  if (pipeline->multisample.multisample) {
+    glEnable(GL_MULTISAMPLE);
+  } else {
+    glDisable(GL_MULTISAMPLE);
+  }
+}
+
+static void _ngf_set_alpha_to_coverage_state(
+    const ngf_graphics_pipeline pipeline) {
+  if (pipeline->multisample.alpha_to_coverage) {
+    glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+  } else {
+    glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+  }
+}
+
+static void _ngf_set_depth_test_state(const ngf_graphics_pipeline pipeline) {
+  if (pipeline->depth_stencil.depth_test) {
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(get_gl_compare(pipeline->depth_stencil.depth_compare));
+  } else {
+    glDisable(GL_DEPTH_TEST);
+  }
+}
+
+static void _ngf_set_depth_write_state(const ngf_graphics_pipeline pipeline) {
+  glDepthMask(pipeline->depth_stencil.depth_write ? GL_TRUE : GL_FALSE);
+}
+
+static void _ngf_set_stencil_face_state(GLenum                  face,
+                                        const ngf_stencil_info *stencil) {
+  glStencilFuncSeparate(face,
+                        get_gl_compare(stencil->compare_op),
+                        (GLint)stencil->reference,
+                        stencil->compare_mask);
+  glStencilOpSeparate(face,
+                      get_gl_stencil_op(stencil->fail_op),
+                      get_gl_stencil_op(stencil->depth_fail_op),
+                      get_gl_stencil_op(stencil->pass_op));
+  glStencilMaskSeparate(face, stencil->write_mask);
+}
+
+static void _ngf_set_stencil_state(const ngf_graphics_pipeline pipeline) {
+  const ngf_depth_stencil_info *depth_stencil = &pipeline->depth_stencil;
+  if (depth_stencil->stencil_test) {
+    glEnable(GL_STENCIL_TEST);
+    _ngf_set_stencil_face_state(GL_FRONT, &depth_stencil->front_stencil);
+    _ngf_set_stencil_face_state(GL_BACK, &depth_stencil->back_stencil);
+  } else {
+    glDisable(GL_STENCIL_TEST);
+  }
+}
+
+static void _ngf_set_depth_range_state(const ngf_graphics_pipeline pipeline) {
+  glDepthRangef(pipeline->depth_stencil.min_depth,
+                pipeline->depth_stencil.max_depth);
+}
+
+static void _ngf_set_blend_state(const ngf_graphics_pipeline pipeline) {
+  if (pipeline->blend.enable) {
+    glEnable(GL_BLEND);
+    glBlendFunc(get_gl_blendfactor(pipeline->blend.sfactor),
+                get_gl_blendfactor(pipeline->blend.dfactor));
+  } else {
+    glDisable(GL_BLEND);
+  }
+}
+
+static void _ngf_set_vertex_input_state(const ngf_graphics_pipeline pipeline) {
+  glBindVertexArray(pipeline->vao);
+  // Keep the same set of attribute buffers bound despite VAO change.
+  const size_t nvbuf_table_entries =
+      _NGF_DARRAY_SIZE(CURRENT_CONTEXT->cached_state.vbuf_table);
+  for (size_t e = 0; e < nvbuf_table_entries; ++e) {
+    bool found_binding = false;
+    const _ngf_vbuf_binding_info *vbuf_table_entry =
+        &_NGF_DARRAY_AT(CURRENT_CONTEXT->cached_state.vbuf_table, e);
+    // Update only bindings relevant to this pipeline.
+    for (uint32_t b = 0;
+         !found_binding && b < pipeline->nvert_buf_bindings;
+         ++b) {
+      if (pipeline->vert_buf_bindings[b].binding ==
+          vbuf_table_entry->binding) {
+        const GLsizei stride =
+          (GLsizei)pipeline->vert_buf_bindings[b].stride;
+        glBindVertexBuffer(vbuf_table_entry->binding,
+                           vbuf_table_entry->buffer,
+                           (GLintptr)vbuf_table_entry->offset,
+                           stride);
+        found_binding = true;
+      }
+    }
+  }
+
+  // Rebind index buffer.
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+               CURRENT_CONTEXT->cached_state.bound_index_buffer);
+}
+
+// Jump table of setters, indexed by state group.
+static const _ngf_gl_state_setter
+    _NGF_GL_STATE_SETTERS[_NGF_GL_STATE_GROUP_COUNT] = {
+  _ngf_set_program_state,
+  _ngf_set_viewport_state,
+  _ngf_set_scissor_state,
+  _ngf_set_discard_state,
+  _ngf_set_polygon_mode_state,
+  _ngf_set_cull_mode_state,
+  _ngf_set_front_face_state,
+  _ngf_set_line_width_state,
+  _ngf_set_multisample_state,
+  _ngf_set_alpha_to_coverage_state,
+  _ngf_set_depth_test_state,
+  _ngf_set_depth_write_state,
+  _ngf_set_stencil_state,
+  _ngf_set_depth_range_state,
+  _ngf_set_blend_state,
+  _ngf_set_vertex_input_state
+};
+
+// Applies only the state of the given pipeline that differs from what is
+// currently set in the GL context.
+static void _ngf_apply_pipeline_state(const ngf_graphics_pipeline pipeline) {
+  _ngf_gl_pipeline_state *cached_state =
+      &CURRENT_CONTEXT->cached_state.pipeline_state;
+  uint32_t changed_groups =
+      (_ngf_diff_pipeline_state(cached_state, &pipeline->state) |
+       CURRENT_CONTEXT->cached_state.clobbered_state_groups) &
+      ~pipeline->dynamic_state_groups;
+  while (changed_groups != 0u) {
+    const uint32_t group = _ngf_ctz32(changed_groups);
+    changed_groups &= changed_groups - 1u;
+    _NGF_GL_STATE_SETTERS[group](pipeline);
+  }
+  *cached_state = pipeline->state;
+  // State that is dynamic for this pipeline is left untouched, so the cached
+  // values for it are not reliable.
+  CURRENT_CONTEXT->cached_state.clobbered_state_groups =
+      pipeline->dynamic_state_groups;
+}
+
+// Writes the glInvalidateFramebuffer enums that correspond to the given
+// attachment into `out`, and returns how many were written. The desktop GL
+// specification uses different enums for attachments of the default
+// framebuffer (this distinction is not present on GLES 3).
+static uint32_t _ngf_gl_invalidate_enums(const ngf_attachment *attachment,
+                                         uint32_t              color_idx,
+                                         bool    is_default_framebuffer,
+                                         GLenum *out) {
+  switch (attachment->type) {
+  case NGF_ATTACHMENT_COLOR:
+    out[0] = is_default_framebuffer
+                 ? GL_COLOR
+                 : (GLenum)(GL_COLOR_ATTACHMENT0 + color_idx);
+    return 1u;
+  case NGF_ATTACHMENT_DEPTH:
+    out[0] = is_default_framebuffer ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
+    return 1u;
+  case NGF_ATTACHMENT_STENCIL:
+    out[0] = is_default_framebuffer ? GL_STENCIL : GL_STENCIL_ATTACHMENT;
+    return 1u;
+  case NGF_ATTACHMENT_DEPTH_STENCIL:
+    if (!is_default_framebuffer) {
+      out[0] = GL_DEPTH_STENCIL_ATTACHMENT;
+      return 1u;
+    }
+    out[0] = GL_DEPTH;
+    out[1] = GL_STENCIL;
+    return 2u;
+  default:
+    assert(false);
+  }
+  return 0u;
+}
+
+// Invalidates all attachments of the given render target for which `discard`
+// returns true, using a single glInvalidateFramebuffer call.
+static void _ngf_gl_invalidate_attachments(
+    const ngf_render_target rt,
+    bool (*discard)(const ngf_attachment*)) {
+  // +1 needed in case we need to handle depth/stencil separately.
+  GLenum *gl_attachments = alloca(sizeof(GLenum) * (rt->nattachments + 1u));
+  const bool is_default_framebuffer = rt->framebuffer == 0;
+  uint32_t ndiscarded_attachments = 0u;
+  uint32_t color_idx = 0u;
+  for (uint32_t a = 0u; a < rt->nattachments; ++a) {
+    const ngf_attachment *attachment = &rt->attachment_infos[a];
+    if (discard(attachment)) {
+      ndiscarded_attachments +=
+          _ngf_gl_invalidate_enums(attachment, color_idx,
+                                   is_default_framebuffer,
+                                   &gl_attachments[ndiscarded_attachments]);
+    }
+    if (attachment->type == NGF_ATTACHMENT_COLOR) ++color_idx;
+  }
+  if (ndiscarded_attachments > 0u) {
+    glInvalidateFramebuffer(GL_FRAMEBUFFER,
+                            (GLsizei)ndiscarded_attachments,
+                            gl_attachments);
+  }
+}
+
+static bool _ngf_load_op_is_dontcare(const ngf_attachment *attachment) {
+  return attachment->load_op == NGF_LOAD_OP_DONTCARE;
+}
+
+static bool _ngf_store_op_is_dontcare(const ngf_attachment *attachment) {
+  return attachment->store_op == NGF_STORE_OP_DONTCARE;
+}
+
+// Clears the attachments of the given render target that have a "clear" load
+// op. When every color attachment is cleared to the same value (which always
+// holds for single-attachment targets), all clears are merged into a single
+// glClear call. The scissor test is disabled for the duration of the clears
+// and enabled again afterwards. Depth/stencil write masks are only touched if
+// the cached pipeline state doesn't already allow the clear; afterwards
+// they're put back to match the cached state, so that rebinding the same
+// pipeline doesn't leave stale masks behind.
+static void _ngf_gl_clear_attachments(const ngf_render_target rt) {
+  const ngf_clear *color_clears[_NGF_MAX_DRAW_BUFFERS];
+  const ngf_clear *first_color_clear = NULL;
+  const ngf_clear *depth_clear = NULL;
+  const ngf_clear *stencil_clear = NULL;
+  uint32_t ncolors = 0u;
+  uint32_t ncolor_clears = 0u;
+  bool     uniform_color = true;
+  for (uint32_t a = 0u; a < rt->nattachments; ++a) {
+    const ngf_attachment *attachment = &rt->attachment_infos[a];
+    const bool cleared = attachment->load_op == NGF_LOAD_OP_CLEAR;
+    const ngf_clear *clear = cleared ? &attachment->clear : NULL;
+    switch (attachment->type) {
+    case NGF_ATTACHMENT_COLOR:
+      assert(ncolors < _NGF_MAX_DRAW_BUFFERS);
+      color_clears[ncolors++] = clear;
+      if (!cleared) break;
+      ++ncolor_clears;
+      if (first_color_clear == NULL) {
+        first_color_clear = clear;
+      } else if (memcmp(first_color_clear->clear_color, clear->clear_color,
+                        sizeof(clear->clear_color)) != 0) {
+        uniform_color = false;
+      }
+      break;
+    case NGF_ATTACHMENT_DEPTH:
+      depth_clear = clear;
+      break;
+    case NGF_ATTACHMENT_STENCIL:
+      stencil_clear = clear;
+      break;
+    case NGF_ATTACHMENT_DEPTH_STENCIL:
+      // ngf_clear can't hold both values, stencil is cleared to zero.
+      depth_clear = stencil_clear = clear;
+      break;
+    default:
+      assert(false);
+    }
+  }
+  if (ncolor_clears == 0u && depth_clear == NULL && stencil_clear == NULL) {
+    return;
+  }
+
+  const uint32_t clobbered =
+      CURRENT_CONTEXT->cached_state.clobbered_state_groups;
+  const uint32_t *cached_words =
+      CURRENT_CONTEXT->cached_state.pipeline_state.words;
+  const bool depth_write_known =
+      !(clobbered & _NGF_GL_STATE_BIT(_NGF_GL_STATE_DEPTH_WRITE));
+  const bool stencil_known =
+      !(clobbered & _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL));
+  const bool set_depth_mask =
+      depth_clear != NULL &&
+      !(depth_write_known && cached_words[_NGF_GL_WORD_DEPTH_WRITE]);
+  // The stencil write mask is only set by pipelines with stencil testing
+  // enabled, otherwise its value is unknown.
+  const bool stencil_enabled =
+      stencil_known && cached_words[_NGF_GL_WORD_STENCIL];
+  const bool set_stencil_mask =
+      stencil_clear != NULL &&
+      !(stencil_enabled &&
+        cached_words[_NGF_GL_WORD_STENCIL + 3] == ~0u &&
+        cached_words[_NGF_GL_WORD_STENCIL + 7] == ~0u);
+
+  glDisable(GL_SCISSOR_TEST);
+  if (set_depth_mask) glDepthMask(GL_TRUE);
+  if (set_stencil_mask) glStencilMask(~0u);
+
+  const float depth = depth_clear ? depth_clear->clear_depth : 0.0f;
+  const GLint stencil =
+      stencil_clear && stencil_clear != depth_clear
+          ? (GLint)stencil_clear->clear_stencil
+          : 0;
+  if (ncolor_clears == ncolors && uniform_color) {
+    GLbitfield mask = 0u;
+    if (first_color_clear != NULL) {
+      const float *c = first_color_clear->clear_color;
+      glClearColor(c[0], c[1], c[2], c[3]);
+      mask |= GL_COLOR_BUFFER_BIT;
+    }
+    if (depth_clear != NULL) {
+      glClearDepthf(depth);
+      mask |= GL_DEPTH_BUFFER_BIT;
+    }
+    if (stencil_clear != NULL) {
+      glClearStencil(stencil);
+      mask |= GL_STENCIL_BUFFER_BIT;
+    }
+    glClear(mask);
+  } else {
+    for (uint32_t c = 0u; c < ncolors; ++c) {
+      if (color_clears[c] != NULL) {
+        glClearBufferfv(GL_COLOR, (GLint)c, color_clears[c]->clear_color);
+      }
+    }
+    if (depth_clear != NULL && stencil_clear != NULL) {
+      glClearBufferfi(GL_DEPTH_STENCIL, 0, depth, stencil);
+    } else if (depth_clear != NULL) {
+      glClearBufferfv(GL_DEPTH, 0, &depth);
+    } else if (stencil_clear != NULL) {
+      glClearBufferiv(GL_STENCIL, 0, &stencil);
+    }
+  }
+
+  glEnable(GL_SCISSOR_TEST);
+  if (set_depth_mask) {
+    if (depth_write_known) {
+      glDepthMask(GL_FALSE);
+    } else {
+      CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+          _NGF_GL_STATE_BIT(_NGF_GL_STATE_DEPTH_WRITE);
+    }
+  }
+  if (set_stencil_mask && stencil_enabled) {
+    glStencilMaskSeparate(GL_FRONT, cached_words[_NGF_GL_WORD_STENCIL + 3]);
+    glStencilMaskSeparate(GL_BACK, cached_words[_NGF_GL_WORD_STENCIL + 7]);
+  }
+}
+
+#define _NGF_PUSH_CONSTANTS_RING_SIZE (64u * 1024u)
+
+// Uploads the shadowed push constant values into the next free range of the
+// streaming ring buffer, and binds that range. When the ring is exhausted,
+// its storage is orphaned instead of waiting for the GPU to release it.
+static void _ngf_flush_push_constants(void) {
+  if (!CURRENT_CONTEXT->push_constants.dirty) {
+    return;
+  }
+  CURRENT_CONTEXT->push_constants.dirty = false;
+  const GLsizeiptr block_size =
+      (GLsizeiptr)CURRENT_CONTEXT->push_constants.block_size;
+  if (block_size == 0) {
+    return;
+  }
+  if (CURRENT_CONTEXT->push_constants.ring_buffer == GL_NONE) {
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT,
+                  &CURRENT_CONTEXT->push_constants.offset_alignment);
+    glGenBuffers(1, &CURRENT_CONTEXT->push_constants.ring_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER,
+                 CURRENT_CONTEXT->push_constants.ring_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, _NGF_PUSH_CONSTANTS_RING_SIZE, NULL,
+                 GL_STREAM_DRAW);
+  } else {
+    glBindBuffer(GL_UNIFORM_BUFFER,
+                 CURRENT_CONTEXT->push_constants.ring_buffer);
+  }
+  const GLintptr alignment =
+      (GLintptr)NGF_MAX(CURRENT_CONTEXT->push_constants.offset_alignment, 1);
+  GLintptr offset = CURRENT_CONTEXT->push_constants.ring_offset;
+  offset = ((offset + alignment - 1) / alignment) * alignment;
+  if (offset + block_size > (GLintptr)_NGF_PUSH_CONSTANTS_RING_SIZE) {
+    glBufferData(GL_UNIFORM_BUFFER, _NGF_PUSH_CONSTANTS_RING_SIZE, NULL,
+                 GL_STREAM_DRAW);
+    offset = 0;
+  }
+  glBufferSubData(GL_UNIFORM_BUFFER, offset, block_size,
+                  CURRENT_CONTEXT->push_constants.data);
+  glBindBufferRange(GL_UNIFORM_BUFFER,
+                    CURRENT_CONTEXT->push_constants.binding,
+                    CURRENT_CONTEXT->push_constants.ring_buffer,
+                    offset, block_size);
+  CURRENT_CONTEXT->push_constants.ring_offset = offset + block_size;
+}
+
+#pragma endregion
+
+// Opens a timing scope in the current context's frame, if GPU timing is
+// enabled.
+static void _ngf_gpu_timing_begin(const char *name) {
+  _ngf_gl_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (t != NULL) {
+    const uint32_t query =
+        _ngf_gpu_timing_begin_scope(&t->frames[t->current_frame], name);
+    if (query != _NGF_GPU_TIMING_NO_QUERY) {
+      glQueryCounter(t->queries[t->current_frame][query], GL_TIMESTAMP);
+    }
+  }
+}
+
+// Closes the most recently opened timing scope in the current context's
+// frame, if GPU timing is enabled.
+static void _ngf_gpu_timing_end(void) {
+  _ngf_gl_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (t != NULL) {
+    const uint32_t query =
+        _ngf_gpu_timing_end_scope(&t->frames[t->current_frame]);
+    if (query != _NGF_GPU_TIMING_NO_QUERY) {
+      glQueryCounter(t->queries[t->current_frame][query], GL_TIMESTAMP);
+    }
+  }
+}
+
 ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
   assert(bufs);
+  const uint64_t start_ns = _ngf_stats_now_ns();
   ngf_render_target active_rt = NULL;
+  // Scopes are only marked as debug groups when there's a debug context or
+  // GPU timing to look at them.
+  const bool debug_groups =
+      CURRENT_CONTEXT->debug || CURRENT_CONTEXT->gpu_timing != NULL;
   for (uint32_t buf_i = 0u; buf_i < nbuffers; ++buf_i) {
     const ngf_cmd_buffer buf = bufs[buf_i];
     for (const _ngf_cmd_block *block = buf->first_cmd_block; block!= NULL;
@@ -2037,221 +3403,13 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
         const _ngf_emulated_cmd *cmd = &block->cmds[i];
         switch (cmd->type) {
         case _NGF_CMD_BIND_PIPELINE: {
-          const ngf_graphics_pipeline bound_pipe = 
-            CURRENT_CONTEXT->has_bound_pipeline
-              ? &(CURRENT_CONTEXT->cached_state.pipeline)
-              : NULL;
-
+          const ngf_graphics_pipeline bound_pipe =
+              CURRENT_CONTEXT->cached_state.bound_pipeline;
           const ngf_graphics_pipeline pipeline = cmd->pipeline;
           if (!bound_pipe || bound_pipe->id != pipeline->id) {
-            // Bind graphics program.
-            if (!bound_pipe ||
-                 bound_pipe->program_pipeline != pipeline->program_pipeline) {
-              glBindProgramPipeline(pipeline->program_pipeline);
-            }
-
-            // Set viewport state.
-            const bool viewport_dynamic = pipeline->dynamic_state_mask &
-                                          NGF_DYNAMIC_STATE_VIEWPORT;
-            if (!viewport_dynamic &&
-                (!bound_pipe ||
-                 !NGF_STRUCT_EQ(pipeline->viewport, bound_pipe->viewport))) {
-              glViewport((GLsizei)pipeline->viewport.x,
-                         (GLsizei)pipeline->viewport.y,
-                         (GLsizei)pipeline->viewport.width,
-                         (GLsizei)pipeline->viewport.height);
-            }
-
-            // Set scissor state.
-            const bool scissor_dynamic = pipeline->dynamic_state_mask &
-                                         NGF_DYNAMIC_STATE_SCISSOR;
-            if (!scissor_dynamic &&
-                (!bound_pipe ||
-                 !NGF_STRUCT_EQ(pipeline->scissor, bound_pipe->scissor))) {
-              glScissor((GLsizei)pipeline->scissor.x,
-                        (GLsizei)pipeline->scissor.y,
-                        (GLsizei)pipeline->scissor.width,
-                        (GLsizei)pipeline->scissor.height);
-            }
-
-            // Set rasterizer state.
-            const ngf_rasterization_info *rast = &(pipeline->rasterization);
-            const ngf_rasterization_info *prev_rast =
-                bound_pipe ? &(bound_pipe->rasterization) : NULL;
-            if (!prev_rast ||
-                 prev_rast->discard != rast->discard) {
-              if (rast->discard) {
-                glEnable(GL_RASTERIZER_DISCARD);
-              } else {
-                glDisable(GL_RASTERIZER_DISCARD);
-              }
-            }
-            if (!prev_rast ||
-                 prev_rast->polygon_mode != rast->polygon_mode) {
-              glPolygonMode(GL_FRONT_AND_BACK,
-                            get_gl_poly_mode(rast->polygon_mode));
-            }
-            if (!prev_rast ||
-                prev_rast->cull_mode != rast->cull_mode) {
-              if (rast->cull_mode != NGF_CULL_MODE_NONE) {
-                glEnable(GL_CULL_FACE);
-                glCullFace(get_gl_cull_mode(rast->cull_mode));
-              } else {
-                glDisable(GL_CULL_FACE);
-              }
-            }
-            if (!prev_rast ||
-                prev_rast->front_face != rast->front_face) {
-              glFrontFace(get_gl_face(rast->front_face));
-            }
-            if (!prev_rast ||
-                prev_rast->line_width != rast->line_width) {
-              glLineWidth(rast->line_width);
-            }
-
-            // Enable/disable multisampling.
-            if (!bound_pipe ||
-                bound_pipe->multisample.multisample !=
-                pipeline->multisample.multisample) {
-              if (pipeline->multisample.multisample) {
-                glEnable(GL_MULTISAMPLE);
-              } else {
-                glDisable(GL_MULTISAMPLE);
-              }
-            }
-
-            // Enable/disable alpha-to-coverage.
-            if (!bound_pipe ||
-                bound_pipe->multisample.alpha_to_coverage !=
-                    pipeline->multisample.alpha_to_coverage) {
-              if (pipeline->multisample.alpha_to_coverage) {
-                glEnable(GL_SAMPLE_ALPHA_TO_COVERAGE);
-              } else {
-                glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
-              }
-            }
-
-            // Set depth/stencil state.
-            const ngf_depth_stencil_info *depth_stencil =
-                &(pipeline->depth_stencil);
-            const ngf_depth_stencil_info *prev_depth_stencil =
-                bound_pipe ? &(bound_pipe->depth_stencil) : NULL;
-
-            if (!prev_depth_stencil ||
-                prev_depth_stencil->depth_test != depth_stencil->depth_test) {
-              if (depth_stencil->depth_test) {
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(get_gl_compare(depth_stencil->depth_compare));
-              } else {
-                glDisable(GL_DEPTH_TEST);
-              }
-            }
-            if (!prev_depth_stencil ||
-                 prev_depth_stencil->depth_write !=
-                 depth_stencil->depth_write) {
-              if (depth_stencil->depth_write) {
-                glDepthMask(GL_TRUE);
-              } else {
-                glDepthMask(GL_FALSE);
-              }
-            }
-            if (!prev_depth_stencil ||
-                 prev_depth_stencil->stencil_test !=
-                   depth_stencil->stencil_test ||
-                !NGF_STRUCT_EQ(prev_depth_stencil->back_stencil,
-                               depth_stencil->back_stencil) ||
-                !NGF_STRUCT_EQ(prev_depth_stencil->front_stencil,
-                               depth_stencil->front_stencil)) {
-              if (depth_stencil->stencil_test) {
-                glEnable(GL_STENCIL_TEST);
-                glStencilFuncSeparate(
-                  GL_FRONT,
-                  get_gl_compare(depth_stencil->front_stencil.compare_op),
-                  (GLint)depth_stencil->front_stencil.reference,
-                  depth_stencil->front_stencil.compare_mask);
-                glStencilOpSeparate(
-                  GL_FRONT,
-                  get_gl_stencil_op(depth_stencil->front_stencil.fail_op),
-                  get_gl_stencil_op(depth_stencil->front_stencil.depth_fail_op),
-                  get_gl_stencil_op(depth_stencil->front_stencil.pass_op));
-                glStencilMaskSeparate(GL_FRONT,
-                                      depth_stencil->front_stencil.write_mask);
-                glStencilFuncSeparate(
-                  GL_BACK,
-                  get_gl_compare(depth_stencil->back_stencil.compare_op),
-                  (GLint)depth_stencil->back_stencil.reference,
-                  depth_stencil->back_stencil.compare_mask);
-                glStencilOpSeparate(
-                  GL_BACK,
-                  get_gl_stencil_op(depth_stencil->back_stencil.fail_op),
-                  get_gl_stencil_op(depth_stencil->back_stencil.depth_fail_op),
-                  get_gl_stencil_op(depth_stencil->back_stencil.pass_op));
-                glStencilMaskSeparate(GL_BACK,
-                                      depth_stencil->back_stencil.write_mask);
-              } else { 
-                glDisable(GL_STENCIL_TEST);
-              }
-            }
-            if (!prev_depth_stencil ||
-                prev_depth_stencil->min_depth != depth_stencil->min_depth ||
-                prev_depth_stencil->max_depth != depth_stencil->max_depth) {
-              glDepthRangef(depth_stencil->min_depth, depth_stencil->max_depth);
-            }
-
-            // Set blend state.
-            const ngf_blend_info *blend = &(pipeline->blend);
-            const ngf_blend_info *prev_blend =
-                bound_pipe ? &(bound_pipe->blend) : NULL;
-            if (!prev_blend ||
-                prev_blend->enable != blend->enable ||
-                prev_blend->sfactor != blend->sfactor ||
-                prev_blend->dfactor != blend->dfactor) {
-              if (blend->enable) {
-                glEnable(GL_BLEND);
-                glBlendFunc(get_gl_blendfactor(blend->sfactor),
-                            get_gl_blendfactor(blend->dfactor));
-              } else {
-                glDisable(GL_BLEND);
-              }
-            }
-
-            // Set vertex input state.
-            if (!bound_pipe ||
-                bound_pipe->vao != pipeline->vao) {
-              glBindVertexArray(pipeline->vao);
-              // Keep the same set of attribute buffers bound despite VAO change.
-              const size_t nvbuf_table_entries =
-                  _NGF_DARRAY_SIZE(CURRENT_CONTEXT->cached_state.vbuf_table);
-              for (size_t e = 0; e < nvbuf_table_entries; ++e) {
-                bool found_binding = false;
-                const _ngf_vbuf_binding_info *vbuf_table_entry =
-                    &_NGF_DARRAY_AT(CURRENT_CONTEXT->cached_state.vbuf_table,
-                                    e);
-                // Update only bindings relevant to this pipeline.
-                for (uint32_t b = 0;
-                     !found_binding && b < pipeline->nvert_buf_bindings;
-                     ++b) {
-                  if (pipeline->vert_buf_bindings[b].binding ==
-                      vbuf_table_entry->binding) {
-                    const GLsizei stride =
-                      (GLsizei)pipeline->vert_buf_bindings[b].stride;
-                    glBindVertexBuffer(vbuf_table_entry->binding,
-                                       vbuf_table_entry->buffer,
-                                       vbuf_table_entry->offset,
-                                       stride);
-                    found_binding = true;
-                  }
-                }
-              }
-
-              // Rebind index buffer.
-              glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
-                           CURRENT_CONTEXT->cached_state.bound_index_buffer);
-            }
-            CURRENT_CONTEXT->cached_state.pipeline = *pipeline;
+            _ngf_apply_pipeline_state(pipeline);
+            CURRENT_CONTEXT->cached_state.bound_pipeline = pipeline;
           }
-          CURRENT_CONTEXT->has_bound_pipeline = true;
-          glEnable(GL_SCISSOR_TEST);
           break; }
 
         case _NGF_CMD_VIEWPORT:
@@ -2259,6 +3417,8 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
                        cmd->viewport.y,
                        (GLsizei)cmd->viewport.width,
                        (GLsizei)cmd->viewport.height);
+            CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+                _NGF_GL_STATE_BIT(_NGF_GL_STATE_VIEWPORT);
           break;
 
         case _NGF_CMD_SCISSOR:
@@ -2266,20 +3426,28 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
                       cmd->scissor.y,
                       (GLsizei)cmd->scissor.width,
                       (GLsizei)cmd->scissor.height);
+            CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+                _NGF_GL_STATE_BIT(_NGF_GL_STATE_SCISSOR);
           break;
 
         case _NGF_CMD_LINE_WIDTH:
           glLineWidth(cmd->line_width);
+          CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+              _NGF_GL_STATE_BIT(_NGF_GL_STATE_LINE_WIDTH);
           break;
 
         case _NGF_CMD_BLEND_CONSTANTS:
           glBlendFunc(cmd->blend_factors.sfactor,
                       cmd->blend_factors.dfactor);
+          CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+              _NGF_GL_STATE_BIT(_NGF_GL_STATE_BLEND);
           break;
 
         case _NGF_CMD_STENCIL_WRITE_MASK:
           glStencilMaskSeparate(GL_FRONT, cmd->stencil_write_mask.front);
           glStencilMaskSeparate(GL_BACK, cmd->stencil_write_mask.back);
+          CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+              _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL);
           break;
 
         case _NGF_CMD_STENCIL_COMPARE_MASK: {
@@ -2296,6 +3464,8 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
                                 (GLenum)back_func,
                                 back_ref,
                                 cmd->stencil_compare_mask.back);
+          CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+              _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL);
           break;
         }
 
@@ -2312,7 +3482,9 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
           glStencilFuncSeparate(GL_BACK,
                                 (GLenum)back_func,
                                 (GLint)cmd->stencil_reference.back,
-                                (GLuint)back_mask);         
+                                (GLuint)back_mask);
+          CURRENT_CONTEXT->cached_state.clobbered_state_groups |=
+              _NGF_GL_STATE_BIT(_NGF_GL_STATE_STENCIL);
           break;
         }
 
@@ -2335,11 +3507,70 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
                         cmd->sampler_bind_op.sampler->glsampler);
           break;
 
+        case _NGF_CMD_BIND_STORAGE_BUFFER:
+          glBindBufferRange(GL_SHADER_STORAGE_BUFFER,
+                            cmd->storage_buffer_bind_op.index,
+                            cmd->storage_buffer_bind_op.buffer,
+                            (GLintptr)cmd->storage_buffer_bind_op.offset,
+                            (GLsizeiptr)cmd->storage_buffer_bind_op.range);
+          break;
+
+        case _NGF_CMD_BIND_STORAGE_IMAGE: {
+          const ngf_image image = cmd->storage_image_bind_op.image;
+          const GLboolean layered = image->bind_point != GL_TEXTURE_2D;
+          glBindImageTexture(cmd->storage_image_bind_op.unit,
+                             image->glimage,
+                             cmd->storage_image_bind_op.level,
+                             layered,
+                             cmd->storage_image_bind_op.layer,
+                             GL_READ_WRITE,
+                             image->glinternalformat);
+          break; }
+
+        case _NGF_CMD_BIND_COMPUTE_PIPELINE: {
+          const GLuint program_pipeline =
+              cmd->compute_pipeline->program_pipeline;
+          glBindProgramPipeline(program_pipeline);
+          // The graphics program binding has been replaced, make sure the
+          // next graphics pipeline bind restores it.
+          CURRENT_CONTEXT->cached_state.bound_pipeline = NULL;
+          CURRENT_CONTEXT->cached_state.pipeline_state
+              .words[_NGF_GL_WORD_PROGRAM] = program_pipeline;
+          break; }
+
+        case _NGF_CMD_PUSH_CONSTANTS:
+          memcpy(&CURRENT_CONTEXT->push_constants
+                      .data[cmd->push_constants.offset],
+                 cmd->push_constants.data, cmd->push_constants.size);
+          CURRENT_CONTEXT->push_constants.binding =
+              cmd->push_constants.binding;
+          CURRENT_CONTEXT->push_constants.block_size =
+              cmd->push_constants.block_size;
+          CURRENT_CONTEXT->push_constants.dirty = true;
+          break;
+
+        case _NGF_CMD_DISPATCH:
+          _ngf_flush_push_constants();
+          glDispatchCompute(cmd->dispatch.ngroups_x,
+                            cmd->dispatch.ngroups_y,
+                            cmd->dispatch.ngroups_z);
+          break;
+
+        case _NGF_CMD_DISPATCH_INDIRECT:
+          _ngf_flush_push_constants();
+          glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER,
+                       cmd->dispatch_indirect.args_buffer);
+          glDispatchComputeIndirect(
+              (GLintptr)cmd->dispatch_indirect.offset);
+          break;
+
+        case _NGF_CMD_MEMORY_BARRIER:
+          glMemoryBarrier(GL_ALL_BARRIER_BITS);
+          break;
+
         case _NGF_CMD_BIND_ATTRIB_BUFFER: {
           const ngf_graphics_pipeline bound_pipeline =
-            CURRENT_CONTEXT->has_bound_pipeline
-              ? &CURRENT_CONTEXT->cached_state.pipeline
-              : NULL;
+              CURRENT_CONTEXT->cached_state.bound_pipeline;
 
           // Update the table of bound attrib buffers.
           const size_t nvbuf_table_entries = _NGF_DARRAY_SIZE(
@@ -2406,99 +3637,30 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
           glBindFramebuffer(GL_FRAMEBUFFER, active_rt->framebuffer);
           if (active_rt->is_srgb) glEnable(GL_FRAMEBUFFER_SRGB);
           else glDisable(GL_FRAMEBUFFER_SRGB);
-          uint32_t color_clear = 0u;
-          glDisable(GL_SCISSOR_TEST);
-          glDepthMask(GL_TRUE);
           if (active_rt->ndraw_buffers > 1u) {
             glDrawBuffers((GLsizei)active_rt->ndraw_buffers,
                            active_rt->draw_buffers);
           }
-          for (uint32_t a = 0u; a < active_rt->nattachments; ++a) {
-            const ngf_attachment *attachment = &active_rt->attachment_infos[a];
-            if (attachment->load_op == NGF_LOAD_OP_CLEAR) {
-              const ngf_clear *clear = &attachment->clear;
-              switch (attachment->type) {
-              case NGF_ATTACHMENT_COLOR:
-                glClearBufferfv(GL_COLOR, (GLint)(color_clear++),
-                                clear->clear_color);
-                break;
-              case NGF_ATTACHMENT_DEPTH:
-                glClearBufferfv(GL_DEPTH, 0, &clear->clear_depth);
-                break;
-              case NGF_ATTACHMENT_STENCIL: {
-                GLint v = (GLint)clear->clear_stencil;
-                glClearBufferiv(GL_STENCIL, 0, &v);
-                break;
-              case NGF_ATTACHMENT_DEPTH_STENCIL:
-                break;
-              }
-              }
-            }
-          }
+          _ngf_gl_invalidate_attachments(active_rt, _ngf_load_op_is_dontcare);
+          _ngf_gl_clear_attachments(active_rt);
+          // The scissor test stays on for the whole pass, so that the
+          // pipeline's scissor and ngf_cmd_scissor apply even when nothing
+          // has been cleared.
           glEnable(GL_SCISSOR_TEST);
           break;
         }
 
         case _NGF_CMD_END_PASS: {
           assert(active_rt);
-          const uint32_t max_discarded_attachments =
-              active_rt->nattachments + 1u; // +1 needed in case we need to
-                                            // handle depth/stencil separately.
-          GLenum *gl_attachments =
-              alloca(sizeof(GLenum) * max_discarded_attachments);
-          uint32_t ndiscarded_attachments = 0u;
-          uint32_t ndiscarded_color_attachments = 0u;
-          // Annoyingly, desktop GL specification of glInvalidateFramebuffer
-          // differs strongly between which enum values to use for invalidating
-          // attachments of a "normal" vs default framebuffer. This distinction
-          // is not present on GLES 3 though (TODO: turn off this path for
-          // GLES 3).
-          const bool is_default_framebuffer = active_rt->framebuffer == 0;
-          for (uint32_t a = 0u; a < active_rt->nattachments; ++a) {
-            const ngf_attachment *attachment = &active_rt->attachment_infos[a];
-            if (attachment->store_op == NGF_STORE_OP_DONTCARE) {
-              switch (attachment->type) {
-              case NGF_ATTACHMENT_COLOR:
-                gl_attachments[ndiscarded_attachments++] =
-                  is_default_framebuffer 
-                    ? GL_COLOR
-                    : GL_COLOR_ATTACHMENT0 + (++ndiscarded_color_attachments);
-                break;
-              case NGF_ATTACHMENT_DEPTH:
-                gl_attachments[ndiscarded_attachments++] = 
-                  is_default_framebuffer ? GL_DEPTH : GL_DEPTH_ATTACHMENT;
-                break;
-              case NGF_ATTACHMENT_STENCIL:
-                gl_attachments[ndiscarded_attachments++] =
-                  is_default_framebuffer
-                    ? GL_STENCIL
-                    : GL_STENCIL_ATTACHMENT;
-                break;
-              case NGF_ATTACHMENT_DEPTH_STENCIL:
-                if (!is_default_framebuffer) {
-                  gl_attachments[ndiscarded_attachments++] =
-                      GL_DEPTH_STENCIL_ATTACHMENT;
-                } else {
-                  gl_attachments[ndiscarded_attachments++] = GL_DEPTH;
-                  gl_attachments[ndiscarded_attachments++] = GL_STENCIL;
-                }
-                break;
-              }
-            }
-          }
-          if (ndiscarded_attachments > 0u) {
-            glInvalidateFramebuffer(GL_FRAMEBUFFER,
-                                    (GLsizei)ndiscarded_attachments,
-                                    gl_attachments);
-          }
+          _ngf_gl_invalidate_attachments(active_rt,
+                                         _ngf_store_op_is_dontcare);
           break;
         }
         case _NGF_CMD_DRAW: {
           const ngf_graphics_pipeline bound_pipeline =
-            CURRENT_CONTEXT->has_bound_pipeline
-              ? &CURRENT_CONTEXT->cached_state.pipeline
-              : NULL;
+              CURRENT_CONTEXT->cached_state.bound_pipeline;
           assert(bound_pipeline);
+          _ngf_flush_push_constants();
           if (!cmd->draw.indexed && cmd->draw.ninstances == 1u) {
             glDrawArrays(bound_pipeline->primitive_type,
                          (GLint)cmd->draw.first_element,
@@ -2533,6 +3695,41 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
                                     (GLsizei)cmd->draw.ninstances);
           }
           break; }
+        case _NGF_CMD_DRAW_INDIRECT: {
+          const ngf_graphics_pipeline bound_pipeline =
+              CURRENT_CONTEXT->cached_state.bound_pipeline;
+          assert(bound_pipeline);
+          _ngf_flush_push_constants();
+          if (CURRENT_CONTEXT->cached_state.bound_indirect_buffer !=
+              cmd->draw_indirect.args_buffer) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER,
+                         cmd->draw_indirect.args_buffer);
+            CURRENT_CONTEXT->cached_state.bound_indirect_buffer =
+                cmd->draw_indirect.args_buffer;
+          }
+          const void *indirect = (void*)(uintptr_t)cmd->draw_indirect.offset;
+          const GLsizei ndraws = (GLsizei)cmd->draw_indirect.ndraws;
+          const GLsizei stride = (GLsizei)cmd->draw_indirect.stride;
+          if (!cmd->draw_indirect.indexed && ndraws == 1) {
+            glDrawArraysIndirect(bound_pipeline->primitive_type, indirect);
+          } else if (!cmd->draw_indirect.indexed) {
+            glMultiDrawArraysIndirect(bound_pipeline->primitive_type,
+                                      indirect, ndraws, stride);
+          } else {
+            assert(CURRENT_CONTEXT->bound_index_buffer_type == NGF_TYPE_UINT16 ||
+                   CURRENT_CONTEXT->bound_index_buffer_type == NGF_TYPE_UINT32);
+            const GLenum index_type =
+                get_gl_type(CURRENT_CONTEXT->bound_index_buffer_type);
+            if (ndraws == 1) {
+              glDrawElementsIndirect(bound_pipeline->primitive_type,
+                                     index_type, indirect);
+            } else {
+              glMultiDrawElementsIndirect(bound_pipeline->primitive_type,
+                                          index_type, indirect, ndraws,
+                                          stride);
+            }
+          }
+          break; }
         case _NGF_CMD_COPY:
           glBindBuffer(GL_COPY_READ_BUFFER, cmd->copy.src);
           glBindBuffer(GL_COPY_WRITE_BUFFER, cmd->copy.dst);
@@ -2587,6 +3784,22 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
           glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
           break;
         }
+
+        case _NGF_CMD_BEGIN_SCOPE:
+          if (debug_groups) {
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1,
+                             cmd->scope_name);
+          }
+          _ngf_gpu_timing_begin(cmd->scope_name);
+          break;
+
+        case _NGF_CMD_END_SCOPE:
+          _ngf_gpu_timing_end();
+          if (debug_groups) {
+            glPopDebugGroup();
+          }
+          break;
+
         default:
           assert(false);
         }
@@ -2594,6 +3807,8 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
     }
     _ngf_cmd_buffer_free_cmds(bufs[buf_i]);
   }
+  _NGF_STAT_ADD(_NGF_STAT_SUBMIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("ngf_submit_cmd_buffers", start_ns);
   return NGF_ERROR_OK;
 }
 
@@ -2636,13 +3851,193 @@ void ngf_end_debug_group() {
   glPopDebugGroup();
 }
 
+// Blocks until the GPU finishes the given frame, unless it's known to have
+// finished already.
+static void _ngf_pacing_wait(uint64_t frame) {
+  ngf_context ctx = CURRENT_CONTEXT;
+  if (frame < ctx->pacing.oldest_pending_frame || frame >= ctx->frame) {
+    return;
+  }
+  GLsync fence = ctx->pacing.fences[frame % NGF_MAX_QUEUED_FRAMES];
+  if (fence == NULL) {
+    return;
+  }
+  const uint64_t start_ns = _ngf_stats_now_ns();
+  while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000u) ==
+         GL_TIMEOUT_EXPIRED);
+  _NGF_STAT_ADD(_NGF_STAT_PACING_WAIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("frame pacing wait", start_ns);
+}
+
+// Ends the given frame with a fence.
+static void _ngf_pacing_fence(uint64_t frame) {
+  ngf_context ctx = CURRENT_CONTEXT;
+  GLsync *fence = &ctx->pacing.fences[frame % NGF_MAX_QUEUED_FRAMES];
+  if (*fence != NULL) {
+    // More frames are pending than there are slots for. Forget about the
+    // oldest one rather than waiting for it.
+    glDeleteSync(*fence);
+    ctx->pacing.oldest_pending_frame = frame - NGF_MAX_QUEUED_FRAMES + 1u;
+  }
+  *fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Releases the fences of frames that the GPU has finished, and returns the
+// number of frames it has yet to finish.
+static uint64_t _ngf_pacing_retire(void) {
+  ngf_context ctx = CURRENT_CONTEXT;
+  for (; ctx->pacing.oldest_pending_frame < ctx->frame;
+       ++ctx->pacing.oldest_pending_frame) {
+    GLsync *fence = &ctx->pacing.fences[ctx->pacing.oldest_pending_frame %
+                                        NGF_MAX_QUEUED_FRAMES];
+    if (*fence != NULL) {
+      GLint status = GL_UNSIGNALED;
+      glGetSynciv(*fence, GL_SYNC_STATUS, 1, NULL, &status);
+      if (status != GL_SIGNALED) {
+        break;
+      }
+      glDeleteSync(*fence);
+      *fence = NULL;
+    }
+  }
+  return ctx->frame - ctx->pacing.oldest_pending_frame;
+}
+
 ngf_error ngf_begin_frame() {
-  glGenBuffers(0, NULL);
+  uint64_t wait_frame = 0u;
+  if (_ngf_frame_pacing_target(&CURRENT_CONTEXT->pacing.info, true,
+                               CURRENT_CONTEXT->frame,
+                               CURRENT_CONTEXT->pacing.info.max_queued_frames,
+                               &wait_frame)) {
+    _ngf_pacing_wait(wait_frame);
+  }
   return NGF_ERROR_OK;
 }
 
+ngf_error ngf_set_frame_pacing(const ngf_frame_pacing_info *info) {
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  const ngf_error err = _ngf_validate_frame_pacing(info);
+  if (err == NGF_ERROR_OK) {
+    CURRENT_CONTEXT->pacing.info = *info;
+  }
+  return err;
+}
+
+// Reads back the timestamps of the given frame, if all of them are available.
+static bool _ngf_gpu_timing_read_back(_ngf_gl_gpu_timing *t, uint32_t f) {
+  const uint32_t nqueries = 2u * t->frames[f].nscopes;
+  for (uint32_t q = 0u; q < nqueries; ++q) {
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(t->queries[f][q], GL_QUERY_RESULT_AVAILABLE,
+                        &available);
+    if (!available) {
+      return false;
+    }
+    glGetQueryObjectui64v(t->queries[f][q], GL_QUERY_RESULT,
+                          (GLuint64*)&t->timestamps[q]);
+  }
+  return true;
+}
+
+// Finishes timing the current frame, and moves on to the next frame's slot,
+// reading back the timings of the frame that used it previously.
+static void _ngf_gpu_timing_end_frame(void) {
+  _ngf_gl_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (t == NULL) {
+    return;
+  }
+  while (_ngf_gpu_timing_has_open_scopes(&t->frames[t->current_frame])) {
+    _ngf_gpu_timing_end();
+  }
+  t->current_frame = (t->current_frame + 1u) % _NGF_GPU_TIMING_LATENCY;
+  _ngf_gpu_timing_frame *f = &t->frames[t->current_frame];
+  if (f->nscopes > 0u && _ngf_gpu_timing_read_back(t, t->current_frame)) {
+    // GL timestamps are always in nanoseconds.
+    _ngf_gpu_timing_resolve(f, t->timestamps, 1.0f, &t->results);
+    if (_NGF_TIMELINE_ENABLED) {
+      // Line the GPU's clock up with the CPU's by reading both at once.
+      GLint64 gpu_now_ns = 0;
+      glGetInteger64v(GL_TIMESTAMP, &gpu_now_ns);
+      const uint64_t cpu_now_ns = _ngf_stats_now_ns();
+      _ngf_timeline_gpu_frame(&t->results,
+                              cpu_now_ns -
+                              ((uint64_t)gpu_now_ns - t->timestamps[0]));
+    }
+  }
+  _ngf_gpu_timing_reset(f, CURRENT_CONTEXT->frame);
+}
+
 ngf_error ngf_end_frame() {
-  return eglSwapBuffers(CURRENT_CONTEXT->dpy, CURRENT_CONTEXT->surface)
-      ? NGF_ERROR_OK
-      : NGF_ERROR_END_FRAME_FAILED;
+  const uint64_t start_ns = _ngf_stats_now_ns();
+  const uint64_t frame = CURRENT_CONTEXT->frame++;
+  _ngf_gpu_timing_end_frame();
+  // Without a swapchain there is nothing to present, only the frame's
+  // commands need to be flushed, which happens along with the fence below.
+  ngf_error err = NGF_ERROR_OK;
+  if (CURRENT_CONTEXT->has_swapchain) {
+    const uint64_t present_start_ns = _ngf_timeline_now();
+    if (!eglSwapBuffers(CURRENT_CONTEXT->dpy, CURRENT_CONTEXT->surface)) {
+      err = NGF_ERROR_END_FRAME_FAILED;
+    }
+    _ngf_timeline_scope("present", present_start_ns);
+  }
+  uint64_t wait_frame = 0u;
+  if (_ngf_frame_pacing_target(&CURRENT_CONTEXT->pacing.info, false, frame,
+                               CURRENT_CONTEXT->pacing.info.max_queued_frames,
+                               &wait_frame)) {
+    _ngf_pacing_wait(wait_frame);
+  }
+  // The fence goes in after waiting, since its slot may still be holding the
+  // fence that was waited for.
+  _ngf_pacing_fence(frame);
+  glFlush();
+  _NGF_STAT_ADD(_NGF_STAT_QUEUED_FRAMES, _ngf_pacing_retire());
+  const _ngf_gl_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (t != NULL) {
+    _NGF_STAT_ADD(_NGF_STAT_GPU_BUSY_TIME_NS,
+                  _ngf_gpu_timing_busy_ns(&t->results));
+  }
+  _NGF_STAT_ADD(_NGF_STAT_END_FRAME_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_stats_end_frame(frame);
+  return err;
+}
+
+ngf_error ngf_enable_gpu_timing(bool enable) {
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  _ngf_gl_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (enable && t == NULL) {
+    t = NGF_ALLOC(_ngf_gl_gpu_timing);
+    if (t == NULL) {
+      return NGF_ERROR_OUTOFMEM;
+    }
+    glGenQueries((GLsizei)(NGF_ARRAYSIZE(t->queries) *
+                           NGF_ARRAYSIZE(t->queries[0])),
+                 &t->queries[0][0]);
+    for (uint32_t f = 0u; f < _NGF_GPU_TIMING_LATENCY; ++f) {
+      _ngf_gpu_timing_reset(&t->frames[f], CURRENT_CONTEXT->frame);
+    }
+    t->results.valid = false;
+    t->current_frame = 0u;
+    CURRENT_CONTEXT->gpu_timing = t;
+  } else if (!enable && t != NULL) {
+    glDeleteQueries((GLsizei)(NGF_ARRAYSIZE(t->queries) *
+                              NGF_ARRAYSIZE(t->queries[0])),
+                    &t->queries[0][0]);
+    NGF_FREE(t);
+    CURRENT_CONTEXT->gpu_timing = NULL;
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_gpu_frame_timings(ngf_gpu_frame_timings *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  const _ngf_gl_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  return _ngf_gpu_timing_get_results(t != NULL ? &t->results : NULL, result);
 }
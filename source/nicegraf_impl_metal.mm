@@ -20,14 +20,19 @@
  * IN THE SOFTWARE.
  */
 
+#if defined(NGF_CAPTURE_BACKEND)
+#include "nicegraf_capture_names.h"
+#endif
 #include "nicegraf.h"
 #include "nicegraf_internal.h"
 #include "nicegraf_wrappers.h"
 
+#include <algorithm>
 #include <memory>
 #include <new>
 #include <optional>
 #include <string>
+#include <vector>
 
 #import <Metal/Metal.h>
 #import <QuartzCore/QuartzCore.h>
@@ -433,6 +438,11 @@ struct ngf_context_t {
   ngf_swapchain_info swapchain_info;
   id<MTLCommandBuffer> pending_cmd_buffer = nil;
   dispatch_semaphore_t frame_sync_sem = nil;
+  uint64_t frame_index = 0u;
+  ngf_frame_pacing_info pacing {};
+  // Command buffers that presented recent frames, indexed by frame index.
+  // Entries are cleared once the GPU is done with them.
+  id<MTLCommandBuffer> inflight[NGF_MAX_QUEUED_FRAMES];
 };
 
 NGF_THREADLOCAL ngf_context CURRENT_CONTEXT = nullptr;
@@ -445,15 +455,33 @@ struct ngf_render_target_t {
   NSUInteger height;
 };
 
+// A dynamic uniform buffer bound on a command buffer, see
+// ngf_cmd_set_dynamic_offsets.
+struct _ngf_dynamic_ubo_binding {
+  uint32_t set;
+  uint32_t binding;
+  uint32_t native_binding;
+  size_t base_offset;
+  bool vert_stage_visible;
+  bool frag_stage_visible;
+};
+
 struct ngf_cmd_buffer_t {
   _ngf_cmd_buffer_state state = _NGF_CMD_BUFFER_READY;
   id<MTLCommandBuffer> mtl_cmd_buffer = nil;
   id<MTLRenderCommandEncoder> active_rce = nil;
   id<MTLBlitCommandEncoder> active_bce = nil;
+  id<MTLComputeCommandEncoder> active_cce = nil;
   ngf_graphics_pipeline active_pipe = nullptr;
+  ngf_compute_pipeline active_compute_pipe = nullptr;
   ngf_render_target active_rt = nullptr;
   id<MTLBuffer> bound_index_buffer = nil;
   MTLIndexType bound_index_buffer_type;
+  // Metal copies the bytes on every set*Bytes call, so partial push constant
+  // updates are applied to this shadow copy and the whole block is re-sent.
+  uint8_t push_constants[NGF_MAX_PUSH_CONSTANTS_SIZE];
+  // Sorted by set, then binding.
+  std::vector<_ngf_dynamic_ubo_binding> dynamic_ubos;
 };
 
 struct ngf_shader_stage_t {
@@ -473,6 +501,7 @@ struct ngf_graphics_pipeline_t {
   
  _ngf_native_binding_map   binding_map = nullptr;
   ngf_pipeline_layout_info layout;
+  uint32_t push_constants_index = 0u;
 
   ~ngf_graphics_pipeline_t() {
     for (uint32_t s = 0u;
@@ -480,10 +509,30 @@ struct ngf_graphics_pipeline_t {
          s < layout.ndescriptor_set_layouts;
          ++s) {
       if (layout.descriptor_set_layouts[s].descriptors != nullptr) {
-        NGF_FREEN(layout.descriptor_set_layouts[s].descriptors,
-                  layout.descriptor_set_layouts[s].ndescriptors);
+        NGF_FREEN_AS(layout.descriptor_set_layouts[s].descriptors,
+                     layout.descriptor_set_layouts[s].ndescriptors,
+                     NGF_ALLOCATION_PIPELINE);
       }
     }
+    if (layout.descriptor_set_layouts != nullptr) {
+      NGF_FREEN_AS(layout.descriptor_set_layouts,
+                   layout.ndescriptor_set_layouts,
+                   NGF_ALLOCATION_PIPELINE);
+    }
+    if (binding_map) {
+      _ngf_destroy_binding_map(binding_map);
+    }
+  }
+};
+
+struct ngf_compute_pipeline_t {
+  id<MTLComputePipelineState> pipeline = nil;
+  MTLSize threadgroup_size;
+ _ngf_native_binding_map binding_map = nullptr;
+  uint32_t push_constants_index = 0u;
+  uint32_t push_constants_size = 0u;
+
+  ~ngf_compute_pipeline_t() {
     if (binding_map) {
       _ngf_destroy_binding_map(binding_map);
     }
@@ -544,9 +593,22 @@ private:
   NgfObjType *ptr_;
 };
 
-#define _NGF_NURSERY(type, name) \
+#define _NGF_NURSERY_AS(type, name, category) \
 _ngf_object_nursery<ngf_##type##_t, ngf_destroy_##type> \
-    name(NGF_ALLOC(ngf_##type##_t));
+    name(NGF_ALLOC_AS(ngf_##type##_t, category));
+#define _NGF_NURSERY(type, name) \
+    _NGF_NURSERY_AS(type, name, NGF_ALLOCATION_GENERAL)
+
+// Records a timeline scope that lasts until the end of the enclosing block.
+class _ngf_timeline_block {
+public:
+  explicit _ngf_timeline_block(const char *name) :
+    name_(name), start_ns_(_ngf_timeline_now()) {}
+  ~_ngf_timeline_block() { _ngf_timeline_scope(name_, start_ns_); }
+private:
+  const char *name_;
+  uint64_t start_ns_;
+};
 
 #pragma mark ngf_function_implementations
 
@@ -574,9 +636,57 @@ ngf_error ngf_initialize(ngf_device_preference dev_pref) {
   return (MTL_DEVICE != nil) ? NGF_ERROR_OK : NGF_ERROR_INITIALIZATION_FAILED;
 }
 
+// Blocks until the GPU finishes the given frame.
+static void _ngf_pacing_wait(uint64_t frame) {
+  id<MTLCommandBuffer> cmd_buf =
+      CURRENT_CONTEXT->inflight[frame % NGF_MAX_QUEUED_FRAMES];
+  if (cmd_buf == nil) {
+    return;
+  }
+  const uint64_t start_ns = _ngf_stats_now_ns();
+  [cmd_buf waitUntilCompleted];
+  _NGF_STAT_ADD(_NGF_STAT_PACING_WAIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("frame pacing wait", start_ns);
+}
+
+// Forgets the command buffers that the GPU is done with, adding up the time
+// it spent executing them. Returns the number of frames it has yet to finish.
+static uint32_t _ngf_pacing_retire(uint64_t *gpu_busy_ns) {
+  uint32_t queued = 0u;
+  for (uint32_t f = 0u; f < NGF_MAX_QUEUED_FRAMES; ++f) {
+    id<MTLCommandBuffer> cmd_buf = CURRENT_CONTEXT->inflight[f];
+    if (cmd_buf == nil) {
+      continue;
+    }
+    if (cmd_buf.status < MTLCommandBufferStatusCompleted) {
+      ++queued;
+      continue;
+    }
+    if (@available(macOS 10.15, iOS 10.3, *)) {
+      if (cmd_buf.GPUEndTime > cmd_buf.GPUStartTime) {
+        *gpu_busy_ns += (uint64_t)(
+            (cmd_buf.GPUEndTime - cmd_buf.GPUStartTime) * 1e9);
+      }
+    }
+    CURRENT_CONTEXT->inflight[f] = nil;
+  }
+  return queued;
+}
+
 ngf_error ngf_begin_frame() {
+  const uint64_t wait_start_ns = _ngf_stats_now_ns();
   dispatch_semaphore_wait(CURRENT_CONTEXT->frame_sync_sem,
                           DISPATCH_TIME_FOREVER);
+  _NGF_STAT_ADD(_NGF_STAT_PACING_WAIT_TIME_NS,
+                _ngf_stats_now_ns() - wait_start_ns);
+  _ngf_timeline_scope("frame sync wait", wait_start_ns);
+  uint64_t wait_frame = 0u;
+  if (_ngf_frame_pacing_target(&CURRENT_CONTEXT->pacing, true,
+                               CURRENT_CONTEXT->frame_index,
+                               CURRENT_CONTEXT->pacing.max_queued_frames,
+                               &wait_frame)) {
+    _ngf_pacing_wait(wait_frame);
+  }
   CURRENT_CONTEXT->frame = CURRENT_CONTEXT->swapchain.next_frame();
   return (!CURRENT_CONTEXT->frame.color_drawable)
            ? NGF_ERROR_NO_FRAME
@@ -584,20 +694,38 @@ ngf_error ngf_begin_frame() {
 }
 
 ngf_error ngf_end_frame() {
+  const uint64_t start_ns = _ngf_stats_now_ns();
   ngf_context ctx = CURRENT_CONTEXT;
+  id<MTLCommandBuffer> committed_cmd_buf = nil;
   if(CURRENT_CONTEXT->frame.color_drawable &&
      CURRENT_CONTEXT->pending_cmd_buffer) {
     [CURRENT_CONTEXT->pending_cmd_buffer addCompletedHandler:^(id<MTLCommandBuffer> _Nonnull) {
       dispatch_semaphore_signal(ctx->frame_sync_sem);
     }];
+    const uint64_t present_start_ns = _ngf_timeline_now();
     [CURRENT_CONTEXT->pending_cmd_buffer
        presentDrawable:CURRENT_CONTEXT->frame.color_drawable];
     [CURRENT_CONTEXT->pending_cmd_buffer commit];
+    _ngf_timeline_scope("present", present_start_ns);
+    committed_cmd_buf = CURRENT_CONTEXT->pending_cmd_buffer;
     CURRENT_CONTEXT->frame = _ngf_swapchain::frame{};
     CURRENT_CONTEXT->pending_cmd_buffer = nil;
   } else {
     dispatch_semaphore_signal(ctx->frame_sync_sem);
   }
+  uint64_t wait_frame = 0u;
+  if (_ngf_frame_pacing_target(&ctx->pacing, false, ctx->frame_index,
+                               ctx->pacing.max_queued_frames, &wait_frame)) {
+    _ngf_pacing_wait(wait_frame);
+  }
+  // The slot may still be holding the frame that was just waited for, so
+  // this frame's command buffer only takes it afterwards.
+  ctx->inflight[ctx->frame_index % NGF_MAX_QUEUED_FRAMES] = committed_cmd_buf;
+  uint64_t gpu_busy_ns = 0u;
+  _NGF_STAT_ADD(_NGF_STAT_QUEUED_FRAMES, _ngf_pacing_retire(&gpu_busy_ns));
+  _NGF_STAT_ADD(_NGF_STAT_GPU_BUSY_TIME_NS, gpu_busy_ns);
+  _NGF_STAT_ADD(_NGF_STAT_END_FRAME_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_stats_end_frame(ctx->frame_index++);
   return NGF_ERROR_OK;
 }
 
@@ -715,6 +843,73 @@ ngf_error ngf_set_context(ngf_context ctx) {
   return NGF_ERROR_OK;
 }
 
+ngf_error ngf_get_device_capabilities(ngf_device_capabilities *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == nullptr) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  // Metal doesn't expose most of these limits through its API, the values
+  // below come from the Metal feature set tables.
+#if TARGET_OS_OSX
+  result->uniform_buffer_offset_alignment = 256u;
+  result->max_image_dimension_2d = 16384u;
+#else
+  result->uniform_buffer_offset_alignment = 16u;
+  result->max_image_dimension_2d = 8192u;
+#endif
+  result->max_uniform_buffer_range = 64u * 1024u;
+  result->optimal_copy_offset_alignment = 16u;
+  result->max_uniform_buffers_per_stage = 31u;
+  result->max_sampled_images_per_stage = 31u;
+  result->max_samplers_per_stage = 16u;
+  result->max_color_attachments = 8u;
+  result->max_sample_count = 1u;
+  for (uint32_t c = 8u; c > 1u; c >>= 1u) {
+    if ([CURRENT_CONTEXT->device supportsTextureSampleCount:c]) {
+      result->max_sample_count = c;
+      break;
+    }
+  }
+  result->timestamp_period = 1.0f;
+  // Render encoders have no multi-draw indirect, see ngf_cmd_draw_indirect.
+  result->multi_draw_indirect = false;
+#if TARGET_OS_OSX
+  result->draw_indirect_first_instance = true;
+#else
+  result->draw_indirect_first_instance =
+      [CURRENT_CONTEXT->device
+          supportsFeatureSet:MTLFeatureSet_iOS_GPUFamily3_v1];
+#endif
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_set_frame_pacing(const ngf_frame_pacing_info *info) {
+  if (CURRENT_CONTEXT == nullptr) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  const ngf_error err = _ngf_validate_frame_pacing(info);
+  if (err == NGF_ERROR_OK) {
+    CURRENT_CONTEXT->pacing = *info;
+  }
+  return err;
+}
+
+// TODO: implement GPU timing with MTLCounterSampleBuffer.
+ngf_error ngf_enable_gpu_timing(bool enable) {
+  if (CURRENT_CONTEXT == nullptr) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  return enable ? NGF_ERROR_INVALID_OPERATION : NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_gpu_frame_timings(ngf_gpu_frame_timings *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == nullptr) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  return NGF_ERROR_NO_FRAME;
+}
+
 ngf_error ngf_create_shader_stage(const ngf_shader_stage_info *info,
                                   ngf_shader_stage *result) {
   assert(info);
@@ -734,9 +929,11 @@ ngf_error ngf_create_shader_stage(const ngf_shader_stage_info *info,
                                  encoding:NSUTF8StringEncoding];
     MTLCompileOptions *opts = [MTLCompileOptions new];
     NSError *err = nil;
+    const uint64_t compile_start_ns = _ngf_timeline_now();
     stage->func_lib = [CURRENT_CONTEXT->device newLibraryWithSource:source
                                   options:opts
                                   error:&err];
+    _ngf_timeline_scope("shader compile", compile_start_ns);
     if (!stage->func_lib) {
       // TODO: call debug callback with error message here.
       NSLog(@"%@\n", err);
@@ -899,6 +1096,7 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
                                        ngf_graphics_pipeline *result) {
   assert(info);
   assert(result);
+  _ngf_timeline_block timeline_block("ngf_create_graphics_pipeline");
   
   auto *mtl_pipe_desc = [MTLRenderPipelineDescriptor new];
   const ngf_render_target_t &compatible_rt = *info->compatible_render_target;
@@ -1006,23 +1204,27 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
     return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
   }
   
-  _NGF_NURSERY(graphics_pipeline, pipeline);
+  _NGF_NURSERY_AS(graphics_pipeline, pipeline, NGF_ALLOCATION_PIPELINE);
   pipeline->layout.ndescriptor_set_layouts =
       info->layout->ndescriptor_set_layouts;
   ngf_descriptor_set_layout_info *descriptor_set_layouts =
-      NGF_ALLOCN(ngf_descriptor_set_layout_info,
-                 info->layout->ndescriptor_set_layouts);
+      NGF_ALLOCN_AS(ngf_descriptor_set_layout_info,
+                    info->layout->ndescriptor_set_layouts,
+                    NGF_ALLOCATION_PIPELINE);
   pipeline->layout.descriptor_set_layouts = descriptor_set_layouts;
   if (pipeline->layout.descriptor_set_layouts == nullptr) {
     return NGF_ERROR_OUTOFMEM;
   }
   memset(pipeline->layout.descriptor_set_layouts, 0,
-         sizeof(ngf_descriptor_set_layout_info));
+         sizeof(ngf_descriptor_set_layout_info) *
+         info->layout->ndescriptor_set_layouts);
   for (uint32_t s = 0u; s < info->layout->ndescriptor_set_layouts; ++s) {
     descriptor_set_layouts[s].ndescriptors =
         info->layout->descriptor_set_layouts[s].ndescriptors;
     ngf_descriptor_info *descriptors  =
-        NGF_ALLOCN(ngf_descriptor_info, descriptor_set_layouts->ndescriptors);
+        NGF_ALLOCN_AS(ngf_descriptor_info,
+                      descriptor_set_layouts[s].ndescriptors,
+                      NGF_ALLOCATION_PIPELINE);
     descriptor_set_layouts[s].descriptors = descriptors;
     if (descriptors == nullptr) return NGF_ERROR_OUTOFMEM;
     memcpy(descriptors,
@@ -1038,6 +1240,11 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
   if (ngf_err != NGF_ERROR_OK) {
     return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
   }
+  pipeline->layout.push_constants_size = info->layout->push_constants_size;
+  pipeline->layout.push_constants_stage_flags =
+      info->layout->push_constants_stage_flags;
+  pipeline->push_constants_index =
+      _ngf_push_constants_native_binding(info->layout);
   NSError *err = nil;
   pipeline->pipeline = [CURRENT_CONTEXT->device
       newRenderPipelineStateWithDescriptor:mtl_pipe_desc
@@ -1081,7 +1288,77 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
 void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline pipe) {
   if (pipe != nullptr) {
     pipe->~ngf_graphics_pipeline_t();
-    NGF_FREE(pipe);
+    NGF_FREE_AS(pipe, NGF_ALLOCATION_PIPELINE);
+  }
+}
+
+ngf_error ngf_create_compute_pipeline(const ngf_compute_pipeline_info *info,
+                                      ngf_compute_pipeline *result) {
+  assert(info);
+  assert(result);
+  _ngf_timeline_block timeline_block("ngf_create_compute_pipeline");
+  const ngf_shader_stage stage = info->shader_stage;
+  if (stage->type != NGF_STAGE_COMPUTE) {
+    return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+  }
+
+  // Populate specialization constant values.
+  MTLFunctionConstantValues *spec_consts = nil;
+  if (info->spec_info != nullptr) {
+    spec_consts = [MTLFunctionConstantValues new];
+    for (uint32_t s = 0u; s < info->spec_info->nspecializations; ++s) {
+      const ngf_constant_specialization *spec =
+          &info->spec_info->specializations[s];
+      MTLDataType type = get_mtl_type(spec->type);
+      if (type == MTLDataTypeNone) {
+        return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+      }
+      void *write_ptr =
+          ((uint8_t*)info->spec_info->value_buffer + spec->offset);
+      [spec_consts setConstantValue:write_ptr
+                               type:type
+                            atIndex:spec->constant_id];
+    }
+  }
+
+  _NGF_NURSERY_AS(compute_pipeline, pipeline, NGF_ALLOCATION_PIPELINE);
+  ngf_error ngf_err =
+      _ngf_create_native_binding_map(info->layout,
+                                     nullptr,
+                                     nullptr,
+                                    &pipeline->binding_map);
+  if (ngf_err != NGF_ERROR_OK) {
+    return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+  }
+  pipeline->push_constants_index =
+      _ngf_push_constants_native_binding(info->layout);
+  pipeline->push_constants_size = info->layout->push_constants_size;
+  // Metal can't query the workgroup size from the function, it has to be
+  // supplied at dispatch time.
+  pipeline->threadgroup_size = MTLSizeMake(info->workgroup_size[0],
+                                           info->workgroup_size[1],
+                                           info->workgroup_size[2]);
+  id<MTLFunction> func =
+      _ngf_get_shader_main(stage->func_lib, stage->entry_point_name.c_str(),
+                           spec_consts);
+  NSError *err = nil;
+  pipeline->pipeline = [CURRENT_CONTEXT->device
+      newComputePipelineStateWithFunction:func
+      error:&err];
+  if (err) {
+    NSLog(@"... [%@]\n", err);
+    // TODO: invoke debug callback
+    return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+  } else {
+    *result = pipeline.release();
+    return NGF_ERROR_OK;
+  }
+}
+
+void ngf_destroy_compute_pipeline(ngf_compute_pipeline pipe) {
+  if (pipe != nullptr) {
+    pipe->~ngf_compute_pipeline_t();
+    NGF_FREE_AS(pipe, NGF_ALLOCATION_PIPELINE);
   }
 }
 
@@ -1332,6 +1609,9 @@ ngf_error ngf_create_image(const ngf_image_info *info, ngf_image *result) {
   if (info->usage_hint & NGF_IMAGE_USAGE_SAMPLE_FROM) {
     mtl_img_desc.usage |= MTLTextureUsageShaderRead;
   }
+  if (info->usage_hint & NGF_IMAGE_USAGE_STORAGE) {
+    mtl_img_desc.usage |= MTLTextureUsageShaderRead | MTLTextureUsageShaderWrite;
+  }
   switch(mtl_img_desc.textureType) {
   case MTLTextureType2D:
   case MTLTextureType3D:
@@ -1361,6 +1641,42 @@ void ngf_destroy_image(ngf_image image) {
   }
 }
 
+// Every image has memory of its own, so images can only be shared between
+// requests with the same configuration.
+static ngf_error _ngf_create_transient_image(
+    ngf_transient_pool              pool,
+    const ngf_transient_image_info *info,
+    ngf_image                      *result,
+    uint32_t                       *block) {
+  _NGF_FAKE_USE(pool);
+  *block = _NGF_TRANSIENT_NO_BLOCK;
+  return ngf_create_image(&info->image_info, result);
+}
+
+ngf_error ngf_create_transient_pool(ngf_transient_pool *result) {
+  return _ngf_transient_pool_create(result);
+}
+
+void ngf_destroy_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_destroy(pool, ngf_destroy_image, nullptr);
+}
+
+ngf_error ngf_acquire_transient_image(ngf_transient_pool pool,
+                                      const ngf_transient_image_info *info,
+                                      ngf_image *result) {
+  return _ngf_transient_acquire(pool, info, _ngf_create_transient_image,
+                                result);
+}
+
+void ngf_reset_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_reset(pool, ngf_destroy_image, nullptr);
+}
+
+void ngf_get_transient_pool_stats(ngf_transient_pool pool,
+                                  ngf_transient_pool_stats *result) {
+  _ngf_transient_pool_stats(pool, result);
+}
+
 void ngf_destroy_cmd_buffer(ngf_cmd_buffer cmd_buffer) {
   if (cmd_buffer != nullptr) {
     cmd_buffer->~ngf_cmd_buffer_t();
@@ -1374,11 +1690,14 @@ ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer cmd_buffer) {
   cmd_buffer->mtl_cmd_buffer = [CURRENT_CONTEXT->queue commandBuffer];
   cmd_buffer->active_rce = nil;
   cmd_buffer->active_bce = nil;
+  cmd_buffer->active_cce = nil;
+  cmd_buffer->dynamic_ubos.clear();
   cmd_buffer->state = _NGF_CMD_BUFFER_READY;
   return NGF_ERROR_OK;
 }
 
 ngf_error ngf_submit_cmd_buffers(uint32_t n, ngf_cmd_buffer *cmd_buffers) {
+  const uint64_t start_ns = _ngf_stats_now_ns();
   if (CURRENT_CONTEXT->pending_cmd_buffer) {
     [CURRENT_CONTEXT->pending_cmd_buffer commit];
     CURRENT_CONTEXT->pending_cmd_buffer = nil;
@@ -1392,6 +1711,8 @@ ngf_error ngf_submit_cmd_buffers(uint32_t n, ngf_cmd_buffer *cmd_buffers) {
     cmd_buffers[b]->mtl_cmd_buffer = nil;
     cmd_buffers[b]->state =  _NGF_CMD_BUFFER_SUBMITTED;
   }
+  _NGF_STAT_ADD(_NGF_STAT_SUBMIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("ngf_submit_cmd_buffers", start_ns);
   return NGF_ERROR_OK;
 }
 
@@ -1443,6 +1764,33 @@ ngf_error ngf_xfer_encoder_end(ngf_xfer_encoder enc) {
   return NGF_ERROR_OK;
 }
 
+ngf_error ngf_cmd_buffer_start_compute(ngf_cmd_buffer cmd_buf,
+                                       ngf_compute_encoder *enc) {
+  if (cmd_buf->state != _NGF_CMD_BUFFER_READY) {
+    enc->__handle = 0u;
+    return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
+  }
+  cmd_buf->state = _NGF_CMD_BUFFER_RECORDING;
+  cmd_buf->active_cce = [cmd_buf->mtl_cmd_buffer computeCommandEncoder];
+  enc->__handle = (uintptr_t)cmd_buf;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_compute_encoder_end(ngf_compute_encoder enc) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  if (cmd_buf->state != _NGF_CMD_BUFFER_RECORDING) {
+    return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
+  }
+  // Metal tracks hazards between encoders, so results become visible to the
+  // following encoders without an explicit barrier.
+  if (cmd_buf->active_cce) {
+    [cmd_buf->active_cce endEncoding];
+    cmd_buf->active_cce = nil;
+  }
+  cmd_buf->state = _NGF_CMD_BUFFER_READY;
+  return NGF_ERROR_OK;
+}
+
 void ngf_cmd_begin_pass(ngf_render_encoder enc,
                         const ngf_render_target rt) {
   auto cmd_buffer = (ngf_cmd_buffer)enc.__handle;
@@ -1490,6 +1838,7 @@ void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc,
       setStencilFrontReferenceValue:pipeline->front_stencil_reference
       backReferenceValue:pipeline->back_stencil_reference];
   buf->active_pipe = pipeline;
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
 }
 
 void ngf_cmd_viewport(ngf_render_encoder enc, const ngf_irect2d *r) {
@@ -1552,6 +1901,57 @@ void ngf_cmd_draw(ngf_render_encoder enc, bool indexed,
      baseVertex:0
      baseInstance:0];
   }
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, 1u);
+  _NGF_STAT_ADD(_NGF_STAT_INSTANCES, ninstances);
+}
+
+void ngf_cmd_push_constants(ngf_render_encoder enc, const void *data,
+                            uint32_t offset, uint32_t size) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  assert(cmd_buf->active_pipe);
+  const ngf_pipeline_layout_info &layout = cmd_buf->active_pipe->layout;
+  assert(offset + size <= layout.push_constants_size);
+  memcpy(&cmd_buf->push_constants[offset], data, size);
+  const NSUInteger index = cmd_buf->active_pipe->push_constants_index;
+  if (layout.push_constants_stage_flags & NGF_DESCRIPTOR_VERTEX_STAGE_BIT) {
+    [cmd_buf->active_rce setVertexBytes:cmd_buf->push_constants
+                                 length:layout.push_constants_size
+                                atIndex:index];
+  }
+  if (layout.push_constants_stage_flags & NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT) {
+    [cmd_buf->active_rce setFragmentBytes:cmd_buf->push_constants
+                                   length:layout.push_constants_size
+                                  atIndex:index];
+  }
+}
+
+void ngf_cmd_draw_indirect(ngf_render_encoder enc, bool indexed,
+                           const ngf_attrib_buffer args, size_t offset,
+                           uint32_t ndraws, uint32_t stride) {
+  auto buf = (ngf_cmd_buffer)enc.__handle;
+  MTLPrimitiveType prim_type = buf->active_pipe->primitive_type;
+  // Metal has no multi-draw indirect on render encoders, issue the draws
+  // one by one.
+  if (stride == 0u) {
+    stride = indexed ? sizeof(ngf_draw_indexed_indirect_args)
+                     : sizeof(ngf_draw_indirect_args);
+  }
+  for (uint32_t d = 0u; d < ndraws; ++d) {
+    const size_t args_offset = offset + d * stride;
+    if (!indexed) {
+      [buf->active_rce drawPrimitives:prim_type
+                       indirectBuffer:args->mtl_buffer
+                 indirectBufferOffset:args_offset];
+    } else {
+      [buf->active_rce drawIndexedPrimitives:prim_type
+       indexType:buf->bound_index_buffer_type
+       indexBuffer:buf->bound_index_buffer
+       indexBufferOffset:0
+       indirectBuffer:args->mtl_buffer
+       indirectBufferOffset:args_offset];
+    }
+  }
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, ndraws);
 }
 
 void ngf_cmd_bind_attrib_buffer(ngf_render_encoder enc,
@@ -1606,11 +2006,31 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
                vert_stage_visible = set_stage_flags &
                                     NGF_DESCRIPTOR_VERTEX_STAGE_BIT;
     switch(bind_op.type) {
-      case NGF_DESCRIPTOR_UNIFORM_BUFFER: {
+      case NGF_DESCRIPTOR_UNIFORM_BUFFER:
+      case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC: {
         const  ngf_uniform_buffer_bind_info &buf_bind_op =
             bind_op.info.uniform_buffer;
         const ngf_uniform_buffer buf = buf_bind_op.buffer;
         size_t offset = buf->current_idx * buf->size + buf_bind_op.offset;
+        if (bind_op.type == NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC) {
+          const _ngf_dynamic_ubo_binding dynamic_ubo {
+            bind_op.target_set, ngf_binding, native_binding, offset,
+            vert_stage_visible, frag_stage_visible
+          };
+          auto &ubos = cmd_buf->dynamic_ubos;
+          auto it = std::lower_bound(ubos.begin(), ubos.end(), dynamic_ubo,
+              [](const _ngf_dynamic_ubo_binding &a,
+                 const _ngf_dynamic_ubo_binding &b) {
+                return a.set < b.set ||
+                       (a.set == b.set && a.binding < b.binding);
+              });
+          if (it != ubos.end() && it->set == dynamic_ubo.set &&
+              it->binding == dynamic_ubo.binding) {
+            *it = dynamic_ubo;
+          } else {
+            ubos.insert(it, dynamic_ubo);
+          }
+        }
         if (vert_stage_visible) {
           [cmd_buf->active_rce setVertexBuffer:buf->mtl_buffer
                                         offset:offset
@@ -1671,11 +2091,178 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
            atIndex:native_binding];
         }
         break; }
+      case NGF_DESCRIPTOR_STORAGE_BUFFER: {
+        const ngf_storage_buffer_bind_info &buf_bind_op =
+            bind_op.info.storage_buffer;
+        if (vert_stage_visible) {
+          [cmd_buf->active_rce setVertexBuffer:buf_bind_op.buffer->mtl_buffer
+                                        offset:buf_bind_op.offset
+                                       atIndex:native_binding];
+        }
+        if (frag_stage_visible) {
+          [cmd_buf->active_rce setFragmentBuffer:buf_bind_op.buffer->mtl_buffer
+                                          offset:buf_bind_op.offset
+                                         atIndex:native_binding];
+        }
+        break; }
+      case NGF_DESCRIPTOR_STORAGE_IMAGE: {
+        if (vert_stage_visible) {
+          [cmd_buf->active_rce
+           setVertexTexture:bind_op.info.storage_image.image->texture
+           atIndex:native_binding];
+        }
+        if (frag_stage_visible) {
+          [cmd_buf->active_rce
+           setFragmentTexture:bind_op.info.storage_image.image->texture
+           atIndex:native_binding];
+        }
+        break; }
       case NGF_DESCRIPTOR_TYPE_COUNT: assert(false);
     }
   }
 }
 
+void ngf_cmd_set_dynamic_offsets(ngf_render_encoder enc, uint32_t set,
+                                 const uint32_t *offsets, uint32_t noffsets) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  uint32_t o = 0u;
+  for (const _ngf_dynamic_ubo_binding &ubo : cmd_buf->dynamic_ubos) {
+    if (ubo.set != set) continue;
+    if (o >= noffsets) break;
+    const size_t offset = ubo.base_offset + offsets[o++];
+    if (ubo.vert_stage_visible) {
+      [cmd_buf->active_rce setVertexBufferOffset:offset
+                                         atIndex:ubo.native_binding];
+    }
+    if (ubo.frag_stage_visible) {
+      [cmd_buf->active_rce setFragmentBufferOffset:offset
+                                           atIndex:ubo.native_binding];
+    }
+  }
+  assert(o == noffsets);
+}
+
+void ngf_cmd_bind_compute_pipeline(ngf_compute_encoder enc,
+                                   const ngf_compute_pipeline pipeline) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  [cmd_buf->active_cce setComputePipelineState:pipeline->pipeline];
+  cmd_buf->active_compute_pipe = pipeline;
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
+}
+
+void ngf_cmd_bind_compute_resources(ngf_compute_encoder enc,
+                                    const ngf_resource_bind_op *bind_ops,
+                                    uint32_t nbind_ops) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  assert(cmd_buf->active_compute_pipe);
+  for (uint32_t o = 0u; o < nbind_ops; ++o) {
+    const ngf_resource_bind_op &bind_op = bind_ops[o];
+    const _ngf_native_binding *nb =
+        _ngf_binding_map_lookup(cmd_buf->active_compute_pipe->binding_map,
+                                bind_op.target_set,
+                                bind_op.target_binding);
+    if (nb == nullptr) {
+      // TODO: call debug callback.
+      continue;
+    }
+    const uint32_t native_binding = nb->native_binding_id;
+    switch(bind_op.type) {
+      case NGF_DESCRIPTOR_UNIFORM_BUFFER:
+      case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC: {
+        const ngf_uniform_buffer_bind_info &buf_bind_op =
+            bind_op.info.uniform_buffer;
+        const ngf_uniform_buffer buf = buf_bind_op.buffer;
+        size_t offset = buf->current_idx * buf->size + buf_bind_op.offset;
+        [cmd_buf->active_cce setBuffer:buf->mtl_buffer
+                                offset:offset
+                               atIndex:native_binding];
+        break; }
+      case NGF_DESCRIPTOR_STORAGE_BUFFER: {
+        const ngf_storage_buffer_bind_info &buf_bind_op =
+            bind_op.info.storage_buffer;
+        [cmd_buf->active_cce setBuffer:buf_bind_op.buffer->mtl_buffer
+                                offset:buf_bind_op.offset
+                               atIndex:native_binding];
+        break; }
+      case NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER:
+        [cmd_buf->active_cce
+         setSamplerState:bind_op.info.image_sampler.sampler->sampler
+         atIndex:native_binding];
+        // Fall through.
+      case NGF_DESCRIPTOR_TEXTURE:
+        [cmd_buf->active_cce
+         setTexture:bind_op.info.image_sampler.image_subresource.image->texture
+         atIndex:native_binding];
+        break;
+      case NGF_DESCRIPTOR_SAMPLER:
+        [cmd_buf->active_cce
+         setSamplerState:bind_op.info.image_sampler.sampler->sampler
+         atIndex:native_binding];
+        break;
+      case NGF_DESCRIPTOR_STORAGE_IMAGE:
+        [cmd_buf->active_cce
+         setTexture:bind_op.info.storage_image.image->texture
+         atIndex:native_binding];
+        break;
+      case NGF_DESCRIPTOR_TYPE_COUNT: assert(false);
+    }
+  }
+}
+
+void ngf_cmd_push_compute_constants(ngf_compute_encoder enc, const void *data,
+                                    uint32_t offset, uint32_t size) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  assert(cmd_buf->active_compute_pipe);
+  const ngf_compute_pipeline pipe = cmd_buf->active_compute_pipe;
+  assert(offset + size <= pipe->push_constants_size);
+  memcpy(&cmd_buf->push_constants[offset], data, size);
+  [cmd_buf->active_cce setBytes:cmd_buf->push_constants
+                         length:pipe->push_constants_size
+                        atIndex:pipe->push_constants_index];
+}
+
+// Debug groups are pushed onto the command buffer rather than the encoder,
+// because the render command encoder doesn't exist until a pass begins.
+void ngf_cmd_begin_debug_group(ngf_render_encoder enc, const char *name) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  [cmd_buf->mtl_cmd_buffer pushDebugGroup:@(name)];
+}
+
+void ngf_cmd_end_debug_group(ngf_render_encoder enc) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  [cmd_buf->mtl_cmd_buffer popDebugGroup];
+}
+
+void ngf_cmd_begin_compute_debug_group(ngf_compute_encoder enc,
+                                       const char *name) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  [cmd_buf->mtl_cmd_buffer pushDebugGroup:@(name)];
+}
+
+void ngf_cmd_end_compute_debug_group(ngf_compute_encoder enc) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  [cmd_buf->mtl_cmd_buffer popDebugGroup];
+}
+
+void ngf_cmd_dispatch(ngf_compute_encoder enc, uint32_t ngroups_x,
+                      uint32_t ngroups_y, uint32_t ngroups_z) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  assert(cmd_buf->active_compute_pipe);
+  [cmd_buf->active_cce
+   dispatchThreadgroups:MTLSizeMake(ngroups_x, ngroups_y, ngroups_z)
+   threadsPerThreadgroup:cmd_buf->active_compute_pipe->threadgroup_size];
+}
+
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc,
+                               const ngf_attrib_buffer args, size_t offset) {
+  auto cmd_buf = (ngf_cmd_buffer)enc.__handle;
+  assert(cmd_buf->active_compute_pipe);
+  [cmd_buf->active_cce
+   dispatchThreadgroupsWithIndirectBuffer:args->mtl_buffer
+   indirectBufferOffset:offset
+   threadsPerThreadgroup:cmd_buf->active_compute_pipe->threadgroup_size];
+}
+
 void _ngf_cmd_copy_buffer(ngf_xfer_encoder enc,
                           id<MTLBuffer> src, id<MTLBuffer> dst,
                           size_t size, size_t src_offset, size_t dst_offset) {
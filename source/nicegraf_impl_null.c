@@ -0,0 +1,1462 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Headless backend that doesn't talk to any driver. It does all of the
+// bookkeeping that a real backend does (object allocation, binding map
+// lookups, command recording and replay, state tracking), so that nicegraf's
+// own CPU overhead can be measured on machines without a GPU. Buffers are
+// backed by host memory, everything else only records its parameters.
+
+#if defined(NGF_CAPTURE_BACKEND)
+#include "nicegraf_capture_names.h"
+#endif
+#include "nicegraf.h"
+#include "nicegraf_internal.h"
+#include "dynamic_array.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma region ngf_impl_type_definitions
+
+// Native bindings beyond this one are looked up, but not tracked at submit.
+#define _NGF_NULL_MAX_TRACKED_BINDINGS 64u
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  bool mapped;
+} _ngf_null_buffer;
+
+struct ngf_graphics_pipeline_t {
+  _ngf_native_binding_map binding_map;
+  ngf_vertex_buf_binding_desc *vert_buf_bindings;
+  uint32_t nvert_buf_bindings;
+  uint32_t dynamic_state_mask;
+  ngf_primitive_type primitive_type;
+  uint32_t push_constants_size;
+};
+
+struct ngf_compute_pipeline_t {
+  _ngf_native_binding_map binding_map;
+  uint32_t push_constants_size;
+};
+
+struct ngf_render_target_t {
+  bool is_default;
+  uint32_t nattachments;
+  ngf_attachment attachment_infos[];
+};
+
+struct ngf_context_t {
+  bool has_swapchain;
+  ngf_swapchain_info swapchain_info;
+  uint64_t frame;
+  // State established by the commands replayed so far.
+  struct {
+    ngf_graphics_pipeline bound_pipeline;
+    ngf_compute_pipeline bound_compute_pipeline;
+    ngf_render_target active_rt;
+    const _ngf_null_buffer *bound_index_buffer;
+    ngf_type bound_index_type;
+    const void *bound_resources[_NGF_NULL_MAX_TRACKED_BINDINGS];
+    ngf_irect2d viewport;
+    ngf_irect2d scissor;
+    uint8_t push_constants[NGF_MAX_PUSH_CONSTANTS_SIZE];
+    uint32_t scope_depth;
+  } cached_state;
+};
+
+struct ngf_shader_stage_t {
+  ngf_stage_type type;
+  uint8_t *content;
+  uint32_t content_length;
+};
+
+struct ngf_attrib_buffer_t {
+  _ngf_null_buffer data;
+};
+
+struct ngf_index_buffer_t {
+  _ngf_null_buffer data;
+};
+
+struct ngf_uniform_buffer_t {
+  _ngf_null_buffer data;
+};
+
+struct ngf_pixel_buffer_t {
+  _ngf_null_buffer data;
+};
+
+struct ngf_image_t {
+  ngf_image_info info;
+};
+
+struct ngf_sampler_t {
+  ngf_sampler_info info;
+};
+
+typedef enum {
+  _NGF_CMD_BIND_PIPELINE,
+  _NGF_CMD_BIND_COMPUTE_PIPELINE,
+  _NGF_CMD_BEGIN_PASS,
+  _NGF_CMD_END_PASS,
+  _NGF_CMD_VIEWPORT,
+  _NGF_CMD_SCISSOR,
+  _NGF_CMD_STENCIL_REFERENCE,
+  _NGF_CMD_STENCIL_COMPARE_MASK,
+  _NGF_CMD_STENCIL_WRITE_MASK,
+  _NGF_CMD_LINE_WIDTH,
+  _NGF_CMD_BLEND_FACTORS,
+  _NGF_CMD_BIND_RESOURCE,
+  _NGF_CMD_BIND_ATTRIB_BUFFER,
+  _NGF_CMD_BIND_INDEX_BUFFER,
+  _NGF_CMD_DRAW,
+  _NGF_CMD_DRAW_INDIRECT,
+  _NGF_CMD_DISPATCH,
+  _NGF_CMD_DISPATCH_INDIRECT,
+  _NGF_CMD_PUSH_CONSTANTS,
+  _NGF_CMD_COPY,
+  _NGF_CMD_WRITE_IMAGE,
+  _NGF_CMD_BEGIN_SCOPE,
+  _NGF_CMD_END_SCOPE
+} _ngf_null_cmd_type;
+
+#define _NGF_PUSH_CONSTANTS_CHUNK_SIZE 32u
+
+typedef struct {
+  _ngf_null_cmd_type type;
+  union {
+    ngf_graphics_pipeline pipeline;
+    ngf_compute_pipeline compute_pipeline;
+    ngf_render_target target;
+    ngf_irect2d rect;
+    struct {
+      uint32_t front;
+      uint32_t back;
+    } stencil;
+    float line_width;
+    struct {
+      ngf_blend_factor sfactor;
+      ngf_blend_factor dfactor;
+    } blend_factors;
+    struct {
+      const void *resource;
+      uint32_t native_binding;
+      size_t offset;
+      size_t range;
+    } bind_resource;
+    struct {
+      const _ngf_null_buffer *buf;
+      uint32_t binding;
+      uint32_t offset;
+    } attrib_buffer_bind;
+    struct {
+      const _ngf_null_buffer *buf;
+      ngf_type type;
+    } index_buffer_bind;
+    struct {
+      uint32_t first_element;
+      uint32_t nelements;
+      uint32_t ninstances;
+      bool indexed;
+    } draw;
+    struct {
+      const _ngf_null_buffer *args;
+      size_t offset;
+      uint32_t ndraws;
+      uint32_t stride;
+    } draw_indirect;
+    struct {
+      uint32_t ngroups_x;
+      uint32_t ngroups_y;
+      uint32_t ngroups_z;
+    } dispatch;
+    struct {
+      const _ngf_null_buffer *args;
+      size_t offset;
+    } dispatch_indirect;
+    struct {
+      uint8_t data[_NGF_PUSH_CONSTANTS_CHUNK_SIZE];
+      uint16_t offset;
+      uint16_t size;
+    } push_constants;
+    struct {
+      const _ngf_null_buffer *src;
+      _ngf_null_buffer *dst;
+      size_t size;
+      size_t src_offset;
+      size_t dst_offset;
+    } copy;
+    struct {
+      const _ngf_null_buffer *src;
+      size_t src_offset;
+      ngf_image_ref dst;
+      ngf_extent3d extent;
+    } write_image;
+    const char *scope_name;
+  };
+} _ngf_null_cmd;
+
+#define _NGF_CMDS_PER_CMD_BLOCK 16u
+
+typedef struct _ngf_cmd_block {
+  struct _ngf_cmd_block *next;
+  _ngf_null_cmd cmds[_NGF_CMDS_PER_CMD_BLOCK];
+  uint32_t next_cmd_idx;
+} _ngf_cmd_block;
+
+typedef struct {
+  uint32_t set;
+  uint32_t binding;
+  uint32_t native_binding;
+  const _ngf_null_buffer *buffer;
+  size_t base_offset;
+  size_t range;
+} _ngf_dynamic_ubo_binding;
+
+struct ngf_cmd_buffer_t {
+  ngf_graphics_pipeline bound_pipeline;
+  ngf_compute_pipeline bound_compute_pipeline;
+  _NGF_DARRAY_OF(_ngf_dynamic_ubo_binding) dynamic_ubos;
+  _ngf_cmd_block *first_cmd_block;
+  _ngf_cmd_block *last_cmd_block;
+  bool renderpass_active;
+  _ngf_cmd_buffer_state state;
+};
+
+#pragma endregion
+
+void (*NGF_DEBUG_CALLBACK)(const char *message, const void *userdata) = NULL;
+void *NGF_DEBUG_USERDATA = NULL;
+
+NGF_THREADLOCAL ngf_context CURRENT_CONTEXT = NULL;
+NGF_THREADLOCAL _ngf_block_allocator *COMMAND_POOL = NULL;
+
+static void _ngf_null_report(const char *message) {
+  if (NGF_DEBUG_CALLBACK) {
+    NGF_DEBUG_CALLBACK(message, NGF_DEBUG_USERDATA);
+  }
+}
+
+void ngf_debug_message_callback(void *userdata,
+                                void(*callback)(const char*, const void*)) {
+  NGF_DEBUG_CALLBACK = callback;
+  NGF_DEBUG_USERDATA = userdata;
+}
+
+#pragma region ngf_impl_context
+
+ngf_error ngf_initialize(ngf_device_preference dev_pref) {
+  _NGF_FAKE_USE(dev_pref);
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_create_context(const ngf_context_info *info,
+                             ngf_context *result) {
+  assert(info);
+  assert(result);
+  *result = NGF_ALLOC(struct ngf_context_t);
+  ngf_context ctx = *result;
+  if (ctx == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  memset(ctx, 0, sizeof(*ctx));
+  if (info->swapchain_info != NULL) {
+    ctx->has_swapchain = true;
+    ctx->swapchain_info = *info->swapchain_info;
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_resize_context(ngf_context ctx,
+                             uint32_t new_width,
+                             uint32_t new_height) {
+  assert(ctx);
+  if (!ctx->has_swapchain) {
+    return NGF_ERROR_NO_DEFAULT_RENDER_TARGET;
+  }
+  ctx->swapchain_info.width = new_width;
+  ctx->swapchain_info.height = new_height;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_set_context(ngf_context ctx) {
+  assert(ctx);
+  if (CURRENT_CONTEXT == ctx) {
+    return NGF_ERROR_CONTEXT_ALREADY_CURRENT;
+  }
+  if (CURRENT_CONTEXT && (CURRENT_CONTEXT != ctx)) {
+    return NGF_ERROR_CALLER_HAS_CURRENT_CONTEXT;
+  }
+  CURRENT_CONTEXT = ctx;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_device_capabilities(ngf_device_capabilities *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  // Limits of a typical desktop GPU, so that code sizing its work by them
+  // behaves the same as it would on real hardware.
+  result->uniform_buffer_offset_alignment = 256u;
+  result->max_uniform_buffer_range = 65536u;
+  result->optimal_copy_offset_alignment = 16u;
+  result->max_uniform_buffers_per_stage = 14u;
+  result->max_sampled_images_per_stage = 32u;
+  result->max_samplers_per_stage = 16u;
+  result->max_color_attachments = 8u;
+  result->max_image_dimension_2d = 16384u;
+  result->max_sample_count = 8u;
+  result->timestamp_period = 1.0f;
+  result->multi_draw_indirect = true;
+  result->draw_indirect_first_instance = true;
+  return NGF_ERROR_OK;
+}
+
+void ngf_destroy_context(ngf_context ctx) {
+  if (ctx != NULL) {
+    if (CURRENT_CONTEXT == ctx) {
+      CURRENT_CONTEXT = NULL;
+    }
+    NGF_FREE(ctx);
+  }
+}
+
+#pragma endregion
+
+#pragma region ngf_impl_objects
+
+ngf_error ngf_create_shader_stage(const ngf_shader_stage_info *info,
+                                  ngf_shader_stage *result) {
+  assert(info);
+  assert(result);
+  *result = NGF_ALLOC(struct ngf_shader_stage_t);
+  ngf_shader_stage stage = *result;
+  if (stage == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  stage->type = info->type;
+  stage->content_length = info->content_length;
+  stage->content = NULL;
+  if (info->content_length > 0u) {
+    stage->content = NGF_ALLOCN(uint8_t, info->content_length);
+    if (stage->content == NULL) {
+      NGF_FREE(stage);
+      *result = NULL;
+      return NGF_ERROR_OUTOFMEM;
+    }
+    memcpy(stage->content, info->content, info->content_length);
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_binary_shader_stage_size(const ngf_shader_stage stage,
+                                           size_t *size) {
+  *size = stage->content_length;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_binary_shader_stage(const ngf_shader_stage stage,
+                                      size_t buf_size,
+                                      void *buffer,
+                                      uint32_t *format) {
+  memcpy(buffer, stage->content, NGF_MIN(buf_size, stage->content_length));
+  *format = 0u;
+  return NGF_ERROR_OK;
+}
+
+void ngf_destroy_shader_stage(ngf_shader_stage stage) {
+  if (stage != NULL) {
+    if (stage->content != NULL) {
+      NGF_FREEN(stage->content, stage->content_length);
+    }
+    NGF_FREE(stage);
+  }
+}
+
+ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
+                                       ngf_graphics_pipeline *result) {
+  assert(info);
+  assert(result);
+  ngf_error err = NGF_ERROR_OK;
+  *result = NGF_ALLOC_AS(struct ngf_graphics_pipeline_t,
+                         NGF_ALLOCATION_PIPELINE);
+  ngf_graphics_pipeline pipeline = *result;
+  if (pipeline == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  memset(pipeline, 0, sizeof(*pipeline));
+
+  const ngf_vertex_input_info *input = info->input_info;
+  if (input->nvert_buf_bindings > 0u) {
+    pipeline->vert_buf_bindings =
+        NGF_ALLOCN_AS(ngf_vertex_buf_binding_desc, input->nvert_buf_bindings,
+                      NGF_ALLOCATION_PIPELINE);
+    if (pipeline->vert_buf_bindings == NULL) {
+      err = NGF_ERROR_OUTOFMEM;
+      goto ngf_create_pipeline_cleanup;
+    }
+    pipeline->nvert_buf_bindings = input->nvert_buf_bindings;
+    memcpy(pipeline->vert_buf_bindings, input->vert_buf_bindings,
+           sizeof(ngf_vertex_buf_binding_desc) * input->nvert_buf_bindings);
+  }
+
+  err = _ngf_create_native_binding_map(info->layout,
+                                       info->image_to_combined_map,
+                                       info->sampler_to_combined_map,
+                                       &pipeline->binding_map);
+  if (err != NGF_ERROR_OK) {
+    goto ngf_create_pipeline_cleanup;
+  }
+  pipeline->dynamic_state_mask = info->dynamic_state_mask;
+  pipeline->primitive_type = info->primitive_type;
+  pipeline->push_constants_size = info->layout->push_constants_size;
+
+ngf_create_pipeline_cleanup:
+  if (err != NGF_ERROR_OK) {
+    ngf_destroy_graphics_pipeline(pipeline);
+    *result = NULL;
+  }
+  return err;
+}
+
+void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline pipeline) {
+  if (pipeline != NULL) {
+    if (pipeline->vert_buf_bindings != NULL) {
+      NGF_FREEN_AS(pipeline->vert_buf_bindings, pipeline->nvert_buf_bindings,
+                   NGF_ALLOCATION_PIPELINE);
+    }
+    if (pipeline->binding_map != NULL) {
+      _ngf_destroy_binding_map(pipeline->binding_map);
+    }
+    if (CURRENT_CONTEXT &&
+        CURRENT_CONTEXT->cached_state.bound_pipeline == pipeline) {
+      CURRENT_CONTEXT->cached_state.bound_pipeline = NULL;
+    }
+    NGF_FREE_AS(pipeline, NGF_ALLOCATION_PIPELINE);
+  }
+}
+
+ngf_error ngf_create_compute_pipeline(const ngf_compute_pipeline_info *info,
+                                      ngf_compute_pipeline *result) {
+  assert(info);
+  assert(result);
+  if (info->shader_stage->type != NGF_STAGE_COMPUTE) {
+    *result = NULL;
+    return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+  }
+  *result = NGF_ALLOC_AS(struct ngf_compute_pipeline_t,
+                         NGF_ALLOCATION_PIPELINE);
+  ngf_compute_pipeline pipeline = *result;
+  if (pipeline == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  pipeline->push_constants_size = info->layout->push_constants_size;
+  const ngf_error err = _ngf_create_native_binding_map(info->layout, NULL,
+                                                       NULL,
+                                                       &pipeline->binding_map);
+  if (err != NGF_ERROR_OK) {
+    NGF_FREE_AS(pipeline, NGF_ALLOCATION_PIPELINE);
+    *result = NULL;
+  }
+  return err;
+}
+
+void ngf_destroy_compute_pipeline(ngf_compute_pipeline pipeline) {
+  if (pipeline != NULL) {
+    _ngf_destroy_binding_map(pipeline->binding_map);
+    if (CURRENT_CONTEXT &&
+        CURRENT_CONTEXT->cached_state.bound_compute_pipeline == pipeline) {
+      CURRENT_CONTEXT->cached_state.bound_compute_pipeline = NULL;
+    }
+    NGF_FREE_AS(pipeline, NGF_ALLOCATION_PIPELINE);
+  }
+}
+
+ngf_error ngf_create_image(const ngf_image_info *info, ngf_image *result) {
+  assert(info);
+  assert(result);
+  *result = NGF_ALLOC(struct ngf_image_t);
+  if (*result == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  (*result)->info = *info;
+  _NGF_STAT_ADD(_NGF_STAT_IMAGES_CREATED, 1u);
+  return NGF_ERROR_OK;
+}
+
+void ngf_destroy_image(ngf_image image) {
+  if (image != NULL) {
+    _NGF_STAT_ADD(_NGF_STAT_IMAGES_DESTROYED, 1u);
+    NGF_FREE(image);
+  }
+}
+
+// Every image has memory of its own, so images can only be shared between
+// requests with the same configuration.
+static ngf_error _ngf_create_transient_image(
+    ngf_transient_pool              pool,
+    const ngf_transient_image_info *info,
+    ngf_image                      *result,
+    uint32_t                       *block) {
+  _NGF_FAKE_USE(pool);
+  *block = _NGF_TRANSIENT_NO_BLOCK;
+  return ngf_create_image(&info->image_info, result);
+}
+
+ngf_error ngf_create_transient_pool(ngf_transient_pool *result) {
+  return _ngf_transient_pool_create(result);
+}
+
+void ngf_destroy_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_destroy(pool, ngf_destroy_image, NULL);
+}
+
+ngf_error ngf_acquire_transient_image(ngf_transient_pool pool,
+                                      const ngf_transient_image_info *info,
+                                      ngf_image *result) {
+  return _ngf_transient_acquire(pool, info, _ngf_create_transient_image,
+                                result);
+}
+
+void ngf_reset_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_reset(pool, ngf_destroy_image, NULL);
+}
+
+void ngf_get_transient_pool_stats(ngf_transient_pool pool,
+                                  ngf_transient_pool_stats *result) {
+  _ngf_transient_pool_stats(pool, result);
+}
+
+ngf_error ngf_create_sampler(const ngf_sampler_info *info,
+                             ngf_sampler *result) {
+  assert(info);
+  assert(result);
+  *result = NGF_ALLOC(struct ngf_sampler_t);
+  if (*result == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  (*result)->info = *info;
+  return NGF_ERROR_OK;
+}
+
+void ngf_destroy_sampler(ngf_sampler sampler) {
+  if (sampler != NULL) {
+    NGF_FREE(sampler);
+  }
+}
+
+static ngf_render_target _ngf_alloc_render_target(uint32_t nattachments) {
+  ngf_render_target rt =
+      (ngf_render_target)NGF_ALLOCN(uint8_t,
+                                    offsetof(struct ngf_render_target_t,
+                                             attachment_infos) +
+                                    sizeof(ngf_attachment) * nattachments);
+  if (rt != NULL) {
+    rt->is_default = false;
+    rt->nattachments = nattachments;
+  }
+  return rt;
+}
+
+ngf_error ngf_default_render_target(ngf_attachment_load_op color_load_op,
+                                    ngf_attachment_load_op depth_load_op,
+                                    ngf_attachment_store_op color_store_op,
+                                    ngf_attachment_store_op depth_store_op,
+                                    const ngf_clear *clear_color,
+                                    const ngf_clear *clear_depth,
+                                    ngf_render_target *result) {
+  assert(result);
+  if (!CURRENT_CONTEXT->has_swapchain) {
+    return NGF_ERROR_NO_DEFAULT_RENDER_TARGET;
+  }
+  const bool has_depth =
+      CURRENT_CONTEXT->swapchain_info.dfmt != NGF_IMAGE_FORMAT_UNDEFINED;
+  ngf_render_target rt = _ngf_alloc_render_target(has_depth ? 2u : 1u);
+  if (rt == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  rt->is_default = true;
+  ngf_attachment *color = &rt->attachment_infos[0];
+  memset(color, 0, sizeof(*color));
+  color->type = NGF_ATTACHMENT_COLOR;
+  color->load_op = color_load_op;
+  color->store_op = color_store_op;
+  if (color_load_op == NGF_LOAD_OP_CLEAR) {
+    assert(clear_color);
+    color->clear = *clear_color;
+  }
+  if (has_depth) {
+    ngf_attachment *depth = &rt->attachment_infos[1];
+    memset(depth, 0, sizeof(*depth));
+    depth->type = NGF_ATTACHMENT_DEPTH;
+    depth->load_op = depth_load_op;
+    depth->store_op = depth_store_op;
+    if (depth_load_op == NGF_LOAD_OP_CLEAR) {
+      assert(clear_depth);
+      depth->clear = *clear_depth;
+    }
+  }
+  *result = rt;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_create_render_target(const ngf_render_target_info *info,
+                                   ngf_render_target *result) {
+  assert(info);
+  assert(result);
+  ngf_render_target rt = _ngf_alloc_render_target(info->nattachments);
+  *result = rt;
+  if (rt == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  for (uint32_t a = 0u; a < info->nattachments; ++a) {
+    if (info->attachments[a].image_ref.image == NULL) {
+      ngf_destroy_render_target(rt);
+      *result = NULL;
+      return NGF_ERROR_INCOMPLETE_RENDER_TARGET;
+    }
+    rt->attachment_infos[a] = info->attachments[a];
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_resolve_render_target(const ngf_render_target src,
+                                    ngf_render_target dst,
+                                    const ngf_irect2d *src_rect) {
+  _NGF_FAKE_USE(src, dst, src_rect);
+  return NGF_ERROR_OK;
+}
+
+void ngf_destroy_render_target(ngf_render_target target) {
+  if (target != NULL) {
+    NGF_FREEN((uint8_t*)target,
+              offsetof(struct ngf_render_target_t, attachment_infos) +
+              sizeof(ngf_attachment) * target->nattachments);
+  }
+}
+
+#pragma endregion
+
+#pragma region ngf_impl_buffers
+
+static ngf_error _ngf_create_buffer(size_t size, _ngf_null_buffer *buf) {
+  buf->size = size;
+  buf->mapped = false;
+  buf->data = size > 0u ? NGF_ALLOCN(uint8_t, size) : NULL;
+  if (size > 0u && buf->data == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  _NGF_STAT_ADD(_NGF_STAT_BUFFERS_CREATED, 1u);
+  return NGF_ERROR_OK;
+}
+
+static void _ngf_destroy_buffer(_ngf_null_buffer *buf) {
+  if (buf->data != NULL) {
+    NGF_FREEN(buf->data, buf->size);
+  }
+  _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
+}
+
+static void* _ngf_buffer_map_range(_ngf_null_buffer *buf,
+                                   size_t offset,
+                                   size_t size,
+                                   uint32_t flags) {
+  _NGF_FAKE_USE(flags);
+  assert(!buf->mapped);
+  if (offset + size > buf->size) {
+    return NULL;
+  }
+  buf->mapped = true;
+  _NGF_STAT_ADD(_NGF_STAT_BYTES_MAPPED, size);
+  return buf->data + offset;
+}
+
+static void _ngf_buffer_flush_range(_ngf_null_buffer *buf,
+                                    size_t offset,
+                                    size_t size) {
+  _NGF_FAKE_USE(offset, size);
+  assert(buf->mapped);
+}
+
+static void _ngf_buffer_unmap(_ngf_null_buffer *buf) {
+  assert(buf->mapped);
+  buf->mapped = false;
+}
+
+// Defines the create/destroy/map entry points of a buffer type.
+#define _NGF_NULL_BUFFER_FUNCS(type, info_type) \
+ngf_error ngf_create_##type(const info_type *info, ngf_##type *result) { \
+  assert(info); \
+  assert(result); \
+  *result = NGF_ALLOC(struct ngf_##type##_t); \
+  if (*result == NULL) { \
+    return NGF_ERROR_OUTOFMEM; \
+  } \
+  const ngf_error err = _ngf_create_buffer(info->size, &(*result)->data); \
+  if (err != NGF_ERROR_OK) { \
+    NGF_FREE(*result); \
+    *result = NULL; \
+  } \
+  return err; \
+} \
+void ngf_destroy_##type(ngf_##type buf) { \
+  if (buf != NULL) { \
+    _ngf_destroy_buffer(&buf->data); \
+    NGF_FREE(buf); \
+  } \
+} \
+void* ngf_##type##_map_range(ngf_##type buf, size_t offset, size_t size, \
+                             uint32_t flags) { \
+  return _ngf_buffer_map_range(&buf->data, offset, size, flags); \
+} \
+void ngf_##type##_flush_range(ngf_##type buf, size_t offset, size_t size) { \
+  _ngf_buffer_flush_range(&buf->data, offset, size); \
+} \
+void ngf_##type##_unmap(ngf_##type buf) { \
+  _ngf_buffer_unmap(&buf->data); \
+}
+
+_NGF_NULL_BUFFER_FUNCS(attrib_buffer, ngf_attrib_buffer_info)
+_NGF_NULL_BUFFER_FUNCS(index_buffer, ngf_index_buffer_info)
+_NGF_NULL_BUFFER_FUNCS(uniform_buffer, ngf_uniform_buffer_info)
+_NGF_NULL_BUFFER_FUNCS(pixel_buffer, ngf_pixel_buffer_info)
+
+#pragma endregion
+
+#pragma region ngf_impl_cmd_buffers
+
+ngf_error ngf_create_cmd_buffer(const ngf_cmd_buffer_info *info,
+                                ngf_cmd_buffer *result) {
+  _NGF_FAKE_USE(info);
+  assert(result);
+  if (COMMAND_POOL == NULL) {
+    COMMAND_POOL = _ngf_blkalloc_create(sizeof(_ngf_cmd_block), 100);
+  }
+  *result = NGF_ALLOC(struct ngf_cmd_buffer_t);
+  ngf_cmd_buffer buf = *result;
+  if (buf == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  buf->first_cmd_block = buf->last_cmd_block = NULL;
+  buf->bound_pipeline = NULL;
+  buf->bound_compute_pipeline = NULL;
+  buf->state = _NGF_CMD_BUFFER_READY;
+  buf->renderpass_active = false;
+  _NGF_DARRAY_RESET(buf->dynamic_ubos, 4u);
+  return NGF_ERROR_OK;
+}
+
+static void _ngf_cmd_buffer_free_cmds(ngf_cmd_buffer buf) {
+  if (buf->first_cmd_block != NULL && COMMAND_POOL != NULL) {
+    _ngf_cmd_block *c = buf->first_cmd_block;
+    while (c != NULL) {
+      _ngf_cmd_block *next = c->next;
+      _ngf_blkalloc_free(COMMAND_POOL, c);
+      c = next;
+    }
+  }
+  buf->first_cmd_block = buf->last_cmd_block = NULL;
+}
+
+void ngf_destroy_cmd_buffer(ngf_cmd_buffer buf) {
+  if (buf != NULL) {
+    _ngf_cmd_buffer_free_cmds(buf);
+    _NGF_DARRAY_DESTROY(buf->dynamic_ubos);
+    NGF_FREE(buf);
+  }
+}
+
+ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer buf) {
+  assert(buf);
+  if (buf->state != _NGF_CMD_BUFFER_READY) {
+    return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
+  }
+  _ngf_cmd_buffer_free_cmds(buf);
+  buf->first_cmd_block = _ngf_blkalloc_alloc(COMMAND_POOL);
+  if (buf->first_cmd_block == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  _NGF_STAT_ADD(_NGF_STAT_CMD_BLOCKS_ALLOCATED, 1u);
+  buf->first_cmd_block->next_cmd_idx = 0u;
+  buf->first_cmd_block->next = NULL;
+  buf->last_cmd_block = buf->first_cmd_block;
+  buf->bound_pipeline = NULL;
+  buf->bound_compute_pipeline = NULL;
+  buf->renderpass_active = false;
+  _NGF_DARRAY_CLEAR(buf->dynamic_ubos);
+  return NGF_ERROR_OK;
+}
+
+static _ngf_null_cmd* _ngf_new_cmd(uintptr_t handle, _ngf_null_cmd_type type) {
+  ngf_cmd_buffer buf = (ngf_cmd_buffer)(void*)handle;
+  if (buf->last_cmd_block->next_cmd_idx == _NGF_CMDS_PER_CMD_BLOCK) {
+    _ngf_cmd_block *block = _ngf_blkalloc_alloc(COMMAND_POOL);
+    _NGF_STAT_ADD(_NGF_STAT_CMD_BLOCKS_ALLOCATED, 1u);
+    block->next = NULL;
+    block->next_cmd_idx = 0u;
+    buf->last_cmd_block->next = block;
+    buf->last_cmd_block = block;
+  }
+  _ngf_cmd_block *block = buf->last_cmd_block;
+  _ngf_null_cmd *cmd = &block->cmds[block->next_cmd_idx++];
+  cmd->type = type;
+  return cmd;
+}
+
+static ngf_error _ngf_start_encoder(ngf_cmd_buffer buf, uintptr_t *handle,
+                                    const char *name) {
+  if (buf->state != _NGF_CMD_BUFFER_READY) {
+    *handle = 0u;
+    return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
+  }
+  *handle = (uintptr_t)buf;
+  _ngf_new_cmd(*handle, _NGF_CMD_BEGIN_SCOPE)->scope_name = name;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_cmd_buffer_start_render(ngf_cmd_buffer buf,
+                                      ngf_render_encoder *enc) {
+  return _ngf_start_encoder(buf, &enc->__handle, "render encoder");
+}
+
+ngf_error ngf_cmd_buffer_start_xfer(ngf_cmd_buffer buf,
+                                    ngf_xfer_encoder *enc) {
+  return _ngf_start_encoder(buf, &enc->__handle, "xfer encoder");
+}
+
+ngf_error ngf_cmd_buffer_start_compute(ngf_cmd_buffer buf,
+                                       ngf_compute_encoder *enc) {
+  return _ngf_start_encoder(buf, &enc->__handle, "compute encoder");
+}
+
+static ngf_error _ngf_end_encoder(uintptr_t handle) {
+  ngf_cmd_buffer buf = (ngf_cmd_buffer)(void*)handle;
+  if (buf->renderpass_active) {
+    return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
+  }
+  _ngf_new_cmd(handle, _NGF_CMD_END_SCOPE)->scope_name = NULL;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_render_encoder_end(ngf_render_encoder enc) {
+  return _ngf_end_encoder(enc.__handle);
+}
+
+ngf_error ngf_xfer_encoder_end(ngf_xfer_encoder enc) {
+  return _ngf_end_encoder(enc.__handle);
+}
+
+ngf_error ngf_compute_encoder_end(ngf_compute_encoder enc) {
+  return _ngf_end_encoder(enc.__handle);
+}
+
+void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc,
+                               const ngf_graphics_pipeline pipeline) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_BIND_PIPELINE)->pipeline = pipeline;
+  ((ngf_cmd_buffer)enc.__handle)->bound_pipeline = pipeline;
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
+}
+
+void ngf_cmd_viewport(ngf_render_encoder enc, const ngf_irect2d *r) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_VIEWPORT)->rect = *r;
+}
+
+void ngf_cmd_scissor(ngf_render_encoder enc, const ngf_irect2d *r) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_SCISSOR)->rect = *r;
+}
+
+static void _ngf_cmd_stencil(ngf_render_encoder enc, _ngf_null_cmd_type type,
+                             uint32_t front, uint32_t back) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, type);
+  cmd->stencil.front = front;
+  cmd->stencil.back = back;
+}
+
+void ngf_cmd_stencil_reference(ngf_render_encoder enc, uint32_t front,
+                               uint32_t back) {
+  _ngf_cmd_stencil(enc, _NGF_CMD_STENCIL_REFERENCE, front, back);
+}
+
+void ngf_cmd_stencil_compare_mask(ngf_render_encoder enc, uint32_t front,
+                                  uint32_t back) {
+  _ngf_cmd_stencil(enc, _NGF_CMD_STENCIL_COMPARE_MASK, front, back);
+}
+
+void ngf_cmd_stencil_write_mask(ngf_render_encoder enc, uint32_t front,
+                                uint32_t back) {
+  _ngf_cmd_stencil(enc, _NGF_CMD_STENCIL_WRITE_MASK, front, back);
+}
+
+void ngf_cmd_line_width(ngf_render_encoder enc, float line_width) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_LINE_WIDTH)->line_width = line_width;
+}
+
+void ngf_cmd_blend_factors(ngf_render_encoder enc,
+                           ngf_blend_factor sfactor,
+                           ngf_blend_factor dfactor) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_BLEND_FACTORS);
+  cmd->blend_factors.sfactor = sfactor;
+  cmd->blend_factors.dfactor = dfactor;
+}
+
+static void _ngf_record_bind(uintptr_t handle, const void *resource,
+                             uint32_t native_binding, size_t offset,
+                             size_t range) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(handle, _NGF_CMD_BIND_RESOURCE);
+  cmd->bind_resource.resource = resource;
+  cmd->bind_resource.native_binding = native_binding;
+  cmd->bind_resource.offset = offset;
+  cmd->bind_resource.range = range;
+}
+
+// Adds or replaces an entry in the command buffer's table of bound dynamic
+// uniform buffers, keeping it sorted.
+static void _ngf_record_dynamic_ubo(ngf_cmd_buffer buf,
+                                    const _ngf_dynamic_ubo_binding *binding) {
+  const uint32_t nentries = (uint32_t)_NGF_DARRAY_SIZE(buf->dynamic_ubos);
+  for (uint32_t e = 0u; e < nentries; ++e) {
+    _ngf_dynamic_ubo_binding *entry = &_NGF_DARRAY_AT(buf->dynamic_ubos, e);
+    if (entry->set == binding->set && entry->binding == binding->binding) {
+      *entry = *binding;
+      return;
+    }
+  }
+  _NGF_DARRAY_APPEND(buf->dynamic_ubos, *binding);
+  for (uint32_t e = nentries; e > 0u; --e) {
+    _ngf_dynamic_ubo_binding *prev = &_NGF_DARRAY_AT(buf->dynamic_ubos, e - 1u);
+    _ngf_dynamic_ubo_binding *curr = &_NGF_DARRAY_AT(buf->dynamic_ubos, e);
+    if (prev->set < curr->set ||
+        (prev->set == curr->set && prev->binding < curr->binding)) {
+      break;
+    }
+    const _ngf_dynamic_ubo_binding tmp = *prev;
+    *prev = *curr;
+    *curr = tmp;
+  }
+}
+
+static void _ngf_cmd_bind_resources(uintptr_t handle,
+                                    const _ngf_native_binding_map binding_map,
+                                    const ngf_resource_bind_op *bind_ops,
+                                    uint32_t nbind_ops) {
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, nbind_ops);
+  for (uint32_t o = 0u; o < nbind_ops; ++o) {
+    const ngf_resource_bind_op *bind_op = &bind_ops[o];
+    const _ngf_native_binding *native_binding =
+        _ngf_binding_map_lookup(binding_map,
+                                bind_op->target_set,
+                                bind_op->target_binding);
+    if (native_binding == NULL) {
+      _ngf_null_report("invalid binding id");
+      continue;
+    }
+    const uint32_t native_id = native_binding->native_binding_id;
+    switch (bind_op->type) {
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC: {
+      const _ngf_dynamic_ubo_binding dynamic_ubo = {
+        .set = bind_op->target_set,
+        .binding = bind_op->target_binding,
+        .native_binding = native_id,
+        .buffer = &bind_op->info.uniform_buffer.buffer->data,
+        .base_offset = bind_op->info.uniform_buffer.offset,
+        .range = bind_op->info.uniform_buffer.range
+      };
+      _ngf_record_dynamic_ubo((ngf_cmd_buffer)handle, &dynamic_ubo);
+    }
+    // Fall through.
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER:
+      _ngf_record_bind(handle, &bind_op->info.uniform_buffer.buffer->data,
+                       native_id, bind_op->info.uniform_buffer.offset,
+                       bind_op->info.uniform_buffer.range);
+      break;
+    case NGF_DESCRIPTOR_TEXTURE:
+    case NGF_DESCRIPTOR_SAMPLER: {
+      const void *resource =
+          bind_op->type == NGF_DESCRIPTOR_TEXTURE
+              ? (const void*)bind_op->info.image_sampler.image_subresource.image
+              : (const void*)bind_op->info.image_sampler.sampler;
+      for (uint32_t c = 0u; c < native_binding->ncis_bindings; ++c) {
+        _ngf_record_bind(handle, resource, native_binding->cis_bindings[c],
+                         0u, 0u);
+      }
+      break;
+    }
+    case NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER:
+      _ngf_record_bind(handle,
+                       bind_op->info.image_sampler.image_subresource.image,
+                       native_id, 0u, 0u);
+      break;
+    case NGF_DESCRIPTOR_STORAGE_BUFFER:
+      _ngf_record_bind(handle, &bind_op->info.storage_buffer.buffer->data,
+                       native_id, bind_op->info.storage_buffer.offset,
+                       bind_op->info.storage_buffer.range);
+      break;
+    case NGF_DESCRIPTOR_STORAGE_IMAGE:
+      _ngf_record_bind(handle, bind_op->info.storage_image.image, native_id,
+                       0u, 0u);
+      break;
+    default:
+      break;
+    }
+  }
+}
+
+void ngf_cmd_bind_gfx_resources(ngf_render_encoder enc,
+                                const ngf_resource_bind_op *bind_ops,
+                                uint32_t nbind_ops) {
+  ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  assert(buf->bound_pipeline);
+  _ngf_cmd_bind_resources(enc.__handle, buf->bound_pipeline->binding_map,
+                          bind_ops, nbind_ops);
+}
+
+void ngf_cmd_set_dynamic_offsets(ngf_render_encoder enc, uint32_t set,
+                                 const uint32_t *offsets, uint32_t noffsets) {
+  const ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  const uint32_t nentries = (uint32_t)_NGF_DARRAY_SIZE(buf->dynamic_ubos);
+  uint32_t o = 0u;
+  for (uint32_t e = 0u; e < nentries && o < noffsets; ++e) {
+    const _ngf_dynamic_ubo_binding *entry =
+        &_NGF_DARRAY_AT(buf->dynamic_ubos, e);
+    if (entry->set != set) continue;
+    _ngf_record_bind(enc.__handle, entry->buffer, entry->native_binding,
+                     entry->base_offset + offsets[o++], entry->range);
+  }
+  assert(o == noffsets);
+}
+
+void ngf_cmd_bind_attrib_buffer(ngf_render_encoder enc,
+                                const ngf_attrib_buffer vbuf,
+                                uint32_t binding, uint32_t offset) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_BIND_ATTRIB_BUFFER);
+  cmd->attrib_buffer_bind.buf = &vbuf->data;
+  cmd->attrib_buffer_bind.binding = binding;
+  cmd->attrib_buffer_bind.offset = offset;
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, 1u);
+}
+
+void ngf_cmd_bind_index_buffer(ngf_render_encoder enc,
+                               const ngf_index_buffer idxbuf,
+                               ngf_type index_type) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_BIND_INDEX_BUFFER);
+  cmd->index_buffer_bind.buf = &idxbuf->data;
+  cmd->index_buffer_bind.type = index_type;
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, 1u);
+}
+
+void ngf_cmd_begin_pass(ngf_render_encoder enc, const ngf_render_target target) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_BEGIN_SCOPE)->scope_name = "pass";
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_BEGIN_PASS)->target = target;
+  ((ngf_cmd_buffer)enc.__handle)->renderpass_active = true;
+}
+
+void ngf_cmd_end_pass(ngf_render_encoder enc) {
+  ((ngf_cmd_buffer)enc.__handle)->renderpass_active = false;
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_END_PASS);
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_END_SCOPE)->scope_name = NULL;
+}
+
+void ngf_cmd_draw(ngf_render_encoder enc, bool indexed,
+                  uint32_t first_element, uint32_t nelements,
+                  uint32_t ninstances) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_DRAW);
+  cmd->draw.first_element = first_element;
+  cmd->draw.nelements = nelements;
+  cmd->draw.ninstances = ninstances;
+  cmd->draw.indexed = indexed;
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, 1u);
+  _NGF_STAT_ADD(_NGF_STAT_INSTANCES, ninstances);
+}
+
+void ngf_cmd_draw_indirect(ngf_render_encoder enc, bool indexed,
+                           const ngf_attrib_buffer args, size_t offset,
+                           uint32_t ndraws, uint32_t stride) {
+  assert(offset % 4u == 0u);
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_DRAW_INDIRECT);
+  cmd->draw_indirect.args = &args->data;
+  cmd->draw_indirect.offset = offset;
+  cmd->draw_indirect.ndraws = ndraws;
+  cmd->draw_indirect.stride =
+      stride != 0u ? stride
+                   : (uint32_t)(indexed ? sizeof(ngf_draw_indexed_indirect_args)
+                                        : sizeof(ngf_draw_indirect_args));
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, ndraws);
+}
+
+static void _ngf_cmd_push_constants(uintptr_t handle, uint32_t block_size,
+                                    const void *data, uint32_t offset,
+                                    uint32_t size) {
+  assert(offset % 4u == 0u && size % 4u == 0u);
+  assert(offset + size <= block_size);
+  _NGF_FAKE_USE(block_size);
+  const uint8_t *src = (const uint8_t*)data;
+  while (size > 0u) {
+    const uint32_t chunk_size = NGF_MIN(size, _NGF_PUSH_CONSTANTS_CHUNK_SIZE);
+    _ngf_null_cmd *cmd = _ngf_new_cmd(handle, _NGF_CMD_PUSH_CONSTANTS);
+    memcpy(cmd->push_constants.data, src, chunk_size);
+    cmd->push_constants.offset = (uint16_t)offset;
+    cmd->push_constants.size = (uint16_t)chunk_size;
+    src += chunk_size;
+    offset += chunk_size;
+    size -= chunk_size;
+  }
+}
+
+void ngf_cmd_push_constants(ngf_render_encoder enc, const void *data,
+                            uint32_t offset, uint32_t size) {
+  const ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  assert(buf->bound_pipeline);
+  _ngf_cmd_push_constants(enc.__handle,
+                          buf->bound_pipeline->push_constants_size, data,
+                          offset, size);
+}
+
+void ngf_cmd_bind_compute_pipeline(ngf_compute_encoder enc,
+                                   const ngf_compute_pipeline pipeline) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_BIND_COMPUTE_PIPELINE)
+      ->compute_pipeline = pipeline;
+  ((ngf_cmd_buffer)enc.__handle)->bound_compute_pipeline = pipeline;
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
+}
+
+void ngf_cmd_bind_compute_resources(ngf_compute_encoder enc,
+                                    const ngf_resource_bind_op *bind_ops,
+                                    uint32_t nbind_ops) {
+  ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  assert(buf->bound_compute_pipeline);
+  _ngf_cmd_bind_resources(enc.__handle,
+                          buf->bound_compute_pipeline->binding_map,
+                          bind_ops, nbind_ops);
+}
+
+void ngf_cmd_dispatch(ngf_compute_encoder enc, uint32_t ngroups_x,
+                      uint32_t ngroups_y, uint32_t ngroups_z) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_DISPATCH);
+  cmd->dispatch.ngroups_x = ngroups_x;
+  cmd->dispatch.ngroups_y = ngroups_y;
+  cmd->dispatch.ngroups_z = ngroups_z;
+}
+
+void ngf_cmd_push_compute_constants(ngf_compute_encoder enc, const void *data,
+                                    uint32_t offset, uint32_t size) {
+  const ngf_cmd_buffer buf = (ngf_cmd_buffer)enc.__handle;
+  assert(buf->bound_compute_pipeline);
+  _ngf_cmd_push_constants(enc.__handle,
+                          buf->bound_compute_pipeline->push_constants_size,
+                          data, offset, size);
+}
+
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc,
+                               const ngf_attrib_buffer args, size_t offset) {
+  assert(offset % 4u == 0u);
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_DISPATCH_INDIRECT);
+  cmd->dispatch_indirect.args = &args->data;
+  cmd->dispatch_indirect.offset = offset;
+}
+
+static void _ngf_cmd_copy_buffer(uintptr_t handle,
+                                 const _ngf_null_buffer *src,
+                                 _ngf_null_buffer *dst,
+                                 size_t size,
+                                 size_t src_offset,
+                                 size_t dst_offset) {
+  _ngf_null_cmd *cmd = _ngf_new_cmd(handle, _NGF_CMD_COPY);
+  cmd->copy.src = src;
+  cmd->copy.dst = dst;
+  cmd->copy.size = size;
+  cmd->copy.src_offset = src_offset;
+  cmd->copy.dst_offset = dst_offset;
+  _NGF_STAT_ADD(_NGF_STAT_BYTES_UPLOADED, size);
+}
+
+void ngf_cmd_copy_attrib_buffer(ngf_xfer_encoder enc,
+                                const ngf_attrib_buffer src,
+                                ngf_attrib_buffer dst,
+                                size_t size,
+                                size_t src_offset,
+                                size_t dst_offset) {
+  _ngf_cmd_copy_buffer(enc.__handle, &src->data, &dst->data, size, src_offset,
+                       dst_offset);
+}
+
+void ngf_cmd_copy_index_buffer(ngf_xfer_encoder enc,
+                               const ngf_index_buffer src,
+                               ngf_index_buffer dst,
+                               size_t size,
+                               size_t src_offset,
+                               size_t dst_offset) {
+  _ngf_cmd_copy_buffer(enc.__handle, &src->data, &dst->data, size, src_offset,
+                       dst_offset);
+}
+
+void ngf_cmd_copy_uniform_buffer(ngf_xfer_encoder enc,
+                                 const ngf_uniform_buffer src,
+                                 ngf_uniform_buffer dst,
+                                 size_t size,
+                                 size_t src_offset,
+                                 size_t dst_offset) {
+  _ngf_cmd_copy_buffer(enc.__handle, &src->data, &dst->data, size, src_offset,
+                       dst_offset);
+}
+
+void ngf_cmd_write_image(ngf_xfer_encoder enc,
+                         const ngf_pixel_buffer src,
+                         size_t src_offset,
+                         ngf_image_ref dst,
+                         const ngf_offset3d *offset,
+                         const ngf_extent3d *extent) {
+  _NGF_FAKE_USE(offset);
+  _ngf_null_cmd *cmd = _ngf_new_cmd(enc.__handle, _NGF_CMD_WRITE_IMAGE);
+  cmd->write_image.src = &src->data;
+  cmd->write_image.src_offset = src_offset;
+  cmd->write_image.dst = dst;
+  cmd->write_image.extent = *extent;
+}
+
+void ngf_cmd_begin_debug_group(ngf_render_encoder enc, const char *name) {
+  assert(name);
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_BEGIN_SCOPE)->scope_name = name;
+}
+
+void ngf_cmd_end_debug_group(ngf_render_encoder enc) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_END_SCOPE)->scope_name = NULL;
+}
+
+void ngf_cmd_begin_compute_debug_group(ngf_compute_encoder enc,
+                                       const char *name) {
+  assert(name);
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_BEGIN_SCOPE)->scope_name = name;
+}
+
+void ngf_cmd_end_compute_debug_group(ngf_compute_encoder enc) {
+  _ngf_new_cmd(enc.__handle, _NGF_CMD_END_SCOPE)->scope_name = NULL;
+}
+
+#pragma endregion
+
+#pragma region ngf_impl_submit
+
+// Replays a single command against the context's tracked state, reporting
+// the kind of misuse that a driver would reject or silently misrender.
+static void _ngf_execute_cmd(ngf_context ctx, const _ngf_null_cmd *cmd) {
+  switch (cmd->type) {
+  case _NGF_CMD_BIND_PIPELINE:
+    ctx->cached_state.bound_pipeline = cmd->pipeline;
+    break;
+  case _NGF_CMD_BIND_COMPUTE_PIPELINE:
+    ctx->cached_state.bound_compute_pipeline = cmd->compute_pipeline;
+    break;
+  case _NGF_CMD_BEGIN_PASS:
+    if (ctx->cached_state.active_rt != NULL) {
+      _ngf_null_report("render pass started within another render pass");
+    }
+    ctx->cached_state.active_rt = cmd->target;
+    break;
+  case _NGF_CMD_END_PASS:
+    ctx->cached_state.active_rt = NULL;
+    break;
+  case _NGF_CMD_VIEWPORT:
+    ctx->cached_state.viewport = cmd->rect;
+    break;
+  case _NGF_CMD_SCISSOR:
+    ctx->cached_state.scissor = cmd->rect;
+    break;
+  case _NGF_CMD_STENCIL_REFERENCE:
+  case _NGF_CMD_STENCIL_COMPARE_MASK:
+  case _NGF_CMD_STENCIL_WRITE_MASK:
+  case _NGF_CMD_LINE_WIDTH:
+  case _NGF_CMD_BLEND_FACTORS:
+    break;
+  case _NGF_CMD_BIND_RESOURCE:
+    if (cmd->bind_resource.native_binding < _NGF_NULL_MAX_TRACKED_BINDINGS) {
+      ctx->cached_state.bound_resources[cmd->bind_resource.native_binding] =
+          cmd->bind_resource.resource;
+    }
+    break;
+  case _NGF_CMD_BIND_ATTRIB_BUFFER:
+    break;
+  case _NGF_CMD_BIND_INDEX_BUFFER:
+    ctx->cached_state.bound_index_buffer = cmd->index_buffer_bind.buf;
+    ctx->cached_state.bound_index_type = cmd->index_buffer_bind.type;
+    break;
+  case _NGF_CMD_DRAW:
+  case _NGF_CMD_DRAW_INDIRECT:
+    if (ctx->cached_state.bound_pipeline == NULL) {
+      _ngf_null_report("draw without a bound pipeline");
+    } else if (ctx->cached_state.active_rt == NULL) {
+      _ngf_null_report("draw outside of a render pass");
+    } else if (cmd->type == _NGF_CMD_DRAW && cmd->draw.indexed &&
+               ctx->cached_state.bound_index_buffer == NULL) {
+      _ngf_null_report("indexed draw without a bound index buffer");
+    } else if (cmd->type == _NGF_CMD_DRAW_INDIRECT &&
+               cmd->draw_indirect.offset +
+               (size_t)cmd->draw_indirect.stride *
+                   cmd->draw_indirect.ndraws > cmd->draw_indirect.args->size) {
+      _ngf_null_report("indirect draw arguments out of bounds");
+    }
+    break;
+  case _NGF_CMD_DISPATCH:
+  case _NGF_CMD_DISPATCH_INDIRECT:
+    if (ctx->cached_state.bound_compute_pipeline == NULL) {
+      _ngf_null_report("dispatch without a bound pipeline");
+    }
+    break;
+  case _NGF_CMD_PUSH_CONSTANTS:
+    memcpy(&ctx->cached_state.push_constants[cmd->push_constants.offset],
+           cmd->push_constants.data, cmd->push_constants.size);
+    break;
+  case _NGF_CMD_COPY:
+    if (cmd->copy.src_offset + cmd->copy.size > cmd->copy.src->size ||
+        cmd->copy.dst_offset + cmd->copy.size > cmd->copy.dst->size) {
+      _ngf_null_report("buffer copy out of bounds");
+    } else if (cmd->copy.size > 0u) {
+      memcpy(cmd->copy.dst->data + cmd->copy.dst_offset,
+             cmd->copy.src->data + cmd->copy.src_offset, cmd->copy.size);
+    }
+    break;
+  case _NGF_CMD_WRITE_IMAGE:
+    if (cmd->write_image.dst.image == NULL) {
+      _ngf_null_report("image write into a null image");
+    }
+    break;
+  case _NGF_CMD_BEGIN_SCOPE:
+    ++ctx->cached_state.scope_depth;
+    break;
+  case _NGF_CMD_END_SCOPE:
+    if (ctx->cached_state.scope_depth == 0u) {
+      _ngf_null_report("unbalanced debug group");
+    } else {
+      --ctx->cached_state.scope_depth;
+    }
+    break;
+  default:
+    assert(false);
+  }
+}
+
+size_t _ngf_null_describe_cmds(ngf_cmd_buffer buf, char *dst, size_t dst_size) {
+  assert(buf);
+  static const char *CMD_NAMES[] = {
+    "pipeline",      "compute_pipeline",   "begin_pass",  "end_pass",
+    "viewport",      "scissor",            "stencil_ref", "stencil_compare",
+    "stencil_write", "line_width",         "blend",       "resource",
+    "attrib",        "index",              "draw",        "draw_indirect",
+    "dispatch",      "dispatch_indirect",  "push",        "copy",
+    "write_image",   "begin_scope",        "end_scope"
+  };
+  size_t len = 0u;
+  if (dst_size > 0u) dst[0] = '\0';
+  for (const _ngf_cmd_block *block = buf->first_cmd_block; block != NULL;
+       block = block->next) {
+    for (uint32_t c = 0u; c < block->next_cmd_idx; ++c) {
+      const _ngf_null_cmd *cmd = &block->cmds[c];
+      const char *separator = len > 0u ? " " : "";
+      char *out = len < dst_size ? dst + len : NULL;
+      const size_t room = len < dst_size ? dst_size - len : 0u;
+      int n = 0;
+      switch (cmd->type) {
+      case _NGF_CMD_BIND_RESOURCE:
+        n = snprintf(out, room, "%s%s:%u", separator, CMD_NAMES[cmd->type],
+                     cmd->bind_resource.native_binding);
+        break;
+      case _NGF_CMD_BIND_ATTRIB_BUFFER:
+        n = snprintf(out, room, "%s%s:%u", separator, CMD_NAMES[cmd->type],
+                     cmd->attrib_buffer_bind.binding);
+        break;
+      case _NGF_CMD_DRAW:
+        n = snprintf(out, room, "%s%s:%u", separator, CMD_NAMES[cmd->type],
+                     cmd->draw.first_element);
+        break;
+      default:
+        n = snprintf(out, room, "%s%s", separator, CMD_NAMES[cmd->type]);
+      }
+      len += (size_t)n;
+    }
+  }
+  return len;
+}
+
+ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
+  assert(bufs);
+  const uint64_t start_ns = _ngf_stats_now_ns();
+  ngf_context ctx = CURRENT_CONTEXT;
+  for (uint32_t b = 0u; b < nbuffers; ++b) {
+    const ngf_cmd_buffer buf = bufs[b];
+    for (const _ngf_cmd_block *block = buf->first_cmd_block; block != NULL;
+         block = block->next) {
+      for (uint32_t c = 0u; c < block->next_cmd_idx; ++c) {
+        _ngf_execute_cmd(ctx, &block->cmds[c]);
+      }
+    }
+    _ngf_cmd_buffer_free_cmds(buf);
+  }
+  _NGF_STAT_ADD(_NGF_STAT_SUBMIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("ngf_submit_cmd_buffers", start_ns);
+  return NGF_ERROR_OK;
+}
+
+void ngf_finish() {
+}
+
+ngf_error ngf_begin_frame() {
+  return CURRENT_CONTEXT != NULL ? NGF_ERROR_OK : NGF_ERROR_INVALID_CONTEXT;
+}
+
+ngf_error ngf_end_frame() {
+  const uint64_t start_ns = _ngf_stats_now_ns();
+  const uint64_t frame = CURRENT_CONTEXT->frame++;
+  _NGF_STAT_ADD(_NGF_STAT_END_FRAME_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_stats_end_frame(frame);
+  return NGF_ERROR_OK;
+}
+
+// There is no GPU to wait for, so frames never queue up.
+ngf_error ngf_set_frame_pacing(const ngf_frame_pacing_info *info) {
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  return _ngf_validate_frame_pacing(info);
+}
+
+ngf_error ngf_enable_gpu_timing(bool enable) {
+  _NGF_FAKE_USE(enable);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_get_gpu_frame_timings(ngf_gpu_frame_timings *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  return NGF_ERROR_NO_FRAME;
+}
+
+#pragma endregion
@@ -21,6 +21,9 @@
  */
 
 #define _CRT_SECURE_NO_WARNINGS
+#if defined(NGF_CAPTURE_BACKEND)
+#include "nicegraf_capture_names.h"
+#endif
 #include "nicegraf.h"
 
 #include "dynamic_array.h"
@@ -74,6 +77,7 @@ struct {
   uint32_t         present_family_idx;
   uint32_t         xfer_family_idx;
   ATOMIC_INT       frame_id;
+  VkPhysicalDeviceFeatures enabled_features;
 } _vk;
 
 // Swapchain state.
@@ -138,8 +142,15 @@ struct _ngf_desc_superpool_t {
   _ngf_desc_pool *active_pool;
   _ngf_desc_pool *list;
 };
+#define _NGF_MAX_BOUND_DESC_SETS 8u
+// Bound descriptor sets are tracked separately for the graphics and compute
+// bind points, which are indexed by their VkPipelineBindPoint values (0 and 1).
+#define _NGF_NUM_BIND_POINTS 2u
+
 typedef struct ngf_cmd_buffer_t {
   ngf_graphics_pipeline           active_pipe;    // < The bound pipeline.
+  ngf_compute_pipeline            active_compute_pipe; // < The bound compute
+                                                       // pipeline.
  _NGF_DARRAY_OF(_ngf_cmd_bundle)  bundles;        // < List of bundles that have
                                                   // finished recording.
  _ngf_cmd_bundle                  active_bundle;  // < The current bundle.
@@ -149,6 +160,23 @@ typedef struct ngf_cmd_buffer_t {
                                                   // the desc pools for this cmd
                                                   // buffer are allocated.
   ngf_render_target               active_rt;      // < Active render target.
+  VkDescriptorSet                 bound_desc_sets[_NGF_NUM_BIND_POINTS]
+                                                 [_NGF_MAX_BOUND_DESC_SETS];
+                                                  // < Last descriptor set
+                                                  // bound at each index of
+                                                  // each bind point, for
+                                                  // updating dynamic offsets.
+  _ngf_gpu_timing_frame          *timing_scopes;  // < Timing scopes recorded
+                                                  // into this cmd buffer, NULL
+                                                  // until GPU timing is first
+                                                  // used with it.
+  uint32_t                        nfixed_scopes;  // < Open timing scopes that
+                                                  // belong to the active
+                                                  // encoder and pass, which
+                                                  // debug groups can't close.
+  uint32_t                        pass_scope_depth; // < Timing scopes that
+                                                    // were open when the
+                                                    // active pass began.
  _ngf_cmd_buffer_state            state;
 } ngf_cmd_buffer_t;
 
@@ -207,6 +235,24 @@ typedef struct _ngf_frame_resources {
   bool                                 active;
 } _ngf_frame_resources;
 
+// GPU timing state of a context. Each of the last few frames gets its own
+// timestamp query pool, which is read back and reset when the frame's slot
+// comes up for reuse. If a frame's timestamps aren't available by then, its
+// timings are dropped rather than waiting for them.
+typedef struct {
+ _ngf_gpu_timing_frame    frames[_NGF_GPU_TIMING_LATENCY];
+  VkQueryPool             query_pools[_NGF_GPU_TIMING_LATENCY];
+  bool                    pool_ready[_NGF_GPU_TIMING_LATENCY]; // < Whether the
+                                                  // pool has been reset for
+                                                  // the slot's current frame.
+  uint64_t                timestamps[2u * NGF_MAX_GPU_TIMING_SCOPES];
+  uint64_t                submit_ns[_NGF_GPU_TIMING_LATENCY]; // < CPU time at
+                                                  // which each slot's frame
+                                                  // was submitted.
+ _ngf_gpu_timing_results  results;
+  float                   timestamp_period;
+} _ngf_vk_gpu_timing;
+
 // API context. Each thread calling nicegraf gets its own context.
 typedef struct ngf_context_t {
  _ngf_frame_resources *frame_res;
@@ -219,6 +265,8 @@ typedef struct ngf_context_t {
   VkSurfaceKHR         surface;
   uint32_t             frame_number;
   uint32_t             max_inflight_frames;
+ _ngf_vk_gpu_timing   *gpu_timing; // < NULL unless GPU timing is enabled.
+  ngf_frame_pacing_info pacing;
 } ngf_context_t;
 
 typedef struct ngf_shader_stage_t {
@@ -227,17 +275,35 @@ typedef struct ngf_shader_stage_t {
   char                  *entry_point_name;
 } ngf_shader_stage_t;
 
-typedef struct ngf_graphics_pipeline_t {
-  VkPipeline                           vk_pipeline;
+// Descriptor set layouts and the pipeline layout built from them. Shared by
+// graphics and compute pipelines.
+typedef struct _ngf_pipeline_layout {
  _NGF_DARRAY_OF(VkDescriptorSetLayout) vk_descriptor_set_layouts;
  _NGF_DARRAY_OF(_ngf_desc_set_size)    desc_set_sizes;
   VkPipelineLayout                     vk_pipeline_layout;
+  VkShaderStageFlags                   push_constants_stages;
+} _ngf_pipeline_layout;
+
+typedef struct ngf_graphics_pipeline_t {
+  VkPipeline            vk_pipeline;
+ _ngf_pipeline_layout   layout;
 } ngf_graphics_pipeline_t;
 
+typedef struct ngf_compute_pipeline_t {
+  VkPipeline            vk_pipeline;
+ _ngf_pipeline_layout   layout;
+} ngf_compute_pipeline_t;
+
 typedef struct ngf_image_t {
   VkImage       vkimg;
   VmaAllocation alloc;
   VkImageView   vkview;
+  // Images created with NGF_IMAGE_USAGE_STORAGE stay in the GENERAL layout
+  // for their whole lifetime, and have a view of each mip level, which is
+  // what storage image descriptors refer to.
+  bool          storage;
+  uint32_t      nmips;
+  VkImageView  *mip_views;
 } ngf_image_t;
 
 typedef struct ngf_render_target_t {
@@ -308,7 +374,10 @@ static VkDescriptorType get_vk_descriptor_type(ngf_descriptor_type type) {
     VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
     VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
     VK_DESCRIPTOR_TYPE_SAMPLER,
-    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
+    VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+    VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
   };
   return types[type];
 }
@@ -319,6 +388,8 @@ static VkShaderStageFlags get_vk_stage_flags(uint32_t flags) {
     result |= VK_SHADER_STAGE_FRAGMENT_BIT;
   if (flags & NGF_DESCRIPTOR_VERTEX_STAGE_BIT)
     result |= VK_SHADER_STAGE_VERTEX_BIT;
+  if (flags & NGF_DESCRIPTOR_COMPUTE_STAGE_BIT)
+    result |= VK_SHADER_STAGE_COMPUTE_BIT;
   return result;
 }
 
@@ -568,7 +639,8 @@ static VkVertexInputRate get_vk_input_rate(ngf_input_rate r) {
 static VkShaderStageFlagBits get_vk_shader_stage(ngf_stage_type s) {
   static const VkShaderStageFlagBits stages[NGF_STAGE_COUNT] = {
     VK_SHADER_STAGE_VERTEX_BIT,
-    VK_SHADER_STAGE_FRAGMENT_BIT
+    VK_SHADER_STAGE_FRAGMENT_BIT,
+    VK_SHADER_STAGE_COMPUTE_BIT
   };
   return stages[s];
 }
@@ -579,6 +651,10 @@ static VkBufferUsageFlags get_vk_buffer_usage(uint32_t usage) {
     flags |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
   if (usage & NGF_BUFFER_USAGE_XFER_SRC)
     flags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  if (usage & NGF_BUFFER_USAGE_DRAW_INDIRECT)
+    flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  if (usage & NGF_BUFFER_USAGE_STORAGE)
+    flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
   return flags;
 }
 
@@ -800,6 +876,15 @@ ngf_error ngf_initialize(ngf_device_preference pref) {
     const uint32_t num_queue_infos =
         1u + (same_gfx_and_present ? 0u : 1u) + (same_gfx_and_xfer ? 0u : 1u);
     const char *device_exts[] = {"VK_KHR_maintenance1", "VK_KHR_swapchain" };
+    // Enable the optional features that nicegraf makes use of, if they're
+    // supported.
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(_vk.phys_dev, &supported_features);
+    memset(&_vk.enabled_features, 0, sizeof(_vk.enabled_features));
+    _vk.enabled_features.multiDrawIndirect =
+        supported_features.multiDrawIndirect;
+    _vk.enabled_features.drawIndirectFirstInstance =
+        supported_features.drawIndirectFirstInstance;
     const VkDeviceCreateInfo dev_info = {
       .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
       .pNext                   = NULL,
@@ -809,7 +894,8 @@ ngf_error ngf_initialize(ngf_device_preference pref) {
       .enabledLayerCount       = 0,
       .ppEnabledLayerNames     = NULL,
       .enabledExtensionCount   = sizeof(device_exts) / sizeof(const char*),
-      .ppEnabledExtensionNames = device_exts
+      .ppEnabledExtensionNames = device_exts,
+      .pEnabledFeatures        = &_vk.enabled_features
     };
     vk_err = vkCreateDevice(_vk.phys_dev, &dev_info, NULL, &_vk.device);
     if (vk_err != VK_SUCCESS) {
@@ -882,6 +968,7 @@ static void _ngf_destroy_swapchain(_ngf_swapchain *swapchain) {
 static ngf_error _ngf_create_vk_image_view(VkImage          image,
                                            VkImageViewType  image_type,
                                            VkFormat         image_format,
+                                           uint32_t         base_mip,
                                            uint32_t         nmips,
                                            uint32_t         nlayers,
                                            VkImageView     *result) {
@@ -905,7 +992,7 @@ static ngf_error _ngf_create_vk_image_view(VkImage          image,
     },
     .subresourceRange = {
       .aspectMask     = is_depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT,
-      .baseMipLevel   = 0u,
+      .baseMipLevel   = base_mip,
       .levelCount     = nmips,
       .baseArrayLayer = 0u,
       .layerCount     = nlayers
@@ -923,6 +1010,133 @@ static ngf_error _ngf_create_vk_image_view(VkImage          image,
   }
 }
 
+// Transitions all mip levels of a storage image from the UNDEFINED layout to
+// the GENERAL one, which storage images are kept in for their whole lifetime.
+// This is submitted and waited on right away, so that the image is in its
+// final layout before any command buffer that uses it gets submitted, no
+// matter in which order they are recorded or submitted.
+static ngf_error _ngf_init_storage_image_layout(ngf_image img) {
+  const VkCommandBufferAllocateInfo vk_cmdbuf_info = {
+    .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+    .pNext              = NULL,
+    .commandPool        = CURRENT_CONTEXT->gfx_cmd_pools[
+        interlocked_read(&_vk.frame_id) % CURRENT_CONTEXT->max_inflight_frames],
+    .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+    .commandBufferCount = 1u
+  };
+  VkCommandBuffer vkcmdbuf = VK_NULL_HANDLE;
+  if (vkAllocateCommandBuffers(_vk.device, &vk_cmdbuf_info, &vkcmdbuf) !=
+      VK_SUCCESS) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  const VkCommandBufferBeginInfo cmd_buf_begin = {
+    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+    .pNext            = NULL,
+    .flags            = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    .pInheritanceInfo = NULL
+  };
+  vkBeginCommandBuffer(vkcmdbuf, &cmd_buf_begin);
+  const VkImageMemoryBarrier barrier = {
+    .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+    .pNext               = NULL,
+    .srcAccessMask       = 0u,
+    .dstAccessMask       = 0u,
+    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+    .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+    .image               = img->vkimg,
+    .subresourceRange    = {
+      .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+      .baseMipLevel   = 0u,
+      .levelCount     = img->nmips,
+      .baseArrayLayer = 0u,
+      .layerCount     = 1u
+    }
+  };
+  vkCmdPipelineBarrier(vkcmdbuf,
+                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                       0u,
+                       0u, NULL,
+                       0u, NULL,
+                       1u, &barrier);
+  vkEndCommandBuffer(vkcmdbuf);
+
+  ngf_error err = NGF_ERROR_OK;
+  const VkFenceCreateInfo fence_info = {
+    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0u
+  };
+  VkFence fence = VK_NULL_HANDLE;
+  if (vkCreateFence(_vk.device, &fence_info, NULL, &fence) != VK_SUCCESS) {
+    err = NGF_ERROR_OUTOFMEM;
+    goto _ngf_init_storage_image_layout_cleanup;
+  }
+  const VkSubmitInfo submit_info = {
+    .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+    .pNext                = NULL,
+    .waitSemaphoreCount   = 0u,
+    .pWaitSemaphores      = NULL,
+    .pWaitDstStageMask    = NULL,
+    .commandBufferCount   = 1u,
+    .pCommandBuffers      = &vkcmdbuf,
+    .signalSemaphoreCount = 0u,
+    .pSignalSemaphores    = NULL
+  };
+  if (vkQueueSubmit(_vk.gfx_queue, 1u, &submit_info, fence) != VK_SUCCESS ||
+      vkWaitForFences(_vk.device, 1u, &fence, VK_TRUE, UINT64_MAX) !=
+          VK_SUCCESS) {
+    err = NGF_ERROR_IMAGE_CREATION_FAILED;
+  }
+
+_ngf_init_storage_image_layout_cleanup:
+  if (fence != VK_NULL_HANDLE) {
+    vkDestroyFence(_vk.device, fence, NULL);
+  }
+  vkFreeCommandBuffers(_vk.device, vk_cmdbuf_info.commandPool, 1u, &vkcmdbuf);
+  return err;
+}
+
+// Creates the per-mip views of a storage image, and transitions it to the
+// GENERAL layout.
+static ngf_error _ngf_init_storage_image(ngf_image                img,
+                                         const VkImageCreateInfo *vk_info) {
+  img->storage = true;
+  img->nmips = vk_info->mipLevels;
+  img->mip_views = NGF_ALLOCN(VkImageView, img->nmips);
+  if (img->mip_views == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  memset(img->mip_views, 0, sizeof(VkImageView) * img->nmips);
+  for (uint32_t m = 0u; m < img->nmips; ++m) {
+    const ngf_error err = _ngf_create_vk_image_view(img->vkimg,
+                                                    vk_info->imageType,
+                                                    vk_info->format,
+                                                    m,
+                                                    1u,
+                                                    vk_info->arrayLayers,
+                                                   &img->mip_views[m]);
+    if (err != NGF_ERROR_OK) {
+      return err;
+    }
+  }
+  return _ngf_init_storage_image_layout(img);
+}
+
+static void _ngf_destroy_storage_image_views(ngf_image img) {
+  if (img->mip_views != NULL) {
+    for (uint32_t m = 0u; m < img->nmips; ++m) {
+      if (img->mip_views[m] != VK_NULL_HANDLE) {
+        vkDestroyImageView(_vk.device, img->mip_views[m], NULL);
+      }
+    }
+    NGF_FREEN(img->mip_views, img->nmips);
+    img->mip_views = NULL;
+  }
+}
+
 static ngf_error _ngf_create_swapchain(
     const ngf_swapchain_info *swapchain_info,
     VkSurfaceKHR              surface,
@@ -1054,6 +1268,7 @@ static ngf_error _ngf_create_swapchain(
     err = _ngf_create_vk_image_view(swapchain->images[i],
                                     VK_IMAGE_VIEW_TYPE_2D,
                                     requested_format,
+                                    0u,
                                     1u,
                                     1u,
                                    &swapchain->image_views[i]);
@@ -1405,8 +1620,9 @@ ngf_error ngf_create_context(const ngf_context_info *info,
   }
 
   // initialize descriptor superpools.
-  ctx->desc_superpools = NGF_ALLOCN(_ngf_desc_superpool,
-                                     ctx->max_inflight_frames);
+  ctx->desc_superpools = NGF_ALLOCN_AS(_ngf_desc_superpool,
+                                        ctx->max_inflight_frames,
+                                        NGF_ALLOCATION_DESCRIPTOR_POOL);
   memset(ctx->desc_superpools, 0,
          sizeof(_ngf_desc_superpool) * ctx->max_inflight_frames);
 
@@ -1433,6 +1649,7 @@ ngf_error ngf_resize_context(ngf_context ctx,
 
 void _ngf_retire_resources(_ngf_frame_resources *frame_res) {
   if (frame_res->active && frame_res->nfences > 0u) {
+    const uint64_t wait_start_ns = _ngf_timeline_now();
     VkResult wait_status = VK_SUCCESS;
     do {
       wait_status = vkWaitForFences(_vk.device,
@@ -1441,6 +1658,7 @@ void _ngf_retire_resources(_ngf_frame_resources *frame_res) {
                                      VK_TRUE,
                                      0x3B9ACA00ul);
     } while(wait_status == VK_TIMEOUT);
+    _ngf_timeline_scope("fence wait", wait_start_ns);
     vkResetFences(_vk.device, frame_res->nfences,
                    frame_res->fences);
     frame_res->nfences = 0;
@@ -1537,6 +1755,15 @@ void _ngf_retire_resources(_ngf_frame_resources *frame_res) {
   _NGF_DARRAY_CLEAR(frame_res->retire_desc_superpools);
 }
 
+static void _ngf_destroy_gpu_timing(_ngf_vk_gpu_timing *t) {
+  for (uint32_t f = 0u; f < _NGF_GPU_TIMING_LATENCY; ++f) {
+    if (t->query_pools[f] != VK_NULL_HANDLE) {
+      vkDestroyQueryPool(_vk.device, t->query_pools[f], NULL);
+    }
+  }
+  NGF_FREE(t);
+}
+
 void ngf_destroy_context(ngf_context ctx) {
   if (ctx != NULL) {
     vkDeviceWaitIdle(_vk.device);
@@ -1580,6 +1807,9 @@ void ngf_destroy_context(ngf_context ctx) {
     if (ctx->surface != VK_NULL_HANDLE) {
       vkDestroySurfaceKHR(_vk.instance, ctx->surface, NULL);
     }
+    if (ctx->gpu_timing != NULL) {
+      _ngf_destroy_gpu_timing(ctx->gpu_timing);
+    }
     if (ctx->allocator != VK_NULL_HANDLE) {
       vmaDestroyAllocator(ctx->allocator);
     }
@@ -1597,6 +1827,48 @@ ngf_error ngf_set_context(ngf_context ctx) {
   return NGF_ERROR_OK;
 }
 
+// Returns the highest sample count present in the given mask.
+static uint32_t _ngf_max_sample_count(VkSampleCountFlags counts) {
+  uint32_t result = 1u;
+  for (uint32_t c = VK_SAMPLE_COUNT_64_BIT; c > 1u; c >>= 1u) {
+    if (counts & c) {
+      result = c;
+      break;
+    }
+  }
+  return result;
+}
+
+ngf_error ngf_get_device_capabilities(ngf_device_capabilities *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  VkPhysicalDeviceProperties dev_props;
+  vkGetPhysicalDeviceProperties(_vk.phys_dev, &dev_props);
+  const VkPhysicalDeviceLimits *limits = &dev_props.limits;
+  result->uniform_buffer_offset_alignment =
+      (size_t)limits->minUniformBufferOffsetAlignment;
+  result->max_uniform_buffer_range = (size_t)limits->maxUniformBufferRange;
+  result->optimal_copy_offset_alignment =
+      (size_t)NGF_MAX(limits->optimalBufferCopyOffsetAlignment, 1u);
+  result->max_uniform_buffers_per_stage =
+      limits->maxPerStageDescriptorUniformBuffers;
+  result->max_sampled_images_per_stage =
+      limits->maxPerStageDescriptorSampledImages;
+  result->max_samplers_per_stage = limits->maxPerStageDescriptorSamplers;
+  result->max_color_attachments = limits->maxColorAttachments;
+  result->max_image_dimension_2d = limits->maxImageDimension2D;
+  result->max_sample_count =
+      _ngf_max_sample_count(limits->framebufferColorSampleCounts &
+                            limits->framebufferDepthSampleCounts);
+  result->timestamp_period = limits->timestampPeriod;
+  result->multi_draw_indirect = _vk.enabled_features.multiDrawIndirect;
+  result->draw_indirect_first_instance =
+      _vk.enabled_features.drawIndirectFirstInstance;
+  return NGF_ERROR_OK;
+}
+
 ngf_error ngf_create_cmd_buffer(const ngf_cmd_buffer_info *info,
                                 ngf_cmd_buffer *result) {
   assert(info);
@@ -1605,11 +1877,13 @@ ngf_error ngf_create_cmd_buffer(const ngf_cmd_buffer_info *info,
 
   ngf_cmd_buffer cmd_buf = NGF_ALLOC(ngf_cmd_buffer_t);
   *result = cmd_buf;
-  cmd_buf->active_pipe = NULL;
   if (cmd_buf == NULL) {
     return NGF_ERROR_OUTOFMEM;
   }
+  cmd_buf->active_pipe = NULL;
+  cmd_buf->active_compute_pipe = NULL;
   _NGF_DARRAY_RESET(cmd_buf->bundles, 3);
+  cmd_buf->timing_scopes = NULL;
   cmd_buf->state = _NGF_CMD_BUFFER_READY;
   return NGF_ERROR_OK;
 }
@@ -1630,6 +1904,7 @@ static ngf_error _ngf_cmd_bundle_create(VkCommandPool        pool,
   if (vk_err != VK_SUCCESS) {
     return NGF_ERROR_OUTOFMEM; // TODO: return appropriate error.
   }
+  _NGF_STAT_ADD(_NGF_STAT_CMD_BLOCKS_ALLOCATED, 1u);
   bundle->vkpool = pool;
   VkCommandBufferBeginInfo cmd_buf_begin = {
     .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -1655,6 +1930,55 @@ static ngf_error _ngf_cmd_bundle_create(VkCommandPool        pool,
   return NGF_ERROR_OK;
 }
 
+// Opens a timing scope in the command buffer, if GPU timing is enabled. The
+// command buffer's scopes are merged into the frame's scope tree when it gets
+// submitted.
+static void _ngf_gpu_timing_begin(ngf_cmd_buffer cmd_buf, const char *name) {
+  _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  const uint32_t f = (uint32_t)(cmd_buf->frame_id % _NGF_GPU_TIMING_LATENCY);
+  if (t == NULL || !t->pool_ready[f]) {
+    return;
+  }
+  if (cmd_buf->timing_scopes == NULL) {
+    cmd_buf->timing_scopes = NGF_ALLOC(_ngf_gpu_timing_frame);
+    if (cmd_buf->timing_scopes == NULL) {
+      return;
+    }
+    _ngf_gpu_timing_reset(cmd_buf->timing_scopes, cmd_buf->frame_id);
+  }
+  const uint32_t query =
+      _ngf_gpu_timing_begin_local_scope(&t->frames[f], cmd_buf->timing_scopes,
+                                        name);
+  if (query != _NGF_GPU_TIMING_NO_QUERY) {
+    vkCmdWriteTimestamp(cmd_buf->active_bundle.vkcmdbuf,
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        t->query_pools[f], query);
+  }
+}
+
+// Number of timing scopes open in the command buffer.
+static uint32_t _ngf_gpu_timing_cmd_depth(ngf_cmd_buffer cmd_buf) {
+  return cmd_buf->timing_scopes != NULL
+             ? _ngf_gpu_timing_depth(cmd_buf->timing_scopes)
+             : 0u;
+}
+
+// Closes the command buffer's timing scopes until only `depth` of them remain
+// open.
+static void _ngf_gpu_timing_end(ngf_cmd_buffer cmd_buf, uint32_t depth) {
+  _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  const uint32_t f = (uint32_t)(cmd_buf->frame_id % _NGF_GPU_TIMING_LATENCY);
+  while (_ngf_gpu_timing_cmd_depth(cmd_buf) > depth) {
+    const uint32_t query = _ngf_gpu_timing_end_scope(cmd_buf->timing_scopes);
+    // If timing got disabled in the meantime, the scope is simply dropped.
+    if (t != NULL && query != _NGF_GPU_TIMING_NO_QUERY) {
+      vkCmdWriteTimestamp(cmd_buf->active_bundle.vkcmdbuf,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                          t->query_pools[f], query);
+    }
+  }
+}
+
 static ngf_error _ngf_cmd_buffer_start_encoder(ngf_cmd_buffer      cmd_buf,
                                               _ngf_cmd_bundle_type type) {
   if (!_NGF_CMD_BUF_RECORDABLE(cmd_buf->state) ||
@@ -1669,13 +1993,20 @@ static ngf_error _ngf_cmd_buffer_start_encoder(ngf_cmd_buffer      cmd_buf,
         : CURRENT_CONTEXT->xfer_cmd_pools[pool_idx];
   ngf_error err = _ngf_cmd_bundle_create(pool, type, &cmd_buf->active_bundle);
   cmd_buf->state = _NGF_CMD_BUFFER_RECORDING;
+  cmd_buf->nfixed_scopes = 0u;
   return err;
 }
 
 ngf_error ngf_cmd_buffer_start_render(ngf_cmd_buffer      cmd_buf,
                                       ngf_render_encoder *enc) {
   enc->__handle = (uintptr_t)((void*)cmd_buf);
-  return _ngf_cmd_buffer_start_encoder(cmd_buf, _NGF_BUNDLE_RENDERING);
+  const ngf_error err =
+      _ngf_cmd_buffer_start_encoder(cmd_buf, _NGF_BUNDLE_RENDERING);
+  if (err == NGF_ERROR_OK) {
+    _ngf_gpu_timing_begin(cmd_buf, "render encoder");
+    cmd_buf->nfixed_scopes = _ngf_gpu_timing_cmd_depth(cmd_buf);
+  }
+  return err;
 }
 
 ngf_error ngf_cmd_buffer_start_xfer(ngf_cmd_buffer    cmd_buf,
@@ -1684,10 +2015,27 @@ ngf_error ngf_cmd_buffer_start_xfer(ngf_cmd_buffer    cmd_buf,
   return _ngf_cmd_buffer_start_encoder(cmd_buf, _NGF_BUNDLE_XFER);
 }
 
+ngf_error ngf_cmd_buffer_start_compute(ngf_cmd_buffer       cmd_buf,
+                                       ngf_compute_encoder *enc) {
+  enc->__handle = (uintptr_t)((void*)cmd_buf);
+  // Compute work goes to the graphics queue, which is guaranteed to support
+  // compute.
+  const ngf_error err =
+      _ngf_cmd_buffer_start_encoder(cmd_buf, _NGF_BUNDLE_RENDERING);
+  if (err == NGF_ERROR_OK) {
+    _ngf_gpu_timing_begin(cmd_buf, "compute encoder");
+    cmd_buf->nfixed_scopes = _ngf_gpu_timing_cmd_depth(cmd_buf);
+  }
+  return err;
+}
+
 static ngf_error _ngf_encoder_end(ngf_cmd_buffer cmd_buf) {
   if (cmd_buf->state != _NGF_CMD_BUFFER_RECORDING) {
     return NGF_ERROR_COMMAND_BUFFER_INVALID_STATE;
   }
+  // Debug groups left open in the encoder are closed along with it.
+  _ngf_gpu_timing_end(cmd_buf, 0u);
+  cmd_buf->nfixed_scopes = 0u;
   vkEndCommandBuffer(cmd_buf->active_bundle.vkcmdbuf);
   _NGF_DARRAY_APPEND(cmd_buf->bundles, cmd_buf->active_bundle);
   cmd_buf->state = _NGF_CMD_BUFFER_AWAITING_SUBMIT;
@@ -1702,6 +2050,36 @@ ngf_error ngf_xfer_encoder_end(ngf_xfer_encoder enc) {
   return _ngf_encoder_end((ngf_cmd_buffer)((void*)enc.__handle));
 }
 
+ngf_error ngf_compute_encoder_end(ngf_compute_encoder enc) {
+  ngf_cmd_buffer cmd_buf = (ngf_cmd_buffer)((void*)enc.__handle);
+  if (cmd_buf->state == _NGF_CMD_BUFFER_RECORDING) {
+    // Make the writes done by the dispatches in this encoder visible to
+    // subsequent commands.
+    const VkMemoryBarrier vk_barrier = {
+      .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .pNext         = NULL,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                       VK_ACCESS_INDEX_READ_BIT |
+                       VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                       VK_ACCESS_UNIFORM_READ_BIT |
+                       VK_ACCESS_SHADER_READ_BIT |
+                       VK_ACCESS_SHADER_WRITE_BIT |
+                       VK_ACCESS_TRANSFER_READ_BIT
+    };
+    vkCmdPipelineBarrier(cmd_buf->active_bundle.vkcmdbuf,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                         VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                         VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0u, 1u, &vk_barrier, 0u, NULL, 0u, NULL);
+  }
+  return _ngf_encoder_end(cmd_buf);
+}
+
 ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer cmd_buf) {
   assert(cmd_buf);
 
@@ -1715,6 +2093,11 @@ ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer cmd_buf) {
   cmd_buf->state          = _NGF_CMD_BUFFER_READY;
   cmd_buf->desc_superpool =  NULL;
   cmd_buf->active_rt      =  NULL;
+  cmd_buf->nfixed_scopes  =  0u;
+  if (cmd_buf->timing_scopes != NULL) {
+    _ngf_gpu_timing_reset(cmd_buf->timing_scopes, cmd_buf->frame_id);
+  }
+  memset(cmd_buf->bound_desc_sets, 0, sizeof(cmd_buf->bound_desc_sets));
   return NGF_ERROR_OK;
 }
 
@@ -1727,12 +2110,16 @@ void ngf_destroy_cmd_buffer(ngf_cmd_buffer buffer) {
     vkDestroySemaphore(_vk.device, bundle->vksem, NULL);
   }
   _NGF_DARRAY_DESTROY(buffer->bundles);
+  if (buffer->timing_scopes != NULL) {
+    NGF_FREE(buffer->timing_scopes);
+  }
   // TODO: free active bundle.
   NGF_FREE(buffer);
 }
 
 ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
   assert(bufs);
+  const uint64_t start_ns = _ngf_stats_now_ns();
   ATOMIC_INT fi = interlocked_read(&_vk.frame_id);
   _ngf_frame_resources *frame_sync_data = 
       &CURRENT_CONTEXT->frame_res[fi % CURRENT_CONTEXT->max_inflight_frames];
@@ -1771,13 +2158,122 @@ ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer *bufs) {
       }
     }
     _NGF_DARRAY_CLEAR(bufs[i]->bundles);
+    if (bufs[i]->timing_scopes != NULL) {
+      const _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+      if (t != NULL) {
+        _ngf_gpu_timing_merge(&t->frames[fi % _NGF_GPU_TIMING_LATENCY],
+                              bufs[i]->timing_scopes);
+      } else {
+        _ngf_gpu_timing_reset(bufs[i]->timing_scopes, fi);
+      }
+    }
     bufs[i]->state = _NGF_CMD_BUFFER_SUBMITTED;
   }
+  _NGF_STAT_ADD(_NGF_STAT_SUBMIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("ngf_submit_cmd_buffers", start_ns);
   return NGF_ERROR_OK;
 }
 
+// Reads back the timings of the frame that previously used the slot of the
+// frame that is about to begin, and resets the slot's queries. The reset is
+// recorded into a command buffer that goes ahead of all of the new frame's
+// other graphics commands.
+static void _ngf_gpu_timing_begin_frame(uint64_t              frame_id,
+                                        _ngf_frame_resources *frame_res,
+                                        VkCommandPool         pool) {
+  _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (t == NULL) {
+    return;
+  }
+  const uint32_t f = (uint32_t)(frame_id % _NGF_GPU_TIMING_LATENCY);
+  _ngf_gpu_timing_frame *frame = &t->frames[f];
+  // Queries handed out to command buffers that never got submitted are never
+  // written, so the frame's timings are incomplete if there were any.
+  if (t->pool_ready[f] && frame->nscopes > 0u &&
+      frame->nscopes == frame->nquery_pairs &&
+      !_ngf_gpu_timing_has_open_scopes(frame)) {
+    const VkResult vk_err =
+        vkGetQueryPoolResults(_vk.device, t->query_pools[f], 0u,
+                              2u * frame->nquery_pairs, sizeof(t->timestamps),
+                              t->timestamps, sizeof(uint64_t),
+                              VK_QUERY_RESULT_64_BIT);
+    if (vk_err == VK_SUCCESS) {
+      _ngf_gpu_timing_resolve(frame, t->timestamps, t->timestamp_period,
+                              &t->results);
+      // The GPU's clock isn't calibrated against the CPU's, so the frame is
+      // placed at the earliest time the GPU could have started on it.
+      if (_NGF_TIMELINE_ENABLED) {
+        _ngf_timeline_gpu_frame(&t->results, t->submit_ns[f]);
+      }
+    }
+  }
+  _ngf_gpu_timing_reset(frame, frame_id);
+  _ngf_cmd_bundle bundle;
+  t->pool_ready[f] = false;
+  if (_ngf_cmd_bundle_create(pool, _NGF_BUNDLE_RENDERING, &bundle) ==
+      NGF_ERROR_OK) {
+    vkCmdResetQueryPool(bundle.vkcmdbuf, t->query_pools[f], 0u,
+                        2u * NGF_MAX_GPU_TIMING_SCOPES);
+    vkEndCommandBuffer(bundle.vkcmdbuf);
+    _NGF_DARRAY_APPEND(frame_res->submitted_gfx_cmds, bundle.vkcmdbuf);
+    _NGF_DARRAY_APPEND(frame_res->signal_gfx_semaphores, bundle.vksem);
+    _NGF_DARRAY_APPEND(frame_res->gfx_cmd_pools, bundle.vkpool);
+    t->pool_ready[f] = true;
+  }
+}
+
+// Number of frames allowed to be queued up on the GPU. End of frame always
+// retires the frame resources that are about to be reused, so there can never
+// be more than max_inflight_frames - 1 frames queued.
+static uint32_t _ngf_max_queued_frames() {
+  const uint32_t limit = CURRENT_CONTEXT->max_inflight_frames - 1u;
+  const uint32_t requested = CURRENT_CONTEXT->pacing.max_queued_frames;
+  return requested < limit ? requested : limit;
+}
+
+// Blocks until the GPU finishes the frame that used the given resources,
+// without retiring them.
+static void _ngf_pacing_wait(const _ngf_frame_resources *frame_res) {
+  if (!frame_res->active || frame_res->nfences == 0u) {
+    return;
+  }
+  const uint64_t start_ns = _ngf_stats_now_ns();
+  VkResult wait_status = VK_SUCCESS;
+  do {
+    wait_status = vkWaitForFences(_vk.device,
+                                  frame_res->nfences,
+                                  frame_res->fences,
+                                  VK_TRUE,
+                                  0x3B9ACA00ul);
+  } while(wait_status == VK_TIMEOUT);
+  _NGF_STAT_ADD(_NGF_STAT_PACING_WAIT_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_timeline_scope("frame pacing wait", start_ns);
+}
+
+// Number of frames that the GPU has yet to finish.
+static uint32_t _ngf_queued_frames() {
+  uint32_t result = 0u;
+  for (uint32_t f = 0u; f < CURRENT_CONTEXT->max_inflight_frames; ++f) {
+    const _ngf_frame_resources *frame_res = &CURRENT_CONTEXT->frame_res[f];
+    for (uint32_t i = 0u; frame_res->active && i < frame_res->nfences; ++i) {
+      if (vkGetFenceStatus(_vk.device, frame_res->fences[i]) == VK_NOT_READY) {
+        ++result;
+        break;
+      }
+    }
+  }
+  return result;
+}
+
 ngf_error ngf_begin_frame() {
   ngf_error err = NGF_ERROR_OK;
+  uint64_t wait_frame = 0u;
+  if (_ngf_frame_pacing_target(&CURRENT_CONTEXT->pacing, true,
+                               interlocked_read(&_vk.frame_id),
+                               _ngf_max_queued_frames(), &wait_frame)) {
+    _ngf_pacing_wait(&CURRENT_CONTEXT->frame_res[
+        wait_frame % CURRENT_CONTEXT->max_inflight_frames]);
+  }
   const ATOMIC_INT fi =
       interlocked_read(&_vk.frame_id) % CURRENT_CONTEXT->max_inflight_frames;
   CURRENT_CONTEXT->frame_res[fi].active = true;
@@ -1787,6 +2283,9 @@ ngf_error ngf_begin_frame() {
   _NGF_DARRAY_CLEAR(CURRENT_CONTEXT->frame_res[fi].submitted_xfer_cmds);
   _NGF_DARRAY_CLEAR(CURRENT_CONTEXT->frame_res[fi].signal_xfer_semaphores);
   _NGF_DARRAY_CLEAR(CURRENT_CONTEXT->frame_res[fi].xfer_cmd_pools);
+  _ngf_gpu_timing_begin_frame(interlocked_read(&_vk.frame_id),
+                              &CURRENT_CONTEXT->frame_res[fi],
+                              CURRENT_CONTEXT->gfx_cmd_pools[fi]);
   
   // reset stack allocator.
   _ngf_sa_reset(_ngf_tmp_store());
@@ -1819,6 +2318,7 @@ static void _ngf_submit_commands(VkQueue                     queue,
 
 ngf_error ngf_end_frame() {
   ngf_error err = NGF_ERROR_OK;
+  const uint64_t start_ns = _ngf_stats_now_ns();
 
   // Obtain the current frame sync structure and increment frame number.
   const ATOMIC_INT frame_id = interlocked_post_inc(&_vk.frame_id);
@@ -1861,6 +2361,10 @@ ngf_error ngf_end_frame() {
     }
 
     // Submit pending graphics commands.
+    if (CURRENT_CONTEXT->gpu_timing != NULL) {
+      CURRENT_CONTEXT->gpu_timing->submit_ns[
+          frame_id % _NGF_GPU_TIMING_LATENCY] = _ngf_stats_now_ns();
+    }
     const VkPipelineStageFlags color_attachment_stage =
         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
     uint32_t wait_sem_count = 0u;
@@ -1895,19 +2399,97 @@ ngf_error ngf_end_frame() {
         .pImageIndices      = &CURRENT_CONTEXT->swapchain.image_idx,
         .pResults           = NULL
       };
+      const uint64_t present_start_ns = _ngf_timeline_now();
       const VkResult present_result = vkQueuePresentKHR(_vk.present_queue,
                                                         &present_info);
+      _ngf_timeline_scope("present", present_start_ns);
       if (present_result != VK_SUCCESS) err = NGF_ERROR_END_FRAME_FAILED;
     }
   }
 
-  // Retire resources.
+  // Retire resources. Waiting for the resources to be freed up is what keeps
+  // the CPU from running too far ahead, so it counts towards frame pacing.
   const ATOMIC_INT next_fi = (fi + 1u) % CURRENT_CONTEXT->max_inflight_frames;
   _ngf_frame_resources *next_frame_sync = &CURRENT_CONTEXT->frame_res[next_fi];
+  _ngf_pacing_wait(next_frame_sync);
   _ngf_retire_resources(next_frame_sync);
+  uint64_t wait_frame = 0u;
+  if (_ngf_frame_pacing_target(&CURRENT_CONTEXT->pacing, false, frame_id,
+                               _ngf_max_queued_frames(), &wait_frame)) {
+    _ngf_pacing_wait(&CURRENT_CONTEXT->frame_res[
+        wait_frame % CURRENT_CONTEXT->max_inflight_frames]);
+  }
+  _NGF_STAT_ADD(_NGF_STAT_QUEUED_FRAMES, _ngf_queued_frames());
+  const _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (t != NULL) {
+    _NGF_STAT_ADD(_NGF_STAT_GPU_BUSY_TIME_NS,
+                  _ngf_gpu_timing_busy_ns(&t->results));
+  }
+  _NGF_STAT_ADD(_NGF_STAT_END_FRAME_TIME_NS, _ngf_stats_now_ns() - start_ns);
+  _ngf_stats_end_frame(frame_id);
+  return err;
+}
+
+ngf_error ngf_set_frame_pacing(const ngf_frame_pacing_info *info) {
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  const ngf_error err = _ngf_validate_frame_pacing(info);
+  if (err == NGF_ERROR_OK) {
+    CURRENT_CONTEXT->pacing = *info;
+  }
   return err;
 }
 
+ngf_error ngf_enable_gpu_timing(bool enable) {
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  if (enable && t == NULL) {
+    t = NGF_ALLOC(_ngf_vk_gpu_timing);
+    if (t == NULL) {
+      return NGF_ERROR_OUTOFMEM;
+    }
+    memset(t, 0, sizeof(*t));
+    const VkQueryPoolCreateInfo pool_info = {
+      .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .pNext              = NULL,
+      .flags              = 0u,
+      .queryType          = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount         = 2u * NGF_MAX_GPU_TIMING_SCOPES,
+      .pipelineStatistics = 0u
+    };
+    for (uint32_t f = 0u; f < _NGF_GPU_TIMING_LATENCY; ++f) {
+      if (vkCreateQueryPool(_vk.device, &pool_info, NULL,
+                            &t->query_pools[f]) != VK_SUCCESS) {
+        _ngf_destroy_gpu_timing(t);
+        return NGF_ERROR_OUTOFMEM;
+      }
+    }
+    VkPhysicalDeviceProperties dev_props;
+    vkGetPhysicalDeviceProperties(_vk.phys_dev, &dev_props);
+    t->timestamp_period = dev_props.limits.timestampPeriod;
+    // Queries can't be used until they have been reset, which happens at the
+    // start of the next frame.
+    CURRENT_CONTEXT->gpu_timing = t;
+  } else if (!enable && t != NULL) {
+    vkDeviceWaitIdle(_vk.device);
+    _ngf_destroy_gpu_timing(t);
+    CURRENT_CONTEXT->gpu_timing = NULL;
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_gpu_frame_timings(ngf_gpu_frame_timings *result) {
+  assert(result);
+  if (CURRENT_CONTEXT == NULL) {
+    return NGF_ERROR_INVALID_CONTEXT;
+  }
+  const _ngf_vk_gpu_timing *t = CURRENT_CONTEXT->gpu_timing;
+  return _ngf_gpu_timing_get_results(t != NULL ? &t->results : NULL, result);
+}
+
 ngf_error ngf_create_shader_stage(const ngf_shader_stage_info *info,
                                   ngf_shader_stage *result) {
   assert(info);
@@ -1949,17 +2531,160 @@ void ngf_destroy_shader_stage(ngf_shader_stage stage) {
   }
 }
 
+static void _ngf_build_vk_spec_info(const ngf_specialization_info *spec_info,
+                                    VkSpecializationInfo          *vk_spec_info) {
+  VkSpecializationMapEntry *spec_map_entries = _ngf_sa_alloc(_ngf_tmp_store(),
+                    spec_info->nspecializations *
+                    sizeof(VkSpecializationMapEntry));
+
+  vk_spec_info->pData         = spec_info->value_buffer;
+  vk_spec_info->mapEntryCount = spec_info->nspecializations;
+  vk_spec_info->pMapEntries   = spec_map_entries;
+
+  size_t total_data_size = 0u;
+  for(size_t i = 0; i < spec_info->nspecializations; ++i) {
+    VkSpecializationMapEntry *vk_specialization =
+        &spec_map_entries[i];
+    const ngf_constant_specialization *specialization =
+        &spec_info->specializations[i];
+    vk_specialization->constantID = specialization->constant_id;
+    vk_specialization->offset     = specialization->offset;
+    size_t specialization_size = 0u;
+    switch(specialization->type) {
+    case NGF_TYPE_INT8:
+    case NGF_TYPE_UINT8:
+      specialization_size = 1u;
+      break;
+    case NGF_TYPE_INT16:
+    case NGF_TYPE_UINT16:
+    case NGF_TYPE_HALF_FLOAT:
+      specialization_size = 2u;
+      break;
+    case NGF_TYPE_INT32:
+    case NGF_TYPE_UINT32:
+    case NGF_TYPE_FLOAT:
+      specialization_size = 4u;
+      break;
+    case NGF_TYPE_DOUBLE:
+      specialization_size = 8u;
+      break;
+    default: assert(false);
+    }
+    vk_specialization->size = specialization_size;
+    total_data_size += specialization_size;
+  }
+  vk_spec_info->dataSize = total_data_size;
+}
+
+static ngf_error _ngf_create_pipeline_layout(
+    const ngf_pipeline_layout_info *info,
+   _ngf_pipeline_layout            *layout) {
+  VkResult vk_err = VK_SUCCESS;
+
+  // Descriptor set layouts.
+  _NGF_DARRAY_RESET(layout->vk_descriptor_set_layouts,
+                    info->ndescriptor_set_layouts);
+  _NGF_DARRAY_RESET(layout->desc_set_sizes,
+                    info->ndescriptor_set_layouts);
+  layout->vk_pipeline_layout = VK_NULL_HANDLE;
+  for (uint32_t s = 0u; s < info->ndescriptor_set_layouts; ++s) {
+    VkDescriptorSetLayoutBinding *vk_descriptor_bindings =
+        NGF_ALLOCN(VkDescriptorSetLayoutBinding,
+                   info->descriptor_set_layouts[s].ndescriptors);
+    _ngf_desc_set_size set_size;
+    memset(&set_size, 0, sizeof(set_size));
+    for (uint32_t b = 0u;
+         b < info->descriptor_set_layouts[s].ndescriptors;
+         ++b) {
+      VkDescriptorSetLayoutBinding *vk_d = &vk_descriptor_bindings[b];
+      const ngf_descriptor_info *d =
+          &info->descriptor_set_layouts[s].descriptors[b];
+      vk_d->binding         = d->id;
+      vk_d->descriptorCount = 1u;
+      vk_d->descriptorType  = get_vk_descriptor_type(d->type);
+      vk_d->descriptorCount = 1u;
+      vk_d->stageFlags      = get_vk_stage_flags(d->stage_flags);
+      vk_d->pImmutableSamplers = NULL;
+      set_size.counts[d->type]++;
+    }
+    const VkDescriptorSetLayoutCreateInfo vk_ds_info = {
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .pNext = NULL,
+      .flags = 0u,
+      .bindingCount = info->descriptor_set_layouts[s].ndescriptors,
+      .pBindings = vk_descriptor_bindings
+    };
+    VkDescriptorSetLayout result_dsl = VK_NULL_HANDLE;
+    vk_err = vkCreateDescriptorSetLayout(_vk.device, &vk_ds_info, NULL,
+                                         &result_dsl);
+    _NGF_DARRAY_APPEND(layout->vk_descriptor_set_layouts, result_dsl);
+    _NGF_DARRAY_APPEND(layout->desc_set_sizes, set_size);
+    NGF_FREEN(vk_descriptor_bindings,
+              info->descriptor_set_layouts[s].ndescriptors);
+    if (vk_err != VK_SUCCESS) {
+      return NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+    }
+  }
+
+  // Pipeline layout.
+  const uint32_t ndescriptor_sets =
+      _NGF_DARRAY_SIZE(layout->vk_descriptor_set_layouts);
+  assert(info->push_constants_size <= NGF_MAX_PUSH_CONSTANTS_SIZE);
+  layout->push_constants_stages =
+      get_vk_stage_flags(info->push_constants_stage_flags);
+  const VkPushConstantRange vk_push_constant_range = {
+    .stageFlags = layout->push_constants_stages,
+    .offset     = 0u,
+    .size       = info->push_constants_size
+  };
+  const bool has_push_constants = info->push_constants_size > 0u;
+  const VkPipelineLayoutCreateInfo vk_pipeline_layout_info = {
+    .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+    .pNext                  = NULL,
+    .flags                  = 0u,
+    .setLayoutCount         = ndescriptor_sets,
+    .pSetLayouts            = layout->vk_descriptor_set_layouts.data,
+    .pushConstantRangeCount = has_push_constants ? 1u : 0u,
+    .pPushConstantRanges    = has_push_constants ? &vk_push_constant_range
+                                                 : NULL
+  };
+  vk_err = vkCreatePipelineLayout(_vk.device, &vk_pipeline_layout_info, NULL,
+                                  &layout->vk_pipeline_layout);
+  return vk_err == VK_SUCCESS ? NGF_ERROR_OK
+                              : NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+}
+
+static void _ngf_retire_pipeline_layout(_ngf_frame_resources *res,
+                                        _ngf_pipeline_layout *layout) {
+  if (layout->vk_pipeline_layout != VK_NULL_HANDLE) {
+    _NGF_DARRAY_APPEND(res->retire_pipeline_layouts,
+                       layout->vk_pipeline_layout);
+  }
+  for (uint32_t l = 0u;
+       l < _NGF_DARRAY_SIZE(layout->vk_descriptor_set_layouts);
+       ++l) {
+    VkDescriptorSetLayout set_layout =
+        _NGF_DARRAY_AT(layout->vk_descriptor_set_layouts, l);
+    if (set_layout != VK_NULL_HANDLE) {
+      _NGF_DARRAY_APPEND(res->retire_dset_layouts, set_layout);
+    }
+  }
+  _NGF_DARRAY_DESTROY(layout->vk_descriptor_set_layouts);
+  _NGF_DARRAY_DESTROY(layout->desc_set_sizes);
+}
+
 ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
                                        ngf_graphics_pipeline            *result) {
   assert(info);
   assert(result);
   VkVertexInputBindingDescription *vk_binding_descs = NULL;
   VkVertexInputAttributeDescription *vk_attrib_descs = NULL;
+  const uint64_t start_ns = _ngf_timeline_now();
   ngf_error err    = NGF_ERROR_OK;
   VkResult  vk_err = VK_SUCCESS;
 
   // Allocate space for the pipeline object.
-  *result = NGF_ALLOC(ngf_graphics_pipeline_t);
+  *result = NGF_ALLOC_AS(ngf_graphics_pipeline_t, NGF_ALLOCATION_PIPELINE);
   ngf_graphics_pipeline pipeline = *result;
   if (pipeline == NULL) {
     err = NGF_ERROR_OUTOFMEM;
@@ -1969,48 +2694,8 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
   // Build up Vulkan specialization structure, if necessary.
   VkSpecializationInfo vk_spec_info;
   const ngf_specialization_info *spec_info = info->spec_info;
-  if (info->spec_info) {
-    VkSpecializationMapEntry *spec_map_entries = _ngf_sa_alloc(_ngf_tmp_store(),
-                      info->spec_info->nspecializations *
-                      sizeof(VkSpecializationMapEntry));
-
-    vk_spec_info.pData         = spec_info->value_buffer;
-    vk_spec_info.mapEntryCount = spec_info->nspecializations;
-    vk_spec_info.pMapEntries   = spec_map_entries;
-            
-    size_t total_data_size = 0u;
-    for(size_t i = 0; i < spec_info->nspecializations; ++i) {
-      VkSpecializationMapEntry *vk_specialization =
-          &spec_map_entries[i];
-      const ngf_constant_specialization *specialization =
-          &spec_info->specializations[i];
-      vk_specialization->constantID = specialization->constant_id;
-      vk_specialization->offset     = specialization->offset;
-      size_t specialization_size = 0u;
-      switch(specialization->type) {
-      case NGF_TYPE_INT8:
-      case NGF_TYPE_UINT8:
-        specialization_size = 1u;
-        break;
-      case NGF_TYPE_INT16:
-      case NGF_TYPE_UINT16:
-      case NGF_TYPE_HALF_FLOAT:
-        specialization_size = 2u;
-        break;
-      case NGF_TYPE_INT32:
-      case NGF_TYPE_UINT32:
-      case NGF_TYPE_FLOAT:
-        specialization_size = 4u;
-        break;
-      case NGF_TYPE_DOUBLE:
-        specialization_size = 8u;
-        break;
-      default: assert(false);
-      }
-      vk_specialization->size = specialization_size;
-      total_data_size += specialization_size;
-    }
-    vk_spec_info.dataSize = total_data_size;
+  if (spec_info) {
+    _ngf_build_vk_spec_info(spec_info, &vk_spec_info);
   }
 
   // Prepare shader stages.
@@ -2234,66 +2919,12 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
     .pDynamicStates = dynamic_states
   };
 
-  // Descriptor set layouts.
-  _NGF_DARRAY_RESET(pipeline->vk_descriptor_set_layouts,
-                    info->layout->ndescriptor_set_layouts);
-  _NGF_DARRAY_RESET(pipeline->desc_set_sizes,
-                    info->layout->ndescriptor_set_layouts);
-  for (uint32_t s = 0u; s < info->layout->ndescriptor_set_layouts; ++s) {
-    VkDescriptorSetLayoutBinding *vk_descriptor_bindings =
-        NGF_ALLOCN(VkDescriptorSetLayoutBinding,
-                   info->layout->descriptor_set_layouts[s].ndescriptors);
-    _ngf_desc_set_size set_size;
-    memset(&set_size, 0, sizeof(set_size));
-    for (uint32_t b = 0u;
-         b < info->layout->descriptor_set_layouts[s].ndescriptors;
-         ++b) {
-      VkDescriptorSetLayoutBinding *vk_d = &vk_descriptor_bindings[b];
-      const ngf_descriptor_info *d =
-          &info->layout->descriptor_set_layouts[s].descriptors[b];
-      vk_d->binding         = d->id;
-      vk_d->descriptorCount = 1u;
-      vk_d->descriptorType  = get_vk_descriptor_type(d->type);
-      vk_d->descriptorCount = 1u;
-      vk_d->stageFlags      = get_vk_stage_flags(d->stage_flags);
-      vk_d->pImmutableSamplers = NULL;
-      set_size.counts[d->type]++;
-    }
-    const VkDescriptorSetLayoutCreateInfo vk_ds_info = {
-      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-      .pNext = NULL,
-      .flags = 0u,
-      .bindingCount = info->layout->descriptor_set_layouts[s].ndescriptors,
-      .pBindings = vk_descriptor_bindings
-    };
-    VkDescriptorSetLayout result_dsl = VK_NULL_HANDLE;
-    vk_err = vkCreateDescriptorSetLayout(_vk.device, &vk_ds_info, NULL,
-                                         &result_dsl);
-    _NGF_DARRAY_APPEND(pipeline->vk_descriptor_set_layouts, result_dsl);
-    _NGF_DARRAY_APPEND(pipeline->desc_set_sizes, set_size);
-    NGF_FREEN(vk_descriptor_bindings,
-              info->layout->descriptor_set_layouts[s].ndescriptors);
-    if (vk_err != VK_SUCCESS) {
-      assert(false);
-      // TODO: return error here.
-    }
+  // Descriptor set layouts and pipeline layout.
+  err = _ngf_create_pipeline_layout(info->layout, &pipeline->layout);
+  if (err != NGF_ERROR_OK) {
+    goto ngf_create_graphics_pipeline_cleanup;
   }
 
-  // Pipeline layout.
-  const uint32_t ndescriptor_sets =
-      _NGF_DARRAY_SIZE(pipeline->vk_descriptor_set_layouts);
-  const VkPipelineLayoutCreateInfo vk_pipeline_layout_info = {
-    .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-    .pNext                  = NULL,
-    .flags                  = 0u,
-    .setLayoutCount         = ndescriptor_sets,
-    .pSetLayouts            = pipeline->vk_descriptor_set_layouts.data,
-    .pushConstantRangeCount = 0u,
-    .pPushConstantRanges    = NULL
-  };
-  vk_err = vkCreatePipelineLayout(_vk.device, &vk_pipeline_layout_info, NULL,
-                                  &pipeline->vk_pipeline_layout);
-  assert(vk_err == VK_SUCCESS);
   VkGraphicsPipelineCreateInfo vk_pipeline_info = {
     .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
     .pNext = NULL,
@@ -2309,7 +2940,7 @@ ngf_error ngf_create_graphics_pipeline(const ngf_graphics_pipeline_info *info,
     .pDepthStencilState = &depth_stencil,
     .pColorBlendState = &color_blend,
     .pDynamicState = &dynamic_state,
-    .layout = pipeline->vk_pipeline_layout,
+    .layout = pipeline->layout.vk_pipeline_layout,
     .renderPass = info->compatible_render_target->render_pass,
     .subpass = 0u,
     .basePipelineHandle = VK_NULL_HANDLE,
@@ -2335,6 +2966,7 @@ ngf_create_graphics_pipeline_cleanup:
   }
   NGF_FREE(vk_binding_descs);
   NGF_FREE(vk_attrib_descs);
+  _ngf_timeline_scope("ngf_create_graphics_pipeline", start_ns);
   return err;  
 }
 
@@ -2345,19 +2977,81 @@ void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline p) {
     if (p->vk_pipeline != VK_NULL_HANDLE) {
       _NGF_DARRAY_APPEND(res->retire_pipelines, p->vk_pipeline);
     }
-    if (p->vk_pipeline_layout != VK_NULL_HANDLE) {
-      _NGF_DARRAY_APPEND(res->retire_pipeline_layouts, p->vk_pipeline_layout);
-    }
-    for (uint32_t l = 0u; l < _NGF_DARRAY_SIZE(p->vk_descriptor_set_layouts);
-         ++l) {
-      VkDescriptorSetLayout set_layout =
-          _NGF_DARRAY_AT(p->vk_descriptor_set_layouts, l);
-      if (set_layout != VK_NULL_HANDLE) {
-        _NGF_DARRAY_APPEND(res->retire_dset_layouts, set_layout);
-      }
+    _ngf_retire_pipeline_layout(res, &p->layout);
+    NGF_FREE_AS(p, NGF_ALLOCATION_PIPELINE);
+  }
+}
+
+ngf_error ngf_create_compute_pipeline(const ngf_compute_pipeline_info *info,
+                                      ngf_compute_pipeline            *result) {
+  assert(info);
+  assert(result);
+  const uint64_t start_ns = _ngf_timeline_now();
+  ngf_error err = NGF_ERROR_OK;
+
+  *result = NGF_ALLOC_AS(ngf_compute_pipeline_t, NGF_ALLOCATION_PIPELINE);
+  ngf_compute_pipeline pipeline = *result;
+  if (pipeline == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  pipeline->vk_pipeline = VK_NULL_HANDLE;
+
+  VkSpecializationInfo vk_spec_info;
+  if (info->spec_info) {
+    _ngf_build_vk_spec_info(info->spec_info, &vk_spec_info);
+  }
+
+  err = _ngf_create_pipeline_layout(info->layout, &pipeline->layout);
+  if (err != NGF_ERROR_OK) {
+    goto ngf_create_compute_pipeline_cleanup;
+  }
+
+  const ngf_shader_stage stage = info->shader_stage;
+  const VkComputePipelineCreateInfo vk_pipeline_info = {
+    .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+    .pNext = NULL,
+    .flags = 0u,
+    .stage = {
+      .sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+      .pNext  = NULL,
+      .flags  = 0u,
+      .stage  = stage->vk_stage_bits,
+      .module = stage->vk_module,
+      .pName  = stage->entry_point_name,
+      .pSpecializationInfo = info->spec_info ? &vk_spec_info : NULL
+    },
+    .layout = pipeline->layout.vk_pipeline_layout,
+    .basePipelineHandle = VK_NULL_HANDLE,
+    .basePipelineIndex = -1
+  };
+  const VkResult vk_err =
+      vkCreateComputePipelines(_vk.device,
+                               VK_NULL_HANDLE,
+                               1u,
+                               &vk_pipeline_info,
+                               NULL,
+                               &pipeline->vk_pipeline);
+  if (vk_err != VK_SUCCESS) {
+    err = NGF_ERROR_FAILED_TO_CREATE_PIPELINE;
+  }
+
+ngf_create_compute_pipeline_cleanup:
+  if (err != NGF_ERROR_OK) {
+    ngf_destroy_compute_pipeline(pipeline);
+  }
+  _ngf_timeline_scope("ngf_create_compute_pipeline", start_ns);
+  return err;
+}
+
+void ngf_destroy_compute_pipeline(ngf_compute_pipeline p) {
+  if (p != NULL) {
+    _ngf_frame_resources *res =
+        &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_number];
+    if (p->vk_pipeline != VK_NULL_HANDLE) {
+      _NGF_DARRAY_APPEND(res->retire_pipelines, p->vk_pipeline);
     }
-    _NGF_DARRAY_DESTROY(p->vk_descriptor_set_layouts);
-    NGF_FREE(p);
+    _ngf_retire_pipeline_layout(res, &p->layout);
+    NGF_FREE_AS(p, NGF_ALLOCATION_PIPELINE);
   }
 }
 
@@ -2480,6 +3174,9 @@ void ngf_cmd_begin_pass(ngf_render_encoder enc, const ngf_render_target target)
      }
   };
   buf->active_rt = target;
+  buf->pass_scope_depth = _ngf_gpu_timing_cmd_depth(buf);
+  _ngf_gpu_timing_begin(buf, "pass");
+  buf->nfixed_scopes = _ngf_gpu_timing_cmd_depth(buf);
   vkCmdBeginRenderPass(buf->active_bundle.vkcmdbuf,
                       &begin_info,
                        VK_SUBPASS_CONTENTS_INLINE);
@@ -2488,9 +3185,45 @@ void ngf_cmd_begin_pass(ngf_render_encoder enc, const ngf_render_target target)
 void ngf_cmd_end_pass(ngf_render_encoder enc) {
   ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
   vkCmdEndRenderPass(buf->active_bundle.vkcmdbuf);
+  // Close the pass's own scope, along with any debug groups opened within the
+  // pass. Debug groups opened around the pass are closed with the encoder.
+  _ngf_gpu_timing_end(buf, buf->pass_scope_depth);
   _ngf_encoder_end(buf);
 }
 
+// Debug groups can only be opened and closed while the encoder is recording,
+// and can't close the scopes of the encoder or pass they're nested in.
+static void _ngf_cmd_begin_debug_group(ngf_cmd_buffer buf, const char *name) {
+  assert(name);
+  if (buf->state == _NGF_CMD_BUFFER_RECORDING) {
+    _ngf_gpu_timing_begin(buf, name);
+  }
+}
+
+static void _ngf_cmd_end_debug_group(ngf_cmd_buffer buf) {
+  const uint32_t depth = _ngf_gpu_timing_cmd_depth(buf);
+  if (buf->state == _NGF_CMD_BUFFER_RECORDING && depth > buf->nfixed_scopes) {
+    _ngf_gpu_timing_end(buf, depth - 1u);
+  }
+}
+
+void ngf_cmd_begin_debug_group(ngf_render_encoder enc, const char *name) {
+  _ngf_cmd_begin_debug_group(_ENC2CMDBUF(enc), name);
+}
+
+void ngf_cmd_end_debug_group(ngf_render_encoder enc) {
+  _ngf_cmd_end_debug_group(_ENC2CMDBUF(enc));
+}
+
+void ngf_cmd_begin_compute_debug_group(ngf_compute_encoder enc,
+                                       const char *name) {
+  _ngf_cmd_begin_debug_group(_ENC2CMDBUF(enc), name);
+}
+
+void ngf_cmd_end_compute_debug_group(ngf_compute_encoder enc) {
+  _ngf_cmd_end_debug_group(_ENC2CMDBUF(enc));
+}
+
 void ngf_cmd_draw(ngf_render_encoder enc,
                   bool               indexed,
                   uint32_t           first_element,
@@ -2503,6 +3236,49 @@ void ngf_cmd_draw(ngf_render_encoder enc,
   } else {
     vkCmdDraw(buf->active_bundle.vkcmdbuf, nelements, ninstances, first_element, 0u);
   }
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, 1u);
+  _NGF_STAT_ADD(_NGF_STAT_INSTANCES, ninstances);
+}
+
+void ngf_cmd_push_constants(ngf_render_encoder enc,
+                            const void        *data,
+                            uint32_t           offset,
+                            uint32_t           size) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  assert(buf->active_pipe);
+  vkCmdPushConstants(buf->active_bundle.vkcmdbuf,
+                     buf->active_pipe->layout.vk_pipeline_layout,
+                     buf->active_pipe->layout.push_constants_stages,
+                     offset, size, data);
+}
+
+void ngf_cmd_draw_indirect(ngf_render_encoder      enc,
+                           bool                    indexed,
+                           const ngf_attrib_buffer args,
+                           size_t                  offset,
+                           uint32_t                ndraws,
+                           uint32_t                stride) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  if (stride == 0u) {
+    stride = indexed ? sizeof(ngf_draw_indexed_indirect_args)
+                     : sizeof(ngf_draw_indirect_args);
+  }
+  // Without multiDrawIndirect, drawCount must be 0 or 1, so the draws are
+  // issued one by one.
+  const bool     multi_draw = _vk.enabled_features.multiDrawIndirect;
+  const uint32_t ncmds = multi_draw ? 1u : ndraws;
+  const uint32_t draws_per_cmd = multi_draw ? ndraws : 1u;
+  for (uint32_t d = 0u; d < ncmds; ++d) {
+    const VkDeviceSize args_offset = offset + (VkDeviceSize)d * stride;
+    if (indexed) {
+      vkCmdDrawIndexedIndirect(buf->active_bundle.vkcmdbuf, args->data.vkbuf,
+                               args_offset, draws_per_cmd, stride);
+    } else {
+      vkCmdDrawIndirect(buf->active_bundle.vkcmdbuf, args->data.vkbuf,
+                        args_offset, draws_per_cmd, stride);
+    }
+  }
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, ndraws);
 }
 
 void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder          enc,
@@ -2511,20 +3287,19 @@ void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder          enc,
   buf->active_pipe = pipeline;
   vkCmdBindPipeline(buf->active_bundle.vkcmdbuf, VK_PIPELINE_BIND_POINT_GRAPHICS,
                     pipeline->vk_pipeline);
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
 }
 
-void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
-                                const ngf_resource_bind_op *bind_operations,
-                                uint32_t                    nbind_operations) {
-  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
-
-  // Binding resources requires an active pipeline.
-  ngf_graphics_pipeline active_pipe = buf->active_pipe;
-  assert(active_pipe);
-
+static void _ngf_cmd_bind_resources(
+    ngf_cmd_buffer              buf,
+    const _ngf_pipeline_layout *layout,
+    VkPipelineBindPoint         bind_point,
+    const ngf_resource_bind_op *bind_operations,
+    uint32_t                    nbind_operations) {
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, nbind_operations);
   // Get the number of active descriptor set layouts in the pipeline.
   const uint32_t ndesc_set_layouts = 
-      _NGF_DARRAY_SIZE(active_pipe->vk_descriptor_set_layouts);
+      _NGF_DARRAY_SIZE(layout->vk_descriptor_set_layouts);
 
   // Reset temp. storage to make sure we have all of it available.
   _ngf_sa_reset(_ngf_tmp_store());
@@ -2572,7 +3347,7 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
         // Check if the active descriptor pool can fit the required descriptor
         // set.
         const _ngf_desc_set_size *set_size =
-            &_NGF_DARRAY_AT(buf->active_pipe->desc_set_sizes,
+            &_NGF_DARRAY_AT(layout->desc_set_sizes,
                             bind_op->target_set);
        _ngf_desc_pool                 *pool     =  superpool->active_pool;
         const _ngf_desc_pool_capacity *capacity = &pool->capacity;
@@ -2618,7 +3393,8 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
           };
 
           // Create the new pool.
-         _ngf_desc_pool *new_pool = NGF_ALLOC(_ngf_desc_pool);
+         _ngf_desc_pool *new_pool =
+             NGF_ALLOC_AS(_ngf_desc_pool, NGF_ALLOCATION_DESCRIPTOR_POOL);
           new_pool->next     = NULL;
           new_pool->capacity = capacity;
           memset(&new_pool->utilization, 0, sizeof(new_pool->utilization));
@@ -2628,6 +3404,7 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
                                     NULL,
                                    &new_pool->vk_pool);
           if (vk_pool_create_result == VK_SUCCESS) {
+            _NGF_STAT_ADD(_NGF_STAT_DESCRIPTOR_POOLS_CREATED, 1u);
             if (superpool->active_pool != NULL) {
               superpool->active_pool->next = new_pool;
             } else {
@@ -2635,7 +3412,7 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
             }
             superpool->active_pool = new_pool;
           } else {
-            NGF_FREE(new_pool);
+            NGF_FREE_AS(new_pool, NGF_ALLOCATION_DESCRIPTOR_POOL);
             assert(false);
           }
         } else {
@@ -2650,7 +3427,7 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
         .descriptorPool     = superpool->active_pool->vk_pool,
         .descriptorSetCount = 1u,
         .pSetLayouts        = &_NGF_DARRAY_AT(
-                                  active_pipe->vk_descriptor_set_layouts,
+                                  layout->vk_descriptor_set_layouts,
                                   bind_op->target_set)
       };
       const VkResult desc_set_alloc_result =
@@ -2660,6 +3437,7 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
       if (desc_set_alloc_result != VK_SUCCESS) {
         exit(1); // TODO
       }
+      _NGF_STAT_ADD(_NGF_STAT_DESCRIPTOR_SETS_ALLOCATED, 1u);
     }
     VkDescriptorSet set =  vk_sets[bind_op->target_set];
 
@@ -2676,7 +3454,8 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
     vk_write->descriptorType  = get_vk_descriptor_type(bind_op->type);
 
     switch(bind_op->type) {
-    case NGF_DESCRIPTOR_UNIFORM_BUFFER: {
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER:
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC: {
       const ngf_uniform_buffer_bind_info *bind_info =
           &bind_op->info.uniform_buffer;
       VkDescriptorBufferInfo *vk_bind_info =
@@ -2701,8 +3480,11 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
       vk_bind_info->sampler     = VK_NULL_HANDLE;
       if (bind_op->type == NGF_DESCRIPTOR_TEXTURE ||
           bind_op->type == NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER) {
-        vk_bind_info->imageView   = bind_info->image_subresource.image->vkview;
-        vk_bind_info->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        const ngf_image img = bind_info->image_subresource.image;
+        vk_bind_info->imageView   = img->vkview;
+        vk_bind_info->imageLayout =
+            img->storage ? VK_IMAGE_LAYOUT_GENERAL
+                         : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
       }
       if (bind_op->type == NGF_DESCRIPTOR_SAMPLER ||
           bind_op->type == NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER) {
@@ -2711,6 +3493,34 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
       vk_write->pImageInfo = vk_bind_info;
       break;
     }
+    case NGF_DESCRIPTOR_STORAGE_BUFFER: {
+      const ngf_storage_buffer_bind_info *bind_info =
+          &bind_op->info.storage_buffer;
+      VkDescriptorBufferInfo *vk_bind_info =
+          _ngf_sa_alloc(_ngf_tmp_store(), sizeof(VkDescriptorBufferInfo));
+
+      vk_bind_info->buffer = bind_info->buffer->data.vkbuf;
+      vk_bind_info->offset = bind_info->offset;
+      vk_bind_info->range  = bind_info->range;
+
+      vk_write->pBufferInfo = vk_bind_info;
+      break;
+    }
+    case NGF_DESCRIPTOR_STORAGE_IMAGE: {
+      VkDescriptorImageInfo *vk_bind_info =
+          _ngf_sa_alloc(_ngf_tmp_store(), sizeof(VkDescriptorImageInfo));
+      // Storage image descriptors refer to a single mip level. Images have a
+      // single layer (see _ngf_vk_image_create_info).
+      const ngf_image_ref *ref = &bind_op->info.storage_image;
+      assert(ref->image->storage);
+      assert(ref->mip_level < ref->image->nmips);
+      assert(ref->layer == 0u);
+      vk_bind_info->imageView   = ref->image->mip_views[ref->mip_level];
+      vk_bind_info->imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+      vk_bind_info->sampler     = VK_NULL_HANDLE;
+      vk_write->pImageInfo = vk_bind_info;
+      break;
+    }
        
       // TODO: handle other descriptor types.
     default:
@@ -2724,21 +3534,127 @@ void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
 
   // bind each of the descriptor sets individually (this ensures that desc.
   // sets bound for a compatible pipeline earlier in this command buffer
-  // don't get clobbered).
+  // don't get clobbered). Dynamic uniform buffers start out at their base
+  // offsets.
   for (uint32_t s = 0; s < ndesc_set_layouts; ++s) {
     if (vk_sets[s] != VK_NULL_HANDLE) {
+      const uint32_t ndynamic_offsets =
+          _NGF_DARRAY_AT(layout->desc_set_sizes, s)
+              .counts[NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC];
+      uint32_t *dynamic_offsets = NULL;
+      if (ndynamic_offsets > 0u) {
+        dynamic_offsets = _ngf_sa_alloc(_ngf_tmp_store(),
+                                        sizeof(uint32_t) * ndynamic_offsets);
+        memset(dynamic_offsets, 0, sizeof(uint32_t) * ndynamic_offsets);
+      }
       vkCmdBindDescriptorSets(buf->active_bundle.vkcmdbuf,
-                              VK_PIPELINE_BIND_POINT_GRAPHICS,
-                              active_pipe->vk_pipeline_layout,
+                              bind_point,
+                              layout->vk_pipeline_layout,
                               s,
                               1,
                              &vk_sets[s],
-                              0,
-                              NULL);
+                              ndynamic_offsets,
+                              dynamic_offsets);
+      if (s < _NGF_MAX_BOUND_DESC_SETS) {
+        assert((uint32_t)bind_point < _NGF_NUM_BIND_POINTS);
+        buf->bound_desc_sets[bind_point][s] = vk_sets[s];
+      }
     }
   }
 }
 
+void ngf_cmd_bind_gfx_resources(ngf_render_encoder          enc,
+                                const ngf_resource_bind_op *bind_operations,
+                                uint32_t                    nbind_operations) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+
+  // Binding resources requires an active pipeline.
+  assert(buf->active_pipe);
+  _ngf_cmd_bind_resources(buf, &buf->active_pipe->layout,
+                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          bind_operations, nbind_operations);
+}
+
+void ngf_cmd_set_dynamic_offsets(ngf_render_encoder enc,
+                                 uint32_t           set,
+                                 const uint32_t    *offsets,
+                                 uint32_t           noffsets) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  assert(buf->active_pipe);
+  assert(set < _NGF_MAX_BOUND_DESC_SETS);
+  VkDescriptorSet *bound_set =
+      &buf->bound_desc_sets[VK_PIPELINE_BIND_POINT_GRAPHICS][set];
+  assert(*bound_set != VK_NULL_HANDLE);
+  // Vulkan requires exactly one offset per dynamic descriptor in the set.
+  const _ngf_pipeline_layout *layout = &buf->active_pipe->layout;
+  assert(set < _NGF_DARRAY_SIZE(layout->desc_set_sizes));
+  const uint32_t ndynamic_offsets =
+      _NGF_DARRAY_AT(layout->desc_set_sizes, set)
+          .counts[NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC];
+  assert(noffsets == ndynamic_offsets);
+  if (noffsets != ndynamic_offsets) {
+    return;
+  }
+  // Re-binding the same set with new dynamic offsets doesn't require any
+  // descriptor writes.
+  vkCmdBindDescriptorSets(buf->active_bundle.vkcmdbuf,
+                          VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          layout->vk_pipeline_layout,
+                          set,
+                          1,
+                          bound_set,
+                          noffsets,
+                          offsets);
+}
+
+void ngf_cmd_bind_compute_pipeline(ngf_compute_encoder        enc,
+                                   const ngf_compute_pipeline pipeline) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  buf->active_compute_pipe = pipeline;
+  vkCmdBindPipeline(buf->active_bundle.vkcmdbuf, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    pipeline->vk_pipeline);
+  _NGF_STAT_ADD(_NGF_STAT_PIPELINE_BINDS, 1u);
+}
+
+void ngf_cmd_bind_compute_resources(ngf_compute_encoder         enc,
+                                    const ngf_resource_bind_op *bind_operations,
+                                    uint32_t                    nbind_operations) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+
+  // Binding resources requires an active pipeline.
+  assert(buf->active_compute_pipe);
+  _ngf_cmd_bind_resources(buf, &buf->active_compute_pipe->layout,
+                          VK_PIPELINE_BIND_POINT_COMPUTE,
+                          bind_operations, nbind_operations);
+}
+
+void ngf_cmd_push_compute_constants(ngf_compute_encoder enc,
+                                    const void         *data,
+                                    uint32_t            offset,
+                                    uint32_t            size) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  assert(buf->active_compute_pipe);
+  vkCmdPushConstants(buf->active_bundle.vkcmdbuf,
+                     buf->active_compute_pipe->layout.vk_pipeline_layout,
+                     buf->active_compute_pipe->layout.push_constants_stages,
+                     offset, size, data);
+}
+
+void ngf_cmd_dispatch(ngf_compute_encoder enc,
+                      uint32_t            ngroups_x,
+                      uint32_t            ngroups_y,
+                      uint32_t            ngroups_z) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  vkCmdDispatch(buf->active_bundle.vkcmdbuf, ngroups_x, ngroups_y, ngroups_z);
+}
+
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder     enc,
+                               const ngf_attrib_buffer args,
+                               size_t                  offset) {
+  ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
+  vkCmdDispatchIndirect(buf->active_bundle.vkcmdbuf, args->data.vkbuf, offset);
+}
+
 void ngf_cmd_viewport(ngf_render_encoder enc, const ngf_irect2d *r) {
   ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
   const VkViewport viewport = {
@@ -2777,6 +3693,7 @@ void ngf_cmd_bind_attrib_buffer(ngf_render_encoder      enc,
                          1,
                         &abuf->data.vkbuf,
                         &vkoffset);
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, 1u);
 }
 
 void ngf_cmd_bind_index_buffer(ngf_render_encoder     enc,
@@ -2790,6 +3707,7 @@ void ngf_cmd_bind_index_buffer(ngf_render_encoder     enc,
                        ibuf->data.vkbuf,
                        0u,
                        idx_type);
+  _NGF_STAT_ADD(_NGF_STAT_RESOURCE_BINDS, 1u);
 }
 
 static void _ngf_cmd_copy_buffer(VkCommandBuffer      vkcmdbuf,
@@ -2812,6 +3730,7 @@ static void _ngf_cmd_copy_buffer(VkCommandBuffer      vkcmdbuf,
                   dst,
                   1u,
                  &copy_region);
+  _NGF_STAT_ADD(_NGF_STAT_BYTES_UPLOADED, size);
 /*
   VkBufferMemoryBarrier buf_mem_bar = {
     .sType               =  VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
@@ -2897,12 +3816,18 @@ void ngf_cmd_write_image(ngf_xfer_encoder       enc,
                          const ngf_extent3d    *extent) {
   ngf_cmd_buffer buf = _ENC2CMDBUF(enc);
   assert(buf);
+  // Storage images are kept in the GENERAL layout, so the other mip levels
+  // keep their contents.
+  const VkImageLayout shader_layout =
+      dst.image->storage ? VK_IMAGE_LAYOUT_GENERAL
+                         : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
   const VkImageMemoryBarrier pre_xfer_barrier = {
     .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
     .pNext               = NULL,
     .srcAccessMask       = VK_ACCESS_TRANSFER_READ_BIT, 
     .dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
-    .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+    .oldLayout           = dst.image->storage ? VK_IMAGE_LAYOUT_GENERAL
+                                              : VK_IMAGE_LAYOUT_UNDEFINED,
     .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -2954,7 +3879,7 @@ void ngf_cmd_write_image(ngf_xfer_encoder       enc,
     .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
     .dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
     .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-    .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    .newLayout           = shader_layout,
     .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED, 
     .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
     .image               = dst.image->vkimg,
@@ -3022,11 +3947,18 @@ static ngf_error _ngf_create_buffer(size_t                 size,
                                       vma_alloc,
                                       NULL);
   *vma_allocator = CURRENT_CONTEXT->allocator;
-  return (vkresult == VK_SUCCESS) ? NGF_ERROR_OK : NGF_ERROR_INVALID_OPERATION;
+  if (vkresult != VK_SUCCESS) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  _NGF_STAT_ADD(_NGF_STAT_BUFFERS_CREATED, 1u);
+  return NGF_ERROR_OK;
 }
 
-static void* _ngf_map_buffer(VmaAllocation alloc, size_t offset) {
+static void* _ngf_map_buffer(VmaAllocation alloc,
+                             size_t        offset,
+                             size_t        size) {
   void* result = NULL;
+  _NGF_STAT_ADD(_NGF_STAT_BYTES_MAPPED, size);
   VkResult vkresult = vmaMapMemory(CURRENT_CONTEXT->allocator,
                                    alloc,
                                   &result);
@@ -3089,6 +4021,7 @@ void ngf_destroy_attrib_buffer(ngf_attrib_buffer buffer) {
   if (buffer) {
     _NGF_DARRAY_APPEND(CURRENT_CONTEXT->frame_res->retire_buffers,
                        buffer->data);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buffer);
   }
 }
@@ -3097,8 +4030,8 @@ void* ngf_attrib_buffer_map_range(ngf_attrib_buffer buf,
                                   size_t            offset,
                                   size_t            size,
                                   uint32_t          flags) {
-  _NGF_FAKE_USE(size, flags);
-  return _ngf_map_buffer(buf->data.alloc, offset);
+  _NGF_FAKE_USE(flags);
+  return _ngf_map_buffer(buf->data.alloc, offset, size);
 }
 
 void ngf_attrib_buffer_flush_range(ngf_attrib_buffer buf,
@@ -3151,6 +4084,7 @@ void ngf_destroy_index_buffer(ngf_index_buffer buffer) {
   if (buffer) {
     _NGF_DARRAY_APPEND(CURRENT_CONTEXT->frame_res->retire_buffers,
                        buffer->data);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buffer);
   }
 }
@@ -3159,8 +4093,8 @@ void* ngf_index_buffer_map_range(ngf_index_buffer buf,
                                  size_t           offset,
                                  size_t           size,
                                  uint32_t         flags) {
-  _NGF_FAKE_USE(size, flags);
-  return _ngf_map_buffer(buf->data.alloc, offset);
+  _NGF_FAKE_USE(flags);
+  return _ngf_map_buffer(buf->data.alloc, offset, size);
 }
 
 void ngf_index_buffer_flush_range(ngf_index_buffer buf,
@@ -3213,6 +4147,7 @@ void ngf_destroy_uniform_buffer(ngf_uniform_buffer buffer) {
   if (buffer) {
     _NGF_DARRAY_APPEND(CURRENT_CONTEXT->frame_res->retire_buffers,
                        buffer->data);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buffer);
   }
 }
@@ -3221,8 +4156,8 @@ void* ngf_uniform_buffer_map_range(ngf_uniform_buffer buf,
                                    size_t             offset,
                                    size_t             size,
                                    uint32_t           flags) {
-  _NGF_FAKE_USE(size, flags);
-  return _ngf_map_buffer(buf->data.alloc, offset);
+  _NGF_FAKE_USE(flags);
+  return _ngf_map_buffer(buf->data.alloc, offset, size);
 }
 
 void ngf_uniform_buffer_flush_range(ngf_uniform_buffer buf,
@@ -3266,6 +4201,7 @@ void ngf_destroy_pixel_buffer(ngf_pixel_buffer buf) {
   if (buf) {
     _NGF_DARRAY_APPEND(CURRENT_CONTEXT->frame_res->retire_buffers,
                        buf->data);
+    _NGF_STAT_ADD(_NGF_STAT_BUFFERS_DESTROYED, 1u);
     NGF_FREE(buf);
   }
 }
@@ -3274,8 +4210,8 @@ void* ngf_pixel_buffer_map_range(ngf_pixel_buffer buf,
                                  size_t offset,
                                  size_t size,
                                  uint32_t flags) {
-  _NGF_FAKE_USE(size, flags);
-  return _ngf_map_buffer(buf->data.alloc, offset);
+  _NGF_FAKE_USE(flags);
+  return _ngf_map_buffer(buf->data.alloc, offset, size);
 }
 
 void ngf_pixel_buffer_flush_range(ngf_pixel_buffer buf,
@@ -3288,15 +4224,18 @@ void ngf_pixel_buffer_unmap(ngf_pixel_buffer buf) {
   _ngf_unmap_buffer(buf->data.alloc);
 }
 
-ngf_error ngf_create_image(const ngf_image_info *info,
-                           ngf_image *result) {
-  assert(info);
-  assert(result);
-
+// Fills out the parameters for creating a VkImage. Queue family indices are
+// written to `queue_family_indices`, which must outlive the result.
+static void _ngf_vk_image_create_info(const ngf_image_info *info,
+                                      uint32_t queue_family_indices[2],
+                                      VkImageCreateInfo *result) {
   VkImageUsageFlagBits usage_flags = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
   if (info->usage_hint & NGF_IMAGE_USAGE_SAMPLE_FROM) {
     usage_flags |= VK_IMAGE_USAGE_SAMPLED_BIT;
   }
+  if (info->usage_hint & NGF_IMAGE_USAGE_STORAGE) {
+    usage_flags |= VK_IMAGE_USAGE_STORAGE_BIT;
+  }
   if (info->usage_hint & NGF_IMAGE_USAGE_ATTACHMENT) {
     if (info->format == NGF_IMAGE_FORMAT_DEPTH32 ||
         info->format == NGF_IMAGE_FORMAT_DEPTH16 ||
@@ -3307,18 +4246,9 @@ ngf_error ngf_create_image(const ngf_image_info *info,
     }
   }
 
-  ngf_error err = NGF_ERROR_OK;
-  *result = NGF_ALLOC(ngf_image_t);
-  ngf_image img = *result;
-  if (img == NULL) {
-    err = NGF_ERROR_OUTOFMEM;
-    goto ngf_create_image_cleanup;
-  }
   const bool exclusive_sharing = (_vk.gfx_family_idx == _vk.xfer_family_idx);
-  const uint32_t queue_family_indices[] = { _vk.gfx_family_idx,
-                                            _vk.xfer_family_idx
-                                          };
-
+  queue_family_indices[0] = _vk.gfx_family_idx;
+  queue_family_indices[1] = _vk.xfer_family_idx;
   const uint32_t nqueue_family_indices = exclusive_sharing ? 1u : 2u;
   const VkSharingMode sharing_mode =
       exclusive_sharing ? VK_SHARING_MODE_EXCLUSIVE
@@ -3344,6 +4274,25 @@ ngf_error ngf_create_image(const ngf_image_info *info,
     .pQueueFamilyIndices = queue_family_indices,
     .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
   };
+  *result = vk_image_info;
+}
+
+ngf_error ngf_create_image(const ngf_image_info *info,
+                           ngf_image *result) {
+  assert(info);
+  assert(result);
+
+  ngf_error err = NGF_ERROR_OK;
+  *result = NGF_ALLOC(ngf_image_t);
+  ngf_image img = *result;
+  if (img == NULL) {
+    err = NGF_ERROR_OUTOFMEM;
+    goto ngf_create_image_cleanup;
+  }
+  memset(img, 0, sizeof(*img));
+  uint32_t queue_family_indices[2];
+  VkImageCreateInfo vk_image_info;
+  _ngf_vk_image_create_info(info, queue_family_indices, &vk_image_info);
 
   VmaAllocationCreateInfo vma_alloc_info = {
     .flags = 0u,
@@ -3366,9 +4315,11 @@ ngf_error ngf_create_image(const ngf_image_info *info,
     err = NGF_ERROR_IMAGE_CREATION_FAILED;
     goto ngf_create_image_cleanup;
   }
+  _NGF_STAT_ADD(_NGF_STAT_IMAGES_CREATED, 1u);
   err = _ngf_create_vk_image_view(img->vkimg,
                                   vk_image_info.imageType,
                                   vk_image_info.format,
+                                  0u,
                                   vk_image_info.mipLevels,
                                   vk_image_info.arrayLayers,
                                  &img->vkview);
@@ -3376,6 +4327,9 @@ ngf_error ngf_create_image(const ngf_image_info *info,
   if (err != NGF_ERROR_OK) {
     goto ngf_create_image_cleanup;
   }
+  if (info->usage_hint & NGF_IMAGE_USAGE_STORAGE) {
+    err = _ngf_init_storage_image(img, &vk_image_info);
+  }
 
 ngf_create_image_cleanup:
   if (err != NGF_ERROR_OK) {
@@ -3387,15 +4341,152 @@ ngf_create_image_cleanup:
 
 void ngf_destroy_image(ngf_image img) {
   if (img != NULL) {
+    _ngf_destroy_storage_image_views(img);
     if (img->vkimg != VK_NULL_HANDLE) {
       // TODO: retire queue for images
       vmaDestroyImage(CURRENT_CONTEXT->allocator,
                       img->vkimg, img->alloc);
       vkDestroyImageView(_vk.device, img->vkview, NULL);
+      _NGF_STAT_ADD(_NGF_STAT_IMAGES_DESTROYED, 1u);
     }
   }
 }
 
+// Transient images don't own their memory. Instead, they're bound to memory
+// blocks that are shared with other transient images, as long as their
+// lifetimes don't overlap.
+static void _ngf_destroy_transient_image(ngf_image img) {
+  if (img != NULL) {
+    _ngf_destroy_storage_image_views(img);
+    if (img->vkview != VK_NULL_HANDLE) {
+      vkDestroyImageView(_vk.device, img->vkview, NULL);
+    }
+    if (img->vkimg != VK_NULL_HANDLE) {
+      vkDestroyImage(_vk.device, img->vkimg, NULL);
+      _NGF_STAT_ADD(_NGF_STAT_IMAGES_DESTROYED, 1u);
+    }
+    NGF_FREE(img);
+  }
+}
+
+static void _ngf_free_transient_block(const _ngf_transient_block *block) {
+  vmaFreeMemory(CURRENT_CONTEXT->allocator, (VmaAllocation)block->mem);
+}
+
+static ngf_error _ngf_create_transient_image(
+    ngf_transient_pool              pool,
+    const ngf_transient_image_info *info,
+    ngf_image                      *result,
+    uint32_t                       *block) {
+  ngf_error err = NGF_ERROR_OK;
+  ngf_image img = NGF_ALLOC(ngf_image_t);
+  if (img == NULL) {
+    err = NGF_ERROR_OUTOFMEM;
+    goto _ngf_create_transient_image_cleanup;
+  }
+  memset(img, 0, sizeof(*img));
+
+  uint32_t queue_family_indices[2];
+  VkImageCreateInfo vk_image_info;
+  _ngf_vk_image_create_info(&info->image_info, queue_family_indices,
+                            &vk_image_info);
+  if (vkCreateImage(_vk.device, &vk_image_info, NULL, &img->vkimg) !=
+      VK_SUCCESS) {
+    err = NGF_ERROR_IMAGE_CREATION_FAILED;
+    goto _ngf_create_transient_image_cleanup;
+  }
+  _NGF_STAT_ADD(_NGF_STAT_IMAGES_CREATED, 1u);
+
+  // Bind to a block whose images are done by the time this one is needed,
+  // or to a new one if there is no such block.
+  VkMemoryRequirements mem_reqs;
+  vkGetImageMemoryRequirements(_vk.device, img->vkimg, &mem_reqs);
+  if (!_ngf_transient_find_block(pool, mem_reqs.size, mem_reqs.alignment,
+                                 mem_reqs.memoryTypeBits, info->first_use,
+                                 block)) {
+    const VmaAllocationCreateInfo vma_alloc_info = {
+      .flags = 0u,
+      .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+      .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      .preferredFlags = 0u,
+      .memoryTypeBits = 0u,
+      .pool = VK_NULL_HANDLE,
+      .pUserData = NULL
+    };
+    VmaAllocation alloc = VK_NULL_HANDLE;
+    VmaAllocationInfo alloc_info;
+    if (vmaAllocateMemory(CURRENT_CONTEXT->allocator, &mem_reqs,
+                          &vma_alloc_info, &alloc, &alloc_info) !=
+        VK_SUCCESS) {
+      err = NGF_ERROR_IMAGE_CREATION_FAILED;
+      goto _ngf_create_transient_image_cleanup;
+    }
+    const _ngf_transient_block new_block = {
+      .mem = alloc,
+      .offset = alloc_info.offset,
+      .size = alloc_info.size,
+      .memory_type_bits = 1u << alloc_info.memoryType
+    };
+    err = _ngf_transient_add_block(pool, &new_block, block);
+    if (err != NGF_ERROR_OK) {
+      vmaFreeMemory(CURRENT_CONTEXT->allocator, alloc);
+      goto _ngf_create_transient_image_cleanup;
+    }
+  }
+  if (vmaBindImageMemory(CURRENT_CONTEXT->allocator,
+                         (VmaAllocation)_ngf_transient_get_block(pool,
+                                                                 *block)->mem,
+                         img->vkimg) != VK_SUCCESS) {
+    err = NGF_ERROR_IMAGE_CREATION_FAILED;
+    goto _ngf_create_transient_image_cleanup;
+  }
+  err = _ngf_create_vk_image_view(img->vkimg,
+                                  vk_image_info.imageType,
+                                  vk_image_info.format,
+                                  0u,
+                                  vk_image_info.mipLevels,
+                                  vk_image_info.arrayLayers,
+                                 &img->vkview);
+  if (err == NGF_ERROR_OK &&
+      (info->image_info.usage_hint & NGF_IMAGE_USAGE_STORAGE)) {
+    err = _ngf_init_storage_image(img, &vk_image_info);
+  }
+
+_ngf_create_transient_image_cleanup:
+  if (err != NGF_ERROR_OK) {
+    _ngf_destroy_transient_image(img);
+    img = NULL;
+  }
+  *result = img;
+  return err;
+}
+
+ngf_error ngf_create_transient_pool(ngf_transient_pool *result) {
+  return _ngf_transient_pool_create(result);
+}
+
+void ngf_destroy_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_destroy(pool, _ngf_destroy_transient_image,
+                              _ngf_free_transient_block);
+}
+
+ngf_error ngf_acquire_transient_image(ngf_transient_pool pool,
+                                      const ngf_transient_image_info *info,
+                                      ngf_image *result) {
+  return _ngf_transient_acquire(pool, info, _ngf_create_transient_image,
+                                result);
+}
+
+void ngf_reset_transient_pool(ngf_transient_pool pool) {
+  _ngf_transient_pool_reset(pool, _ngf_destroy_transient_image,
+                            _ngf_free_transient_block);
+}
+
+void ngf_get_transient_pool_stats(ngf_transient_pool pool,
+                                  ngf_transient_pool_stats *result) {
+  _ngf_transient_pool_stats(pool, result);
+}
+
 
 ngf_error ngf_create_sampler(const ngf_sampler_info *info,
                              ngf_sampler *result) {
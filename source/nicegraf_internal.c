@@ -20,10 +20,15 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#define _CRT_SECURE_NO_WARNINGS
 #include "nicegraf_internal.h"
 #include "dynamic_array.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h> 
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <time.h>
+#endif
 
 // Default allocation callbacks.
 void* ngf_default_alloc(size_t obj_size, size_t nobjs) {
@@ -50,6 +55,157 @@ void ngf_set_allocation_callbacks(const ngf_allocation_callbacks *callbacks) {
   }
 }
 
+// Allocation counters are shared by all threads and updated with atomic ops,
+// which cost little next to the allocations themselves.
+typedef struct {
+  volatile uint64_t live_bytes;
+  volatile uint64_t peak_bytes;
+  volatile uint64_t live_allocations;
+  volatile uint64_t total_allocations;
+} _ngf_alloc_counters;
+
+static _ngf_alloc_counters _NGF_ALLOC_COUNTERS[NGF_ALLOCATION_CATEGORY_COUNT];
+static _ngf_alloc_counters _NGF_ALLOC_TOTAL;
+
+static uint64_t _ngf_atomic_add_u64(volatile uint64_t *v, uint64_t n) {
+#if defined(_WIN32) || defined(_WIN64)
+  return (uint64_t)InterlockedExchangeAdd64((volatile LONG64*)v, (LONG64)n) +
+         n;
+#else
+  return __sync_add_and_fetch(v, n);
+#endif
+}
+
+// Raises `v` to `value` unless it's already higher.
+static void _ngf_atomic_max_u64(volatile uint64_t *v, uint64_t value) {
+  uint64_t cur = *v;
+  while (value > cur) {
+#if defined(_WIN32) || defined(_WIN64)
+    const uint64_t prev = (uint64_t)InterlockedCompareExchange64(
+        (volatile LONG64*)v, (LONG64)value, (LONG64)cur);
+#else
+    const uint64_t prev = __sync_val_compare_and_swap(v, cur, value);
+#endif
+    if (prev == cur) {
+      break;
+    }
+    cur = prev;
+  }
+}
+
+static void _ngf_count_alloc(_ngf_alloc_counters *c, uint64_t nbytes) {
+  _ngf_atomic_max_u64(&c->peak_bytes,
+                      _ngf_atomic_add_u64(&c->live_bytes, nbytes));
+  _ngf_atomic_add_u64(&c->live_allocations, 1u);
+  _ngf_atomic_add_u64(&c->total_allocations, 1u);
+}
+
+static void _ngf_count_free(_ngf_alloc_counters *c, uint64_t nbytes) {
+  // Adding the two's complement subtracts.
+  _ngf_atomic_add_u64(&c->live_bytes, ~nbytes + 1u);
+  _ngf_atomic_add_u64(&c->live_allocations, ~(uint64_t)0u);
+}
+
+void* _ngf_alloc(size_t obj_size, size_t nobjs,
+                 ngf_allocation_category category) {
+  void *ptr = NGF_ALLOC_CB->allocate(obj_size, nobjs);
+  if (ptr != NULL) {
+    const uint64_t nbytes = (uint64_t)obj_size * (uint64_t)nobjs;
+    _ngf_count_alloc(&_NGF_ALLOC_COUNTERS[category], nbytes);
+    _ngf_count_alloc(&_NGF_ALLOC_TOTAL, nbytes);
+  }
+  return ptr;
+}
+
+void _ngf_free(void *ptr, size_t obj_size, size_t nobjs,
+               ngf_allocation_category category) {
+  if (ptr != NULL) {
+    const uint64_t nbytes = (uint64_t)obj_size * (uint64_t)nobjs;
+    _ngf_count_free(&_NGF_ALLOC_COUNTERS[category], nbytes);
+    _ngf_count_free(&_NGF_ALLOC_TOTAL, nbytes);
+  }
+  NGF_ALLOC_CB->free(ptr, obj_size, nobjs);
+}
+
+void* _ngf_darray_alloc(size_t elem_size, uint32_t capacity) {
+  return _ngf_alloc(elem_size, capacity, NGF_ALLOCATION_DYNAMIC_ARRAY);
+}
+
+void* _ngf_darray_realloc(void    *data,
+                          size_t   elem_size,
+                          uint32_t old_capacity,
+                          uint32_t new_capacity) {
+  void *new_data = _ngf_darray_alloc(elem_size, new_capacity);
+  if (new_data != NULL && data != NULL) {
+    memcpy(new_data, data, elem_size * NGF_MIN(old_capacity, new_capacity));
+    _ngf_darray_free(data, elem_size, old_capacity);
+  }
+  return new_data;
+}
+
+void _ngf_darray_free(void *data, size_t elem_size, uint32_t capacity) {
+  _ngf_free(data, elem_size, capacity, NGF_ALLOCATION_DYNAMIC_ARRAY);
+}
+
+static void _ngf_read_alloc_counters(const _ngf_alloc_counters *c,
+                                     ngf_allocation_counters *result) {
+  result->live_bytes = c->live_bytes;
+  result->peak_bytes = c->peak_bytes;
+  result->live_allocations = c->live_allocations;
+  result->total_allocations = c->total_allocations;
+}
+
+void ngf_get_allocation_stats(ngf_allocation_stats *result) {
+  for (uint32_t c = 0u; c < NGF_ALLOCATION_CATEGORY_COUNT; ++c) {
+    _ngf_read_alloc_counters(&_NGF_ALLOC_COUNTERS[c],
+                             &result->categories[c]);
+  }
+  _ngf_read_alloc_counters(&_NGF_ALLOC_TOTAL, &result->total);
+}
+
+// Appends a row of the allocation report, keeping track of the length of the
+// full report even once the buffer runs out.
+static void _ngf_report_row(char *buffer, size_t buffer_size, size_t *len,
+                            const char *name,
+                            const ngf_allocation_counters *c) {
+  char *dst = *len < buffer_size ? buffer + *len : NULL;
+  const size_t dst_size = *len < buffer_size ? buffer_size - *len : 0u;
+  const int n = c == NULL
+      ? snprintf(dst, dst_size, "%-16s %14s %14s %10s %10s\n", name,
+                 "live bytes", "peak bytes", "live", "total")
+      : snprintf(dst, dst_size, "%-16s %14llu %14llu %10llu %10llu\n", name,
+                 (unsigned long long)c->live_bytes,
+                 (unsigned long long)c->peak_bytes,
+                 (unsigned long long)c->live_allocations,
+                 (unsigned long long)c->total_allocations);
+  *len += n > 0 ? (size_t)n : 0u;
+}
+
+size_t ngf_format_allocation_report(char *buffer, size_t buffer_size) {
+  static const char *category_names[NGF_ALLOCATION_CATEGORY_COUNT] = {
+    "general",
+    "pipeline",
+    "binding map",
+    "cmd block",
+    "descriptor pool",
+    "dynamic array",
+    "temp store"
+  };
+  ngf_allocation_stats stats;
+  ngf_get_allocation_stats(&stats);
+  size_t len = 0u;
+  if (buffer_size > 0u) {
+    buffer[0] = '\0';
+  }
+  _ngf_report_row(buffer, buffer_size, &len, "category", NULL);
+  for (uint32_t c = 0u; c < NGF_ALLOCATION_CATEGORY_COUNT; ++c) {
+    _ngf_report_row(buffer, buffer_size, &len, category_names[c],
+                    &stats.categories[c]);
+  }
+  _ngf_report_row(buffer, buffer_size, &len, "total", &stats.total);
+  return len;
+}
+
 /**
  * The block allocator. doles out memory in fixed-size blocks from a pool.
  * A block allocator is created with a certain initial capacity. If the block
@@ -81,7 +237,8 @@ static const uint32_t MARKER_MASK = (1u << 31);
 static void _ngf_blkallock_add_pool(_ngf_block_allocator *alloc) {
  _ngf_blkalloc_block *old_freelist = alloc->freelist;
   const size_t        pool_size    = alloc->block_size * alloc->nblocks;
-  uint8_t            *pool         = NGF_ALLOCN(uint8_t, pool_size);
+  uint8_t            *pool         =
+      NGF_ALLOCN_AS(uint8_t, pool_size, NGF_ALLOCATION_CMD_BLOCK);
 
   alloc->freelist = (_ngf_blkalloc_block*)pool;
   for (uint32_t b = 0u; b < alloc->nblocks; ++b) {
@@ -125,7 +282,10 @@ _ngf_block_allocator* _ngf_blkalloc_create(uint32_t requested_block_size,
 void _ngf_blkalloc_destroy(_ngf_block_allocator *alloc) {
   for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(alloc->pools); ++i) {
     uint8_t *pool = _NGF_DARRAY_AT(alloc->pools, i);
-    if (pool) { NGF_FREEN(pool, alloc->block_size * alloc->nblocks); }
+    if (pool) {
+      NGF_FREEN_AS(pool, alloc->block_size * alloc->nblocks,
+                   NGF_ALLOCATION_CMD_BLOCK);
+    }
   }
   _NGF_DARRAY_DESTROY(alloc->pools);
   NGF_FREE(alloc);
@@ -194,7 +354,8 @@ ngf_error _ngf_create_native_binding_map(
   ngf_error err = NGF_ERROR_OK;
   uint32_t nmap_entries = layout->ndescriptor_set_layouts + 1;
   _ngf_native_binding_map map =
-      NGF_ALLOCN(_ngf_native_binding*, nmap_entries);
+      NGF_ALLOCN_AS(_ngf_native_binding*, nmap_entries,
+                    NGF_ALLOCATION_BINDING_MAP);
   *result = map;
   if (map == NULL) {
     err = NGF_ERROR_OUTOFMEM;
@@ -206,19 +367,29 @@ ngf_error _ngf_create_native_binding_map(
   for (uint32_t set = 0u; set < layout->ndescriptor_set_layouts; ++set) {
     const ngf_descriptor_set_layout_info *set_layout =
         &layout->descriptor_set_layouts[set];
-    map[set] = NGF_ALLOCN(_ngf_native_binding,
-                          set_layout->ndescriptors + 1u);
+    map[set] = NGF_ALLOCN_AS(_ngf_native_binding,
+                             set_layout->ndescriptors + 1u,
+                             NGF_ALLOCATION_BINDING_MAP);
     if (map[set] == NULL) {
       err = NGF_ERROR_OUTOFMEM;
       goto _ngf_create_native_binding_map_cleanup;
     }
+    // Zeroed entries keep the set walkable if we bail out half-way through.
+    memset(map[set], 0,
+           sizeof(_ngf_native_binding) * (set_layout->ndescriptors + 1u));
     map[set][set_layout->ndescriptors].ngf_binding_id = (uint32_t)(-1);
     for (uint32_t b = 0u; b < set_layout->ndescriptors; ++b) {
       const ngf_descriptor_info *desc_info = &set_layout->descriptors[b];
       const ngf_descriptor_type desc_type = desc_info->type;
       _ngf_native_binding *mapping = &map[set][b];
       mapping->ngf_binding_id = desc_info->id;
-      mapping->native_binding_id = total_c[desc_type]++;
+      // Dynamic uniform buffers are plain uniform buffers as far as the
+      // native API is concerned.
+      const ngf_descriptor_type native_type =
+          desc_type == NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC
+              ? NGF_DESCRIPTOR_UNIFORM_BUFFER
+              : desc_type;
+      mapping->native_binding_id = total_c[native_type]++;
       if ((desc_info->type == NGF_DESCRIPTOR_SAMPLER && samplers_to_cis) ||
           (desc_info->type == NGF_DESCRIPTOR_TEXTURE && images_to_cis)) {
         const ngf_plmd_cis_map *cis_map =
@@ -235,7 +406,8 @@ ngf_error _ngf_create_native_binding_map(
         }
         if (combined_list) {
           mapping->cis_bindings =
-            NGF_ALLOCN(uint32_t, combined_list->ncombined_ids);
+            NGF_ALLOCN_AS(uint32_t, combined_list->ncombined_ids,
+                          NGF_ALLOCATION_BINDING_MAP);
           if (mapping->cis_bindings == NULL) {
             err = NGF_ERROR_OUTOFMEM;
             goto _ngf_create_native_binding_map_cleanup;
@@ -263,13 +435,753 @@ _ngf_create_native_binding_map_cleanup:
 
 void _ngf_destroy_binding_map(_ngf_native_binding_map map) {
   if (map != NULL) {
-    for (uint32_t i = 0; map[i] != NULL; ++i) {
-      _ngf_native_binding *set = map[i];
-      if (set->cis_bindings) {
-        NGF_FREEN(set->cis_bindings, set->ncis_bindings);
+    uint32_t nsets = 0u;
+    for (; map[nsets] != NULL; ++nsets) {
+      _ngf_native_binding *set = map[nsets];
+      uint32_t nbindings = 0u;
+      for (; set[nbindings].ngf_binding_id != (uint32_t)(-1); ++nbindings) {
+        if (set[nbindings].cis_bindings) {
+          NGF_FREEN_AS(set[nbindings].cis_bindings,
+                       set[nbindings].ncis_bindings,
+                       NGF_ALLOCATION_BINDING_MAP);
+        }
+      }
+      // Sets end with a terminating entry.
+      NGF_FREEN_AS(set, nbindings + 1u, NGF_ALLOCATION_BINDING_MAP);
+    }
+    // The map ends with a NULL set.
+    NGF_FREEN_AS(map, nsets + 1u, NGF_ALLOCATION_BINDING_MAP);
+  }
+}
+
+uint32_t _ngf_push_constants_native_binding(
+    const ngf_pipeline_layout_info *layout) {
+  uint32_t nuniform_buffers = 0u;
+  for (uint32_t set = 0u; set < layout->ndescriptor_set_layouts; ++set) {
+    const ngf_descriptor_set_layout_info *set_layout =
+        &layout->descriptor_set_layouts[set];
+    for (uint32_t b = 0u; b < set_layout->ndescriptors; ++b) {
+      const ngf_descriptor_type type = set_layout->descriptors[b].type;
+      if (type == NGF_DESCRIPTOR_UNIFORM_BUFFER ||
+          type == NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC) {
+        ++nuniform_buffers;
       }
-      NGF_FREE(set);
     }
-    NGF_FREE(map);
   }
+  return nuniform_buffers;
+}
+
+void _ngf_radix_sort_u64(uint64_t *keys,
+                         uint32_t *values,
+                         uint64_t *scratch_keys,
+                         uint32_t *scratch_values,
+                         uint32_t  n) {
+  uint64_t *src_keys   = keys,   *dst_keys   = scratch_keys;
+  uint32_t *src_values = values, *dst_values = scratch_values;
+  for (uint32_t shift = 0u; shift < 64u; shift += 8u) {
+    uint32_t histogram[256];
+    memset(histogram, 0, sizeof(histogram));
+    for (uint32_t i = 0u; i < n; ++i) {
+      ++histogram[(src_keys[i] >> shift) & 0xffu];
+    }
+    // If all keys have the same value in this digit, the pass would be a
+    // no-op, so skip it. This is very common for keys with unused high bits.
+    if (n == 0u || histogram[(src_keys[0] >> shift) & 0xffu] == n) {
+      continue;
+    }
+    uint32_t offset = 0u;
+    for (uint32_t d = 0u; d < 256u; ++d) {
+      const uint32_t count = histogram[d];
+      histogram[d] = offset;
+      offset += count;
+    }
+    for (uint32_t i = 0u; i < n; ++i) {
+      const uint32_t dst = histogram[(src_keys[i] >> shift) & 0xffu]++;
+      dst_keys[dst]   = src_keys[i];
+      dst_values[dst] = src_values[i];
+    }
+    uint64_t *tmp_keys   = src_keys;   src_keys   = dst_keys;
+    dst_keys             = tmp_keys;
+    uint32_t *tmp_values = src_values; src_values = dst_values;
+    dst_values           = tmp_values;
+  }
+  if (src_keys != keys) {
+    memcpy(keys, src_keys, sizeof(uint64_t) * n);
+    memcpy(values, src_values, sizeof(uint32_t) * n);
+  }
+}
+
+void _ngf_gpu_timing_reset(_ngf_gpu_timing_frame *f, uint64_t frame) {
+  f->frame = frame;
+  f->nscopes = 0u;
+  f->nquery_pairs = 0u;
+  f->stack_size = 0u;
+  f->nuntimed_open = 0u;
+}
+
+// Opens a scope in `f`, taking its queries from `owner`.
+static uint32_t _ngf_gpu_timing_open_scope(_ngf_gpu_timing_frame *owner,
+                                           _ngf_gpu_timing_frame *f,
+                                           const char *name) {
+  // Once a scope goes untimed, so do all the scopes nested within it.
+  if (f->nuntimed_open > 0u ||
+      owner->nquery_pairs >= NGF_MAX_GPU_TIMING_SCOPES ||
+      f->stack_size >= _NGF_MAX_GPU_TIMING_DEPTH) {
+    ++f->nuntimed_open;
+    return _NGF_GPU_TIMING_NO_QUERY;
+  }
+  const uint32_t pair = owner->nquery_pairs++;
+  const uint32_t idx = f->nscopes++;
+  f->query_pairs[idx] = pair;
+  ngf_gpu_timing_scope *scope = &f->scopes[idx];
+  strncpy(scope->name, name, NGF_GPU_TIMING_SCOPE_NAME_SIZE - 1u);
+  scope->name[NGF_GPU_TIMING_SCOPE_NAME_SIZE - 1u] = '\0';
+  scope->depth = f->stack_size;
+  scope->parent = f->stack_size > 0u ? f->stack[f->stack_size - 1u]
+                                     : NGF_GPU_TIMING_NO_PARENT;
+  scope->start_ns = scope->duration_ns = 0u;
+  f->stack[f->stack_size++] = idx;
+  return 2u * pair;
+}
+
+uint32_t _ngf_gpu_timing_begin_scope(_ngf_gpu_timing_frame *f,
+                                     const char *name) {
+  return _ngf_gpu_timing_open_scope(f, f, name);
+}
+
+uint32_t _ngf_gpu_timing_begin_local_scope(_ngf_gpu_timing_frame *frame,
+                                           _ngf_gpu_timing_frame *local,
+                                           const char *name) {
+  return _ngf_gpu_timing_open_scope(frame, local, name);
+}
+
+uint32_t _ngf_gpu_timing_end_scope(_ngf_gpu_timing_frame *f) {
+  if (f->nuntimed_open > 0u) {
+    --f->nuntimed_open;
+    return _NGF_GPU_TIMING_NO_QUERY;
+  }
+  if (f->stack_size == 0u) {
+    return _NGF_GPU_TIMING_NO_QUERY;
+  }
+  return 2u * f->query_pairs[f->stack[--f->stack_size]] + 1u;
+}
+
+bool _ngf_gpu_timing_has_open_scopes(const _ngf_gpu_timing_frame *f) {
+  return f->stack_size > 0u || f->nuntimed_open > 0u;
+}
+
+uint32_t _ngf_gpu_timing_depth(const _ngf_gpu_timing_frame *f) {
+  return f->stack_size + f->nuntimed_open;
+}
+
+void _ngf_gpu_timing_merge(_ngf_gpu_timing_frame *frame,
+                           _ngf_gpu_timing_frame *local) {
+  assert(!_ngf_gpu_timing_has_open_scopes(local));
+  const uint32_t base = frame->nscopes;
+  const uint32_t parent = frame->stack_size > 0u
+                              ? frame->stack[frame->stack_size - 1u]
+                              : NGF_GPU_TIMING_NO_PARENT;
+  // Each of the local scopes holds one of the frame's query pairs, so they
+  // are guaranteed to fit.
+  assert(base + local->nscopes <= NGF_MAX_GPU_TIMING_SCOPES);
+  for (uint32_t s = 0u; s < local->nscopes; ++s) {
+    ngf_gpu_timing_scope *scope = &frame->scopes[base + s];
+    *scope = local->scopes[s];
+    scope->depth += frame->stack_size;
+    scope->parent = scope->parent == NGF_GPU_TIMING_NO_PARENT
+                        ? parent
+                        : scope->parent + base;
+    frame->query_pairs[base + s] = local->query_pairs[s];
+  }
+  frame->nscopes += local->nscopes;
+  _ngf_gpu_timing_reset(local, local->frame);
+}
+
+void _ngf_gpu_timing_resolve(const _ngf_gpu_timing_frame *f,
+                             const uint64_t *timestamps,
+                             float period,
+                             _ngf_gpu_timing_results *results) {
+  assert(!_ngf_gpu_timing_has_open_scopes(f));
+  const uint64_t origin =
+      f->nscopes > 0u ? timestamps[2u * f->query_pairs[0]] : 0u;
+  for (uint32_t s = 0u; s < f->nscopes; ++s) {
+    const uint64_t start = timestamps[2u * f->query_pairs[s]];
+    const uint64_t end = timestamps[2u * f->query_pairs[s] + 1u];
+    results->scopes[s] = f->scopes[s];
+    results->scopes[s].start_ns =
+        start > origin ? (uint64_t)((double)(start - origin) * period) : 0u;
+    results->scopes[s].duration_ns =
+        end > start ? (uint64_t)((double)(end - start) * period) : 0u;
+  }
+  results->nscopes = f->nscopes;
+  results->frame = f->frame;
+  results->valid = true;
+}
+
+ngf_error _ngf_gpu_timing_get_results(const _ngf_gpu_timing_results *results,
+                                      ngf_gpu_frame_timings *timings) {
+  if (results == NULL || !results->valid) {
+    return NGF_ERROR_NO_FRAME;
+  }
+  timings->frame = results->frame;
+  timings->nscopes = results->nscopes;
+  timings->scopes = results->scopes;
+  return NGF_ERROR_OK;
+}
+
+uint64_t _ngf_gpu_timing_busy_ns(const _ngf_gpu_timing_results *results) {
+  uint64_t busy_ns = 0u;
+  if (results != NULL && results->valid) {
+    for (uint32_t s = 0u; s < results->nscopes; ++s) {
+      if (results->scopes[s].depth == 0u) {
+        busy_ns += results->scopes[s].duration_ns;
+      }
+    }
+  }
+  return busy_ns;
+}
+
+NGF_THREADLOCAL _ngf_stat_counters *_NGF_STATS = NULL;
+
+static _ngf_stat_counters _NGF_STAT_SLOTS[_NGF_MAX_STAT_THREADS];
+static ATOMIC_INT _NGF_STAT_NEXT_SLOT = 0u;
+static ngf_frame_stats _NGF_LAST_FRAME_STATS;
+static bool _NGF_HAVE_FRAME_STATS = false;
+
+_ngf_stat_counters* _ngf_stats_register() {
+  const ATOMIC_INT slot = interlocked_post_inc(&_NGF_STAT_NEXT_SLOT);
+  _ngf_stat_counters *c = NULL;
+  if (slot < _NGF_MAX_STAT_THREADS - 1u) {
+    c = &_NGF_STAT_SLOTS[slot];
+  } else {
+    // Out of slots, fall back to the shared one.
+    c = &_NGF_STAT_SLOTS[_NGF_MAX_STAT_THREADS - 1u];
+    c->shared = true;
+  }
+  _NGF_STATS = c;
+  return c;
+}
+
+void _ngf_stats_add_shared(_ngf_stat_counters *c, _ngf_stat stat, uint64_t n) {
+#if defined(_WIN32) || defined(_WIN64)
+  InterlockedExchangeAdd64((volatile LONG64*)&c->values[stat], (LONG64)n);
+#else
+  __sync_fetch_and_add(&c->values[stat], n);
+#endif
+}
+
+void _ngf_stats_end_frame(uint64_t frame) {
+  uint64_t totals[_NGF_STAT_COUNT] = {0u};
+  uint32_t nslots = (uint32_t)interlocked_read(&_NGF_STAT_NEXT_SLOT);
+  nslots = NGF_MIN(nslots, _NGF_MAX_STAT_THREADS);
+  for (uint32_t t = 0u; t < nslots; ++t) {
+    _ngf_stat_counters *c = &_NGF_STAT_SLOTS[t];
+    for (uint32_t s = 0u; s < _NGF_STAT_COUNT; ++s) {
+      const uint64_t v = c->values[s];
+      totals[s] += v - c->snapshot[s];
+      c->snapshot[s] = v;
+    }
+  }
+  ngf_frame_stats *r = &_NGF_LAST_FRAME_STATS;
+  r->frame = frame;
+  r->draws = totals[_NGF_STAT_DRAWS];
+  r->instances = totals[_NGF_STAT_INSTANCES];
+  r->pipeline_binds = totals[_NGF_STAT_PIPELINE_BINDS];
+  r->resource_binds = totals[_NGF_STAT_RESOURCE_BINDS];
+  r->descriptor_sets_allocated = totals[_NGF_STAT_DESCRIPTOR_SETS_ALLOCATED];
+  r->descriptor_pools_created = totals[_NGF_STAT_DESCRIPTOR_POOLS_CREATED];
+  r->buffers_created = totals[_NGF_STAT_BUFFERS_CREATED];
+  r->buffers_destroyed = totals[_NGF_STAT_BUFFERS_DESTROYED];
+  r->images_created = totals[_NGF_STAT_IMAGES_CREATED];
+  r->images_destroyed = totals[_NGF_STAT_IMAGES_DESTROYED];
+  r->bytes_mapped = totals[_NGF_STAT_BYTES_MAPPED];
+  r->bytes_uploaded = totals[_NGF_STAT_BYTES_UPLOADED];
+  r->cmd_blocks_allocated = totals[_NGF_STAT_CMD_BLOCKS_ALLOCATED];
+  r->submit_time_ns = totals[_NGF_STAT_SUBMIT_TIME_NS];
+  r->end_frame_time_ns = totals[_NGF_STAT_END_FRAME_TIME_NS];
+  r->pacing_wait_time_ns = totals[_NGF_STAT_PACING_WAIT_TIME_NS];
+  r->queued_frames = totals[_NGF_STAT_QUEUED_FRAMES];
+  r->gpu_busy_time_ns = totals[_NGF_STAT_GPU_BUSY_TIME_NS];
+  _NGF_HAVE_FRAME_STATS = true;
+}
+
+uint64_t _ngf_stats_now_ns() {
+#if defined(_WIN32) || defined(_WIN64)
+  LARGE_INTEGER freq, count;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+  return (uint64_t)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+ngf_error _ngf_validate_frame_pacing(const ngf_frame_pacing_info *info) {
+  assert(info);
+  if (info->mode != NGF_FRAME_PACING_DEFAULT &&
+      (info->max_queued_frames == 0u ||
+       info->max_queued_frames > NGF_MAX_QUEUED_FRAMES)) {
+    return NGF_ERROR_OUT_OF_BOUNDS;
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_frame_stats(ngf_frame_stats *result) {
+  if (!_NGF_HAVE_FRAME_STATS) {
+    return NGF_ERROR_NO_FRAME;
+  }
+  *result = _NGF_LAST_FRAME_STATS;
+  return NGF_ERROR_OK;
+}
+
+typedef struct {
+  ngf_image_info info;
+  ngf_image      image;
+  uint32_t       block;    // Index of the memory block the image is bound to.
+  uint32_t       last_use; // End of the latest lifetime since `reset`.
+  uint64_t       reset;    // Reset after which the image was last acquired.
+} _ngf_transient_image;
+
+typedef struct {
+  _ngf_transient_block b; // Memory is NULL for unused entries.
+  uint32_t             nimages;
+  uint32_t             last_use;
+  uint64_t             reset;
+} _ngf_transient_block_entry;
+
+typedef struct ngf_transient_pool_t {
+  _NGF_DARRAY_OF(_ngf_transient_image)       images;
+  _NGF_DARRAY_OF(_ngf_transient_block_entry) blocks;
+  uint64_t nresets;
+  uint32_t nacquired;
+} ngf_transient_pool_t;
+
+static bool _ngf_transient_same_info(const ngf_image_info *a,
+                                     const ngf_image_info *b) {
+  return a->type == b->type &&
+         a->extent.width == b->extent.width &&
+         a->extent.height == b->extent.height &&
+         a->extent.depth == b->extent.depth &&
+         a->nmips == b->nmips &&
+         a->format == b->format &&
+         a->nsamples == b->nsamples &&
+         a->usage_hint == b->usage_hint;
+}
+
+// Whether something last used until `last_use` after the given reset is free
+// from `first_use` on.
+static bool _ngf_transient_free_from(const ngf_transient_pool_t *pool,
+                                     uint64_t                    reset,
+                                     uint32_t                    last_use,
+                                     uint32_t                    first_use) {
+  return reset != pool->nresets || last_use < first_use;
+}
+
+static bool _ngf_transient_block_free_from(const ngf_transient_pool_t *pool,
+                                           uint32_t block,
+                                           uint32_t first_use) {
+  const _ngf_transient_block_entry *e = &_NGF_DARRAY_AT(pool->blocks, block);
+  return _ngf_transient_free_from(pool, e->reset, e->last_use, first_use);
+}
+
+ngf_error _ngf_transient_pool_create(ngf_transient_pool *result) {
+  assert(result);
+  ngf_transient_pool pool = NGF_ALLOC(ngf_transient_pool_t);
+  *result = pool;
+  if (pool == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  memset(pool, 0, sizeof(*pool));
+  _NGF_DARRAY_RESET(pool->images, 8u);
+  _NGF_DARRAY_RESET(pool->blocks, 8u);
+  return NGF_ERROR_OK;
+}
+
+void _ngf_transient_pool_destroy(ngf_transient_pool           pool,
+                                 _ngf_transient_destroy_fn    destroy,
+                                 _ngf_transient_free_block_fn free_block) {
+  if (pool == NULL) {
+    return;
+  }
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(pool->images); ++i) {
+    destroy(_NGF_DARRAY_AT(pool->images, i).image);
+  }
+  for (uint32_t b = 0u; b < _NGF_DARRAY_SIZE(pool->blocks); ++b) {
+    const _ngf_transient_block_entry *e = &_NGF_DARRAY_AT(pool->blocks, b);
+    if (e->b.mem != NULL) {
+      free_block(&e->b);
+    }
+  }
+  _NGF_DARRAY_DESTROY(pool->images);
+  _NGF_DARRAY_DESTROY(pool->blocks);
+  NGF_FREE(pool);
+}
+
+ngf_error _ngf_transient_acquire(ngf_transient_pool              pool,
+                                 const ngf_transient_image_info *info,
+                                 _ngf_transient_create_fn        create,
+                                 ngf_image                      *result) {
+  assert(pool);
+  assert(info);
+  assert(result);
+  if (info->last_use < info->first_use) {
+    return NGF_ERROR_OUT_OF_BOUNDS;
+  }
+
+  // Look for an image with the same configuration that, along with the
+  // memory it is bound to, isn't needed anymore by the time this one is.
+  _ngf_transient_image *img = NULL;
+  for (uint32_t i = 0u; img == NULL && i < _NGF_DARRAY_SIZE(pool->images);
+       ++i) {
+    _ngf_transient_image *candidate = &_NGF_DARRAY_AT(pool->images, i);
+    if (_ngf_transient_same_info(&candidate->info, &info->image_info) &&
+        _ngf_transient_free_from(pool, candidate->reset, candidate->last_use,
+                                 info->first_use) &&
+        (candidate->block == _NGF_TRANSIENT_NO_BLOCK ||
+         _ngf_transient_block_free_from(pool, candidate->block,
+                                        info->first_use))) {
+      img = candidate;
+    }
+  }
+
+  if (img == NULL) {
+    _ngf_transient_image new_img;
+    memset(&new_img, 0, sizeof(new_img));
+    new_img.info = info->image_info;
+    const ngf_error err = create(pool, info, &new_img.image, &new_img.block);
+    if (err != NGF_ERROR_OK) {
+      return err;
+    }
+    if (new_img.block != _NGF_TRANSIENT_NO_BLOCK) {
+      ++_NGF_DARRAY_AT(pool->blocks, new_img.block).nimages;
+    }
+    _NGF_DARRAY_APPEND(pool->images, new_img);
+    img = _NGF_DARRAY_BACKPTR(pool->images);
+  }
+
+  img->reset = pool->nresets;
+  img->last_use = info->last_use;
+  if (img->block != _NGF_TRANSIENT_NO_BLOCK) {
+    _ngf_transient_block_entry *e =
+        &_NGF_DARRAY_AT(pool->blocks, img->block);
+    e->reset = pool->nresets;
+    e->last_use = info->last_use;
+  }
+  ++pool->nacquired;
+  *result = img->image;
+  return NGF_ERROR_OK;
+}
+
+void _ngf_transient_pool_reset(ngf_transient_pool           pool,
+                               _ngf_transient_destroy_fn    destroy,
+                               _ngf_transient_free_block_fn free_block) {
+  assert(pool);
+  ++pool->nresets;
+  pool->nacquired = 0u;
+
+  // Destroy the images that have been idle for too long, then the memory
+  // blocks that no longer have any images bound to them.
+  uint32_t nkept = 0u;
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(pool->images); ++i) {
+    const _ngf_transient_image img = _NGF_DARRAY_AT(pool->images, i);
+    if (pool->nresets - img.reset > _NGF_TRANSIENT_MAX_IDLE_RESETS) {
+      destroy(img.image);
+      if (img.block != _NGF_TRANSIENT_NO_BLOCK) {
+        --_NGF_DARRAY_AT(pool->blocks, img.block).nimages;
+      }
+    } else {
+      _NGF_DARRAY_AT(pool->images, nkept++) = img;
+    }
+  }
+  pool->images.endptr = pool->images.data + nkept;
+  for (uint32_t b = 0u; b < _NGF_DARRAY_SIZE(pool->blocks); ++b) {
+    _ngf_transient_block_entry *e = &_NGF_DARRAY_AT(pool->blocks, b);
+    if (e->b.mem != NULL && e->nimages == 0u) {
+      free_block(&e->b);
+      memset(e, 0, sizeof(*e));
+    }
+  }
+}
+
+void _ngf_transient_pool_stats(ngf_transient_pool        pool,
+                               ngf_transient_pool_stats *result) {
+  assert(pool);
+  assert(result);
+  memset(result, 0, sizeof(*result));
+  result->nimages = _NGF_DARRAY_SIZE(pool->images);
+  result->nacquired = pool->nacquired;
+  for (uint32_t b = 0u; b < _NGF_DARRAY_SIZE(pool->blocks); ++b) {
+    const _ngf_transient_block_entry *e = &_NGF_DARRAY_AT(pool->blocks, b);
+    if (e->b.mem != NULL) {
+      ++result->nmemory_blocks;
+      result->memory_bytes += e->b.size;
+    }
+  }
+}
+
+bool _ngf_transient_find_block(ngf_transient_pool pool,
+                               uint64_t           size,
+                               uint64_t           alignment,
+                               uint32_t           memory_type_bits,
+                               uint32_t           first_use,
+                               uint32_t          *block) {
+  assert(pool);
+  assert(block);
+  for (uint32_t b = 0u; b < _NGF_DARRAY_SIZE(pool->blocks); ++b) {
+    const _ngf_transient_block *candidate =
+        &_NGF_DARRAY_AT(pool->blocks, b).b;
+    if (candidate->mem != NULL && candidate->size >= size &&
+        (alignment == 0u || candidate->offset % alignment == 0u) &&
+        (candidate->memory_type_bits & memory_type_bits) != 0u &&
+        _ngf_transient_block_free_from(pool, b, first_use)) {
+      *block = b;
+      return true;
+    }
+  }
+  return false;
+}
+
+ngf_error _ngf_transient_add_block(ngf_transient_pool          pool,
+                                   const _ngf_transient_block *b,
+                                   uint32_t                   *block) {
+  assert(pool);
+  assert(b && b->mem != NULL);
+  assert(block);
+  _ngf_transient_block_entry e;
+  memset(&e, 0, sizeof(e));
+  e.b = *b;
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(pool->blocks); ++i) {
+    if (_NGF_DARRAY_AT(pool->blocks, i).b.mem == NULL) {
+      _NGF_DARRAY_AT(pool->blocks, i) = e;
+      *block = i;
+      return NGF_ERROR_OK;
+    }
+  }
+  _NGF_DARRAY_APPEND(pool->blocks, e);
+  *block = _NGF_DARRAY_SIZE(pool->blocks) - 1u;
+  return NGF_ERROR_OK;
+}
+
+const _ngf_transient_block* _ngf_transient_get_block(ngf_transient_pool pool,
+                                                     uint32_t block) {
+  assert(pool);
+  assert(block < _NGF_DARRAY_SIZE(pool->blocks));
+  return &_NGF_DARRAY_AT(pool->blocks, block).b;
+}
+
+typedef struct {
+  char name[NGF_GPU_TIMING_SCOPE_NAME_SIZE];
+  uint64_t start_ns;
+  uint64_t duration_ns;
+  bool gpu;
+} _ngf_timeline_event;
+
+typedef struct {
+  _ngf_timeline_event events[_NGF_TIMELINE_RING_SIZE];
+  ATOMIC_INT head; // Only advanced by the owning thread.
+  ATOMIC_INT tail; // Only advanced by the flushing thread.
+  ATOMIC_INT ndropped;
+  ATOMIC_INT nreported_dropped;
+  uint32_t tid;
+  bool named; // Whether the trace has the thread's name yet.
+} _ngf_timeline_ring;
+
+volatile bool _NGF_TIMELINE_ENABLED = false;
+
+static _ngf_timeline_ring* volatile _NGF_TIMELINE_RINGS[_NGF_MAX_STAT_THREADS];
+static ATOMIC_INT _NGF_TIMELINE_NEXT_RING = 0u;
+static NGF_THREADLOCAL _ngf_timeline_ring *_NGF_TIMELINE_RING = NULL;
+static NGF_THREADLOCAL bool _NGF_TIMELINE_NO_RING = false;
+static FILE *_NGF_TIMELINE_FILE = NULL;
+static uint64_t _NGF_TIMELINE_ORIGIN_NS = 0u;
+static uint64_t _NGF_TIMELINE_NEVENTS = 0u;
+
+// GPU scopes go on the track with this id, CPU threads get ids starting at 1.
+#define _NGF_TIMELINE_GPU_TID 0u
+
+static _ngf_timeline_ring* _ngf_timeline_register() {
+  const ATOMIC_INT slot = interlocked_post_inc(&_NGF_TIMELINE_NEXT_RING);
+  _ngf_timeline_ring *ring = NULL;
+  if (slot < _NGF_MAX_STAT_THREADS) {
+    ring = NGF_ALLOC(_ngf_timeline_ring);
+  }
+  if (ring == NULL) {
+    // Out of slots or memory, the thread's scopes won't be recorded.
+    _NGF_TIMELINE_NO_RING = true;
+    return NULL;
+  }
+  memset(ring, 0, sizeof(*ring));
+  ring->tid = (uint32_t)slot + 1u;
+  _NGF_TIMELINE_RINGS[slot] = ring;
+  _NGF_TIMELINE_RING = ring;
+  return ring;
+}
+
+void _ngf_timeline_record(const char *name,
+                          uint64_t    start_ns,
+                          uint64_t    duration_ns,
+                          bool        gpu) {
+  _ngf_timeline_ring *ring = _NGF_TIMELINE_RING;
+  if (ring == NULL) {
+    if (_NGF_TIMELINE_NO_RING || (ring = _ngf_timeline_register()) == NULL) {
+      return;
+    }
+  }
+  const ATOMIC_INT head = ring->head;
+  if (head - interlocked_read(&ring->tail) >= _NGF_TIMELINE_RING_SIZE) {
+    interlocked_inc(&ring->ndropped);
+    return;
+  }
+  _ngf_timeline_event *e =
+      &ring->events[head & (_NGF_TIMELINE_RING_SIZE - 1u)];
+  strncpy(e->name, name, NGF_GPU_TIMING_SCOPE_NAME_SIZE - 1u);
+  e->name[NGF_GPU_TIMING_SCOPE_NAME_SIZE - 1u] = '\0';
+  e->start_ns = start_ns;
+  e->duration_ns = duration_ns;
+  e->gpu = gpu;
+  // The event becomes visible to the flushing thread only after it has been
+  // written out completely.
+  interlocked_inc(&ring->head);
+}
+
+void _ngf_timeline_gpu_frame(const _ngf_gpu_timing_results *results,
+                             uint64_t origin_cpu_ns) {
+  for (uint32_t s = 0u; s < results->nscopes; ++s) {
+    const ngf_gpu_timing_scope *scope = &results->scopes[s];
+    _ngf_timeline_record(scope->name, origin_cpu_ns + scope->start_ns,
+                         scope->duration_ns, true);
+  }
+}
+
+// Writes the separator that goes ahead of every event but the first one.
+static void _ngf_timeline_begin_event() {
+  fputs(_NGF_TIMELINE_NEVENTS++ > 0u ? ",\n" : "\n", _NGF_TIMELINE_FILE);
+}
+
+static void _ngf_timeline_write_string(const char *str) {
+  fputc('"', _NGF_TIMELINE_FILE);
+  for (const char *c = str; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', _NGF_TIMELINE_FILE);
+      fputc(*c, _NGF_TIMELINE_FILE);
+    } else if ((unsigned char)*c < 0x20u) {
+      fprintf(_NGF_TIMELINE_FILE, "\\u%04x", (unsigned)*c);
+    } else {
+      fputc(*c, _NGF_TIMELINE_FILE);
+    }
+  }
+  fputc('"', _NGF_TIMELINE_FILE);
+}
+
+static void _ngf_timeline_write_thread_name(uint32_t tid, const char *name) {
+  _ngf_timeline_begin_event();
+  fprintf(_NGF_TIMELINE_FILE,
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+          "\"tid\":%u,\"args\":{\"name\":", tid);
+  _ngf_timeline_write_string(name);
+  fputs("}}", _NGF_TIMELINE_FILE);
+}
+
+// Timestamps in the trace are in microseconds since the start of the trace.
+static double _ngf_timeline_us(uint64_t t_ns) {
+  return ((double)t_ns - (double)_NGF_TIMELINE_ORIGIN_NS) / 1000.0;
+}
+
+static void _ngf_timeline_flush_ring(_ngf_timeline_ring *ring) {
+  if (!ring->named) {
+    char name[32];
+    snprintf(name, sizeof(name), "thread %u", ring->tid);
+    _ngf_timeline_write_thread_name(ring->tid, name);
+    ring->named = true;
+  }
+  const ATOMIC_INT head = interlocked_read(&ring->head);
+  while (ring->tail != head) {
+    const _ngf_timeline_event *e =
+        &ring->events[ring->tail & (_NGF_TIMELINE_RING_SIZE - 1u)];
+    _ngf_timeline_begin_event();
+    fputs("{\"name\":", _NGF_TIMELINE_FILE);
+    _ngf_timeline_write_string(e->name);
+    fprintf(_NGF_TIMELINE_FILE,
+            ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+            "\"ts\":%.3f,\"dur\":%.3f}",
+            e->gpu ? "gpu" : "cpu",
+            e->gpu ? _NGF_TIMELINE_GPU_TID : ring->tid,
+            _ngf_timeline_us(e->start_ns),
+            (double)e->duration_ns / 1000.0);
+    // Hands the slot back to the owning thread.
+    interlocked_inc(&ring->tail);
+  }
+  const ATOMIC_INT ndropped = interlocked_read(&ring->ndropped);
+  if (ndropped != ring->nreported_dropped) {
+    _ngf_timeline_begin_event();
+    fprintf(_NGF_TIMELINE_FILE,
+            "{\"name\":\"%llu scopes dropped\",\"ph\":\"i\",\"s\":\"t\","
+            "\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+            (unsigned long long)(ndropped - ring->nreported_dropped),
+            ring->tid, _ngf_timeline_us(_ngf_stats_now_ns()));
+    ring->nreported_dropped = ndropped;
+  }
+}
+
+static uint32_t _ngf_timeline_nrings() {
+  const ATOMIC_INT nrings = interlocked_read(&_NGF_TIMELINE_NEXT_RING);
+  return (uint32_t)NGF_MIN(nrings, _NGF_MAX_STAT_THREADS);
+}
+
+ngf_error ngf_begin_timeline_trace(const char *file_path) {
+  if (_NGF_TIMELINE_FILE != NULL) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  _NGF_TIMELINE_FILE = fopen(file_path, "w");
+  if (_NGF_TIMELINE_FILE == NULL) {
+    return NGF_ERROR_INITIALIZATION_FAILED;
+  }
+  // Discard whatever got recorded while the previous trace was ending.
+  for (uint32_t r = 0u; r < _ngf_timeline_nrings(); ++r) {
+    _ngf_timeline_ring *ring = _NGF_TIMELINE_RINGS[r];
+    if (ring != NULL) {
+      const ATOMIC_INT head = interlocked_read(&ring->head);
+      while (ring->tail != head) {
+        interlocked_inc(&ring->tail);
+      }
+      ring->nreported_dropped = interlocked_read(&ring->ndropped);
+      ring->named = false;
+    }
+  }
+  _NGF_TIMELINE_NEVENTS = 0u;
+  _NGF_TIMELINE_ORIGIN_NS = _ngf_stats_now_ns();
+  fputs("[", _NGF_TIMELINE_FILE);
+  _ngf_timeline_write_thread_name(_NGF_TIMELINE_GPU_TID, "GPU");
+  _NGF_TIMELINE_ENABLED = true;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_flush_timeline_trace() {
+  if (_NGF_TIMELINE_FILE == NULL) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  for (uint32_t r = 0u; r < _ngf_timeline_nrings(); ++r) {
+    // A ring may not have been published yet by a thread that is still
+    // registering, in which case its scopes go into the next flush.
+    _ngf_timeline_ring *ring = _NGF_TIMELINE_RINGS[r];
+    if (ring != NULL) {
+      _ngf_timeline_flush_ring(ring);
+    }
+  }
+  fflush(_NGF_TIMELINE_FILE);
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_end_timeline_trace() {
+  if (_NGF_TIMELINE_FILE == NULL) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  _NGF_TIMELINE_ENABLED = false;
+  ngf_flush_timeline_trace();
+  fputs("\n]\n", _NGF_TIMELINE_FILE);
+  fclose(_NGF_TIMELINE_FILE);
+  _NGF_TIMELINE_FILE = NULL;
+  return NGF_ERROR_OK;
 }
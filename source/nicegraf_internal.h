@@ -60,11 +60,23 @@ extern "C" {
 // Custom allocation callbacks.
 extern const ngf_allocation_callbacks *NGF_ALLOC_CB;
 
+// Invoke the allocation callbacks and count the allocation under the given
+// category (see ngf_get_allocation_stats). Memory must be freed under the
+// same category and with the same size that it was allocated with.
+void* _ngf_alloc(size_t obj_size, size_t nobjs,
+                 ngf_allocation_category category);
+void _ngf_free(void *ptr, size_t obj_size, size_t nobjs,
+               ngf_allocation_category category);
+
 // Convenience macros for invoking custom memory allocation callbacks.
-#define NGF_ALLOC(type)     ((type*) NGF_ALLOC_CB->allocate(sizeof(type), 1))
-#define NGF_ALLOCN(type, n) ((type*) NGF_ALLOC_CB->allocate(sizeof(type), n))
-#define NGF_FREE(ptr)       (NGF_ALLOC_CB->free((void*)(ptr), sizeof(*ptr), 1))
-#define NGF_FREEN(ptr, n)   (NGF_ALLOC_CB->free((void*)(ptr), sizeof(*ptr), n))
+#define NGF_ALLOC_AS(type, c)     ((type*) _ngf_alloc(sizeof(type), 1, c))
+#define NGF_ALLOCN_AS(type, n, c) ((type*) _ngf_alloc(sizeof(type), n, c))
+#define NGF_FREE_AS(ptr, c)       (_ngf_free((void*)(ptr), sizeof(*ptr), 1, c))
+#define NGF_FREEN_AS(ptr, n, c)   (_ngf_free((void*)(ptr), sizeof(*ptr), n, c))
+#define NGF_ALLOC(type)     NGF_ALLOC_AS(type, NGF_ALLOCATION_GENERAL)
+#define NGF_ALLOCN(type, n) NGF_ALLOCN_AS(type, n, NGF_ALLOCATION_GENERAL)
+#define NGF_FREE(ptr)       NGF_FREE_AS(ptr, NGF_ALLOCATION_GENERAL)
+#define NGF_FREEN(ptr, n)   NGF_FREEN_AS(ptr, n, NGF_ALLOCATION_GENERAL)
 
 // Macro for determining size of arrays.
 #if defined(_MSC_VER)
@@ -148,6 +160,282 @@ const _ngf_native_binding* _ngf_binding_map_lookup(
     uint32_t set,
     uint32_t binding);
 
+// Native uniform buffer binding used for the push constant block on backends
+// that emulate push constants with a uniform buffer. It is the first one not
+// taken by the uniform buffers declared in the given layout.
+uint32_t _ngf_push_constants_native_binding(
+    const ngf_pipeline_layout_info *layout);
+
+// Sorts `n` 64-bit keys in ascending order, permuting the associated 32-bit
+// values along with them. The sort is stable. `scratch_keys` and
+// `scratch_values` must have room for at least `n` elements each.
+void _ngf_radix_sort_u64(uint64_t *keys,
+                         uint32_t *values,
+                         uint64_t *scratch_keys,
+                         uint32_t *scratch_values,
+                         uint32_t  n);
+
+// Number of frames that GPU timestamps are given to become available before
+// they are read back.
+#define _NGF_GPU_TIMING_LATENCY 4u
+
+// Maximum nesting depth of timed scopes. Deeper scopes are not timed.
+#define _NGF_MAX_GPU_TIMING_DEPTH 32u
+
+// Returned by the functions below when no timestamp needs to be written.
+#define _NGF_GPU_TIMING_NO_QUERY (~0u)
+
+// Scope tree of a single frame, shared by the backends that implement GPU
+// timing. The start and end timestamps of scope `i` are written into queries
+// `2 * query_pairs[i]` and `2 * query_pairs[i] + 1` of the frame's query pool.
+// The same structure also holds the scopes recorded into a single command
+// buffer until they are merged into the frame, see
+// _ngf_gpu_timing_begin_local_scope.
+typedef struct {
+  ngf_gpu_timing_scope scopes[NGF_MAX_GPU_TIMING_SCOPES];
+  uint32_t query_pairs[NGF_MAX_GPU_TIMING_SCOPES];
+  uint32_t stack[_NGF_MAX_GPU_TIMING_DEPTH];
+  uint64_t frame;
+  uint32_t nscopes;
+  uint32_t nquery_pairs;  // Query pairs handed out so far.
+  uint32_t stack_size;
+  uint32_t nuntimed_open; // Scopes that are open, but not being timed.
+} _ngf_gpu_timing_frame;
+
+// Timings of the most recent frame that has been read back.
+typedef struct {
+  ngf_gpu_timing_scope scopes[NGF_MAX_GPU_TIMING_SCOPES];
+  uint64_t frame;
+  uint32_t nscopes;
+  bool valid;
+} _ngf_gpu_timing_results;
+
+// Clears the scope tree and associates it with the given frame.
+void _ngf_gpu_timing_reset(_ngf_gpu_timing_frame *f, uint64_t frame);
+
+// Opens a new scope nested within the currently open one. Returns the index
+// of the query that the start timestamp needs to be written into, or
+// _NGF_GPU_TIMING_NO_QUERY if the scope won't be timed.
+uint32_t _ngf_gpu_timing_begin_scope(_ngf_gpu_timing_frame *f,
+                                     const char *name);
+
+// Like _ngf_gpu_timing_begin_scope, but the scope is opened in `local`, which
+// holds the scopes of a single command buffer, while its queries are taken
+// from `frame`. This way, command buffers that are recorded at the same time
+// don't get their scopes nested within each other.
+uint32_t _ngf_gpu_timing_begin_local_scope(_ngf_gpu_timing_frame *frame,
+                                           _ngf_gpu_timing_frame *local,
+                                           const char *name);
+
+// Closes the most recently opened scope. Returns the index of the query that
+// the end timestamp needs to be written into, or _NGF_GPU_TIMING_NO_QUERY.
+uint32_t _ngf_gpu_timing_end_scope(_ngf_gpu_timing_frame *f);
+
+// Returns true if the frame has scopes that haven't been closed yet.
+bool _ngf_gpu_timing_has_open_scopes(const _ngf_gpu_timing_frame *f);
+
+// Number of scopes that are currently open, timed or not.
+uint32_t _ngf_gpu_timing_depth(const _ngf_gpu_timing_frame *f);
+
+// Appends the scopes of a command buffer to the frame's scope tree, nesting
+// them within the frame's currently open scope, if any. This is done when the
+// command buffer is submitted, so the tree follows submission order. `local`
+// is cleared afterwards.
+void _ngf_gpu_timing_merge(_ngf_gpu_timing_frame *frame,
+                           _ngf_gpu_timing_frame *local);
+
+// Computes the start times and durations of the frame's scopes from their raw
+// timestamps, which are given in ticks of `period` nanoseconds, and stores
+// them into `results`. All of the frame's scopes must have been closed.
+void _ngf_gpu_timing_resolve(const _ngf_gpu_timing_frame *f,
+                             const uint64_t *timestamps,
+                             float period,
+                             _ngf_gpu_timing_results *results);
+
+// Implements ngf_get_gpu_frame_timings on top of the given results.
+ngf_error _ngf_gpu_timing_get_results(const _ngf_gpu_timing_results *results,
+                                      ngf_gpu_frame_timings *timings);
+
+// Total duration of the top-level scopes in the given results, or 0 if there
+// are no results yet.
+uint64_t _ngf_gpu_timing_busy_ns(const _ngf_gpu_timing_results *results);
+
+// CPU-side per-frame counters, see ngf_frame_stats.
+typedef enum {
+  _NGF_STAT_DRAWS = 0,
+  _NGF_STAT_INSTANCES,
+  _NGF_STAT_PIPELINE_BINDS,
+  _NGF_STAT_RESOURCE_BINDS,
+  _NGF_STAT_DESCRIPTOR_SETS_ALLOCATED,
+  _NGF_STAT_DESCRIPTOR_POOLS_CREATED,
+  _NGF_STAT_BUFFERS_CREATED,
+  _NGF_STAT_BUFFERS_DESTROYED,
+  _NGF_STAT_IMAGES_CREATED,
+  _NGF_STAT_IMAGES_DESTROYED,
+  _NGF_STAT_BYTES_MAPPED,
+  _NGF_STAT_BYTES_UPLOADED,
+  _NGF_STAT_CMD_BLOCKS_ALLOCATED,
+  _NGF_STAT_SUBMIT_TIME_NS,
+  _NGF_STAT_END_FRAME_TIME_NS,
+  _NGF_STAT_PACING_WAIT_TIME_NS,
+  _NGF_STAT_QUEUED_FRAMES,
+  _NGF_STAT_GPU_BUSY_TIME_NS,
+  _NGF_STAT_COUNT
+} _ngf_stat;
+
+// Maximum number of threads that get their own set of counters. Any threads
+// beyond that share a single set, which is updated with atomic ops.
+#define _NGF_MAX_STAT_THREADS 64u
+
+// Counters of a single thread. `values` are only ever written by the owning
+// thread, and `snapshot` only by the thread that ends frames, so counting
+// doesn't require any synchronization.
+typedef struct {
+  volatile uint64_t values[_NGF_STAT_COUNT];
+  uint64_t snapshot[_NGF_STAT_COUNT];
+  bool shared;
+} _ngf_stat_counters;
+
+// Counters of the calling thread, NULL until the thread counts something.
+extern NGF_THREADLOCAL _ngf_stat_counters *_NGF_STATS;
+
+// Assigns a set of counters to the calling thread.
+_ngf_stat_counters* _ngf_stats_register();
+
+// Atomically adds to a counter in the shared set.
+void _ngf_stats_add_shared(_ngf_stat_counters *c, _ngf_stat stat, uint64_t n);
+
+static inline void _ngf_stat_add(_ngf_stat stat, uint64_t n) {
+  _ngf_stat_counters *c = _NGF_STATS != NULL ? _NGF_STATS
+                                             : _ngf_stats_register();
+  if (!c->shared) {
+    c->values[stat] += n;
+  } else {
+    _ngf_stats_add_shared(c, stat, n);
+  }
+}
+
+#define _NGF_STAT_ADD(stat, n) (_ngf_stat_add(stat, (uint64_t)(n)))
+
+// Collects the counts accumulated by all threads since the previous call and
+// makes them available through ngf_get_frame_stats as the given frame's.
+void _ngf_stats_end_frame(uint64_t frame);
+
+// Current value of a monotonic clock, in nanoseconds.
+uint64_t _ngf_stats_now_ns();
+
+// Checks frame pacing settings passed to ngf_set_frame_pacing.
+ngf_error _ngf_validate_frame_pacing(const ngf_frame_pacing_info *info);
+
+// Determines which frame the GPU has to finish at the start (or the end) of
+// `frame`, so that no more than `max_queued` frames are in flight. Returns
+// false if the pacing mode doesn't wait at that point.
+static inline bool _ngf_frame_pacing_target(const ngf_frame_pacing_info *info,
+                                            bool     in_begin_frame,
+                                            uint64_t frame,
+                                            uint32_t max_queued,
+                                            uint64_t *target) {
+  const ngf_frame_pacing_mode mode = in_begin_frame
+      ? NGF_FRAME_PACING_BEGIN_FRAME
+      : NGF_FRAME_PACING_END_FRAME;
+  if (info->mode != mode || frame < max_queued) {
+    return false;
+  }
+  *target = frame - max_queued;
+  return true;
+}
+
+// Transient image pools, see ngf_create_transient_pool. The bookkeeping is
+// shared by all back-ends, which only provide the images and, if they support
+// aliasing, the device memory blocks that images are bound to.
+#define _NGF_TRANSIENT_NO_BLOCK (~0u)
+
+// Number of resets after which an image that hasn't been acquired is
+// destroyed. Must be larger than the number of frames in flight.
+#define _NGF_TRANSIENT_MAX_IDLE_RESETS 8u
+
+// Device memory that several transient images may be bound to.
+typedef struct _ngf_transient_block {
+  void     *mem;              // Back-end handle of the memory.
+  uint64_t  offset;           // Offset of the block within device memory.
+  uint64_t  size;
+  uint32_t  memory_type_bits; // Memory types that the block belongs to.
+} _ngf_transient_block;
+
+// Creates a new image for the pool. If the image gets bound to a memory
+// block, `block` receives its index, otherwise _NGF_TRANSIENT_NO_BLOCK.
+typedef ngf_error (*_ngf_transient_create_fn)(
+    ngf_transient_pool              pool,
+    const ngf_transient_image_info *info,
+    ngf_image                      *result,
+    uint32_t                       *block);
+typedef void (*_ngf_transient_destroy_fn)(ngf_image image);
+typedef void (*_ngf_transient_free_block_fn)(const _ngf_transient_block *b);
+
+ngf_error _ngf_transient_pool_create(ngf_transient_pool *result);
+void _ngf_transient_pool_destroy(ngf_transient_pool           pool,
+                                 _ngf_transient_destroy_fn    destroy,
+                                 _ngf_transient_free_block_fn free_block);
+ngf_error _ngf_transient_acquire(ngf_transient_pool              pool,
+                                 const ngf_transient_image_info *info,
+                                 _ngf_transient_create_fn        create,
+                                 ngf_image                      *result);
+void _ngf_transient_pool_reset(ngf_transient_pool           pool,
+                               _ngf_transient_destroy_fn    destroy,
+                               _ngf_transient_free_block_fn free_block);
+void _ngf_transient_pool_stats(ngf_transient_pool        pool,
+                               ngf_transient_pool_stats *result);
+
+// Looks for a memory block that can hold an image with the given memory
+// requirements from `first_use` on, because none of the images bound to it
+// are needed anymore.
+bool _ngf_transient_find_block(ngf_transient_pool pool,
+                               uint64_t           size,
+                               uint64_t           alignment,
+                               uint32_t           memory_type_bits,
+                               uint32_t           first_use,
+                               uint32_t          *block);
+ngf_error _ngf_transient_add_block(ngf_transient_pool          pool,
+                                   const _ngf_transient_block *b,
+                                   uint32_t                   *block);
+const _ngf_transient_block* _ngf_transient_get_block(ngf_transient_pool pool,
+                                                     uint32_t block);
+
+// Timeline of CPU and GPU scopes, see ngf_begin_timeline_trace. Every thread
+// records the scopes it completes into a ring of its own. Only the owning
+// thread writes to a ring and only the thread flushing the trace reads from
+// it, so recording doesn't take any locks. Scopes that don't fit into a full
+// ring are dropped.
+#define _NGF_TIMELINE_RING_SIZE 4096u // Must be a power of two.
+
+// True while a timeline trace is being written.
+extern volatile bool _NGF_TIMELINE_ENABLED;
+
+// Appends a scope to the calling thread's ring. GPU scopes go on a separate
+// track of the timeline.
+void _ngf_timeline_record(const char *name,
+                          uint64_t    start_ns,
+                          uint64_t    duration_ns,
+                          bool        gpu);
+
+// Start time for a CPU scope, or 0 if no trace is being written.
+static inline uint64_t _ngf_timeline_now() {
+  return _NGF_TIMELINE_ENABLED ? _ngf_stats_now_ns() : 0u;
+}
+
+// Records a CPU scope that started at `start_ns` and ends now.
+static inline void _ngf_timeline_scope(const char *name, uint64_t start_ns) {
+  if (_NGF_TIMELINE_ENABLED && start_ns != 0u) {
+    _ngf_timeline_record(name, start_ns, _ngf_stats_now_ns() - start_ns,
+                         false);
+  }
+}
+
+// Records the scopes of a frame that has been read back. `origin_cpu_ns` is
+// the CPU time that corresponds to the start of the frame's first scope.
+void _ngf_timeline_gpu_frame(const _ngf_gpu_timing_results *results,
+                             uint64_t origin_cpu_ns);
+
 typedef enum {
   _NGF_CMD_BUFFER_READY,
   _NGF_CMD_BUFFER_RECORDING,
@@ -158,6 +446,13 @@ typedef enum {
 #define _NGF_CMD_BUF_RECORDABLE(s) (s == _NGF_CMD_BUFFER_READY || \
                                     s == _NGF_CMD_BUFFER_AWAITING_SUBMIT)
 
+// Implemented by the null backend only, for tests. Writes the commands that
+// have been recorded into `buf` and not submitted yet to `dst` as a string of
+// space-separated names. Resource and attribute buffer binds are followed by
+// the binding (e.g. "resource:1"), draws by the first element ("draw:3").
+// Returns the length of the full string, like snprintf.
+size_t _ngf_null_describe_cmds(ngf_cmd_buffer buf, char *dst, size_t dst_size);
+
 // Interlocked ops.
 #if defined(_WIN32)
 #define ATOMIC_INT ULONG
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Layout of the trace files written by the capture layer (nicegraf_capture.c)
+// and read by ngf_replay.
+//
+// A trace starts with a _ngf_trace_header, followed by a sequence of records.
+// Each record is a _ngf_trace_record_header followed by `payload_size` bytes
+// of arguments, in the order in which the corresponding entry point takes
+// them. Arguments are encoded as follows:
+//  - integers, enums and bools are stored as u32, sizes and offsets as u64;
+//  - handles (and encoders) are stored as the u64 value of the pointer at
+//    capture time, NULL is 0;
+//  - structures without pointers are stored verbatim, which ties a trace to
+//    the ABI it was captured on (see `pointer_size`);
+//  - strings are a u32 length followed by the characters (no terminator), with
+//    a length of _NGF_TRACE_NULL_STRING for NULL;
+//  - blobs are a u64 size followed by the bytes;
+//  - optional structures are a u32 presence flag followed by the structure.
+// Values are in the byte order of the capturing machine.
+
+#define _NGF_TRACE_MAGIC 0x454341525446474eull // "NGFTRACE"
+#define _NGF_TRACE_VERSION 1u
+#define _NGF_TRACE_NULL_STRING 0xffffffffu
+
+typedef struct {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t pointer_size;
+} _ngf_trace_header;
+
+typedef struct {
+  uint32_t op;
+  uint32_t payload_size;
+} _ngf_trace_record_header;
+
+typedef enum {
+  _NGF_TRACE_INITIALIZE = 1,
+  _NGF_TRACE_CREATE_CONTEXT,
+  _NGF_TRACE_DESTROY_CONTEXT,
+  _NGF_TRACE_RESIZE_CONTEXT,
+  _NGF_TRACE_SET_CONTEXT,
+  _NGF_TRACE_BEGIN_FRAME,
+  _NGF_TRACE_END_FRAME,
+  _NGF_TRACE_FINISH,
+  _NGF_TRACE_CREATE_SHADER_STAGE,
+  _NGF_TRACE_DESTROY_SHADER_STAGE,
+  _NGF_TRACE_CREATE_GRAPHICS_PIPELINE,
+  _NGF_TRACE_DESTROY_GRAPHICS_PIPELINE,
+  _NGF_TRACE_CREATE_COMPUTE_PIPELINE,
+  _NGF_TRACE_DESTROY_COMPUTE_PIPELINE,
+  _NGF_TRACE_CREATE_IMAGE,
+  _NGF_TRACE_DESTROY_IMAGE,
+  _NGF_TRACE_CREATE_SAMPLER,
+  _NGF_TRACE_DESTROY_SAMPLER,
+  _NGF_TRACE_DEFAULT_RENDER_TARGET,
+  _NGF_TRACE_CREATE_RENDER_TARGET,
+  _NGF_TRACE_RESOLVE_RENDER_TARGET,
+  _NGF_TRACE_DESTROY_RENDER_TARGET,
+  // Buffer records start with a _ngf_trace_buffer_kind.
+  _NGF_TRACE_CREATE_BUFFER,
+  _NGF_TRACE_DESTROY_BUFFER,
+  _NGF_TRACE_MAP_BUFFER,
+  _NGF_TRACE_FLUSH_BUFFER, // Carries the flushed bytes.
+  _NGF_TRACE_UNMAP_BUFFER,
+  _NGF_TRACE_CREATE_CMD_BUFFER,
+  _NGF_TRACE_DESTROY_CMD_BUFFER,
+  _NGF_TRACE_START_CMD_BUFFER,
+  _NGF_TRACE_SUBMIT_CMD_BUFFERS,
+  _NGF_TRACE_START_RENDER,
+  _NGF_TRACE_START_XFER,
+  _NGF_TRACE_START_COMPUTE,
+  _NGF_TRACE_RENDER_ENCODER_END,
+  _NGF_TRACE_XFER_ENCODER_END,
+  _NGF_TRACE_COMPUTE_ENCODER_END,
+  _NGF_TRACE_BIND_GFX_PIPELINE,
+  _NGF_TRACE_VIEWPORT,
+  _NGF_TRACE_SCISSOR,
+  _NGF_TRACE_STENCIL_REFERENCE,
+  _NGF_TRACE_STENCIL_COMPARE_MASK,
+  _NGF_TRACE_STENCIL_WRITE_MASK,
+  _NGF_TRACE_LINE_WIDTH,
+  _NGF_TRACE_BLEND_FACTORS,
+  _NGF_TRACE_BIND_GFX_RESOURCES,
+  _NGF_TRACE_SET_DYNAMIC_OFFSETS,
+  _NGF_TRACE_BIND_ATTRIB_BUFFER,
+  _NGF_TRACE_BIND_INDEX_BUFFER,
+  _NGF_TRACE_BEGIN_PASS,
+  _NGF_TRACE_END_PASS,
+  _NGF_TRACE_DRAW,
+  _NGF_TRACE_PUSH_CONSTANTS,
+  _NGF_TRACE_DRAW_INDIRECT,
+  _NGF_TRACE_BIND_COMPUTE_PIPELINE,
+  _NGF_TRACE_BIND_COMPUTE_RESOURCES,
+  _NGF_TRACE_DISPATCH,
+  _NGF_TRACE_PUSH_COMPUTE_CONSTANTS,
+  _NGF_TRACE_DISPATCH_INDIRECT,
+  _NGF_TRACE_COPY_BUFFER, // Starts with a _ngf_trace_buffer_kind.
+  _NGF_TRACE_WRITE_IMAGE,
+  _NGF_TRACE_BEGIN_DEBUG_GROUP,
+  _NGF_TRACE_END_DEBUG_GROUP,
+  _NGF_TRACE_BEGIN_COMPUTE_DEBUG_GROUP,
+  _NGF_TRACE_END_COMPUTE_DEBUG_GROUP,
+  _NGF_TRACE_OP_COUNT
+} _ngf_trace_op;
+
+typedef enum {
+  _NGF_TRACE_ATTRIB_BUFFER = 0,
+  _NGF_TRACE_INDEX_BUFFER,
+  _NGF_TRACE_UNIFORM_BUFFER,
+  _NGF_TRACE_PIXEL_BUFFER
+} _ngf_trace_buffer_kind;
@@ -22,6 +22,7 @@ SOFTWARE.
 
 #include "nicegraf_util.h"
 #include "nicegraf_internal.h"
+#include "dynamic_array.h"
 
 #include <assert.h>
 #include <string.h>
@@ -117,21 +118,65 @@ void ngf_util_create_default_graphics_pipeline_data(
   result->pipeline_info = gpi;
 }
 
-ngf_error ngf_util_create_simple_layout(const ngf_descriptor_info *desc,
-                                        uint32_t ndesc,
-                                        ngf_pipeline_layout_info *result) {
-  assert(desc);
+// Size of a block holding `nsets` descriptor set layouts, followed by
+// `ndescriptors` descriptors in total.
+static size_t _ngf_util_layout_storage_size(uint32_t nsets,
+                                            uint32_t ndescriptors) {
+  return sizeof(ngf_descriptor_set_layout_info) * nsets +
+         sizeof(ngf_descriptor_info) * ndescriptors;
+}
+
+size_t ngf_util_simple_layout_storage_size(uint32_t ndesc) {
+  return _ngf_util_layout_storage_size(1u, ndesc);
+}
+
+void ngf_util_create_simple_layout_in_storage(
+    const ngf_descriptor_info *desc,
+    uint32_t ndesc,
+    void *storage,
+    ngf_pipeline_layout_info *result) {
+  assert(desc || ndesc == 0u);
+  assert(storage);
   assert(result);
-  ngf_error err = NGF_ERROR_OK;
-  result->ndescriptor_set_layouts = 1u;
   ngf_descriptor_set_layout_info *dsl =
-      NGF_ALLOC(ngf_descriptor_set_layout_info);
-  ngf_descriptor_info *desc_copy = NGF_ALLOCN(ngf_descriptor_info, ndesc);
-  memcpy(desc_copy, desc, ndesc * sizeof(ngf_descriptor_info));
+      (ngf_descriptor_set_layout_info*)storage;
+  ngf_descriptor_info *desc_copy = (ngf_descriptor_info*)(dsl + 1);
+  if (ndesc > 0u) {
+    memcpy(desc_copy, desc, ndesc * sizeof(ngf_descriptor_info));
+  }
   dsl->descriptors = desc_copy;
   dsl->ndescriptors = ndesc;
+  result->ndescriptor_set_layouts = 1u;
   result->descriptor_set_layouts = dsl;
-  return err;
+  result->push_constants_size = 0u;
+  result->push_constants_stage_flags = 0u;
+}
+
+ngf_error ngf_util_create_simple_layout(const ngf_descriptor_info *desc,
+                                        uint32_t ndesc,
+                                        ngf_pipeline_layout_info *result) {
+  assert(result);
+  uint8_t *storage =
+      NGF_ALLOCN(uint8_t, ngf_util_simple_layout_storage_size(ndesc));
+  if (storage == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  ngf_util_create_simple_layout_in_storage(desc, ndesc, storage, result);
+  return NGF_ERROR_OK;
+}
+
+void ngf_util_destroy_layout(ngf_pipeline_layout_info *layout) {
+  if (layout != NULL && layout->descriptor_set_layouts != NULL) {
+    uint32_t ndescriptors = 0u;
+    for (uint32_t s = 0u; s < layout->ndescriptor_set_layouts; ++s) {
+      ndescriptors += layout->descriptor_set_layouts[s].ndescriptors;
+    }
+    NGF_FREEN((uint8_t*)layout->descriptor_set_layouts,
+              _ngf_util_layout_storage_size(layout->ndescriptor_set_layouts,
+                                            ndescriptors));
+    layout->descriptor_set_layouts = NULL;
+    layout->ndescriptor_set_layouts = 0u;
+  }
 }
 
 ngf_descriptor_type _plmd_desc_to_ngf(uint32_t plmd_desc_type) {
@@ -144,6 +189,10 @@ ngf_descriptor_type _plmd_desc_to_ngf(uint32_t plmd_desc_type) {
     return NGF_DESCRIPTOR_SAMPLER;
   case NGF_PLMD_DESC_COMBINED_IMAGE_SAMPLER:
     return NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER;
+  case NGF_PLMD_DESC_STORAGE_BUFFER:
+    return NGF_DESCRIPTOR_STORAGE_BUFFER;
+  case NGF_PLMD_DESC_LOADSTORE_IMAGE:
+    return NGF_DESCRIPTOR_STORAGE_IMAGE;
   default:
     assert(false);
     return 0u;
@@ -156,49 +205,49 @@ uint32_t _plmd_stage_flags_to_ngf(uint32_t plmd_stage_flags) {
     result |= NGF_DESCRIPTOR_VERTEX_STAGE_BIT;
   if (plmd_stage_flags & NGF_PLMD_STAGE_VISIBILITY_FRAGMENT_BIT)
     result |= NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT;
+  if (plmd_stage_flags & NGF_PLMD_STAGE_VISIBILITY_COMPUTE_BIT)
+    result |= NGF_DESCRIPTOR_COMPUTE_STAGE_BIT;
   return result;
 }
 
-ngf_error ngf_util_create_pipeline_layout_from_metadata(
+size_t ngf_util_pipeline_layout_storage_size(
+    const ngf_plmd_layout *layout_metadata) {
+  assert(layout_metadata);
+  uint32_t ndescriptors = 0u;
+  for (uint32_t set = 0u; set < layout_metadata->ndescriptor_sets; ++set) {
+    ndescriptors += layout_metadata->set_layouts[set]->ndescriptors;
+  }
+  return _ngf_util_layout_storage_size(layout_metadata->ndescriptor_sets,
+                                       ndescriptors);
+}
+
+void ngf_util_create_pipeline_layout_from_metadata_in_storage(
     const ngf_plmd_layout *layout_metadata,
+    void *storage,
     ngf_pipeline_layout_info *result) {
   assert(layout_metadata);
+  assert(storage || layout_metadata->ndescriptor_sets == 0u);
   assert(result);
 
-  ngf_error err = NGF_ERROR_OK;
-  ngf_descriptor_set_layout_info *descriptor_set_layout_infos = NULL;
-  descriptor_set_layout_infos = NGF_ALLOCN(ngf_descriptor_set_layout_info,
-                                           layout_metadata->ndescriptor_sets);
-  if (descriptor_set_layout_infos == NULL) {
-    err = NGF_ERROR_OUTOFMEM;
-    goto ngf_util_create_pipeline_layout_from_metadata_cleanup;
-  }
-  memset(descriptor_set_layout_infos, 0,
-         sizeof(ngf_descriptor_set_layout_info) *
-           layout_metadata->ndescriptor_sets);
+  // Descriptor set layouts come first, followed by the descriptors of all the
+  // sets.
+  ngf_descriptor_set_layout_info *descriptor_set_layout_infos =
+      (ngf_descriptor_set_layout_info*)storage;
+  ngf_descriptor_info *descriptors = (ngf_descriptor_info*)
+      (descriptor_set_layout_infos + layout_metadata->ndescriptor_sets);
 
   result->ndescriptor_set_layouts = layout_metadata->ndescriptor_sets;
   result->descriptor_set_layouts = descriptor_set_layout_infos;
-  
-  if (descriptor_set_layout_infos == NULL) {
-    err = NGF_ERROR_OUTOFMEM;
-    goto ngf_util_create_pipeline_layout_from_metadata_cleanup;
-  }
+  result->push_constants_size = 0u;
+  result->push_constants_stage_flags = 0u;
 
   for (uint32_t set = 0u; set < layout_metadata->ndescriptor_sets; ++set) {
+    const ngf_plmd_descriptor_set_layout *descriptor_set_metadata =
+        layout_metadata->set_layouts[set];
     ngf_descriptor_set_layout_info *set_layout_info =
        &descriptor_set_layout_infos[set];
-    set_layout_info->ndescriptors =
-        layout_metadata->set_layouts[set]->ndescriptors;
-    ngf_descriptor_info *descriptors =
-        NGF_ALLOCN(ngf_descriptor_info, set_layout_info->ndescriptors);
+    set_layout_info->ndescriptors = descriptor_set_metadata->ndescriptors;
     set_layout_info->descriptors = descriptors;
-    if (set_layout_info->descriptors == NULL) {
-      err = NGF_ERROR_OUTOFMEM;
-      goto ngf_util_create_pipeline_layout_from_metadata_cleanup;
-    }
-    const ngf_plmd_descriptor_set_layout *descriptor_set_metadata =
-        layout_metadata->set_layouts[set];
     for (uint32_t d = 0u; d < set_layout_info->ndescriptors; ++d) {
       const ngf_plmd_descriptor *descriptor_metadata =
           &descriptor_set_metadata->descriptors[d];
@@ -207,9 +256,29 @@ ngf_error ngf_util_create_pipeline_layout_from_metadata(
       descriptors[d].stage_flags =
           _plmd_stage_flags_to_ngf(descriptor_metadata->stage_visibility_mask);
     }
+    descriptors += set_layout_info->ndescriptors;
   }
-ngf_util_create_pipeline_layout_from_metadata_cleanup:
-  return err;
+}
+
+ngf_error ngf_util_create_pipeline_layout_from_metadata(
+    const ngf_plmd_layout *layout_metadata,
+    ngf_pipeline_layout_info *result) {
+  assert(layout_metadata);
+  assert(result);
+  // A layout without descriptor sets needs no storage. Allocating zero bytes
+  // may return NULL, which must not be mistaken for running out of memory.
+  const size_t storage_size =
+      ngf_util_pipeline_layout_storage_size(layout_metadata);
+  uint8_t *storage = NULL;
+  if (storage_size > 0u) {
+    storage = NGF_ALLOCN(uint8_t, storage_size);
+    if (storage == NULL) {
+      return NGF_ERROR_OUTOFMEM;
+    }
+  }
+  ngf_util_create_pipeline_layout_from_metadata_in_storage(layout_metadata,
+                                                           storage, result);
+  return NGF_ERROR_OK;
 }
 
 const char* ngf_util_get_error_name(const ngf_error err) {
@@ -252,3 +321,823 @@ const char* ngf_util_get_error_name(const ngf_error err) {
   };
   return ngf_error_names[err];
 }
+
+uint64_t ngf_util_make_sort_key(const ngf_util_sort_key_layout *layout,
+                                uint32_t pass,
+                                uint32_t pipeline,
+                                uint32_t material,
+                                uint32_t depth) {
+  assert(layout);
+  assert(layout->pass_bits <= 32u && layout->pipeline_bits <= 32u &&
+         layout->material_bits <= 32u && layout->depth_bits <= 32u);
+  assert((uint32_t)layout->pass_bits + layout->pipeline_bits +
+         layout->material_bits + layout->depth_bits <= 64u);
+  const uint32_t fields[] = { pass, pipeline, material, depth };
+  const uint8_t  bits[]   = { layout->pass_bits, layout->pipeline_bits,
+                              layout->material_bits, layout->depth_bits };
+  uint64_t key = 0u;
+  for (uint32_t f = 0u; f < NGF_ARRAYSIZE(fields); ++f) {
+    const uint64_t mask = (bits[f] == 0u) ? 0u : (~0ull >> (64u - bits[f]));
+    key = (bits[f] == 0u) ? key : ((key << bits[f]) | (fields[f] & mask));
+  }
+  return key;
+}
+
+typedef struct {
+  ngf_graphics_pipeline pipeline;
+  uint32_t first_bind_op;
+  uint32_t nbind_ops;
+  uint32_t first_attrib_buffer;
+  uint32_t nattrib_buffers;
+  ngf_index_buffer index_buffer;
+  ngf_type index_type;
+  uint32_t first_element;
+  uint32_t nelements;
+  uint32_t ninstances;
+} _ngf_util_queued_draw;
+
+struct ngf_util_draw_queue_t {
+  _NGF_DARRAY_OF(_ngf_util_queued_draw) draws;
+  _NGF_DARRAY_OF(uint64_t) keys;
+  _NGF_DARRAY_OF(ngf_resource_bind_op) bind_ops;
+  _NGF_DARRAY_OF(ngf_util_attrib_buffer_bind_op) attrib_buffers;
+  uint64_t *sort_keys;     // Keys being sorted, followed by scratch space.
+  uint32_t *sort_indices;  // Draw indices being sorted, followed by scratch.
+  uint32_t  sort_capacity;
+};
+
+ngf_error ngf_util_create_draw_queue(uint32_t capacity_hint,
+                                     ngf_util_draw_queue *result) {
+  assert(result);
+  ngf_util_draw_queue queue = NGF_ALLOC(struct ngf_util_draw_queue_t);
+  *result = queue;
+  if (queue == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  const uint32_t capacity = NGF_MAX(capacity_hint, 1u);
+  _NGF_DARRAY_RESET(queue->draws, capacity);
+  _NGF_DARRAY_RESET(queue->keys, capacity);
+  _NGF_DARRAY_RESET(queue->bind_ops, capacity);
+  _NGF_DARRAY_RESET(queue->attrib_buffers, capacity);
+  queue->sort_keys     = NULL;
+  queue->sort_indices  = NULL;
+  queue->sort_capacity = 0u;
+  return NGF_ERROR_OK;
+}
+
+void ngf_util_destroy_draw_queue(ngf_util_draw_queue queue) {
+  if (queue != NULL) {
+    _NGF_DARRAY_DESTROY(queue->draws);
+    _NGF_DARRAY_DESTROY(queue->keys);
+    _NGF_DARRAY_DESTROY(queue->bind_ops);
+    _NGF_DARRAY_DESTROY(queue->attrib_buffers);
+    if (queue->sort_keys != NULL) {
+      NGF_FREEN(queue->sort_keys, 2u * queue->sort_capacity);
+      NGF_FREEN(queue->sort_indices, 2u * queue->sort_capacity);
+    }
+    NGF_FREE(queue);
+  }
+}
+
+ngf_error ngf_util_draw_queue_add(ngf_util_draw_queue queue,
+                                  const ngf_util_draw_info *draw) {
+  assert(queue);
+  assert(draw);
+  assert(draw->pipeline);
+  const _ngf_util_queued_draw queued_draw = {
+    .pipeline            = draw->pipeline,
+    .first_bind_op       = _NGF_DARRAY_SIZE(queue->bind_ops),
+    .nbind_ops           = draw->nbind_ops,
+    .first_attrib_buffer = _NGF_DARRAY_SIZE(queue->attrib_buffers),
+    .nattrib_buffers     = draw->nattrib_buffers,
+    .index_buffer        = draw->index_buffer,
+    .index_type          = draw->index_type,
+    .first_element       = draw->first_element,
+    .nelements           = draw->nelements,
+    .ninstances          = draw->ninstances
+  };
+  for (uint32_t i = 0u; i < draw->nbind_ops; ++i) {
+    _NGF_DARRAY_APPEND(queue->bind_ops, draw->bind_ops[i]);
+  }
+  for (uint32_t i = 0u; i < draw->nattrib_buffers; ++i) {
+    _NGF_DARRAY_APPEND(queue->attrib_buffers, draw->attrib_buffers[i]);
+  }
+  _NGF_DARRAY_APPEND(queue->draws, queued_draw);
+  _NGF_DARRAY_APPEND(queue->keys, draw->sort_key);
+  return NGF_ERROR_OK;
+}
+
+static bool _ngf_util_ranges_equal(const void *a,
+                                   uint32_t    na,
+                                   const void *b,
+                                   uint32_t    nb,
+                                   size_t      elem_size) {
+  return na == nb && (a == b || memcmp(a, b, elem_size * na) == 0);
+}
+
+void ngf_util_draw_queue_flush(ngf_util_draw_queue queue,
+                               ngf_render_encoder enc) {
+  assert(queue);
+  const uint32_t ndraws = _NGF_DARRAY_SIZE(queue->draws);
+  if (ndraws == 0u) {
+    return;
+  }
+
+  // Make sure there's enough room for sorting.
+  if (queue->sort_capacity < ndraws) {
+    if (queue->sort_keys != NULL) {
+      NGF_FREEN(queue->sort_keys, 2u * queue->sort_capacity);
+      NGF_FREEN(queue->sort_indices, 2u * queue->sort_capacity);
+    }
+    queue->sort_capacity = queue->draws.capacity;
+    queue->sort_keys     = NGF_ALLOCN(uint64_t, 2u * queue->sort_capacity);
+    queue->sort_indices  = NGF_ALLOCN(uint32_t, 2u * queue->sort_capacity);
+    if (queue->sort_keys == NULL || queue->sort_indices == NULL) {
+      // Can't sort, fall back to submission order.
+      if (queue->sort_keys != NULL) {
+        NGF_FREEN(queue->sort_keys, 2u * queue->sort_capacity);
+      }
+      if (queue->sort_indices != NULL) {
+        NGF_FREEN(queue->sort_indices, 2u * queue->sort_capacity);
+      }
+      queue->sort_keys     = NULL;
+      queue->sort_indices  = NULL;
+      queue->sort_capacity = 0u;
+    }
+  }
+
+  const uint32_t *order = NULL;
+  if (queue->sort_keys != NULL) {
+    memcpy(queue->sort_keys, queue->keys.data, sizeof(uint64_t) * ndraws);
+    for (uint32_t i = 0u; i < ndraws; ++i) queue->sort_indices[i] = i;
+    _ngf_radix_sort_u64(queue->sort_keys,
+                        queue->sort_indices,
+                        queue->sort_keys + queue->sort_capacity,
+                        queue->sort_indices + queue->sort_capacity,
+                        ndraws);
+    order = queue->sort_indices;
+  }
+
+  // Record the draws, skipping binds that would not change anything.
+  ngf_graphics_pipeline bound_pipeline = NULL;
+  const ngf_resource_bind_op *bound_ops = NULL;
+  uint32_t nbound_ops = 0u;
+  const ngf_util_attrib_buffer_bind_op *bound_attribs = NULL;
+  uint32_t nbound_attribs = 0u;
+  ngf_index_buffer bound_index_buffer = NULL;
+  ngf_type bound_index_type = NGF_TYPE_UINT16;
+  for (uint32_t i = 0u; i < ndraws; ++i) {
+    const _ngf_util_queued_draw *draw =
+        &_NGF_DARRAY_AT(queue->draws, order ? order[i] : i);
+    if (draw->pipeline != bound_pipeline) {
+      ngf_cmd_bind_gfx_pipeline(enc, draw->pipeline);
+      bound_pipeline = draw->pipeline;
+      // Native binding slots may differ between pipelines, so resources have
+      // to be bound again after a pipeline switch.
+      bound_ops  = NULL;
+      nbound_ops = 0u;
+    }
+    const ngf_resource_bind_op *ops =
+        &_NGF_DARRAY_AT(queue->bind_ops, draw->first_bind_op);
+    if (draw->nbind_ops > 0u &&
+        (bound_ops == NULL ||
+         !_ngf_util_ranges_equal(ops, draw->nbind_ops, bound_ops, nbound_ops,
+                                 sizeof(ngf_resource_bind_op)))) {
+      ngf_cmd_bind_gfx_resources(enc, ops, draw->nbind_ops);
+      bound_ops  = ops;
+      nbound_ops = draw->nbind_ops;
+    }
+    const ngf_util_attrib_buffer_bind_op *attribs =
+        &_NGF_DARRAY_AT(queue->attrib_buffers, draw->first_attrib_buffer);
+    if (draw->nattrib_buffers > 0u &&
+        (bound_attribs == NULL ||
+         !_ngf_util_ranges_equal(attribs, draw->nattrib_buffers,
+                                 bound_attribs, nbound_attribs,
+                                 sizeof(ngf_util_attrib_buffer_bind_op)))) {
+      for (uint32_t a = 0u; a < draw->nattrib_buffers; ++a) {
+        ngf_cmd_bind_attrib_buffer(enc, attribs[a].buffer, attribs[a].binding,
+                                   attribs[a].offset);
+      }
+      bound_attribs  = attribs;
+      nbound_attribs = draw->nattrib_buffers;
+    }
+    if (draw->index_buffer != NULL &&
+        (draw->index_buffer != bound_index_buffer ||
+         draw->index_type != bound_index_type)) {
+      ngf_cmd_bind_index_buffer(enc, draw->index_buffer, draw->index_type);
+      bound_index_buffer = draw->index_buffer;
+      bound_index_type   = draw->index_type;
+    }
+    ngf_cmd_draw(enc, draw->index_buffer != NULL, draw->first_element,
+                 draw->nelements, draw->ninstances);
+  }
+
+  _NGF_DARRAY_CLEAR(queue->draws);
+  _NGF_DARRAY_CLEAR(queue->keys);
+  _NGF_DARRAY_CLEAR(queue->bind_ops);
+  _NGF_DARRAY_CLEAR(queue->attrib_buffers);
+}
+
+// Render targets that haven't been used for this many executions are
+// destroyed. Must be less than _NGF_TRANSIENT_MAX_IDLE_RESETS, so that render
+// targets go away before the transient images they refer to.
+#define _NGF_UTIL_RG_MAX_IDLE_EXECUTIONS 4u
+
+typedef struct {
+  ngf_image_info  info;
+  ngf_image       image;     // Imported image, or the acquired transient one.
+  const void     *handle;    // Imported image or buffer.
+  bool            transient;
+  uint32_t        first_use; // Index of the first pass using the resource.
+  uint32_t        last_use;  // Index of the last pass using the resource.
+  bool            needed;    // Used while culling.
+  uint32_t        group_reads;  // Last encoder group reading the resource.
+  uint32_t        group_writes; // Last encoder group writing the resource.
+} _ngf_util_rg_resource;
+
+typedef struct {
+  ngf_util_rg_pass_info info; // Arrays point into the graph's storage.
+  uint32_t first_attachment;
+  uint32_t first_read;
+  uint32_t first_write;
+  bool     culled;
+  bool     new_encoder; // Whether the pass starts a new encoder.
+  ngf_attachment_load_op  load_ops[NGF_UTIL_RG_MAX_ATTACHMENTS];
+  ngf_attachment_store_op store_ops[NGF_UTIL_RG_MAX_ATTACHMENTS];
+} _ngf_util_rg_pass;
+
+typedef struct {
+  ngf_attachment    attachments[NGF_UTIL_RG_MAX_ATTACHMENTS];
+  uint32_t          nattachments;
+  ngf_render_target rt;
+  uint64_t          last_used; // Execution in which the target was last used.
+} _ngf_util_rg_cached_rt;
+
+struct ngf_util_render_graph_t {
+  _NGF_DARRAY_OF(_ngf_util_rg_resource)  resources;
+  _NGF_DARRAY_OF(_ngf_util_rg_pass)      passes;
+  _NGF_DARRAY_OF(ngf_util_rg_attachment) attachments;
+  _NGF_DARRAY_OF(ngf_util_rg_resource)   accesses; // Reads and writes.
+  _NGF_DARRAY_OF(_ngf_util_rg_cached_rt) rts;
+  ngf_transient_pool pool;
+  uint64_t           nexecutions;
+  bool               compiled;
+};
+
+ngf_error ngf_util_create_render_graph(ngf_util_render_graph *result) {
+  assert(result);
+  ngf_util_render_graph graph = NGF_ALLOC(struct ngf_util_render_graph_t);
+  *result = graph;
+  if (graph == NULL) {
+    return NGF_ERROR_OUTOFMEM;
+  }
+  memset(graph, 0, sizeof(*graph));
+  const ngf_error err = ngf_create_transient_pool(&graph->pool);
+  if (err != NGF_ERROR_OK) {
+    NGF_FREE(graph);
+    *result = NULL;
+    return err;
+  }
+  _NGF_DARRAY_RESET(graph->resources, 16u);
+  _NGF_DARRAY_RESET(graph->passes, 16u);
+  _NGF_DARRAY_RESET(graph->attachments, 16u);
+  _NGF_DARRAY_RESET(graph->accesses, 32u);
+  _NGF_DARRAY_RESET(graph->rts, 8u);
+  return NGF_ERROR_OK;
+}
+
+void ngf_util_destroy_render_graph(ngf_util_render_graph graph) {
+  if (graph != NULL) {
+    for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(graph->rts); ++i) {
+      ngf_destroy_render_target(_NGF_DARRAY_AT(graph->rts, i).rt);
+    }
+    ngf_destroy_transient_pool(graph->pool);
+    _NGF_DARRAY_DESTROY(graph->resources);
+    _NGF_DARRAY_DESTROY(graph->passes);
+    _NGF_DARRAY_DESTROY(graph->attachments);
+    _NGF_DARRAY_DESTROY(graph->accesses);
+    _NGF_DARRAY_DESTROY(graph->rts);
+    NGF_FREE(graph);
+  }
+}
+
+void ngf_util_render_graph_reset(ngf_util_render_graph graph) {
+  assert(graph);
+  _NGF_DARRAY_CLEAR(graph->resources);
+  _NGF_DARRAY_CLEAR(graph->passes);
+  _NGF_DARRAY_CLEAR(graph->attachments);
+  _NGF_DARRAY_CLEAR(graph->accesses);
+  graph->compiled = false;
+}
+
+static ngf_util_rg_resource _ngf_util_rg_add_resource(
+    ngf_util_render_graph        graph,
+    const _ngf_util_rg_resource *resource) {
+  _NGF_DARRAY_APPEND(graph->resources, *resource);
+  graph->compiled = false;
+  return _NGF_DARRAY_SIZE(graph->resources) - 1u;
+}
+
+ngf_util_rg_resource ngf_util_render_graph_create_image(
+    ngf_util_render_graph graph,
+    const ngf_image_info *info) {
+  assert(graph);
+  assert(info);
+  _ngf_util_rg_resource resource;
+  memset(&resource, 0, sizeof(resource));
+  resource.info = *info;
+  resource.transient = true;
+  return _ngf_util_rg_add_resource(graph, &resource);
+}
+
+ngf_util_rg_resource ngf_util_render_graph_import(ngf_util_render_graph graph,
+                                                  const void *handle) {
+  assert(graph);
+  _ngf_util_rg_resource resource;
+  memset(&resource, 0, sizeof(resource));
+  resource.handle = handle;
+  return _ngf_util_rg_add_resource(graph, &resource);
+}
+
+ngf_error ngf_util_render_graph_add_pass(ngf_util_render_graph graph,
+                                         const ngf_util_rg_pass_info *info) {
+  assert(graph);
+  assert(info);
+  if (info->nattachments > NGF_UTIL_RG_MAX_ATTACHMENTS) {
+    return NGF_ERROR_OUT_OF_BOUNDS;
+  }
+  _ngf_util_rg_pass pass;
+  memset(&pass, 0, sizeof(pass));
+  pass.info = *info;
+  pass.first_attachment = _NGF_DARRAY_SIZE(graph->attachments);
+  pass.first_read = _NGF_DARRAY_SIZE(graph->accesses);
+  pass.first_write = pass.first_read + info->nreads;
+  for (uint32_t i = 0u; i < info->nattachments; ++i) {
+    _NGF_DARRAY_APPEND(graph->attachments, info->attachments[i]);
+  }
+  for (uint32_t i = 0u; i < info->nreads; ++i) {
+    _NGF_DARRAY_APPEND(graph->accesses, info->reads[i]);
+  }
+  for (uint32_t i = 0u; i < info->nwrites; ++i) {
+    _NGF_DARRAY_APPEND(graph->accesses, info->writes[i]);
+  }
+  _NGF_DARRAY_APPEND(graph->passes, pass);
+  graph->compiled = false;
+  return NGF_ERROR_OK;
+}
+
+static const ngf_util_rg_attachment* _ngf_util_rg_attachment(
+    ngf_util_render_graph    graph,
+    const _ngf_util_rg_pass *pass,
+    uint32_t                 i) {
+  return &_NGF_DARRAY_AT(graph->attachments, pass->first_attachment + i);
+}
+
+static ngf_util_rg_resource _ngf_util_rg_read(ngf_util_render_graph    graph,
+                                              const _ngf_util_rg_pass *pass,
+                                              uint32_t                 i) {
+  return _NGF_DARRAY_AT(graph->accesses, pass->first_read + i);
+}
+
+static ngf_util_rg_resource _ngf_util_rg_write(ngf_util_render_graph    graph,
+                                               const _ngf_util_rg_pass *pass,
+                                               uint32_t                 i) {
+  return _NGF_DARRAY_AT(graph->accesses, pass->first_write + i);
+}
+
+// Culls the passes whose results nothing depends on, going from the last
+// pass to the first. Resources are needed if they are imported, or if a pass
+// that is kept reads them. An attachment that isn't loaded overwrites the
+// image, so whatever was written to it before isn't needed anymore.
+static void _ngf_util_rg_cull(ngf_util_render_graph graph) {
+  for (uint32_t r = 0u; r < _NGF_DARRAY_SIZE(graph->resources); ++r) {
+    _ngf_util_rg_resource *res = &_NGF_DARRAY_AT(graph->resources, r);
+    res->needed = !res->transient;
+  }
+  for (uint32_t p = _NGF_DARRAY_SIZE(graph->passes); p-- > 0u;) {
+    _ngf_util_rg_pass *pass = &_NGF_DARRAY_AT(graph->passes, p);
+    bool keep = pass->info.side_effects;
+    for (uint32_t a = 0u; !keep && a < pass->info.nattachments; ++a) {
+      const ngf_util_rg_attachment *att = _ngf_util_rg_attachment(graph,
+                                                                  pass, a);
+      keep = _NGF_DARRAY_AT(graph->resources, att->image).needed;
+    }
+    for (uint32_t w = 0u; !keep && w < pass->info.nwrites; ++w) {
+      const ngf_util_rg_resource r = _ngf_util_rg_write(graph, pass, w);
+      keep = _NGF_DARRAY_AT(graph->resources, r).needed;
+    }
+    pass->culled = !keep;
+    if (!keep) {
+      continue;
+    }
+    for (uint32_t a = 0u; a < pass->info.nattachments; ++a) {
+      const ngf_util_rg_attachment *att = _ngf_util_rg_attachment(graph,
+                                                                  pass, a);
+      _NGF_DARRAY_AT(graph->resources, att->image).needed =
+          att->load_op == NGF_LOAD_OP_KEEP;
+    }
+    for (uint32_t r = 0u; r < pass->info.nreads; ++r) {
+      const ngf_util_rg_resource res = _ngf_util_rg_read(graph, pass, r);
+      _NGF_DARRAY_AT(graph->resources, res).needed = true;
+    }
+  }
+}
+
+// Extends the lifetime of a resource to cover the given pass.
+static void _ngf_util_rg_use(ngf_util_render_graph graph,
+                             ngf_util_rg_resource  r,
+                             uint32_t              p) {
+  _ngf_util_rg_resource *res = &_NGF_DARRAY_AT(graph->resources, r);
+  if (res->first_use == ~0u) {
+    res->first_use = p;
+  }
+  res->last_use = p;
+}
+
+// Whether the given compute pass depends on, or would overwrite the inputs
+// of, a pass in the current encoder group. Dispatches within the same compute
+// encoder may execute concurrently, so such passes need a new encoder.
+static bool _ngf_util_rg_conflicts(ngf_util_render_graph    graph,
+                                   const _ngf_util_rg_pass *pass,
+                                   uint32_t                 group) {
+  for (uint32_t r = 0u; r < pass->info.nreads; ++r) {
+    const ngf_util_rg_resource res = _ngf_util_rg_read(graph, pass, r);
+    if (_NGF_DARRAY_AT(graph->resources, res).group_writes == group) {
+      return true;
+    }
+  }
+  for (uint32_t w = 0u; w < pass->info.nwrites; ++w) {
+    const _ngf_util_rg_resource *res =
+        &_NGF_DARRAY_AT(graph->resources, _ngf_util_rg_write(graph, pass, w));
+    if (res->group_writes == group || res->group_reads == group) {
+      return true;
+    }
+  }
+  return false;
+}
+
+ngf_error ngf_util_render_graph_compile(ngf_util_render_graph graph,
+                                        ngf_util_rg_stats *stats) {
+  assert(graph);
+  const uint32_t nresources = _NGF_DARRAY_SIZE(graph->resources);
+  const uint32_t npasses = _NGF_DARRAY_SIZE(graph->passes);
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(graph->attachments); ++i) {
+    if (_NGF_DARRAY_AT(graph->attachments, i).image >= nresources) {
+      return NGF_ERROR_OUT_OF_BOUNDS;
+    }
+  }
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(graph->accesses); ++i) {
+    if (_NGF_DARRAY_AT(graph->accesses, i) >= nresources) {
+      return NGF_ERROR_OUT_OF_BOUNDS;
+    }
+  }
+  graph->compiled = false;
+  _ngf_util_rg_cull(graph);
+
+  // Work out lifetimes, and check that transient images are written to
+  // before they're read.
+  for (uint32_t r = 0u; r < nresources; ++r) {
+    _ngf_util_rg_resource *res = &_NGF_DARRAY_AT(graph->resources, r);
+    res->first_use = ~0u;
+    res->last_use = 0u;
+    res->group_reads = res->group_writes = ~0u;
+  }
+  for (uint32_t p = 0u; p < npasses; ++p) {
+    const _ngf_util_rg_pass *pass = &_NGF_DARRAY_AT(graph->passes, p);
+    if (pass->culled) {
+      continue;
+    }
+    for (uint32_t r = 0u; r < pass->info.nreads; ++r) {
+      const ngf_util_rg_resource res = _ngf_util_rg_read(graph, pass, r);
+      if (_NGF_DARRAY_AT(graph->resources, res).transient &&
+          _NGF_DARRAY_AT(graph->resources, res).first_use == ~0u) {
+        return NGF_ERROR_INVALID_OPERATION;
+      }
+      _ngf_util_rg_use(graph, res, p);
+    }
+    for (uint32_t a = 0u; a < pass->info.nattachments; ++a) {
+      _ngf_util_rg_use(graph, _ngf_util_rg_attachment(graph, pass, a)->image,
+                       p);
+    }
+    for (uint32_t w = 0u; w < pass->info.nwrites; ++w) {
+      _ngf_util_rg_use(graph, _ngf_util_rg_write(graph, pass, w), p);
+    }
+  }
+
+  // Don't load or store attachment contents that no other pass uses, and
+  // batch passes into encoders.
+  ngf_util_rg_stats s;
+  memset(&s, 0, sizeof(s));
+  s.npasses = npasses;
+  const _ngf_util_rg_pass *prev_pass = NULL;
+  for (uint32_t p = 0u; p < npasses; ++p) {
+    _ngf_util_rg_pass *pass = &_NGF_DARRAY_AT(graph->passes, p);
+    if (pass->culled) {
+      ++s.nculled_passes;
+      continue;
+    }
+    for (uint32_t a = 0u; a < pass->info.nattachments; ++a) {
+      const ngf_util_rg_attachment *att = _ngf_util_rg_attachment(graph,
+                                                                  pass, a);
+      const _ngf_util_rg_resource *res =
+          &_NGF_DARRAY_AT(graph->resources, att->image);
+      pass->load_ops[a] =
+          (att->load_op == NGF_LOAD_OP_KEEP && res->transient &&
+           res->first_use == p) ? NGF_LOAD_OP_DONTCARE : att->load_op;
+      pass->store_ops[a] = (!res->transient || res->last_use > p)
+                               ? NGF_STORE_OP_STORE
+                               : NGF_STORE_OP_DONTCARE;
+    }
+    // Render passes always get an encoder of their own, since some backends
+    // (e.g. Vulkan) finish the encoder when its render pass ends.
+    pass->new_encoder =
+        prev_pass == NULL || prev_pass->info.type != pass->info.type ||
+        pass->info.type == NGF_UTIL_RG_PASS_RENDER ||
+        (pass->info.type == NGF_UTIL_RG_PASS_COMPUTE &&
+         _ngf_util_rg_conflicts(graph, pass, s.nencoders));
+    if (pass->new_encoder) {
+      ++s.nencoders;
+    }
+    for (uint32_t r = 0u; r < pass->info.nreads; ++r) {
+      const ngf_util_rg_resource res = _ngf_util_rg_read(graph, pass, r);
+      _NGF_DARRAY_AT(graph->resources, res).group_reads = s.nencoders;
+    }
+    for (uint32_t w = 0u; w < pass->info.nwrites; ++w) {
+      const ngf_util_rg_resource res = _ngf_util_rg_write(graph, pass, w);
+      _NGF_DARRAY_AT(graph->resources, res).group_writes = s.nencoders;
+    }
+    prev_pass = pass;
+  }
+  for (uint32_t r = 0u; r < nresources; ++r) {
+    const _ngf_util_rg_resource *res = &_NGF_DARRAY_AT(graph->resources, r);
+    if (res->transient && res->first_use != ~0u) {
+      ++s.ntransient_images;
+    }
+  }
+  if (stats != NULL) {
+    *stats = s;
+  }
+  graph->compiled = true;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_util_render_graph_get_compiled_pass(
+    ngf_util_render_graph      graph,
+    uint32_t                   pass_index,
+    ngf_util_rg_compiled_pass *result) {
+  assert(graph);
+  assert(result);
+  if (!graph->compiled) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (pass_index >= _NGF_DARRAY_SIZE(graph->passes)) {
+    return NGF_ERROR_OUT_OF_BOUNDS;
+  }
+  const _ngf_util_rg_pass *pass = &_NGF_DARRAY_AT(graph->passes, pass_index);
+  memset(result, 0, sizeof(*result));
+  result->culled = pass->culled;
+  result->new_encoder = !pass->culled && pass->new_encoder;
+  if (!pass->culled) {
+    memcpy(result->load_ops, pass->load_ops, sizeof(pass->load_ops));
+    memcpy(result->store_ops, pass->store_ops, sizeof(pass->store_ops));
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_util_render_graph_get_lifetime(ngf_util_render_graph graph,
+                                             ngf_util_rg_resource  resource,
+                                             uint32_t             *first_use,
+                                             uint32_t             *last_use) {
+  assert(graph);
+  assert(first_use);
+  assert(last_use);
+  if (!graph->compiled) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (resource >= _NGF_DARRAY_SIZE(graph->resources)) {
+    return NGF_ERROR_OUT_OF_BOUNDS;
+  }
+  const _ngf_util_rg_resource *res =
+      &_NGF_DARRAY_AT(graph->resources, resource);
+  *first_use = res->first_use;
+  *last_use = res->first_use == ~0u ? ~0u : res->last_use;
+  return NGF_ERROR_OK;
+}
+
+ngf_image ngf_util_render_graph_get_image(ngf_util_render_graph graph,
+                                          ngf_util_rg_resource resource) {
+  assert(graph);
+  assert(resource < _NGF_DARRAY_SIZE(graph->resources));
+  const _ngf_util_rg_resource *res =
+      &_NGF_DARRAY_AT(graph->resources, resource);
+  return res->transient ? res->image : (ngf_image)res->handle;
+}
+
+// Finds or creates a render target for the attachments of the given pass.
+static ngf_error _ngf_util_rg_render_target(ngf_util_render_graph    graph,
+                                            const _ngf_util_rg_pass *pass,
+                                            ngf_render_target       *result) {
+  ngf_attachment attachments[NGF_UTIL_RG_MAX_ATTACHMENTS];
+  memset(attachments, 0, sizeof(attachments));
+  for (uint32_t a = 0u; a < pass->info.nattachments; ++a) {
+    const ngf_util_rg_attachment *att = _ngf_util_rg_attachment(graph,
+                                                                pass, a);
+    attachments[a].image_ref.image =
+        ngf_util_render_graph_get_image(graph, att->image);
+    attachments[a].type = att->type;
+    attachments[a].load_op = pass->load_ops[a];
+    attachments[a].store_op = pass->store_ops[a];
+    attachments[a].clear = att->clear;
+  }
+  const size_t attachments_size =
+      sizeof(ngf_attachment) * pass->info.nattachments;
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(graph->rts); ++i) {
+    _ngf_util_rg_cached_rt *cached = &_NGF_DARRAY_AT(graph->rts, i);
+    if (cached->nattachments == pass->info.nattachments &&
+        memcmp(cached->attachments, attachments, attachments_size) == 0) {
+      cached->last_used = graph->nexecutions;
+      *result = cached->rt;
+      return NGF_ERROR_OK;
+    }
+  }
+  _ngf_util_rg_cached_rt cached;
+  memset(&cached, 0, sizeof(cached));
+  memcpy(cached.attachments, attachments, attachments_size);
+  cached.nattachments = pass->info.nattachments;
+  cached.last_used = graph->nexecutions;
+  const ngf_render_target_info rt_info = {
+    .attachments = cached.attachments,
+    .nattachments = cached.nattachments
+  };
+  const ngf_error err = ngf_create_render_target(&rt_info, &cached.rt);
+  if (err != NGF_ERROR_OK) {
+    return err;
+  }
+  _NGF_DARRAY_APPEND(graph->rts, cached);
+  *result = cached.rt;
+  return NGF_ERROR_OK;
+}
+
+// Destroys the render targets that haven't been used for a while, e.g.
+// because the screen has been resized.
+static void _ngf_util_rg_evict_render_targets(ngf_util_render_graph graph) {
+  uint32_t nkept = 0u;
+  for (uint32_t i = 0u; i < _NGF_DARRAY_SIZE(graph->rts); ++i) {
+    const _ngf_util_rg_cached_rt *cached = &_NGF_DARRAY_AT(graph->rts, i);
+    if (graph->nexecutions - cached->last_used >
+        _NGF_UTIL_RG_MAX_IDLE_EXECUTIONS) {
+      ngf_destroy_render_target(cached->rt);
+    } else {
+      _NGF_DARRAY_AT(graph->rts, nkept++) = *cached;
+    }
+  }
+  graph->rts.endptr = graph->rts.data + nkept;
+}
+
+typedef struct {
+  ngf_util_rg_pass_type type;
+  bool                  active;
+  ngf_render_encoder    render;
+  ngf_compute_encoder   compute;
+  ngf_xfer_encoder      xfer;
+} _ngf_util_rg_encoder;
+
+static ngf_error _ngf_util_rg_end_encoder(_ngf_util_rg_encoder *enc) {
+  if (!enc->active) {
+    return NGF_ERROR_OK;
+  }
+  enc->active = false;
+  switch (enc->type) {
+  case NGF_UTIL_RG_PASS_RENDER:  return ngf_render_encoder_end(enc->render);
+  case NGF_UTIL_RG_PASS_COMPUTE: return ngf_compute_encoder_end(enc->compute);
+  case NGF_UTIL_RG_PASS_XFER:    return ngf_xfer_encoder_end(enc->xfer);
+  default: assert(false);
+  }
+  return NGF_ERROR_OK;
+}
+
+static ngf_error _ngf_util_rg_start_encoder(_ngf_util_rg_encoder *enc,
+                                            ngf_util_rg_pass_type type,
+                                            ngf_cmd_buffer        cmd_buf) {
+  ngf_error err = _ngf_util_rg_end_encoder(enc);
+  if (err != NGF_ERROR_OK) {
+    return err;
+  }
+  switch (type) {
+  case NGF_UTIL_RG_PASS_RENDER:
+    err = ngf_cmd_buffer_start_render(cmd_buf, &enc->render);
+    break;
+  case NGF_UTIL_RG_PASS_COMPUTE:
+    err = ngf_cmd_buffer_start_compute(cmd_buf, &enc->compute);
+    break;
+  case NGF_UTIL_RG_PASS_XFER:
+    err = ngf_cmd_buffer_start_xfer(cmd_buf, &enc->xfer);
+    break;
+  default:
+    assert(false);
+  }
+  enc->type = type;
+  enc->active = err == NGF_ERROR_OK;
+  return err;
+}
+
+// Acquires the transient images that are first used by the given pass.
+static ngf_error _ngf_util_rg_acquire_images(ngf_util_render_graph graph,
+                                             uint32_t              p) {
+  for (uint32_t r = 0u; r < _NGF_DARRAY_SIZE(graph->resources); ++r) {
+    _ngf_util_rg_resource *res = &_NGF_DARRAY_AT(graph->resources, r);
+    if (res->transient && res->first_use == p) {
+      const ngf_transient_image_info info = {
+        .image_info = res->info,
+        .first_use = res->first_use,
+        .last_use = res->last_use
+      };
+      const ngf_error err = ngf_acquire_transient_image(graph->pool, &info,
+                                                        &res->image);
+      if (err != NGF_ERROR_OK) {
+        return err;
+      }
+    }
+  }
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_util_render_graph_execute(ngf_util_render_graph graph,
+                                        ngf_cmd_buffer cmd_buf) {
+  assert(graph);
+  assert(cmd_buf);
+  if (!graph->compiled) {
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  ++graph->nexecutions;
+  ngf_reset_transient_pool(graph->pool);
+  _ngf_util_rg_evict_render_targets(graph);
+
+  ngf_error err = NGF_ERROR_OK;
+  _ngf_util_rg_encoder enc;
+  memset(&enc, 0, sizeof(enc));
+  for (uint32_t p = 0u; p < _NGF_DARRAY_SIZE(graph->passes); ++p) {
+    const _ngf_util_rg_pass *pass = &_NGF_DARRAY_AT(graph->passes, p);
+    if (pass->culled) {
+      continue;
+    }
+    err = _ngf_util_rg_acquire_images(graph, p);
+    if (err != NGF_ERROR_OK) {
+      break;
+    }
+    if (pass->new_encoder) {
+      err = _ngf_util_rg_start_encoder(&enc, pass->info.type, cmd_buf);
+      if (err != NGF_ERROR_OK) {
+        break;
+      }
+    }
+    switch (pass->info.type) {
+    case NGF_UTIL_RG_PASS_RENDER: {
+      ngf_render_target rt = pass->info.render_target;
+      if (rt == NULL) {
+        err = _ngf_util_rg_render_target(graph, pass, &rt);
+        if (err != NGF_ERROR_OK) {
+          break;
+        }
+      }
+      // The debug group is closed before the pass ends, since ending the
+      // pass may finish the encoder.
+      ngf_cmd_begin_pass(enc.render, rt);
+      if (pass->info.name != NULL) {
+        ngf_cmd_begin_debug_group(enc.render, pass->info.name);
+      }
+      if (pass->info.render != NULL) {
+        pass->info.render(graph, enc.render, pass->info.userdata);
+      }
+      if (pass->info.name != NULL) {
+        ngf_cmd_end_debug_group(enc.render);
+      }
+      ngf_cmd_end_pass(enc.render);
+      break;
+    }
+    case NGF_UTIL_RG_PASS_COMPUTE:
+      if (pass->info.name != NULL) {
+        ngf_cmd_begin_compute_debug_group(enc.compute, pass->info.name);
+      }
+      if (pass->info.compute != NULL) {
+        pass->info.compute(graph, enc.compute, pass->info.userdata);
+      }
+      if (pass->info.name != NULL) {
+        ngf_cmd_end_compute_debug_group(enc.compute);
+      }
+      break;
+    case NGF_UTIL_RG_PASS_XFER:
+      if (pass->info.xfer != NULL) {
+        pass->info.xfer(graph, enc.xfer, pass->info.userdata);
+      }
+      break;
+    default:
+      assert(false);
+    }
+    if (err != NGF_ERROR_OK) {
+      break;
+    }
+  }
+  const ngf_error end_err = _ngf_util_rg_end_encoder(&enc);
+  return err != NGF_ERROR_OK ? err : end_err;
+}
@@ -17,13 +17,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "stack_alloc.h"
+#include "nicegraf_internal.h"
 
 #include <stdlib.h>
 #include <assert.h>
 #include <stdio.h>
 
 _ngf_sa* _ngf_sa_create(size_t capacity) {
-  _ngf_sa* result = malloc(capacity + sizeof(_ngf_sa));
+  _ngf_sa* result = (_ngf_sa*)_ngf_alloc(1u, capacity + sizeof(_ngf_sa),
+                                         NGF_ALLOCATION_TEMP_STORE);
   if (result) {
     result->capacity = capacity;
     result->ptr      = result->data;
@@ -50,6 +52,7 @@ void _ngf_sa_reset(_ngf_sa *allocator) {
 
 void _ngf_sa_destroy(_ngf_sa *allocator) {
   assert(allocator);
-  free(allocator);
+  _ngf_free(allocator, 1u, allocator->capacity + sizeof(_ngf_sa),
+            NGF_ALLOCATION_TEMP_STORE);
 }
 
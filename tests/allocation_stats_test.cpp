@@ -0,0 +1,125 @@
+#include "catch.hpp"
+#include "nicegraf_internal.h"
+#include "nicegraf_util.h"
+#include "dynamic_array.h"
+#include "stack_alloc.h"
+#include <string>
+#include <vector>
+
+// Other tests allocate too, so everything here is checked relative to a
+// snapshot taken beforehand.
+TEST_CASE("Allocations are counted per category", "[allocation_stats]") {
+  ngf_allocation_stats before, after;
+  ngf_get_allocation_stats(&before);
+
+  uint64_t *a = NGF_ALLOCN_AS(uint64_t, 8u, NGF_ALLOCATION_PIPELINE);
+  uint32_t *b = NGF_ALLOC_AS(uint32_t, NGF_ALLOCATION_PIPELINE);
+  REQUIRE(a != NULL);
+  REQUIRE(b != NULL);
+  ngf_get_allocation_stats(&after);
+  const ngf_allocation_counters &p0 =
+      before.categories[NGF_ALLOCATION_PIPELINE];
+  const ngf_allocation_counters &p1 =
+      after.categories[NGF_ALLOCATION_PIPELINE];
+  REQUIRE(p1.live_bytes - p0.live_bytes == 68u);
+  REQUIRE(p1.live_allocations - p0.live_allocations == 2u);
+  REQUIRE(p1.total_allocations - p0.total_allocations == 2u);
+  REQUIRE(p1.peak_bytes >= p1.live_bytes);
+  REQUIRE(after.total.live_bytes - before.total.live_bytes == 68u);
+
+  NGF_FREEN_AS(a, 8u, NGF_ALLOCATION_PIPELINE);
+  NGF_FREE_AS(b, NGF_ALLOCATION_PIPELINE);
+  // Freeing NULL isn't counted.
+  NGF_FREE_AS((uint32_t*)NULL, NGF_ALLOCATION_PIPELINE);
+  ngf_get_allocation_stats(&after);
+  REQUIRE(p1.live_bytes == p0.live_bytes);
+  REQUIRE(p1.live_allocations == p0.live_allocations);
+  REQUIRE(p1.total_allocations - p0.total_allocations == 2u);
+  REQUIRE(p1.peak_bytes >= p0.live_bytes + 68u);
+  REQUIRE(after.total.live_bytes == before.total.live_bytes);
+}
+
+TEST_CASE("Internal containers report their storage",
+          "[allocation_stats]") {
+  ngf_allocation_stats before, after;
+  ngf_get_allocation_stats(&before);
+
+  _NGF_DARRAY_OF(uint32_t) arr;
+  _NGF_DARRAY_RESET(arr, 2u);
+  for (uint32_t i = 0u; i < 5u; ++i) _NGF_DARRAY_APPEND(arr, i);
+  for (uint32_t i = 0u; i < 5u; ++i) REQUIRE(_NGF_DARRAY_AT(arr, i) == i);
+  _ngf_sa *sa = _ngf_sa_create(100u);
+  ngf_get_allocation_stats(&after);
+  const ngf_allocation_counters &d0 =
+      before.categories[NGF_ALLOCATION_DYNAMIC_ARRAY];
+  const ngf_allocation_counters &d1 =
+      after.categories[NGF_ALLOCATION_DYNAMIC_ARRAY];
+  // Two reallocations: 2 -> 4 -> 8 elements.
+  REQUIRE(d1.live_bytes - d0.live_bytes == 8u * sizeof(uint32_t));
+  REQUIRE(d1.live_allocations - d0.live_allocations == 1u);
+  REQUIRE(d1.total_allocations - d0.total_allocations == 3u);
+  REQUIRE(after.categories[NGF_ALLOCATION_TEMP_STORE].live_bytes -
+          before.categories[NGF_ALLOCATION_TEMP_STORE].live_bytes ==
+          100u + sizeof(_ngf_sa));
+
+  _NGF_DARRAY_DESTROY(arr);
+  _ngf_sa_destroy(sa);
+  ngf_get_allocation_stats(&after);
+  REQUIRE(d1.live_bytes == d0.live_bytes);
+  REQUIRE(after.categories[NGF_ALLOCATION_TEMP_STORE].live_bytes ==
+          before.categories[NGF_ALLOCATION_TEMP_STORE].live_bytes);
+}
+
+TEST_CASE("Allocation report formatting", "[allocation_stats]") {
+  const size_t len = ngf_format_allocation_report(NULL, 0u);
+  REQUIRE(len > 0u);
+  std::vector<char> buffer(len + 1u);
+  REQUIRE(ngf_format_allocation_report(buffer.data(), buffer.size()) == len);
+  const std::string report(buffer.data());
+  REQUIRE(report.size() == len);
+  REQUIRE(report.find("descriptor pool") != std::string::npos);
+  REQUIRE(report.find("total") != std::string::npos);
+  REQUIRE(report.back() == '\n');
+
+  // Truncated output is still terminated and the full length is reported.
+  char small[16];
+  REQUIRE(ngf_format_allocation_report(small, sizeof(small)) == len);
+  REQUIRE(std::string(small) == report.substr(0u, sizeof(small) - 1u));
+}
+
+TEST_CASE("Util pipeline layouts are a single allocation",
+          "[allocation_stats]") {
+  ngf_allocation_stats before, after;
+  ngf_get_allocation_stats(&before);
+
+  const ngf_plmd_descriptor_set_layout *no_sets[1] = {NULL};
+  const ngf_plmd_layout empty_metadata = {0u, no_sets};
+  ngf_pipeline_layout_info empty_layout;
+  REQUIRE(ngf_util_pipeline_layout_storage_size(&empty_metadata) == 0u);
+  REQUIRE(ngf_util_create_pipeline_layout_from_metadata(
+              &empty_metadata, &empty_layout) == NGF_ERROR_OK);
+  REQUIRE(empty_layout.ndescriptor_set_layouts == 0u);
+  ngf_get_allocation_stats(&after);
+  REQUIRE(after.total.total_allocations == before.total.total_allocations);
+  ngf_util_destroy_layout(&empty_layout);
+
+  const ngf_descriptor_info descs[2] = {
+    {NGF_DESCRIPTOR_UNIFORM_BUFFER, 0u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT},
+    {NGF_DESCRIPTOR_TEXTURE, 1u, NGF_DESCRIPTOR_FRAGMENT_STAGE_BIT}
+  };
+  ngf_pipeline_layout_info layout;
+  REQUIRE(ngf_util_create_simple_layout(descs, 2u, &layout) == NGF_ERROR_OK);
+  REQUIRE(layout.ndescriptor_set_layouts == 1u);
+  REQUIRE(layout.descriptor_set_layouts[0].ndescriptors == 2u);
+  REQUIRE(layout.descriptor_set_layouts[0].descriptors[1].id == 1u);
+  ngf_get_allocation_stats(&after);
+  REQUIRE(after.total.total_allocations - before.total.total_allocations ==
+          1u);
+  REQUIRE(after.total.live_bytes - before.total.live_bytes ==
+          ngf_util_simple_layout_storage_size(2u));
+
+  ngf_util_destroy_layout(&layout);
+  REQUIRE(layout.descriptor_set_layouts == NULL);
+  ngf_get_allocation_stats(&after);
+  REQUIRE(after.total.live_bytes == before.total.live_bytes);
+}
@@ -0,0 +1,147 @@
+#include "catch.hpp"
+#include "nicegraf_util.h"
+#include "nicegraf_internal.h"
+#include <string.h>
+#include <string>
+
+namespace {
+
+std::string recorded_cmds(ngf_cmd_buffer buf) {
+  std::string result(_ngf_null_describe_cmds(buf, NULL, 0u), '\0');
+  _ngf_null_describe_cmds(buf, &result[0], result.size() + 1u);
+  return result;
+}
+
+ngf_resource_bind_op ubo_bind_op(ngf_uniform_buffer ubo) {
+  ngf_resource_bind_op op;
+  memset(&op, 0, sizeof(op));
+  op.target_set = 0u;
+  op.target_binding = 0u;
+  op.type = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+  op.info.uniform_buffer.buffer = ubo;
+  op.info.uniform_buffer.offset = 0u;
+  op.info.uniform_buffer.range = 256u;
+  return op;
+}
+
+ngf_util_draw_info draw_info(uint64_t                              key,
+                             ngf_graphics_pipeline                 pipeline,
+                             const ngf_resource_bind_op           *bind_op,
+                             const ngf_util_attrib_buffer_bind_op *attribs,
+                             ngf_index_buffer                      ibuf,
+                             uint32_t                              first) {
+  ngf_util_draw_info draw;
+  memset(&draw, 0, sizeof(draw));
+  draw.sort_key = key;
+  draw.pipeline = pipeline;
+  draw.bind_ops = bind_op;
+  draw.nbind_ops = 1u;
+  draw.attrib_buffers = attribs;
+  draw.nattrib_buffers = 1u;
+  draw.index_buffer = ibuf;
+  draw.index_type = NGF_TYPE_UINT16;
+  draw.first_element = first;
+  draw.nelements = 3u;
+  draw.ninstances = 1u;
+  return draw;
+}
+
+}  // namespace
+
+TEST_CASE("Draw queue flush", "[draw_queue]") {
+  REQUIRE(ngf_initialize(NGF_DEVICE_PREFERENCE_DONTCARE) == NGF_ERROR_OK);
+  const ngf_context_info ctx_info = {NULL, NULL, false};
+  ngf_context ctx;
+  REQUIRE(ngf_create_context(&ctx_info, &ctx) == NGF_ERROR_OK);
+  REQUIRE(ngf_set_context(ctx) == NGF_ERROR_OK);
+  ngf_cmd_buffer cmd_buf;
+  REQUIRE(ngf_create_cmd_buffer(NULL, &cmd_buf) == NGF_ERROR_OK);
+
+  const ngf_descriptor_info descriptor = {
+    NGF_DESCRIPTOR_UNIFORM_BUFFER, 0u, NGF_DESCRIPTOR_VERTEX_STAGE_BIT
+  };
+  ngf_util_graphics_pipeline_data pipeline_data;
+  ngf_util_create_default_graphics_pipeline_data(NULL, &pipeline_data);
+  REQUIRE(ngf_util_create_simple_layout(&descriptor, 1u,
+                                        &pipeline_data.layout_info) ==
+          NGF_ERROR_OK);
+  ngf_graphics_pipeline pipeline_a, pipeline_b;
+  REQUIRE(ngf_create_graphics_pipeline(&pipeline_data.pipeline_info,
+                                       &pipeline_a) == NGF_ERROR_OK);
+  REQUIRE(ngf_create_graphics_pipeline(&pipeline_data.pipeline_info,
+                                       &pipeline_b) == NGF_ERROR_OK);
+
+  const ngf_uniform_buffer_info ubo_info = {
+    256u, NGF_BUFFER_STORAGE_HOST_WRITEABLE, 0u
+  };
+  ngf_uniform_buffer ubo_a, ubo_b;
+  REQUIRE(ngf_create_uniform_buffer(&ubo_info, &ubo_a) == NGF_ERROR_OK);
+  REQUIRE(ngf_create_uniform_buffer(&ubo_info, &ubo_b) == NGF_ERROR_OK);
+  const ngf_attrib_buffer_info vbuf_info = {
+    256u, NGF_BUFFER_STORAGE_PRIVATE, 0u
+  };
+  ngf_attrib_buffer vbuf;
+  REQUIRE(ngf_create_attrib_buffer(&vbuf_info, &vbuf) == NGF_ERROR_OK);
+  const ngf_index_buffer_info ibuf_info = {
+    256u, NGF_BUFFER_STORAGE_PRIVATE, 0u
+  };
+  ngf_index_buffer ibuf_a, ibuf_b;
+  REQUIRE(ngf_create_index_buffer(&ibuf_info, &ibuf_a) == NGF_ERROR_OK);
+  REQUIRE(ngf_create_index_buffer(&ibuf_info, &ibuf_b) == NGF_ERROR_OK);
+
+  const ngf_resource_bind_op ops_a = ubo_bind_op(ubo_a);
+  const ngf_resource_bind_op ops_b = ubo_bind_op(ubo_b);
+  const ngf_util_attrib_buffer_bind_op attribs_a = {vbuf, 0u, 0u};
+  const ngf_util_attrib_buffer_bind_op attribs_b = {vbuf, 0u, 64u};
+
+  ngf_util_draw_queue queue;
+  REQUIRE(ngf_util_create_draw_queue(2u, &queue) == NGF_ERROR_OK);
+  const ngf_util_draw_info draws[] = {
+    draw_info(4u, pipeline_b, &ops_a, &attribs_a, ibuf_a, 6u),
+    draw_info(0u, pipeline_a, &ops_a, &attribs_a, ibuf_a, 0u),
+    draw_info(3u, pipeline_b, &ops_a, &attribs_a, ibuf_a, 5u),
+    draw_info(1u, pipeline_a, &ops_b, &attribs_a, ibuf_a, 1u),
+    draw_info(2u, pipeline_a, &ops_b, &attribs_b, ibuf_b, 3u),
+    // Equal keys keep their submission order.
+    draw_info(1u, pipeline_a, &ops_b, &attribs_a, ibuf_a, 2u),
+    draw_info(2u, pipeline_a, &ops_b, &attribs_b, ibuf_b, 4u)
+  };
+  for (const ngf_util_draw_info &draw : draws) {
+    REQUIRE(ngf_util_draw_queue_add(queue, &draw) == NGF_ERROR_OK);
+  }
+
+  REQUIRE(ngf_begin_frame() == NGF_ERROR_OK);
+  REQUIRE(ngf_start_cmd_buffer(cmd_buf) == NGF_ERROR_OK);
+  ngf_render_encoder enc;
+  REQUIRE(ngf_cmd_buffer_start_render(cmd_buf, &enc) == NGF_ERROR_OK);
+  ngf_util_draw_queue_flush(queue, enc);
+  const std::string first_flush = recorded_cmds(cmd_buf);
+  REQUIRE(first_flush ==
+          "begin_scope "
+          "pipeline resource:0 attrib:0 index draw:0 "
+          "resource:0 draw:1 draw:2 "
+          "attrib:0 index draw:3 draw:4 "
+          "pipeline resource:0 attrib:0 index draw:5 draw:6");
+
+  // The queue is empty after a flush, and a new flush starts from scratch.
+  ngf_util_draw_queue_flush(queue, enc);
+  REQUIRE(ngf_util_draw_queue_add(queue, &draws[1]) == NGF_ERROR_OK);
+  ngf_util_draw_queue_flush(queue, enc);
+  REQUIRE(recorded_cmds(cmd_buf) ==
+          first_flush + " pipeline resource:0 attrib:0 index draw:0");
+  REQUIRE(ngf_render_encoder_end(enc) == NGF_ERROR_OK);
+  REQUIRE(ngf_submit_cmd_buffers(1u, &cmd_buf) == NGF_ERROR_OK);
+  REQUIRE(ngf_end_frame() == NGF_ERROR_OK);
+
+  ngf_util_destroy_draw_queue(queue);
+  ngf_destroy_index_buffer(ibuf_b);
+  ngf_destroy_index_buffer(ibuf_a);
+  ngf_destroy_attrib_buffer(vbuf);
+  ngf_destroy_uniform_buffer(ubo_b);
+  ngf_destroy_uniform_buffer(ubo_a);
+  ngf_destroy_graphics_pipeline(pipeline_b);
+  ngf_destroy_graphics_pipeline(pipeline_a);
+  ngf_util_destroy_layout(&pipeline_data.layout_info);
+  ngf_destroy_cmd_buffer(cmd_buf);
+  ngf_destroy_context(ctx);
+}
@@ -0,0 +1,70 @@
+#include "catch.hpp"
+#include "nicegraf_internal.h"
+#include <string.h>
+#include <thread>
+
+TEST_CASE("Frame stats aggregation", "[frame_stats]") {
+  // Flush whatever has been counted before.
+  _ngf_stats_end_frame(0u);
+
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, 3u);
+  _NGF_STAT_ADD(_NGF_STAT_INSTANCES, 12u);
+  std::thread worker([] {
+    _NGF_STAT_ADD(_NGF_STAT_DRAWS, 2u);
+    _NGF_STAT_ADD(_NGF_STAT_BYTES_MAPPED, 256u);
+  });
+  worker.join();
+  _ngf_stats_end_frame(1u);
+
+  ngf_frame_stats stats;
+  REQUIRE(ngf_get_frame_stats(&stats) == NGF_ERROR_OK);
+  REQUIRE(stats.frame == 1u);
+  REQUIRE(stats.draws == 5u);
+  REQUIRE(stats.instances == 12u);
+  REQUIRE(stats.bytes_mapped == 256u);
+  REQUIRE(stats.pipeline_binds == 0u);
+
+  // Only the counts accumulated since the previous frame are reported.
+  _NGF_STAT_ADD(_NGF_STAT_DRAWS, 1u);
+  _ngf_stats_end_frame(2u);
+  REQUIRE(ngf_get_frame_stats(&stats) == NGF_ERROR_OK);
+  REQUIRE(stats.frame == 2u);
+  REQUIRE(stats.draws == 1u);
+  REQUIRE(stats.instances == 0u);
+  REQUIRE(stats.bytes_mapped == 0u);
+
+  const uint64_t t0 = _ngf_stats_now_ns();
+  REQUIRE(_ngf_stats_now_ns() >= t0);
+}
+
+TEST_CASE("Frame pacing", "[frame_stats]") {
+  ngf_frame_pacing_info info = {NGF_FRAME_PACING_DEFAULT, 0u};
+  REQUIRE(_ngf_validate_frame_pacing(&info) == NGF_ERROR_OK);
+  info.mode = NGF_FRAME_PACING_END_FRAME;
+  REQUIRE(_ngf_validate_frame_pacing(&info) == NGF_ERROR_OUT_OF_BOUNDS);
+  info.max_queued_frames = NGF_MAX_QUEUED_FRAMES + 1u;
+  REQUIRE(_ngf_validate_frame_pacing(&info) == NGF_ERROR_OUT_OF_BOUNDS);
+  info.max_queued_frames = 2u;
+  REQUIRE(_ngf_validate_frame_pacing(&info) == NGF_ERROR_OK);
+
+  // Ending frame 5 with at most 2 frames queued waits for frame 3.
+  uint64_t target = 0u;
+  REQUIRE(_ngf_frame_pacing_target(&info, false, 5u, 2u, &target));
+  REQUIRE(target == 3u);
+  REQUIRE(!_ngf_frame_pacing_target(&info, true, 5u, 2u, &target));
+  REQUIRE(!_ngf_frame_pacing_target(&info, false, 1u, 2u, &target));
+
+  // Only the outermost GPU scopes count towards busy time.
+  _ngf_gpu_timing_results results;
+  memset(&results, 0, sizeof(results));
+  results.nscopes = 3u;
+  results.scopes[0].depth = 0u;
+  results.scopes[0].duration_ns = 100u;
+  results.scopes[1].depth = 1u;
+  results.scopes[1].duration_ns = 40u;
+  results.scopes[2].depth = 0u;
+  results.scopes[2].duration_ns = 50u;
+  REQUIRE(_ngf_gpu_timing_busy_ns(&results) == 0u);
+  results.valid = true;
+  REQUIRE(_ngf_gpu_timing_busy_ns(&results) == 150u);
+}
@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "nicegraf_internal.h"
+#include <memory>
+#include <string.h>
+
+TEST_CASE("GPU timing scope tree", "[gpu_timing]") {
+  auto frame = std::make_unique<_ngf_gpu_timing_frame>();
+  auto results = std::make_unique<_ngf_gpu_timing_results>();
+  results->valid = false;
+  ngf_gpu_frame_timings timings;
+  REQUIRE(_ngf_gpu_timing_get_results(results.get(), &timings) ==
+          NGF_ERROR_NO_FRAME);
+
+  _ngf_gpu_timing_reset(frame.get(), 42u);
+  REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "encoder") == 0u);
+  REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "pass") == 2u);
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == 3u);
+  REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "shadows") == 4u);
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == 5u);
+  REQUIRE(_ngf_gpu_timing_has_open_scopes(frame.get()));
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == 1u);
+  REQUIRE(!_ngf_gpu_timing_has_open_scopes(frame.get()));
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == _NGF_GPU_TIMING_NO_QUERY);
+
+  const uint64_t timestamps[] = { 100u, 200u, 110u, 150u, 150u, 190u };
+  _ngf_gpu_timing_resolve(frame.get(), timestamps, 2.0f, results.get());
+  REQUIRE(_ngf_gpu_timing_get_results(results.get(), &timings) ==
+          NGF_ERROR_OK);
+  REQUIRE(timings.frame == 42u);
+  REQUIRE(timings.nscopes == 3u);
+  REQUIRE(strcmp(timings.scopes[0].name, "encoder") == 0);
+  REQUIRE(timings.scopes[0].parent == NGF_GPU_TIMING_NO_PARENT);
+  REQUIRE(timings.scopes[0].depth == 0u);
+  REQUIRE(timings.scopes[0].start_ns == 0u);
+  REQUIRE(timings.scopes[0].duration_ns == 200u);
+  REQUIRE(strcmp(timings.scopes[2].name, "shadows") == 0);
+  REQUIRE(timings.scopes[2].parent == 0u);
+  REQUIRE(timings.scopes[2].depth == 1u);
+  REQUIRE(timings.scopes[2].start_ns == 100u);
+  REQUIRE(timings.scopes[2].duration_ns == 80u);
+}
+
+TEST_CASE("GPU timing scope limits", "[gpu_timing_limits]") {
+  auto frame = std::make_unique<_ngf_gpu_timing_frame>();
+  _ngf_gpu_timing_reset(frame.get(), 0u);
+
+  // Scopes nested too deeply, and everything within them, are not timed.
+  for (uint32_t d = 0u; d < _NGF_MAX_GPU_TIMING_DEPTH; ++d) {
+    REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "deep") == 2u * d);
+  }
+  REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "too deep") ==
+          _NGF_GPU_TIMING_NO_QUERY);
+  REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "too deep") ==
+          _NGF_GPU_TIMING_NO_QUERY);
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == _NGF_GPU_TIMING_NO_QUERY);
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == _NGF_GPU_TIMING_NO_QUERY);
+  for (uint32_t d = _NGF_MAX_GPU_TIMING_DEPTH; d > 0u; --d) {
+    REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == 2u * (d - 1u) + 1u);
+  }
+
+  // So are scopes beyond the per-frame limit. Long names get truncated.
+  const char long_name[] =
+      "a scope name that is too long to fit into the name buffer of a scope";
+  while (frame->nscopes < NGF_MAX_GPU_TIMING_SCOPES) {
+    REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), long_name) !=
+            _NGF_GPU_TIMING_NO_QUERY);
+    _ngf_gpu_timing_end_scope(frame.get());
+  }
+  REQUIRE(strlen(frame->scopes[frame->nscopes - 1u].name) ==
+          NGF_GPU_TIMING_SCOPE_NAME_SIZE - 1u);
+  REQUIRE(_ngf_gpu_timing_begin_scope(frame.get(), "one too many") ==
+          _NGF_GPU_TIMING_NO_QUERY);
+  REQUIRE(_ngf_gpu_timing_end_scope(frame.get()) == _NGF_GPU_TIMING_NO_QUERY);
+  REQUIRE(!_ngf_gpu_timing_has_open_scopes(frame.get()));
+}
+
+TEST_CASE("GPU timing scopes merged at submission",
+          "[gpu_timing_merge]") {
+  auto frame = std::make_unique<_ngf_gpu_timing_frame>();
+  auto a = std::make_unique<_ngf_gpu_timing_frame>();
+  auto b = std::make_unique<_ngf_gpu_timing_frame>();
+  _ngf_gpu_timing_reset(frame.get(), 7u);
+  _ngf_gpu_timing_reset(a.get(), 7u);
+  _ngf_gpu_timing_reset(b.get(), 7u);
+
+  // Two command buffers recorded in an interleaved fashion. Their scopes
+  // don't get nested within each other.
+  REQUIRE(_ngf_gpu_timing_begin_local_scope(frame.get(), a.get(), "a") == 0u);
+  REQUIRE(_ngf_gpu_timing_begin_local_scope(frame.get(), b.get(), "b") == 2u);
+  REQUIRE(_ngf_gpu_timing_begin_local_scope(frame.get(), a.get(), "a.pass") ==
+          4u);
+  REQUIRE(_ngf_gpu_timing_depth(a.get()) == 2u);
+  REQUIRE(_ngf_gpu_timing_depth(b.get()) == 1u);
+  REQUIRE(_ngf_gpu_timing_end_scope(b.get()) == 3u);
+  REQUIRE(_ngf_gpu_timing_end_scope(a.get()) == 5u);
+  REQUIRE(_ngf_gpu_timing_end_scope(a.get()) == 1u);
+  REQUIRE(frame->nscopes == 0u);
+  REQUIRE(frame->nquery_pairs == 3u);
+
+  // The frame's tree follows submission order.
+  _ngf_gpu_timing_merge(frame.get(), b.get());
+  _ngf_gpu_timing_merge(frame.get(), a.get());
+  REQUIRE(b->nscopes == 0u);
+  REQUIRE(a->nscopes == 0u);
+  REQUIRE(frame->nscopes == 3u);
+  REQUIRE(!_ngf_gpu_timing_has_open_scopes(frame.get()));
+
+  const uint64_t timestamps[] = { 300u, 400u, 100u, 200u, 310u, 390u };
+  auto results = std::make_unique<_ngf_gpu_timing_results>();
+  _ngf_gpu_timing_resolve(frame.get(), timestamps, 1.0f, results.get());
+  ngf_gpu_frame_timings timings;
+  REQUIRE(_ngf_gpu_timing_get_results(results.get(), &timings) ==
+          NGF_ERROR_OK);
+  REQUIRE(timings.nscopes == 3u);
+  REQUIRE(strcmp(timings.scopes[0].name, "b") == 0);
+  REQUIRE(timings.scopes[0].start_ns == 0u);
+  REQUIRE(timings.scopes[0].duration_ns == 100u);
+  REQUIRE(strcmp(timings.scopes[1].name, "a") == 0);
+  REQUIRE(timings.scopes[1].parent == NGF_GPU_TIMING_NO_PARENT);
+  REQUIRE(timings.scopes[1].depth == 0u);
+  REQUIRE(timings.scopes[1].start_ns == 200u);
+  REQUIRE(strcmp(timings.scopes[2].name, "a.pass") == 0);
+  REQUIRE(timings.scopes[2].parent == 1u);
+  REQUIRE(timings.scopes[2].depth == 1u);
+  REQUIRE(timings.scopes[2].start_ns == 210u);
+  REQUIRE(timings.scopes[2].duration_ns == 80u);
+}
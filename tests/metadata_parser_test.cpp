@@ -0,0 +1,329 @@
+#include "catch.hpp"
+#include "metadata_parser.h"
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Builds a pipeline metadata file, either in network byte order (as written by
+// the shader pipeline tool) or in host byte order.
+class plmd_builder {
+public:
+  explicit plmd_builder(bool network_order) : network_order_(network_order) {}
+
+  std::vector<uint32_t> build(uint32_t nsets, uint32_t ndescriptors_per_set,
+                              uint32_t ncis_entries,
+                              const std::vector<std::pair<std::string,
+                                                          std::string>> &user) {
+    words_.clear();
+    const size_t header_start = words_.size();
+    for (uint32_t i = 0u; i < 8u; ++i) push(0u);
+
+    const uint32_t layout_offset = offset();
+    push(nsets);
+    for (uint32_t s = 0u; s < nsets; ++s) {
+      push(ndescriptors_per_set);
+      for (uint32_t d = 0u; d < ndescriptors_per_set; ++d) {
+        push(d);
+        push(d % 6u);
+        push(0x3u);
+      }
+    }
+
+    uint32_t cis_offsets[2];
+    for (uint32_t m = 0u; m < 2u; ++m) {
+      cis_offsets[m] = offset();
+      push(ncis_entries);
+      for (uint32_t e = 0u; e < ncis_entries; ++e) {
+        push(m);
+        push(e);
+        push(e + 1u);
+        for (uint32_t c = 0u; c <= e; ++c) push(100u * m + c);
+      }
+    }
+
+    const uint32_t user_offset = offset();
+    push((uint32_t)user.size());
+    for (const auto &kv : user) {
+      push_string(kv.first);
+      push_string(kv.second);
+    }
+
+    const uint32_t header[] = {
+      0xdeadbeef, 8u * 4u, 0u, 1u,
+      layout_offset, cis_offsets[0], cis_offsets[1], user_offset
+    };
+    for (uint32_t i = 0u; i < 8u; ++i) set(header_start + i, header[i]);
+    return words_;
+  }
+
+private:
+  uint32_t offset() const { return (uint32_t)(words_.size() * 4u); }
+
+  void push(uint32_t v) {
+    words_.push_back(0u);
+    set(words_.size() - 1u, v);
+  }
+
+  void set(size_t idx, uint32_t v) {
+    if (network_order_) {
+      uint8_t *bytes = (uint8_t*)&words_[idx];
+      bytes[0] = (uint8_t)(v >> 24u);
+      bytes[1] = (uint8_t)(v >> 16u);
+      bytes[2] = (uint8_t)(v >> 8u);
+      bytes[3] = (uint8_t)v;
+    } else {
+      words_[idx] = v;
+    }
+  }
+
+  void push_string(const std::string &str) {
+    const uint32_t nwords = (uint32_t)(str.size() / 4u + 1u);
+    push(0xffffffff);
+    push(nwords);
+    const size_t start = words_.size();
+    words_.resize(start + nwords, 0u);
+    memcpy(&words_[start], str.c_str(), str.size());
+  }
+
+  bool network_order_;
+  std::vector<uint32_t> words_;
+};
+
+static const std::vector<std::pair<std::string, std::string>> test_user_data = {
+  {"entry_point", "VSMain"},
+  {"primitive_topology", "triangle_list"},
+  {"x", "yz"}
+};
+
+TEST_CASE("Metadata views match loaded metadata", "[plmd_view]") {
+  std::vector<uint32_t> file =
+      plmd_builder(true).build(3u, 4u, 3u, test_user_data);
+  ngf_plmd *meta = nullptr;
+  REQUIRE(ngf_plmd_load(file.data(), file.size() * 4u, nullptr, &meta) ==
+          NGF_PLMD_ERROR_OK);
+
+  ngf_plmd_view view;
+  REQUIRE(ngf_plmd_view_init(file.data(), file.size() * 4u, &view) ==
+          NGF_PLMD_ERROR_OK);
+
+  const ngf_plmd_layout *layout = ngf_plmd_get_layout(meta);
+  uint32_t nsets = 0u;
+  const ngf_plmd_descriptor_set_layout *set =
+      ngf_plmd_view_get_set_layouts(&view, &nsets);
+  REQUIRE(nsets == layout->ndescriptor_sets);
+  for (uint32_t s = 0u; s < nsets; ++s) {
+    REQUIRE(set->ndescriptors == layout->set_layouts[s]->ndescriptors);
+    REQUIRE(memcmp(set->descriptors, layout->set_layouts[s]->descriptors,
+                   sizeof(ngf_plmd_descriptor) * set->ndescriptors) == 0);
+    set = ngf_plmd_next_set_layout(set);
+  }
+
+  const ngf_plmd_cis_map *cis_map = ngf_plmd_get_sampler_to_cis_map(meta);
+  uint32_t nentries = 0u;
+  const ngf_plmd_cis_map_entry *entry =
+      ngf_plmd_view_get_sampler_to_cis_map(&view, &nentries);
+  REQUIRE(nentries == cis_map->nentries);
+  for (uint32_t e = 0u; e < nentries; ++e) {
+    REQUIRE(entry->separate_set_id == cis_map->entries[e]->separate_set_id);
+    REQUIRE(entry->ncombined_ids == e + 1u);
+    REQUIRE(entry->combined_ids[e] == 100u + e);
+    entry = ngf_plmd_next_cis_map_entry(entry);
+  }
+
+  for (const auto &kv : test_user_data) {
+    const char *value =
+        ngf_plmd_view_find_user_value(&view, kv.first.c_str());
+    REQUIRE(value != nullptr);
+    REQUIRE(kv.second == value);
+  }
+  REQUIRE(ngf_plmd_view_find_user_value(&view, "missing") == nullptr);
+  ngf_plmd_destroy(meta, nullptr);
+}
+
+TEST_CASE("Metadata in host byte order is viewed in place",
+          "[plmd_view_host_order]") {
+  std::vector<uint32_t> file =
+      plmd_builder(false).build(2u, 2u, 1u, test_user_data);
+  const std::vector<uint32_t> original = file;
+  ngf_plmd_view view;
+  REQUIRE(ngf_plmd_view_init(file.data(), file.size() * 4u, &view) ==
+          NGF_PLMD_ERROR_OK);
+  REQUIRE(file == original);
+  REQUIRE(std::string("VSMain") ==
+          ngf_plmd_view_find_user_value(&view, "entry_point"));
+
+  // Converted buffers are left alone the second time around.
+  std::vector<uint32_t> network_file =
+      plmd_builder(true).build(2u, 2u, 1u, test_user_data);
+  REQUIRE(ngf_plmd_view_init(network_file.data(), network_file.size() * 4u,
+                             &view) == NGF_PLMD_ERROR_OK);
+  REQUIRE(network_file == original);
+  REQUIRE(ngf_plmd_view_init(network_file.data(), network_file.size() * 4u,
+                             &view) == NGF_PLMD_ERROR_OK);
+  REQUIRE(network_file == original);
+}
+
+TEST_CASE("Truncated user metadata is rejected", "[plmd_view]") {
+  const std::vector<uint32_t> file =
+      plmd_builder(false).build(1u, 1u, 0u, {{"key", "value"}});
+  // The file ends with the value's block: a start mark, a size of 2 words and
+  // the contents. Cut it off right after the start mark, so that its size is
+  // missing, and then in the middle of the contents.
+  for (size_t ndropped : {3u, 1u}) {
+    std::vector<uint32_t> truncated(file.begin(), file.end() - ndropped);
+    ngf_plmd_view view;
+    REQUIRE(ngf_plmd_view_init(truncated.data(), truncated.size() * 4u,
+                               &view) == NGF_PLMD_ERROR_OK);
+    REQUIRE(ngf_plmd_view_find_user_value(&view, "key") == nullptr);
+    ngf_plmd *meta = nullptr;
+    REQUIRE(ngf_plmd_load(truncated.data(), truncated.size() * 4u, nullptr,
+                          &meta) == NGF_PLMD_ERROR_BUFFER_TOO_SMALL);
+  }
+  std::vector<uint32_t> intact = file;
+  ngf_plmd_view view;
+  REQUIRE(ngf_plmd_view_init(intact.data(), intact.size() * 4u, &view) ==
+          NGF_PLMD_ERROR_OK);
+  REQUIRE(std::string("value") == ngf_plmd_view_find_user_value(&view, "key"));
+}
+
+TEST_CASE("Pipeline lookup in a metadata archive", "[plmd_archive]") {
+  constexpr uint32_t npipelines = 200u;
+  std::vector<std::vector<uint32_t>> files;
+  std::vector<std::string> names;
+  for (uint32_t i = 0u; i < npipelines; ++i) {
+    names.push_back("pipeline_" + std::to_string(i));
+    files.push_back(plmd_builder(i % 2u == 0u).build(
+        1u + i % 3u, 1u + i % 5u, i % 2u,
+        {{"name", names.back()}}));
+  }
+  std::vector<const char*> name_ptrs;
+  std::vector<const void*> blobs;
+  std::vector<size_t> blob_sizes;
+  for (uint32_t i = 0u; i < npipelines; ++i) {
+    name_ptrs.push_back(names[i].c_str());
+    blobs.push_back(files[i].data());
+    blob_sizes.push_back(files[i].size() * 4u);
+  }
+
+  size_t archive_size = 0u;
+  REQUIRE(ngf_plmd_archive_pack(npipelines, name_ptrs.data(), blobs.data(),
+                                blob_sizes.data(), nullptr, &archive_size) ==
+          NGF_PLMD_ERROR_OK);
+  std::vector<uint32_t> archive_data(archive_size / 4u + 1u);
+  REQUIRE(ngf_plmd_archive_pack(npipelines, name_ptrs.data(), blobs.data(),
+                                blob_sizes.data(), archive_data.data(),
+                                &archive_size) == NGF_PLMD_ERROR_OK);
+
+  ngf_plmd_archive archive;
+  REQUIRE(ngf_plmd_archive_init(archive_data.data(), archive_size,
+                                &archive) == NGF_PLMD_ERROR_OK);
+  REQUIRE(archive.nentries == npipelines);
+  for (uint32_t i = 1u; i < npipelines; ++i) {
+    REQUIRE(archive.index[i - 1u].name_hash <= archive.index[i].name_hash);
+  }
+  for (uint32_t i = 0u; i < npipelines; ++i) {
+    ngf_plmd_view view;
+    REQUIRE(ngf_plmd_archive_find(&archive, names[i].c_str(), &view) ==
+            NGF_PLMD_ERROR_OK);
+    REQUIRE(names[i] == ngf_plmd_view_find_user_value(&view, "name"));
+    uint32_t nsets = 0u;
+    ngf_plmd_view_get_set_layouts(&view, &nsets);
+    REQUIRE(nsets == 1u + i % 3u);
+  }
+  ngf_plmd_view view;
+  REQUIRE(ngf_plmd_archive_find(&archive, "pipeline_x", &view) ==
+          NGF_PLMD_ERROR_ENTRY_NOT_FOUND);
+
+  // Archives of other format versions are rejected.
+  ngf_plmd_archive_header *header =
+      (ngf_plmd_archive_header*)archive_data.data();
+  header->version += 1u;
+  REQUIRE(ngf_plmd_archive_init(archive_data.data(), archive_size,
+                                &archive) == NGF_PLMD_ERROR_VERSION_MISMATCH);
+}
+
+static std::vector<std::pair<std::string, std::string>>
+make_user_data(uint32_t nentries) {
+  std::vector<std::pair<std::string, std::string>> user;
+  for (uint32_t i = 0u; i < nentries; ++i) {
+    user.emplace_back("key_" + std::to_string(i), "value_" + std::to_string(i));
+  }
+  return user;
+}
+
+TEST_CASE("User metadata lookup", "[plmd_find_user]") {
+  for (uint32_t nentries : {0u, 3u, 40u}) {
+    const auto user = make_user_data(nentries);
+    std::vector<uint32_t> file = plmd_builder(true).build(1u, 1u, 0u, user);
+    ngf_plmd *meta = nullptr;
+    REQUIRE(ngf_plmd_load(file.data(), file.size() * 4u, nullptr, &meta) ==
+            NGF_PLMD_ERROR_OK);
+    for (const auto &kv : user) {
+      const char *value = ngf_plmd_find_user(meta, kv.first.c_str());
+      REQUIRE(value != nullptr);
+      REQUIRE(kv.second == value);
+    }
+    REQUIRE(ngf_plmd_find_user(meta, "key_") == nullptr);
+    REQUIRE(ngf_plmd_find_user(meta, "value_0") == nullptr);
+    ngf_plmd_destroy(meta, nullptr);
+  }
+}
+
+// Run with `ngf_tests [plmd_benchmark]`.
+TEST_CASE("Metadata loading benchmark", "[.][plmd_benchmark]") {
+  constexpr uint32_t ncorpus_files = 2000u;
+  std::vector<std::vector<uint32_t>> corpus;
+  for (uint32_t i = 0u; i < ncorpus_files; ++i) {
+    corpus.push_back(plmd_builder(false).build(1u + i % 4u, 1u + i % 8u,
+                                               i % 3u, test_user_data));
+  }
+
+  BENCHMARK("ngf_plmd_load") {
+    for (std::vector<uint32_t> &file : corpus) {
+      ngf_plmd *meta = nullptr;
+      ngf_plmd_load(file.data(), file.size() * 4u, nullptr, &meta);
+      ngf_plmd_destroy(meta, nullptr);
+    }
+  }
+
+  BENCHMARK("ngf_plmd_view_init") {
+    for (std::vector<uint32_t> &file : corpus) {
+      ngf_plmd_view view;
+      ngf_plmd_view_init(file.data(), file.size() * 4u, &view);
+      ngf_plmd_view_find_user_value(&view, "entry_point");
+    }
+  }
+}
+
+TEST_CASE("User metadata lookup benchmark", "[.][plmd_benchmark]") {
+  const auto user = make_user_data(48u);
+  std::vector<uint32_t> file = plmd_builder(true).build(1u, 1u, 0u, user);
+  ngf_plmd *meta = nullptr;
+  ngf_plmd_load(file.data(), file.size() * 4u, nullptr, &meta);
+  constexpr uint32_t nqueries = 100000u;
+  size_t nfound = 0u;
+
+  BENCHMARK("linear scan") {
+    const ngf_plmd_user *entries = ngf_plmd_get_user(meta);
+    for (uint32_t q = 0u; q < nqueries; ++q) {
+      const char *key = user[q % user.size()].first.c_str();
+      for (uint32_t e = 0u; e < entries->nentries; ++e) {
+        if (strcmp(entries->entries[e].key, key) == 0) {
+          ++nfound;
+          break;
+        }
+      }
+    }
+  }
+
+  BENCHMARK("ngf_plmd_find_user") {
+    for (uint32_t q = 0u; q < nqueries; ++q) {
+      nfound += ngf_plmd_find_user(meta, user[q % user.size()].first.c_str())
+                    != nullptr;
+    }
+  }
+
+  REQUIRE(nfound == 2u * nqueries);
+  ngf_plmd_destroy(meta, nullptr);
+}
@@ -0,0 +1,50 @@
+#include "catch.hpp"
+#include "nicegraf_internal.h"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+static void sort_and_check(std::vector<uint64_t> &keys) {
+  const uint32_t n = (uint32_t)keys.size();
+  std::vector<uint32_t> values(n);
+  for (uint32_t i = 0u; i < n; ++i) values[i] = i;
+  std::vector<std::pair<uint64_t, uint32_t>> expected;
+  for (uint32_t i = 0u; i < n; ++i) expected.emplace_back(keys[i], i);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const std::pair<uint64_t, uint32_t> &a,
+                      const std::pair<uint64_t, uint32_t> &b) {
+                     return a.first < b.first;
+                   });
+  std::vector<uint64_t> scratch_keys(n);
+  std::vector<uint32_t> scratch_values(n);
+  _ngf_radix_sort_u64(keys.data(), values.data(), scratch_keys.data(),
+                      scratch_values.data(), n);
+  for (uint32_t i = 0u; i < n; ++i) {
+    REQUIRE(keys[i] == expected[i].first);
+    REQUIRE(values[i] == expected[i].second);
+  }
+}
+
+TEST_CASE("Radix sort of random keys", "[radix_sort_random]") {
+  std::mt19937_64 gen(0xbeef);
+  std::vector<uint64_t> keys(5000u);
+  for (uint64_t &k : keys) k = gen();
+  sort_and_check(keys);
+}
+
+TEST_CASE("Radix sort is stable", "[radix_sort_stable]") {
+  std::mt19937_64 gen(0xf00d);
+  std::uniform_int_distribution<uint64_t> dist(0u, 7u);
+  std::vector<uint64_t> keys(1000u);
+  // Only a few distinct values, spread over high and low bits.
+  for (uint64_t &k : keys) k = (dist(gen) << 56u) | dist(gen);
+  sort_and_check(keys);
+}
+
+TEST_CASE("Radix sort of trivial inputs", "[radix_sort_trivial]") {
+  std::vector<uint64_t> empty;
+  sort_and_check(empty);
+  std::vector<uint64_t> same(100u, 0x1234u);
+  sort_and_check(same);
+}
@@ -0,0 +1,355 @@
+#include "catch.hpp"
+#include "nicegraf_util.h"
+#include <string.h>
+#include <string>
+
+namespace {
+
+ngf_image_info color_image_info() {
+  ngf_image_info info;
+  memset(&info, 0, sizeof(info));
+  info.type = NGF_IMAGE_TYPE_IMAGE_2D;
+  info.extent.width = 256u;
+  info.extent.height = 256u;
+  info.extent.depth = 1u;
+  info.nmips = 1u;
+  info.format = NGF_IMAGE_FORMAT_RGBA8;
+  info.usage_hint = NGF_IMAGE_USAGE_ATTACHMENT | NGF_IMAGE_USAGE_SAMPLE_FROM;
+  return info;
+}
+
+ngf_util_rg_attachment color_attachment(ngf_util_rg_resource image,
+                                        ngf_attachment_load_op load_op) {
+  ngf_util_rg_attachment att;
+  memset(&att, 0, sizeof(att));
+  att.image = image;
+  att.type = NGF_ATTACHMENT_COLOR;
+  att.load_op = load_op;
+  return att;
+}
+
+ngf_util_rg_pass_info render_pass(const ngf_util_rg_attachment *att,
+                                  const ngf_util_rg_resource   *reads,
+                                  uint32_t                      nreads) {
+  ngf_util_rg_pass_info pass;
+  memset(&pass, 0, sizeof(pass));
+  pass.type = NGF_UTIL_RG_PASS_RENDER;
+  pass.attachments = att;
+  pass.nattachments = 1u;
+  pass.reads = reads;
+  pass.nreads = nreads;
+  return pass;
+}
+
+ngf_util_rg_pass_info compute_pass(const ngf_util_rg_resource *reads,
+                                   uint32_t                    nreads,
+                                   const ngf_util_rg_resource *writes,
+                                   uint32_t                    nwrites) {
+  ngf_util_rg_pass_info pass;
+  memset(&pass, 0, sizeof(pass));
+  pass.type = NGF_UTIL_RG_PASS_COMPUTE;
+  pass.reads = reads;
+  pass.nreads = nreads;
+  pass.writes = writes;
+  pass.nwrites = nwrites;
+  return pass;
+}
+
+ngf_util_rg_compiled_pass compiled_pass(ngf_util_render_graph graph,
+                                        uint32_t              p) {
+  ngf_util_rg_compiled_pass result;
+  REQUIRE(ngf_util_render_graph_get_compiled_pass(graph, p, &result) ==
+          NGF_ERROR_OK);
+  return result;
+}
+
+void record_render(ngf_util_render_graph, ngf_render_encoder, void *u) {
+  *(std::string*)u += "r";
+}
+
+void record_compute(ngf_util_render_graph, ngf_compute_encoder, void *u) {
+  *(std::string*)u += "c";
+}
+
+}  // namespace
+
+TEST_CASE("Render graph culling", "[render_graph]") {
+  ngf_util_render_graph graph;
+  REQUIRE(ngf_util_create_render_graph(&graph) == NGF_ERROR_OK);
+  const ngf_image_info info = color_image_info();
+  const ngf_util_rg_resource backbuffer =
+      ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_resource scene =
+      ngf_util_render_graph_create_image(graph, &info);
+  const ngf_util_rg_resource unused =
+      ngf_util_render_graph_create_image(graph, &info);
+
+  const ngf_util_rg_attachment scene_att =
+      color_attachment(scene, NGF_LOAD_OP_CLEAR);
+  const ngf_util_rg_attachment unused_att =
+      color_attachment(unused, NGF_LOAD_OP_CLEAR);
+  const ngf_util_rg_attachment final_att =
+      color_attachment(backbuffer, NGF_LOAD_OP_DONTCARE);
+  ngf_util_rg_pass_info pass = render_pass(&scene_att, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = render_pass(&unused_att, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  // Has side effects, so it's kept even though nothing reads its output.
+  pass.side_effects = true;
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = render_pass(&final_att, &scene, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+
+  ngf_util_rg_stats stats;
+  REQUIRE(ngf_util_render_graph_compile(graph, &stats) == NGF_ERROR_OK);
+  REQUIRE(stats.npasses == 4u);
+  REQUIRE(stats.nculled_passes == 1u);
+  REQUIRE(stats.ntransient_images == 2u);
+  REQUIRE(!compiled_pass(graph, 0u).culled);
+  REQUIRE(compiled_pass(graph, 1u).culled);
+  REQUIRE(!compiled_pass(graph, 2u).culled);
+  REQUIRE(!compiled_pass(graph, 3u).culled);
+
+  // A pass that clears its only output makes the earlier writer redundant.
+  ngf_util_render_graph_reset(graph);
+  const ngf_util_rg_resource target =
+      ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_attachment keep_att =
+      color_attachment(target, NGF_LOAD_OP_KEEP);
+  const ngf_util_rg_attachment clear_att =
+      color_attachment(target, NGF_LOAD_OP_CLEAR);
+  pass = render_pass(&keep_att, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = render_pass(&clear_att, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  REQUIRE(ngf_util_render_graph_compile(graph, &stats) == NGF_ERROR_OK);
+  REQUIRE(stats.nculled_passes == 1u);
+  REQUIRE(compiled_pass(graph, 0u).culled);
+  REQUIRE(!compiled_pass(graph, 1u).culled);
+
+  ngf_util_destroy_render_graph(graph);
+}
+
+TEST_CASE("Render graph lifetimes and attachment ops", "[render_graph]") {
+  ngf_util_render_graph graph;
+  REQUIRE(ngf_util_create_render_graph(&graph) == NGF_ERROR_OK);
+  const ngf_image_info info = color_image_info();
+  const ngf_util_rg_resource backbuffer =
+      ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_resource a =
+      ngf_util_render_graph_create_image(graph, &info);
+  const ngf_util_rg_resource b =
+      ngf_util_render_graph_create_image(graph, &info);
+  const ngf_util_rg_resource never_used =
+      ngf_util_render_graph_create_image(graph, &info);
+
+  // Keeping the contents of an image nothing has written to yet is pointless,
+  // so the first pass doesn't load `a`. The second pass does, and `a` is
+  // read afterwards, so both store it.
+  const ngf_util_rg_attachment a_first =
+      color_attachment(a, NGF_LOAD_OP_KEEP);
+  const ngf_util_rg_attachment a_second =
+      color_attachment(a, NGF_LOAD_OP_KEEP);
+  const ngf_util_rg_attachment b_att = color_attachment(b, NGF_LOAD_OP_CLEAR);
+  const ngf_util_rg_attachment final_att =
+      color_attachment(backbuffer, NGF_LOAD_OP_KEEP);
+  ngf_util_rg_pass_info pass = render_pass(&a_first, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = render_pass(&a_second, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = render_pass(&b_att, &a, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = render_pass(&final_att, &b, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+
+  uint32_t first = 0u, last = 0u;
+  REQUIRE(ngf_util_render_graph_get_lifetime(graph, a, &first, &last) ==
+          NGF_ERROR_INVALID_OPERATION);
+  ngf_util_rg_compiled_pass compiled;
+  REQUIRE(ngf_util_render_graph_get_compiled_pass(graph, 0u, &compiled) ==
+          NGF_ERROR_INVALID_OPERATION);
+  REQUIRE(ngf_util_render_graph_compile(graph, NULL) == NGF_ERROR_OK);
+
+  REQUIRE(ngf_util_render_graph_get_lifetime(graph, a, &first, &last) ==
+          NGF_ERROR_OK);
+  REQUIRE(first == 0u);
+  REQUIRE(last == 2u);
+  REQUIRE(ngf_util_render_graph_get_lifetime(graph, b, &first, &last) ==
+          NGF_ERROR_OK);
+  REQUIRE(first == 2u);
+  REQUIRE(last == 3u);
+  REQUIRE(ngf_util_render_graph_get_lifetime(graph, never_used, &first,
+                                             &last) == NGF_ERROR_OK);
+  REQUIRE(first == ~0u);
+  REQUIRE(last == ~0u);
+  REQUIRE(ngf_util_render_graph_get_lifetime(graph, 42u, &first, &last) ==
+          NGF_ERROR_OUT_OF_BOUNDS);
+  REQUIRE(ngf_util_render_graph_get_compiled_pass(graph, 4u, &compiled) ==
+          NGF_ERROR_OUT_OF_BOUNDS);
+
+  compiled = compiled_pass(graph, 0u);
+  REQUIRE(compiled.load_ops[0] == NGF_LOAD_OP_DONTCARE);
+  REQUIRE(compiled.store_ops[0] == NGF_STORE_OP_STORE);
+  compiled = compiled_pass(graph, 1u);
+  REQUIRE(compiled.load_ops[0] == NGF_LOAD_OP_KEEP);
+  REQUIRE(compiled.store_ops[0] == NGF_STORE_OP_STORE);
+  // `b` isn't used after the last pass, but it is read by it.
+  compiled = compiled_pass(graph, 2u);
+  REQUIRE(compiled.load_ops[0] == NGF_LOAD_OP_CLEAR);
+  REQUIRE(compiled.store_ops[0] == NGF_STORE_OP_STORE);
+  // Imported images are always loaded and stored as requested.
+  compiled = compiled_pass(graph, 3u);
+  REQUIRE(compiled.load_ops[0] == NGF_LOAD_OP_KEEP);
+  REQUIRE(compiled.store_ops[0] == NGF_STORE_OP_STORE);
+
+  // Nothing reads `b` after a pass that only renders to it.
+  ngf_util_render_graph_reset(graph);
+  const ngf_util_rg_resource c =
+      ngf_util_render_graph_create_image(graph, &info);
+  const ngf_util_rg_attachment c_att = color_attachment(c, NGF_LOAD_OP_CLEAR);
+  pass = render_pass(&c_att, NULL, 0u);
+  pass.side_effects = true;
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  REQUIRE(ngf_util_render_graph_compile(graph, NULL) == NGF_ERROR_OK);
+  REQUIRE(compiled_pass(graph, 0u).store_ops[0] == NGF_STORE_OP_DONTCARE);
+
+  ngf_util_destroy_render_graph(graph);
+}
+
+TEST_CASE("Render graph validation", "[render_graph]") {
+  ngf_util_render_graph graph;
+  REQUIRE(ngf_util_create_render_graph(&graph) == NGF_ERROR_OK);
+  const ngf_image_info info = color_image_info();
+  const ngf_util_rg_resource target =
+      ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_resource unwritten =
+      ngf_util_render_graph_create_image(graph, &info);
+
+  // Reading a transient image that nothing has written to.
+  const ngf_util_rg_attachment att =
+      color_attachment(target, NGF_LOAD_OP_CLEAR);
+  ngf_util_rg_pass_info pass = render_pass(&att, &unwritten, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  REQUIRE(ngf_util_render_graph_compile(graph, NULL) ==
+          NGF_ERROR_INVALID_OPERATION);
+
+  // Unknown resources.
+  ngf_util_render_graph_reset(graph);
+  const ngf_util_rg_resource bogus = 7u;
+  pass = compute_pass(&bogus, 1u, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  REQUIRE(ngf_util_render_graph_compile(graph, NULL) ==
+          NGF_ERROR_OUT_OF_BOUNDS);
+
+  // Too many attachments.
+  ngf_util_render_graph_reset(graph);
+  ngf_util_rg_attachment atts[NGF_UTIL_RG_MAX_ATTACHMENTS + 1u];
+  for (uint32_t i = 0u; i < NGF_UTIL_RG_MAX_ATTACHMENTS + 1u; ++i) {
+    atts[i] = att;
+  }
+  pass = render_pass(atts, NULL, 0u);
+  pass.nattachments = NGF_UTIL_RG_MAX_ATTACHMENTS + 1u;
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) ==
+          NGF_ERROR_OUT_OF_BOUNDS);
+
+  ngf_util_destroy_render_graph(graph);
+}
+
+TEST_CASE("Render graph encoder batching", "[render_graph]") {
+  ngf_util_render_graph graph;
+  REQUIRE(ngf_util_create_render_graph(&graph) == NGF_ERROR_OK);
+  const ngf_util_rg_resource x = ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_resource y = ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_resource z = ngf_util_render_graph_import(graph, NULL);
+  const ngf_util_rg_resource w = ngf_util_render_graph_import(graph, NULL);
+
+  // 0: writes x.
+  // 1: writes y, independent of 0, so it shares its encoder.
+  // 2: reads x, which pass 0 writes in the same encoder: new encoder.
+  // 3: writes x, which pass 2 reads in the same encoder: new encoder.
+  // 4, 5: render passes, which never share an encoder.
+  // 6: compute again, after render passes: new encoder.
+  ngf_util_rg_pass_info pass = compute_pass(NULL, 0u, &x, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = compute_pass(NULL, 0u, &y, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = compute_pass(&x, 1u, &z, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = compute_pass(NULL, 0u, &x, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  const ngf_util_rg_attachment att = color_attachment(w, NGF_LOAD_OP_KEEP);
+  pass = render_pass(&att, NULL, 0u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+  pass = compute_pass(&y, 1u, &z, 1u);
+  REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+
+  ngf_util_rg_stats stats;
+  REQUIRE(ngf_util_render_graph_compile(graph, &stats) == NGF_ERROR_OK);
+  REQUIRE(stats.nculled_passes == 0u);
+  REQUIRE(stats.nencoders == 6u);
+  const bool expected[] = {true, false, true, true, true, true, true};
+  for (uint32_t p = 0u; p < sizeof(expected) / sizeof(expected[0]); ++p) {
+    INFO("pass " << p);
+    REQUIRE(compiled_pass(graph, p).new_encoder == expected[p]);
+  }
+
+  ngf_util_destroy_render_graph(graph);
+}
+
+TEST_CASE("Render graph execution", "[render_graph]") {
+  REQUIRE(ngf_initialize(NGF_DEVICE_PREFERENCE_DONTCARE) == NGF_ERROR_OK);
+  const ngf_context_info ctx_info = {NULL, NULL, false};
+  ngf_context ctx;
+  REQUIRE(ngf_create_context(&ctx_info, &ctx) == NGF_ERROR_OK);
+  REQUIRE(ngf_set_context(ctx) == NGF_ERROR_OK);
+  ngf_cmd_buffer cmd_buf;
+  REQUIRE(ngf_create_cmd_buffer(NULL, &cmd_buf) == NGF_ERROR_OK);
+
+  ngf_util_render_graph graph;
+  REQUIRE(ngf_util_create_render_graph(&graph) == NGF_ERROR_OK);
+  const ngf_image_info info = color_image_info();
+  std::string recorded;
+  for (uint32_t frame = 0u; frame < 3u; ++frame) {
+    ngf_util_render_graph_reset(graph);
+    const ngf_util_rg_resource out = ngf_util_render_graph_import(graph, NULL);
+    const ngf_util_rg_resource a =
+        ngf_util_render_graph_create_image(graph, &info);
+    const ngf_util_rg_resource b =
+        ngf_util_render_graph_create_image(graph, &info);
+    const ngf_util_rg_attachment a_att =
+        color_attachment(a, NGF_LOAD_OP_CLEAR);
+    const ngf_util_rg_attachment b_att =
+        color_attachment(b, NGF_LOAD_OP_CLEAR);
+    ngf_util_rg_pass_info pass = render_pass(&a_att, NULL, 0u);
+    pass.name = "a";
+    pass.render = record_render;
+    pass.userdata = &recorded;
+    REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+    pass = render_pass(&b_att, &a, 1u);
+    pass.name = "b";
+    pass.render = record_render;
+    pass.userdata = &recorded;
+    REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+    pass = compute_pass(&b, 1u, &out, 1u);
+    pass.name = "resolve";
+    pass.compute = record_compute;
+    pass.userdata = &recorded;
+    REQUIRE(ngf_util_render_graph_add_pass(graph, &pass) == NGF_ERROR_OK);
+
+    REQUIRE(ngf_begin_frame() == NGF_ERROR_OK);
+    REQUIRE(ngf_start_cmd_buffer(cmd_buf) == NGF_ERROR_OK);
+    REQUIRE(ngf_util_render_graph_execute(graph, cmd_buf) ==
+            NGF_ERROR_INVALID_OPERATION);
+    REQUIRE(ngf_util_render_graph_compile(graph, NULL) == NGF_ERROR_OK);
+    REQUIRE(ngf_util_render_graph_execute(graph, cmd_buf) == NGF_ERROR_OK);
+    REQUIRE(ngf_util_render_graph_get_image(graph, a) != NULL);
+    REQUIRE(ngf_submit_cmd_buffers(1u, &cmd_buf) == NGF_ERROR_OK);
+    REQUIRE(ngf_end_frame() == NGF_ERROR_OK);
+  }
+  REQUIRE(recorded == "rrcrrcrrc");
+
+  ngf_util_destroy_render_graph(graph);
+  ngf_destroy_cmd_buffer(cmd_buf);
+  ngf_destroy_context(ctx);
+}
@@ -0,0 +1,58 @@
+#include "catch.hpp"
+#include "nicegraf_internal.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static std::string read_file(const char *path) {
+  std::ifstream in(path);
+  std::stringstream contents;
+  contents << in.rdbuf();
+  return contents.str();
+}
+
+TEST_CASE("Timeline trace export", "[timeline]") {
+  const char *path = "ngf_timeline_test.json";
+  REQUIRE(ngf_flush_timeline_trace() == NGF_ERROR_INVALID_OPERATION);
+  // Nothing gets recorded while no trace is being written.
+  REQUIRE(_ngf_timeline_now() == 0u);
+  _ngf_timeline_record("before", 1u, 1u, false);
+
+  REQUIRE(ngf_begin_timeline_trace(path) == NGF_ERROR_OK);
+  REQUIRE(ngf_begin_timeline_trace(path) == NGF_ERROR_INVALID_OPERATION);
+  _ngf_timeline_scope("main \"scope\"", _ngf_timeline_now());
+  std::thread worker([] {
+    _ngf_timeline_scope("worker scope", _ngf_timeline_now());
+  });
+  worker.join();
+  _ngf_gpu_timing_results gpu;
+  gpu.nscopes = 1u;
+  strcpy(gpu.scopes[0].name, "render encoder");
+  gpu.scopes[0].start_ns = 0u;
+  gpu.scopes[0].duration_ns = 2000u;
+  _ngf_timeline_gpu_frame(&gpu, _ngf_stats_now_ns());
+  REQUIRE(ngf_flush_timeline_trace() == NGF_ERROR_OK);
+
+  // Overflowing a ring drops scopes instead of overwriting unflushed ones.
+  const uint64_t t = _ngf_timeline_now();
+  for (uint32_t i = 0u; i < _NGF_TIMELINE_RING_SIZE + 10u; ++i) {
+    _ngf_timeline_scope("spam", t);
+  }
+  REQUIRE(ngf_end_timeline_trace() == NGF_ERROR_OK);
+  REQUIRE(ngf_end_timeline_trace() == NGF_ERROR_INVALID_OPERATION);
+
+  const std::string trace = read_file(path);
+  std::remove(path);
+  REQUIRE(trace.front() == '[');
+  REQUIRE(trace.find("\"before\"") == std::string::npos);
+  REQUIRE(trace.find("\"main \\\"scope\\\"\"") != std::string::npos);
+  REQUIRE(trace.find("\"worker scope\"") != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"render encoder\",\"cat\":\"gpu\"") !=
+          std::string::npos);
+  REQUIRE(trace.find("{\"name\":\"GPU\"}") != std::string::npos);
+  REQUIRE(trace.find("\"10 scopes dropped\"") != std::string::npos);
+  REQUIRE(trace.substr(trace.size() - 3u) == "\n]\n");
+}
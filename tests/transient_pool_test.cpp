@@ -0,0 +1,174 @@
+#include "catch.hpp"
+#include "nicegraf_internal.h"
+#include <stdint.h>
+#include <string.h>
+
+namespace {
+
+uintptr_t next_handle = 1u;
+uint32_t nlive_images = 0u;
+uint32_t nlive_blocks = 0u;
+
+ngf_image fake_image() {
+  ++nlive_images;
+  return (ngf_image)(next_handle++);
+}
+
+void destroy_image(ngf_image) { --nlive_images; }
+
+void free_block(const _ngf_transient_block*) { --nlive_blocks; }
+
+// Every image has memory of its own.
+ngf_error create_dedicated(ngf_transient_pool,
+                           const ngf_transient_image_info*,
+                           ngf_image *result,
+                           uint32_t *block) {
+  *block = _NGF_TRANSIENT_NO_BLOCK;
+  *result = fake_image();
+  return NGF_ERROR_OK;
+}
+
+// Images take 1KiB per layer of depth, from memory blocks that they share.
+ngf_error create_aliased(ngf_transient_pool pool,
+                         const ngf_transient_image_info *info,
+                         ngf_image *result,
+                         uint32_t *block) {
+  const uint64_t size = 1024u * info->image_info.extent.depth;
+  if (!_ngf_transient_find_block(pool, size, 256u, 0x1u, info->first_use,
+                                 block)) {
+    const _ngf_transient_block b = {(void*)(next_handle++), 0u, size, 0x1u};
+    REQUIRE(_ngf_transient_add_block(pool, &b, block) == NGF_ERROR_OK);
+    ++nlive_blocks;
+  }
+  *result = fake_image();
+  return NGF_ERROR_OK;
+}
+
+ngf_transient_image_info image_info(ngf_image_format format,
+                                    uint32_t depth,
+                                    uint32_t first_use,
+                                    uint32_t last_use) {
+  ngf_transient_image_info info;
+  memset(&info, 0, sizeof(info));
+  info.image_info.type = NGF_IMAGE_TYPE_IMAGE_2D;
+  info.image_info.extent.width = 1920u;
+  info.image_info.extent.height = 1080u;
+  info.image_info.extent.depth = depth;
+  info.image_info.nmips = 1u;
+  info.image_info.format = format;
+  info.image_info.usage_hint = NGF_IMAGE_USAGE_ATTACHMENT;
+  info.first_use = first_use;
+  info.last_use = last_use;
+  return info;
+}
+
+}
+
+TEST_CASE("Transient images are shared between disjoint lifetimes",
+          "[transient_pool]") {
+  ngf_transient_pool pool = NULL;
+  REQUIRE(_ngf_transient_pool_create(&pool) == NGF_ERROR_OK);
+
+  const ngf_transient_image_info bad =
+      image_info(NGF_IMAGE_FORMAT_RGBA8, 1u, 3u, 2u);
+  ngf_image a = NULL, b = NULL, c = NULL, d = NULL;
+  REQUIRE(_ngf_transient_acquire(pool, &bad, create_dedicated, &a) ==
+          NGF_ERROR_OUT_OF_BOUNDS);
+
+  // A post-processing chain: each pass reads the previous pass' output.
+  ngf_transient_image_info info =
+      image_info(NGF_IMAGE_FORMAT_RGBA8, 1u, 0u, 1u);
+  REQUIRE(_ngf_transient_acquire(pool, &info, create_dedicated, &a) ==
+          NGF_ERROR_OK);
+  info.first_use = 1u; info.last_use = 2u;
+  REQUIRE(_ngf_transient_acquire(pool, &info, create_dedicated, &b) ==
+          NGF_ERROR_OK);
+  info.first_use = 2u; info.last_use = 3u;
+  REQUIRE(_ngf_transient_acquire(pool, &info, create_dedicated, &c) ==
+          NGF_ERROR_OK);
+  REQUIRE(a != b);
+  REQUIRE(c == a);
+
+  // Images with other configurations are never shared.
+  const ngf_transient_image_info other =
+      image_info(NGF_IMAGE_FORMAT_RGBA16F, 1u, 4u, 4u);
+  REQUIRE(_ngf_transient_acquire(pool, &other, create_dedicated, &d) ==
+          NGF_ERROR_OK);
+  REQUIRE(d != a);
+  REQUIRE(d != b);
+
+  ngf_transient_pool_stats stats;
+  _ngf_transient_pool_stats(pool, &stats);
+  REQUIRE(stats.nimages == 3u);
+  REQUIRE(stats.nacquired == 4u);
+  REQUIRE(stats.nmemory_blocks == 0u);
+
+  // The same images are handed out in the next frame.
+  _ngf_transient_pool_reset(pool, destroy_image, free_block);
+  info.first_use = 0u; info.last_use = 1u;
+  ngf_image a2 = NULL;
+  REQUIRE(_ngf_transient_acquire(pool, &info, create_dedicated, &a2) ==
+          NGF_ERROR_OK);
+  REQUIRE(a2 == a);
+
+  // Images that stay idle for long enough are destroyed.
+  for (uint32_t r = 0u; r < _NGF_TRANSIENT_MAX_IDLE_RESETS; ++r) {
+    _ngf_transient_pool_stats(pool, &stats);
+    REQUIRE(stats.nimages == 3u);
+    _ngf_transient_pool_reset(pool, destroy_image, free_block);
+  }
+  _ngf_transient_pool_stats(pool, &stats);
+  REQUIRE(stats.nimages == 1u);
+  _ngf_transient_pool_reset(pool, destroy_image, free_block);
+  _ngf_transient_pool_stats(pool, &stats);
+  REQUIRE(stats.nimages == 0u);
+  REQUIRE(stats.nacquired == 0u);
+  REQUIRE(nlive_images == 0u);
+
+  _ngf_transient_pool_destroy(pool, destroy_image, free_block);
+}
+
+TEST_CASE("Transient images alias memory", "[transient_pool]") {
+  ngf_transient_pool pool = NULL;
+  REQUIRE(_ngf_transient_pool_create(&pool) == NGF_ERROR_OK);
+
+  // Different configurations share memory when their lifetimes don't
+  // overlap and the memory is large enough.
+  ngf_transient_image_info hdr =
+      image_info(NGF_IMAGE_FORMAT_RGBA16F, 2u, 0u, 1u);
+  ngf_transient_image_info ldr =
+      image_info(NGF_IMAGE_FORMAT_RGBA8, 1u, 1u, 2u);
+  ngf_transient_image_info bloom =
+      image_info(NGF_IMAGE_FORMAT_RG11B10F, 2u, 2u, 3u);
+  ngf_image a = NULL, b = NULL, c = NULL;
+  REQUIRE(_ngf_transient_acquire(pool, &hdr, create_aliased, &a) ==
+          NGF_ERROR_OK);
+  REQUIRE(_ngf_transient_acquire(pool, &ldr, create_aliased, &b) ==
+          NGF_ERROR_OK);
+  REQUIRE(_ngf_transient_acquire(pool, &bloom, create_aliased, &c) ==
+          NGF_ERROR_OK);
+  ngf_transient_pool_stats stats;
+  _ngf_transient_pool_stats(pool, &stats);
+  REQUIRE(stats.nimages == 3u);
+  REQUIRE(stats.nmemory_blocks == 2u);
+  REQUIRE(stats.memory_bytes == 3u * 1024u);
+
+  // An image can't be reused while another image is using its memory.
+  _ngf_transient_pool_reset(pool, destroy_image, free_block);
+  ngf_image c2 = NULL, a2 = NULL;
+  bloom.first_use = 0u; bloom.last_use = 5u;
+  hdr.first_use = 1u; hdr.last_use = 2u;
+  REQUIRE(_ngf_transient_acquire(pool, &bloom, create_aliased, &c2) ==
+          NGF_ERROR_OK);
+  REQUIRE(_ngf_transient_acquire(pool, &hdr, create_aliased, &a2) ==
+          NGF_ERROR_OK);
+  REQUIRE(c2 == c);
+  REQUIRE(a2 != a);
+  _ngf_transient_pool_stats(pool, &stats);
+  REQUIRE(stats.nimages == 4u);
+  REQUIRE(stats.nmemory_blocks == 3u);
+
+  _ngf_transient_pool_destroy(pool, destroy_image, free_block);
+  REQUIRE(nlive_images == 0u);
+  REQUIRE(nlive_blocks == 0u);
+}
@@ -0,0 +1,1237 @@
+/**
+ * Copyright (c) 2019 nicegraf contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+// Replays a trace written by nicegraf's capture layer (see nicegraf_trace.h).
+//
+// Usage: ngf_replay [--timing] [--frames N] trace_file
+//   --timing    Only report per-frame CPU and GPU times.
+//   --frames N  Stop after replaying N frames.
+//
+// Contexts are always created without a swapchain, so that traces can be
+// replayed on headless machines. Default render targets are replaced with
+// off-screen render targets of the captured swapchain's size and formats.
+// Replay happens on a single thread, in the order in which records were
+// written.
+
+#define _CRT_SECURE_NO_WARNINGS
+#include "nicegraf.h"
+#include "nicegraf_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#pragma region handle_maps
+
+// Maps handle values from the trace to the objects created during replay.
+typedef struct {
+  uint64_t key;
+  void *value;
+} map_entry;
+
+typedef struct {
+  map_entry *entries;
+  size_t capacity; // Always a power of two.
+  size_t size;
+} handle_map;
+
+static size_t map_slot(const handle_map *m, uint64_t key) {
+  size_t slot = (size_t)((key >> 4) * 0x9E3779B97F4A7C15ull) &
+                (m->capacity - 1u);
+  while (m->entries[slot].key != 0u && m->entries[slot].key != key) {
+    slot = (slot + 1u) & (m->capacity - 1u);
+  }
+  return slot;
+}
+
+static void map_set(handle_map *m, uint64_t key, void *value) {
+  if (key == 0u) {
+    return;
+  }
+  if ((m->size + 1u) * 2u > m->capacity) {
+    handle_map grown = {NULL, m->capacity > 0u ? m->capacity * 2u : 64u, 0u};
+    grown.entries = (map_entry*)calloc(grown.capacity, sizeof(map_entry));
+    for (size_t i = 0u; i < m->capacity; ++i) {
+      if (m->entries[i].key != 0u) {
+        map_entry *e = &grown.entries[map_slot(&grown, m->entries[i].key)];
+        *e = m->entries[i];
+        ++grown.size;
+      }
+    }
+    free(m->entries);
+    *m = grown;
+  }
+  map_entry *e = &m->entries[map_slot(m, key)];
+  if (e->key == 0u) {
+    ++m->size;
+  }
+  e->key = key;
+  e->value = value;
+}
+
+static void* map_get(const handle_map *m, uint64_t key) {
+  if (key == 0u || m->capacity == 0u) {
+    return NULL;
+  }
+  return m->entries[map_slot(m, key)].value;
+}
+
+static handle_map OBJECTS = {NULL, 0u, 0u};
+static handle_map ENCODERS = {NULL, 0u, 0u};
+
+#pragma endregion
+
+#pragma region record_decoding
+
+// Memory for the decoded arguments of the current record.
+static uint8_t *SCRATCH = NULL;
+static size_t SCRATCH_USED = 0u;
+static size_t SCRATCH_CAPACITY = 0u;
+
+static void* scratch_alloc(size_t size) {
+  const size_t offset = (SCRATCH_USED + 15u) & ~(size_t)15u;
+  if (offset + size > SCRATCH_CAPACITY) {
+    return NULL;
+  }
+  SCRATCH_USED = offset + size;
+  return SCRATCH + offset;
+}
+
+typedef struct {
+  const uint8_t *ptr;
+  const uint8_t *end;
+  bool overrun;
+} reader;
+
+static void get(reader *r, void *dst, size_t size) {
+  if (r->overrun || (size_t)(r->end - r->ptr) < size || dst == NULL) {
+    r->overrun = true;
+    if (dst != NULL) {
+      memset(dst, 0, size);
+    }
+    return;
+  }
+  memcpy(dst, r->ptr, size);
+  r->ptr += size;
+}
+
+#define GET(r, value) get(r, &(value), sizeof(value))
+
+static uint32_t get_u32(reader *r) {
+  uint32_t value;
+  GET(r, value);
+  return value;
+}
+
+static uint64_t get_u64(reader *r) {
+  uint64_t value;
+  GET(r, value);
+  return value;
+}
+
+static void* get_handle(reader *r) {
+  return map_get(&OBJECTS, get_u64(r));
+}
+
+static uintptr_t get_encoder(reader *r) {
+  return (uintptr_t)map_get(&ENCODERS, get_u64(r));
+}
+
+static void* get_array(reader *r, size_t size) {
+  void *data = scratch_alloc(size);
+  get(r, data, size);
+  return data;
+}
+
+static void* get_blob(reader *r, size_t *size) {
+  *size = (size_t)get_u64(r);
+  return get_array(r, *size);
+}
+
+static const char* get_string(reader *r) {
+  const uint32_t len = get_u32(r);
+  if (len == _NGF_TRACE_NULL_STRING) {
+    return NULL;
+  }
+  char *str = (char*)scratch_alloc(len + 1u);
+  get(r, str, len);
+  if (str != NULL) {
+    str[len] = '\0';
+  }
+  return str;
+}
+
+static void* get_optional(reader *r, size_t size) {
+  return get_u32(r) != 0u ? get_array(r, size) : NULL;
+}
+
+static ngf_image_ref get_image_ref(reader *r) {
+  ngf_image_ref ref;
+  ref.image = (ngf_image)get_handle(r);
+  ref.mip_level = get_u32(r);
+  ref.layer = get_u32(r);
+  ref.cubemap_face = (ngf_cubemap_face)get_u32(r);
+  return ref;
+}
+
+static ngf_pipeline_layout_info* get_layout(reader *r) {
+  ngf_pipeline_layout_info *layout =
+      (ngf_pipeline_layout_info*)scratch_alloc(sizeof(*layout));
+  if (layout == NULL) {
+    r->overrun = true;
+    return NULL;
+  }
+  layout->ndescriptor_set_layouts = get_u32(r);
+  layout->descriptor_set_layouts = (ngf_descriptor_set_layout_info*)
+      scratch_alloc(sizeof(ngf_descriptor_set_layout_info) *
+                    layout->ndescriptor_set_layouts);
+  for (uint32_t s = 0u; s < layout->ndescriptor_set_layouts && !r->overrun;
+       ++s) {
+    ngf_descriptor_set_layout_info *set = &layout->descriptor_set_layouts[s];
+    set->ndescriptors = get_u32(r);
+    set->descriptors = (const ngf_descriptor_info*)
+        get_array(r, sizeof(ngf_descriptor_info) * set->ndescriptors);
+  }
+  layout->push_constants_size = get_u32(r);
+  layout->push_constants_stage_flags = get_u32(r);
+  return layout;
+}
+
+static ngf_specialization_info* get_spec_info(reader *r) {
+  if (get_u32(r) == 0u) {
+    return NULL;
+  }
+  ngf_specialization_info *spec =
+      (ngf_specialization_info*)scratch_alloc(sizeof(*spec));
+  if (spec == NULL) {
+    r->overrun = true;
+    return NULL;
+  }
+  spec->nspecializations = get_u32(r);
+  spec->specializations = (ngf_constant_specialization*)
+      get_array(r, sizeof(ngf_constant_specialization) *
+                   spec->nspecializations);
+  size_t value_buffer_size;
+  spec->value_buffer = get_blob(r, &value_buffer_size);
+  return spec;
+}
+
+static const ngf_plmd_cis_map* get_cis_map(reader *r) {
+  if (get_u32(r) == 0u) {
+    return NULL;
+  }
+  ngf_plmd_cis_map *map = (ngf_plmd_cis_map*)scratch_alloc(sizeof(*map));
+  if (map == NULL) {
+    r->overrun = true;
+    return NULL;
+  }
+  map->nentries = get_u32(r);
+  const ngf_plmd_cis_map_entry **entries = (const ngf_plmd_cis_map_entry**)
+      scratch_alloc(sizeof(ngf_plmd_cis_map_entry*) * map->nentries);
+  map->entries = entries;
+  for (uint32_t e = 0u; e < map->nentries && !r->overrun; ++e) {
+    const uint32_t set = get_u32(r), binding = get_u32(r),
+                   ncombined = get_u32(r);
+    ngf_plmd_cis_map_entry *entry = (ngf_plmd_cis_map_entry*)
+        scratch_alloc(sizeof(ngf_plmd_cis_map_entry) +
+                      sizeof(uint32_t) * ncombined);
+    if (entry == NULL) {
+      r->overrun = true;
+      break;
+    }
+    entry->separate_set_id = set;
+    entry->separate_binding_id = binding;
+    entry->ncombined_ids = ncombined;
+    get(r, entry->combined_ids, sizeof(uint32_t) * ncombined);
+    entries[e] = entry;
+  }
+  return map;
+}
+
+static const ngf_resource_bind_op* get_bind_ops(reader *r, uint32_t *nops) {
+  *nops = get_u32(r);
+  ngf_resource_bind_op *ops = (ngf_resource_bind_op*)
+      scratch_alloc(sizeof(ngf_resource_bind_op) * *nops);
+  for (uint32_t o = 0u; o < *nops && ops != NULL && !r->overrun; ++o) {
+    ngf_resource_bind_op *op = &ops[o];
+    op->target_set = get_u32(r);
+    op->target_binding = get_u32(r);
+    op->type = (ngf_descriptor_type)get_u32(r);
+    switch (op->type) {
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER:
+    case NGF_DESCRIPTOR_UNIFORM_BUFFER_DYNAMIC:
+      op->info.uniform_buffer.buffer = (ngf_uniform_buffer)get_handle(r);
+      op->info.uniform_buffer.offset = (size_t)get_u64(r);
+      op->info.uniform_buffer.range = (size_t)get_u64(r);
+      break;
+    case NGF_DESCRIPTOR_TEXTURE:
+    case NGF_DESCRIPTOR_SAMPLER:
+    case NGF_DESCRIPTOR_TEXTURE_AND_SAMPLER:
+      op->info.image_sampler.image_subresource = get_image_ref(r);
+      op->info.image_sampler.sampler = (ngf_sampler)get_handle(r);
+      break;
+    case NGF_DESCRIPTOR_STORAGE_BUFFER:
+      op->info.storage_buffer.buffer = (ngf_attrib_buffer)get_handle(r);
+      op->info.storage_buffer.offset = (size_t)get_u64(r);
+      op->info.storage_buffer.range = (size_t)get_u64(r);
+      break;
+    case NGF_DESCRIPTOR_STORAGE_IMAGE:
+      op->info.storage_image = get_image_ref(r);
+      break;
+    default:
+      break;
+    }
+  }
+  return ops;
+}
+
+#pragma endregion
+
+#pragma region replay_state
+
+static bool TIMING_ONLY = false;
+
+static void report(const char *message, const void *userdata) {
+  (void)userdata;
+  if (!TIMING_ONLY) {
+    fprintf(stderr, "nicegraf: %s\n", message);
+  }
+}
+
+static void check(ngf_error err, const char *what) {
+  if (err != NGF_ERROR_OK && !TIMING_ONLY) {
+    fprintf(stderr, "ngf_replay: %s failed (error %d)\n", what, (int)err);
+  }
+}
+
+// Swapchain parameters of each captured context, used for replacing default
+// render targets.
+#define MAX_CONTEXTS 16u
+
+typedef struct {
+  ngf_context ctx;
+  bool has_swapchain;
+  ngf_swapchain_info swapchain_info;
+} context_entry;
+
+static context_entry CONTEXTS[MAX_CONTEXTS];
+static ngf_context CURRENT_CONTEXT = NULL;
+
+// Off-screen replacements for default render targets, along with the images
+// that they own.
+#define MAX_REPLACED_RTS 64u
+
+typedef struct {
+  ngf_render_target rt;
+  ngf_image color;
+  ngf_image depth;
+} replaced_rt;
+
+static replaced_rt REPLACED_RTS[MAX_REPLACED_RTS];
+
+// Debug group names must outlive the records that they come from, since
+// backends may only read them at submission time.
+#define MAX_NAMES 1024u
+static char *NAMES[MAX_NAMES];
+
+static const char* intern_name(const char *name) {
+  if (name == NULL) {
+    return NULL;
+  }
+  for (uint32_t n = 0u; n < MAX_NAMES; ++n) {
+    if (NAMES[n] == NULL) {
+      NAMES[n] = (char*)malloc(strlen(name) + 1u);
+      strcpy(NAMES[n], name);
+      return NAMES[n];
+    }
+    if (strcmp(NAMES[n], name) == 0) {
+      return NAMES[n];
+    }
+  }
+  return "(too many debug group names)";
+}
+
+static ngf_error replace_default_rt(ngf_attachment_load_op color_load_op,
+                                    ngf_attachment_load_op depth_load_op,
+                                    ngf_attachment_store_op color_store_op,
+                                    ngf_attachment_store_op depth_store_op,
+                                    const ngf_clear *clear_color,
+                                    const ngf_clear *clear_depth,
+                                    ngf_render_target *result) {
+  const context_entry *ctx = NULL;
+  for (uint32_t c = 0u; c < MAX_CONTEXTS; ++c) {
+    if (CONTEXTS[c].ctx == CURRENT_CONTEXT && CURRENT_CONTEXT != NULL) {
+      ctx = &CONTEXTS[c];
+    }
+  }
+  replaced_rt *replaced = NULL;
+  for (uint32_t r = 0u; r < MAX_REPLACED_RTS && replaced == NULL; ++r) {
+    if (REPLACED_RTS[r].rt == NULL) {
+      replaced = &REPLACED_RTS[r];
+    }
+  }
+  if (ctx == NULL || !ctx->has_swapchain || replaced == NULL) {
+    return NGF_ERROR_NO_DEFAULT_RENDER_TARGET;
+  }
+  const ngf_swapchain_info *sc = &ctx->swapchain_info;
+  ngf_image_info image_info = {
+    NGF_IMAGE_TYPE_IMAGE_2D,
+    {sc->width, sc->height, 1u},
+    1u,
+    sc->cfmt,
+    sc->nsamples > 0 ? (uint32_t)sc->nsamples : 1u,
+    NGF_IMAGE_USAGE_ATTACHMENT
+  };
+  ngf_attachment attachments[2];
+  uint32_t nattachments = 0u;
+  ngf_error err = ngf_create_image(&image_info, &replaced->color);
+  if (err != NGF_ERROR_OK) {
+    return err;
+  }
+  memset(attachments, 0, sizeof(attachments));
+  attachments[nattachments].image_ref.image = replaced->color;
+  attachments[nattachments].type = NGF_ATTACHMENT_COLOR;
+  attachments[nattachments].load_op = color_load_op;
+  attachments[nattachments].store_op = color_store_op;
+  if (clear_color != NULL) {
+    attachments[nattachments].clear = *clear_color;
+  }
+  ++nattachments;
+  if (sc->dfmt != NGF_IMAGE_FORMAT_UNDEFINED) {
+    image_info.format = sc->dfmt;
+    err = ngf_create_image(&image_info, &replaced->depth);
+    if (err != NGF_ERROR_OK) {
+      ngf_destroy_image(replaced->color);
+      return err;
+    }
+    attachments[nattachments].image_ref.image = replaced->depth;
+    attachments[nattachments].type =
+        sc->dfmt == NGF_IMAGE_FORMAT_DEPTH24_STENCIL8
+            ? NGF_ATTACHMENT_DEPTH_STENCIL
+            : NGF_ATTACHMENT_DEPTH;
+    attachments[nattachments].load_op = depth_load_op;
+    attachments[nattachments].store_op = depth_store_op;
+    if (clear_depth != NULL) {
+      attachments[nattachments].clear = *clear_depth;
+    }
+    ++nattachments;
+  }
+  const ngf_render_target_info rt_info = {attachments, nattachments};
+  err = ngf_create_render_target(&rt_info, &replaced->rt);
+  if (err != NGF_ERROR_OK) {
+    ngf_destroy_image(replaced->color);
+    ngf_destroy_image(replaced->depth);
+    replaced->rt = NULL;
+    return err;
+  }
+  *result = replaced->rt;
+  return NGF_ERROR_OK;
+}
+
+static void destroy_rt(ngf_render_target rt) {
+  ngf_destroy_render_target(rt);
+  for (uint32_t r = 0u; r < MAX_REPLACED_RTS && rt != NULL; ++r) {
+    if (REPLACED_RTS[r].rt == rt) {
+      ngf_destroy_image(REPLACED_RTS[r].color);
+      ngf_destroy_image(REPLACED_RTS[r].depth);
+      memset(&REPLACED_RTS[r], 0, sizeof(REPLACED_RTS[r]));
+    }
+  }
+}
+
+// Bookkeeping for buffer mappings: the pointer returned by the replayed
+// map call, which flushed data gets copied into.
+typedef struct {
+  void *buffer;
+  uint8_t *ptr;
+} mapping;
+
+#define MAX_MAPPINGS 64u
+static mapping MAPPINGS[MAX_MAPPINGS];
+
+static uint8_t* find_mapping(void *buffer) {
+  for (uint32_t m = 0u; m < MAX_MAPPINGS; ++m) {
+    if (MAPPINGS[m].buffer == buffer && buffer != NULL) {
+      return MAPPINGS[m].ptr;
+    }
+  }
+  return NULL;
+}
+
+static void set_mapping(void *buffer, void *ptr) {
+  for (uint32_t m = 0u; m < MAX_MAPPINGS; ++m) {
+    if (ptr == NULL ? MAPPINGS[m].buffer == buffer
+                    : MAPPINGS[m].buffer == NULL) {
+      MAPPINGS[m].buffer = ptr == NULL ? NULL : buffer;
+      MAPPINGS[m].ptr = (uint8_t*)ptr;
+      return;
+    }
+  }
+}
+
+#pragma endregion
+
+#pragma region buffer_replay
+
+static void replay_buffer_op(_ngf_trace_op op, reader *r) {
+  const _ngf_trace_buffer_kind kind = (_ngf_trace_buffer_kind)get_u32(r);
+  if (op == _NGF_TRACE_CREATE_BUFFER) {
+    const uint64_t key = get_u64(r);
+    void *result = NULL;
+    ngf_error err = NGF_ERROR_OK;
+    if (kind == _NGF_TRACE_PIXEL_BUFFER) {
+      ngf_pixel_buffer_info info;
+      GET(r, info);
+      err = ngf_create_pixel_buffer(&info, (ngf_pixel_buffer*)&result);
+    } else {
+      ngf_buffer_info info;
+      GET(r, info);
+      switch (kind) {
+      case _NGF_TRACE_ATTRIB_BUFFER:
+        err = ngf_create_attrib_buffer(&info, (ngf_attrib_buffer*)&result);
+        break;
+      case _NGF_TRACE_INDEX_BUFFER:
+        err = ngf_create_index_buffer(&info, (ngf_index_buffer*)&result);
+        break;
+      default:
+        err = ngf_create_uniform_buffer(&info, (ngf_uniform_buffer*)&result);
+        break;
+      }
+    }
+    check(err, "buffer creation");
+    map_set(&OBJECTS, key, result);
+    return;
+  }
+  void *buf = get_handle(r);
+  if (buf == NULL) {
+    return;
+  }
+  switch (op) {
+  case _NGF_TRACE_DESTROY_BUFFER:
+    switch (kind) {
+    case _NGF_TRACE_ATTRIB_BUFFER:
+      ngf_destroy_attrib_buffer((ngf_attrib_buffer)buf); break;
+    case _NGF_TRACE_INDEX_BUFFER:
+      ngf_destroy_index_buffer((ngf_index_buffer)buf); break;
+    case _NGF_TRACE_UNIFORM_BUFFER:
+      ngf_destroy_uniform_buffer((ngf_uniform_buffer)buf); break;
+    case _NGF_TRACE_PIXEL_BUFFER:
+      ngf_destroy_pixel_buffer((ngf_pixel_buffer)buf); break;
+    }
+    break;
+  case _NGF_TRACE_MAP_BUFFER: {
+    const size_t offset = (size_t)get_u64(r), size = (size_t)get_u64(r);
+    const uint32_t flags = get_u32(r);
+    void *ptr = NULL;
+    switch (kind) {
+    case _NGF_TRACE_ATTRIB_BUFFER:
+      ptr = ngf_attrib_buffer_map_range((ngf_attrib_buffer)buf, offset, size,
+                                        flags);
+      break;
+    case _NGF_TRACE_INDEX_BUFFER:
+      ptr = ngf_index_buffer_map_range((ngf_index_buffer)buf, offset, size,
+                                       flags);
+      break;
+    case _NGF_TRACE_UNIFORM_BUFFER:
+      ptr = ngf_uniform_buffer_map_range((ngf_uniform_buffer)buf, offset,
+                                         size, flags);
+      break;
+    case _NGF_TRACE_PIXEL_BUFFER:
+      ptr = ngf_pixel_buffer_map_range((ngf_pixel_buffer)buf, offset, size,
+                                       flags);
+      break;
+    }
+    if (ptr == NULL) {
+      check(NGF_ERROR_OUTOFMEM, "buffer mapping");
+    } else {
+      set_mapping(buf, ptr);
+    }
+    break;
+  }
+  case _NGF_TRACE_FLUSH_BUFFER: {
+    const size_t offset = (size_t)get_u64(r), size = (size_t)get_u64(r);
+    size_t data_size;
+    const void *data = get_blob(r, &data_size);
+    uint8_t *ptr = find_mapping(buf);
+    if (ptr != NULL && data != NULL && data_size == size) {
+      memcpy(ptr + offset, data, size);
+    }
+    switch (kind) {
+    case _NGF_TRACE_ATTRIB_BUFFER:
+      ngf_attrib_buffer_flush_range((ngf_attrib_buffer)buf, offset, size);
+      break;
+    case _NGF_TRACE_INDEX_BUFFER:
+      ngf_index_buffer_flush_range((ngf_index_buffer)buf, offset, size);
+      break;
+    case _NGF_TRACE_UNIFORM_BUFFER:
+      ngf_uniform_buffer_flush_range((ngf_uniform_buffer)buf, offset, size);
+      break;
+    case _NGF_TRACE_PIXEL_BUFFER:
+      ngf_pixel_buffer_flush_range((ngf_pixel_buffer)buf, offset, size);
+      break;
+    }
+    break;
+  }
+  case _NGF_TRACE_UNMAP_BUFFER:
+    set_mapping(buf, NULL);
+    switch (kind) {
+    case _NGF_TRACE_ATTRIB_BUFFER:
+      ngf_attrib_buffer_unmap((ngf_attrib_buffer)buf); break;
+    case _NGF_TRACE_INDEX_BUFFER:
+      ngf_index_buffer_unmap((ngf_index_buffer)buf); break;
+    case _NGF_TRACE_UNIFORM_BUFFER:
+      ngf_uniform_buffer_unmap((ngf_uniform_buffer)buf); break;
+    case _NGF_TRACE_PIXEL_BUFFER:
+      ngf_pixel_buffer_unmap((ngf_pixel_buffer)buf); break;
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+#pragma endregion
+
+#pragma region replay
+
+static double now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec * 1e-6;
+}
+
+static void replay_record(_ngf_trace_op op, reader *r) {
+  switch (op) {
+  case _NGF_TRACE_INITIALIZE:
+    check(ngf_initialize((ngf_device_preference)get_u32(r)), "ngf_initialize");
+    break;
+  case _NGF_TRACE_CREATE_CONTEXT: {
+    const uint64_t key = get_u64(r);
+    const ngf_swapchain_info *swapchain_info = (const ngf_swapchain_info*)
+        get_optional(r, sizeof(ngf_swapchain_info));
+    const ngf_context_info info = {
+      .swapchain_info = NULL,
+      .shared_context = (ngf_context)get_handle(r),
+      .debug = get_u32(r) != 0u && !TIMING_ONLY
+    };
+    ngf_context ctx = NULL;
+    check(ngf_create_context(&info, &ctx), "ngf_create_context");
+    map_set(&OBJECTS, key, ctx);
+    for (uint32_t c = 0u; c < MAX_CONTEXTS && ctx != NULL; ++c) {
+      if (CONTEXTS[c].ctx == NULL) {
+        CONTEXTS[c].ctx = ctx;
+        CONTEXTS[c].has_swapchain = swapchain_info != NULL;
+        if (swapchain_info != NULL) {
+          CONTEXTS[c].swapchain_info = *swapchain_info;
+        }
+        break;
+      }
+    }
+    break;
+  }
+  case _NGF_TRACE_DESTROY_CONTEXT: {
+    ngf_context ctx = (ngf_context)get_handle(r);
+    for (uint32_t c = 0u; c < MAX_CONTEXTS && ctx != NULL; ++c) {
+      if (CONTEXTS[c].ctx == ctx) {
+        CONTEXTS[c].ctx = NULL;
+      }
+    }
+    if (CURRENT_CONTEXT == ctx) {
+      CURRENT_CONTEXT = NULL;
+    }
+    ngf_destroy_context(ctx);
+    break;
+  }
+  case _NGF_TRACE_RESIZE_CONTEXT: {
+    ngf_context ctx = (ngf_context)get_handle(r);
+    const uint32_t width = get_u32(r), height = get_u32(r);
+    for (uint32_t c = 0u; c < MAX_CONTEXTS && ctx != NULL; ++c) {
+      if (CONTEXTS[c].ctx == ctx) {
+        CONTEXTS[c].swapchain_info.width = width;
+        CONTEXTS[c].swapchain_info.height = height;
+      }
+    }
+    break;
+  }
+  case _NGF_TRACE_SET_CONTEXT: {
+    ngf_context ctx = (ngf_context)get_handle(r);
+    if (ctx != NULL && ctx != CURRENT_CONTEXT) {
+      check(ngf_set_context(ctx), "ngf_set_context");
+      CURRENT_CONTEXT = ctx;
+    }
+    break;
+  }
+  case _NGF_TRACE_FINISH:
+    ngf_finish();
+    break;
+  case _NGF_TRACE_CREATE_SHADER_STAGE: {
+    const uint64_t key = get_u64(r);
+    ngf_shader_stage_info info;
+    size_t content_length;
+    info.type = (ngf_stage_type)get_u32(r);
+    info.content = get_blob(r, &content_length);
+    info.content_length = (uint32_t)content_length;
+    info.debug_name = get_string(r);
+    info.is_binary = get_u32(r) != 0u;
+    info.entry_point_name = get_string(r);
+    info.binary_format = get_u32(r);
+    ngf_shader_stage stage = NULL;
+    check(ngf_create_shader_stage(&info, &stage), "ngf_create_shader_stage");
+    map_set(&OBJECTS, key, stage);
+    break;
+  }
+  case _NGF_TRACE_DESTROY_SHADER_STAGE:
+    ngf_destroy_shader_stage((ngf_shader_stage)get_handle(r));
+    break;
+  case _NGF_TRACE_CREATE_GRAPHICS_PIPELINE: {
+    const uint64_t key = get_u64(r);
+    ngf_graphics_pipeline_info info;
+    memset(&info, 0, sizeof(info));
+    info.nshader_stages = get_u32(r);
+    for (uint32_t s = 0u; s < info.nshader_stages; ++s) {
+      ngf_shader_stage stage = (ngf_shader_stage)get_handle(r);
+      if (s < sizeof(info.shader_stages) / sizeof(info.shader_stages[0])) {
+        info.shader_stages[s] = stage;
+      }
+    }
+    info.viewport = (const ngf_irect2d*)get_optional(r, sizeof(ngf_irect2d));
+    info.scissor = (const ngf_irect2d*)get_optional(r, sizeof(ngf_irect2d));
+    info.rasterization = (const ngf_rasterization_info*)
+        get_optional(r, sizeof(ngf_rasterization_info));
+    info.multisample = (const ngf_multisample_info*)
+        get_optional(r, sizeof(ngf_multisample_info));
+    info.depth_stencil = (const ngf_depth_stencil_info*)
+        get_optional(r, sizeof(ngf_depth_stencil_info));
+    info.blend = (const ngf_blend_info*)
+        get_optional(r, sizeof(ngf_blend_info));
+    info.dynamic_state_mask = get_u32(r);
+    ngf_vertex_input_info input;
+    input.nvert_buf_bindings = get_u32(r);
+    input.vert_buf_bindings = (const ngf_vertex_buf_binding_desc*)
+        get_array(r, sizeof(ngf_vertex_buf_binding_desc) *
+                     input.nvert_buf_bindings);
+    input.nattribs = get_u32(r);
+    input.attribs = (const ngf_vertex_attrib_desc*)
+        get_array(r, sizeof(ngf_vertex_attrib_desc) * input.nattribs);
+    info.input_info = &input;
+    info.primitive_type = (ngf_primitive_type)get_u32(r);
+    info.layout = get_layout(r);
+    info.spec_info = get_spec_info(r);
+    info.compatible_render_target = (ngf_render_target)get_handle(r);
+    info.image_to_combined_map = get_cis_map(r);
+    info.sampler_to_combined_map = get_cis_map(r);
+    if (r->overrun) {
+      break;
+    }
+    ngf_graphics_pipeline pipeline = NULL;
+    check(ngf_create_graphics_pipeline(&info, &pipeline),
+          "ngf_create_graphics_pipeline");
+    map_set(&OBJECTS, key, pipeline);
+    break;
+  }
+  case _NGF_TRACE_DESTROY_GRAPHICS_PIPELINE:
+    ngf_destroy_graphics_pipeline((ngf_graphics_pipeline)get_handle(r));
+    break;
+  case _NGF_TRACE_CREATE_COMPUTE_PIPELINE: {
+    const uint64_t key = get_u64(r);
+    ngf_compute_pipeline_info info;
+    info.shader_stage = (ngf_shader_stage)get_handle(r);
+    info.layout = get_layout(r);
+    info.spec_info = get_spec_info(r);
+    get(r, info.workgroup_size, sizeof(info.workgroup_size));
+    if (r->overrun) {
+      break;
+    }
+    ngf_compute_pipeline pipeline = NULL;
+    check(ngf_create_compute_pipeline(&info, &pipeline),
+          "ngf_create_compute_pipeline");
+    map_set(&OBJECTS, key, pipeline);
+    break;
+  }
+  case _NGF_TRACE_DESTROY_COMPUTE_PIPELINE:
+    ngf_destroy_compute_pipeline((ngf_compute_pipeline)get_handle(r));
+    break;
+  case _NGF_TRACE_CREATE_IMAGE: {
+    const uint64_t key = get_u64(r);
+    ngf_image_info info;
+    GET(r, info);
+    ngf_image image = NULL;
+    check(ngf_create_image(&info, &image), "ngf_create_image");
+    map_set(&OBJECTS, key, image);
+    break;
+  }
+  case _NGF_TRACE_DESTROY_IMAGE:
+    ngf_destroy_image((ngf_image)get_handle(r));
+    break;
+  case _NGF_TRACE_CREATE_SAMPLER: {
+    const uint64_t key = get_u64(r);
+    ngf_sampler_info info;
+    GET(r, info);
+    ngf_sampler sampler = NULL;
+    check(ngf_create_sampler(&info, &sampler), "ngf_create_sampler");
+    map_set(&OBJECTS, key, sampler);
+    break;
+  }
+  case _NGF_TRACE_DESTROY_SAMPLER:
+    ngf_destroy_sampler((ngf_sampler)get_handle(r));
+    break;
+  case _NGF_TRACE_DEFAULT_RENDER_TARGET: {
+    const uint64_t key = get_u64(r);
+    const ngf_attachment_load_op color_load_op =
+        (ngf_attachment_load_op)get_u32(r);
+    const ngf_attachment_load_op depth_load_op =
+        (ngf_attachment_load_op)get_u32(r);
+    const ngf_attachment_store_op color_store_op =
+        (ngf_attachment_store_op)get_u32(r);
+    const ngf_attachment_store_op depth_store_op =
+        (ngf_attachment_store_op)get_u32(r);
+    const ngf_clear *clear_color =
+        (const ngf_clear*)get_optional(r, sizeof(ngf_clear));
+    const ngf_clear *clear_depth =
+        (const ngf_clear*)get_optional(r, sizeof(ngf_clear));
+    ngf_render_target rt = NULL;
+    check(replace_default_rt(color_load_op, depth_load_op, color_store_op,
+                             depth_store_op, clear_color, clear_depth, &rt),
+          "ngf_default_render_target");
+    map_set(&OBJECTS, key, rt);
+    break;
+  }
+  case _NGF_TRACE_CREATE_RENDER_TARGET: {
+    const uint64_t key = get_u64(r);
+    ngf_render_target_info info;
+    info.nattachments = get_u32(r);
+    ngf_attachment *attachments = (ngf_attachment*)
+        scratch_alloc(sizeof(ngf_attachment) * info.nattachments);
+    for (uint32_t a = 0u; a < info.nattachments && attachments != NULL;
+         ++a) {
+      attachments[a].image_ref = get_image_ref(r);
+      attachments[a].type = (ngf_attachment_type)get_u32(r);
+      attachments[a].load_op = (ngf_attachment_load_op)get_u32(r);
+      attachments[a].store_op = (ngf_attachment_store_op)get_u32(r);
+      GET(r, attachments[a].clear);
+    }
+    info.attachments = attachments;
+    ngf_render_target rt = NULL;
+    check(ngf_create_render_target(&info, &rt), "ngf_create_render_target");
+    map_set(&OBJECTS, key, rt);
+    break;
+  }
+  case _NGF_TRACE_RESOLVE_RENDER_TARGET: {
+    ngf_render_target src = (ngf_render_target)get_handle(r);
+    ngf_render_target dst = (ngf_render_target)get_handle(r);
+    const ngf_irect2d *rect =
+        (const ngf_irect2d*)get_optional(r, sizeof(ngf_irect2d));
+    check(ngf_resolve_render_target(src, dst, rect),
+          "ngf_resolve_render_target");
+    break;
+  }
+  case _NGF_TRACE_DESTROY_RENDER_TARGET:
+    destroy_rt((ngf_render_target)get_handle(r));
+    break;
+  case _NGF_TRACE_CREATE_BUFFER:
+  case _NGF_TRACE_DESTROY_BUFFER:
+  case _NGF_TRACE_MAP_BUFFER:
+  case _NGF_TRACE_FLUSH_BUFFER:
+  case _NGF_TRACE_UNMAP_BUFFER:
+    replay_buffer_op(op, r);
+    break;
+  case _NGF_TRACE_CREATE_CMD_BUFFER: {
+    const uint64_t key = get_u64(r);
+    const ngf_cmd_buffer_info *info = (const ngf_cmd_buffer_info*)
+        get_optional(r, sizeof(ngf_cmd_buffer_info));
+    ngf_cmd_buffer buf = NULL;
+    check(ngf_create_cmd_buffer(info, &buf), "ngf_create_cmd_buffer");
+    map_set(&OBJECTS, key, buf);
+    break;
+  }
+  case _NGF_TRACE_DESTROY_CMD_BUFFER:
+    ngf_destroy_cmd_buffer((ngf_cmd_buffer)get_handle(r));
+    break;
+  case _NGF_TRACE_START_CMD_BUFFER:
+    check(ngf_start_cmd_buffer((ngf_cmd_buffer)get_handle(r)),
+          "ngf_start_cmd_buffer");
+    break;
+  case _NGF_TRACE_SUBMIT_CMD_BUFFERS: {
+    const uint32_t nbufs = get_u32(r);
+    ngf_cmd_buffer *bufs =
+        (ngf_cmd_buffer*)scratch_alloc(sizeof(ngf_cmd_buffer) * nbufs);
+    for (uint32_t b = 0u; b < nbufs && bufs != NULL; ++b) {
+      bufs[b] = (ngf_cmd_buffer)get_handle(r);
+    }
+    if (bufs != NULL && !r->overrun) {
+      check(ngf_submit_cmd_buffers(nbufs, bufs), "ngf_submit_cmd_buffers");
+    }
+    break;
+  }
+  case _NGF_TRACE_START_RENDER:
+  case _NGF_TRACE_START_XFER:
+  case _NGF_TRACE_START_COMPUTE: {
+    ngf_cmd_buffer buf = (ngf_cmd_buffer)get_handle(r);
+    const uint64_t key = get_u64(r);
+    uintptr_t handle = 0u;
+    ngf_error err;
+    if (op == _NGF_TRACE_START_RENDER) {
+      ngf_render_encoder enc;
+      err = ngf_cmd_buffer_start_render(buf, &enc);
+      handle = enc.__handle;
+    } else if (op == _NGF_TRACE_START_XFER) {
+      ngf_xfer_encoder enc;
+      err = ngf_cmd_buffer_start_xfer(buf, &enc);
+      handle = enc.__handle;
+    } else {
+      ngf_compute_encoder enc;
+      err = ngf_cmd_buffer_start_compute(buf, &enc);
+      handle = enc.__handle;
+    }
+    check(err, "encoder start");
+    map_set(&ENCODERS, key, (void*)handle);
+    break;
+  }
+  case _NGF_TRACE_RENDER_ENCODER_END: {
+    const ngf_render_encoder enc = {get_encoder(r)};
+    check(ngf_render_encoder_end(enc), "ngf_render_encoder_end");
+    break;
+  }
+  case _NGF_TRACE_XFER_ENCODER_END: {
+    const ngf_xfer_encoder enc = {get_encoder(r)};
+    check(ngf_xfer_encoder_end(enc), "ngf_xfer_encoder_end");
+    break;
+  }
+  case _NGF_TRACE_COMPUTE_ENCODER_END: {
+    const ngf_compute_encoder enc = {get_encoder(r)};
+    check(ngf_compute_encoder_end(enc), "ngf_compute_encoder_end");
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+// Replays a command recorded into an encoder. Returns false if the op isn't
+// an encoder command.
+static bool replay_cmd(_ngf_trace_op op, reader *r) {
+  const uintptr_t handle = get_encoder(r);
+  const ngf_render_encoder renc = {handle};
+  const ngf_xfer_encoder xenc = {handle};
+  const ngf_compute_encoder cenc = {handle};
+  if (handle == 0u) {
+    return true;
+  }
+  switch (op) {
+  case _NGF_TRACE_BIND_GFX_PIPELINE:
+    ngf_cmd_bind_gfx_pipeline(renc, (ngf_graphics_pipeline)get_handle(r));
+    break;
+  case _NGF_TRACE_VIEWPORT:
+  case _NGF_TRACE_SCISSOR: {
+    ngf_irect2d rect;
+    GET(r, rect);
+    if (op == _NGF_TRACE_VIEWPORT) {
+      ngf_cmd_viewport(renc, &rect);
+    } else {
+      ngf_cmd_scissor(renc, &rect);
+    }
+    break;
+  }
+  case _NGF_TRACE_STENCIL_REFERENCE: {
+    const uint32_t front = get_u32(r), back = get_u32(r);
+    ngf_cmd_stencil_reference(renc, front, back);
+    break;
+  }
+  case _NGF_TRACE_STENCIL_COMPARE_MASK: {
+    const uint32_t front = get_u32(r), back = get_u32(r);
+    ngf_cmd_stencil_compare_mask(renc, front, back);
+    break;
+  }
+  case _NGF_TRACE_STENCIL_WRITE_MASK: {
+    const uint32_t front = get_u32(r), back = get_u32(r);
+    ngf_cmd_stencil_write_mask(renc, front, back);
+    break;
+  }
+  case _NGF_TRACE_LINE_WIDTH: {
+    float width;
+    GET(r, width);
+    ngf_cmd_line_width(renc, width);
+    break;
+  }
+  case _NGF_TRACE_BLEND_FACTORS: {
+    const ngf_blend_factor sfactor = (ngf_blend_factor)get_u32(r);
+    const ngf_blend_factor dfactor = (ngf_blend_factor)get_u32(r);
+    ngf_cmd_blend_factors(renc, sfactor, dfactor);
+    break;
+  }
+  case _NGF_TRACE_BIND_GFX_RESOURCES:
+  case _NGF_TRACE_BIND_COMPUTE_RESOURCES: {
+    uint32_t nops;
+    const ngf_resource_bind_op *ops = get_bind_ops(r, &nops);
+    if (ops == NULL || r->overrun) {
+      break;
+    }
+    if (op == _NGF_TRACE_BIND_GFX_RESOURCES) {
+      ngf_cmd_bind_gfx_resources(renc, ops, nops);
+    } else {
+      ngf_cmd_bind_compute_resources(cenc, ops, nops);
+    }
+    break;
+  }
+  case _NGF_TRACE_SET_DYNAMIC_OFFSETS: {
+    const uint32_t set = get_u32(r), noffsets = get_u32(r);
+    const uint32_t *offsets =
+        (const uint32_t*)get_array(r, sizeof(uint32_t) * noffsets);
+    if (!r->overrun) {
+      ngf_cmd_set_dynamic_offsets(renc, set, offsets, noffsets);
+    }
+    break;
+  }
+  case _NGF_TRACE_BIND_ATTRIB_BUFFER: {
+    ngf_attrib_buffer buf = (ngf_attrib_buffer)get_handle(r);
+    const uint32_t binding = get_u32(r), offset = get_u32(r);
+    ngf_cmd_bind_attrib_buffer(renc, buf, binding, offset);
+    break;
+  }
+  case _NGF_TRACE_BIND_INDEX_BUFFER: {
+    ngf_index_buffer buf = (ngf_index_buffer)get_handle(r);
+    ngf_cmd_bind_index_buffer(renc, buf, (ngf_type)get_u32(r));
+    break;
+  }
+  case _NGF_TRACE_BEGIN_PASS:
+    ngf_cmd_begin_pass(renc, (ngf_render_target)get_handle(r));
+    break;
+  case _NGF_TRACE_END_PASS:
+    ngf_cmd_end_pass(renc);
+    break;
+  case _NGF_TRACE_DRAW: {
+    const bool indexed = get_u32(r) != 0u;
+    const uint32_t first = get_u32(r), nelements = get_u32(r),
+                   ninstances = get_u32(r);
+    ngf_cmd_draw(renc, indexed, first, nelements, ninstances);
+    break;
+  }
+  case _NGF_TRACE_PUSH_CONSTANTS:
+  case _NGF_TRACE_PUSH_COMPUTE_CONSTANTS: {
+    const uint32_t offset = get_u32(r);
+    size_t size;
+    const void *data = get_blob(r, &size);
+    if (data == NULL || r->overrun) {
+      break;
+    }
+    if (op == _NGF_TRACE_PUSH_CONSTANTS) {
+      ngf_cmd_push_constants(renc, data, offset, (uint32_t)size);
+    } else {
+      ngf_cmd_push_compute_constants(cenc, data, offset, (uint32_t)size);
+    }
+    break;
+  }
+  case _NGF_TRACE_DRAW_INDIRECT: {
+    const bool indexed = get_u32(r) != 0u;
+    ngf_attrib_buffer args = (ngf_attrib_buffer)get_handle(r);
+    const size_t offset = (size_t)get_u64(r);
+    const uint32_t ndraws = get_u32(r), stride = get_u32(r);
+    ngf_cmd_draw_indirect(renc, indexed, args, offset, ndraws, stride);
+    break;
+  }
+  case _NGF_TRACE_BIND_COMPUTE_PIPELINE:
+    ngf_cmd_bind_compute_pipeline(cenc, (ngf_compute_pipeline)get_handle(r));
+    break;
+  case _NGF_TRACE_DISPATCH: {
+    const uint32_t x = get_u32(r), y = get_u32(r), z = get_u32(r);
+    ngf_cmd_dispatch(cenc, x, y, z);
+    break;
+  }
+  case _NGF_TRACE_DISPATCH_INDIRECT: {
+    ngf_attrib_buffer args = (ngf_attrib_buffer)get_handle(r);
+    ngf_cmd_dispatch_indirect(cenc, args, (size_t)get_u64(r));
+    break;
+  }
+  case _NGF_TRACE_WRITE_IMAGE: {
+    ngf_pixel_buffer src = (ngf_pixel_buffer)get_handle(r);
+    const size_t src_offset = (size_t)get_u64(r);
+    const ngf_image_ref dst = get_image_ref(r);
+    ngf_offset3d offset;
+    ngf_extent3d extent;
+    GET(r, offset);
+    GET(r, extent);
+    ngf_cmd_write_image(xenc, src, src_offset, dst, &offset, &extent);
+    break;
+  }
+  case _NGF_TRACE_BEGIN_DEBUG_GROUP:
+    ngf_cmd_begin_debug_group(renc, intern_name(get_string(r)));
+    break;
+  case _NGF_TRACE_END_DEBUG_GROUP:
+    ngf_cmd_end_debug_group(renc);
+    break;
+  case _NGF_TRACE_BEGIN_COMPUTE_DEBUG_GROUP:
+    ngf_cmd_begin_compute_debug_group(cenc, intern_name(get_string(r)));
+    break;
+  case _NGF_TRACE_END_COMPUTE_DEBUG_GROUP:
+    ngf_cmd_end_compute_debug_group(cenc);
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+// Copy commands start with the buffer kind, ahead of the encoder.
+static void replay_copy(reader *r) {
+  const _ngf_trace_buffer_kind kind = (_ngf_trace_buffer_kind)get_u32(r);
+  const ngf_xfer_encoder enc = {get_encoder(r)};
+  void *src = get_handle(r), *dst = get_handle(r);
+  const size_t size = (size_t)get_u64(r), src_offset = (size_t)get_u64(r),
+               dst_offset = (size_t)get_u64(r);
+  if (enc.__handle == 0u) {
+    return;
+  }
+  switch (kind) {
+  case _NGF_TRACE_ATTRIB_BUFFER:
+    ngf_cmd_copy_attrib_buffer(enc, (ngf_attrib_buffer)src,
+                               (ngf_attrib_buffer)dst, size, src_offset,
+                               dst_offset);
+    break;
+  case _NGF_TRACE_INDEX_BUFFER:
+    ngf_cmd_copy_index_buffer(enc, (ngf_index_buffer)src,
+                              (ngf_index_buffer)dst, size, src_offset,
+                              dst_offset);
+    break;
+  case _NGF_TRACE_UNIFORM_BUFFER:
+    ngf_cmd_copy_uniform_buffer(enc, (ngf_uniform_buffer)src,
+                                (ngf_uniform_buffer)dst, size, src_offset,
+                                dst_offset);
+    break;
+  default:
+    break;
+  }
+}
+
+static uint64_t gpu_frame_time_ns() {
+  ngf_gpu_frame_timings timings;
+  if (ngf_get_gpu_frame_timings(&timings) != NGF_ERROR_OK) {
+    return 0u;
+  }
+  uint64_t total = 0u;
+  for (uint32_t s = 0u; s < timings.nscopes; ++s) {
+    if (timings.scopes[s].depth == 0u) {
+      total += timings.scopes[s].duration_ns;
+    }
+  }
+  return total;
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  uint64_t max_frames = UINT64_MAX;
+  for (int a = 1; a < argc; ++a) {
+    if (strcmp(argv[a], "--timing") == 0) {
+      TIMING_ONLY = true;
+    } else if (strcmp(argv[a], "--frames") == 0 && a + 1 < argc) {
+      max_frames = strtoull(argv[++a], NULL, 10);
+    } else {
+      path = argv[a];
+    }
+  }
+  if (path == NULL) {
+    fprintf(stderr, "usage: %s [--timing] [--frames N] trace_file\n",
+            argv[0]);
+    return 1;
+  }
+  FILE *trace = fopen(path, "rb");
+  if (trace == NULL) {
+    fprintf(stderr, "ngf_replay: can't open %s\n", path);
+    return 1;
+  }
+  _ngf_trace_header header;
+  if (fread(&header, sizeof(header), 1u, trace) != 1u ||
+      header.magic != _NGF_TRACE_MAGIC ||
+      header.version != _NGF_TRACE_VERSION ||
+      header.pointer_size != sizeof(void*)) {
+    fprintf(stderr, "ngf_replay: %s is not a compatible trace\n", path);
+    fclose(trace);
+    return 1;
+  }
+  ngf_debug_message_callback(NULL, report);
+
+  uint8_t *payload = NULL;
+  size_t payload_capacity = 0u;
+  uint64_t nrecords = 0u, nframes = 0u;
+  double frame_start_ms = now_ms(), total_ms = 0.0;
+  bool gpu_timing = false;
+  _ngf_trace_record_header record;
+  while (nframes < max_frames &&
+         fread(&record, sizeof(record), 1u, trace) == 1u) {
+    if (record.payload_size > payload_capacity) {
+      payload_capacity = record.payload_size;
+      payload = (uint8_t*)realloc(payload, payload_capacity);
+    }
+    if (fread(payload, 1u, record.payload_size, trace) !=
+        record.payload_size) {
+      fprintf(stderr, "ngf_replay: truncated record %llu\n",
+              (unsigned long long)nrecords);
+      break;
+    }
+    const size_t scratch_needed = (size_t)record.payload_size * 8u + 4096u;
+    if (scratch_needed > SCRATCH_CAPACITY) {
+      free(SCRATCH);
+      SCRATCH_CAPACITY = scratch_needed;
+      SCRATCH = (uint8_t*)malloc(SCRATCH_CAPACITY);
+    }
+    SCRATCH_USED = 0u;
+    reader r = {payload, payload + record.payload_size, false};
+    const _ngf_trace_op op = (_ngf_trace_op)record.op;
+
+    if (op == _NGF_TRACE_BEGIN_FRAME) {
+      if (TIMING_ONLY && !gpu_timing && CURRENT_CONTEXT != NULL) {
+        gpu_timing = ngf_enable_gpu_timing(true) == NGF_ERROR_OK;
+      }
+      frame_start_ms = now_ms();
+      check(ngf_begin_frame(), "ngf_begin_frame");
+    } else if (op == _NGF_TRACE_END_FRAME) {
+      check(ngf_end_frame(), "ngf_end_frame");
+      const double frame_ms = now_ms() - frame_start_ms;
+      total_ms += frame_ms;
+      if (TIMING_ONLY) {
+        printf("frame %llu: cpu %.3f ms, gpu %.3f ms\n",
+               (unsigned long long)nframes, frame_ms,
+               gpu_timing ? (double)gpu_frame_time_ns() * 1e-6 : 0.0);
+      }
+      ++nframes;
+    } else if (op == _NGF_TRACE_COPY_BUFFER) {
+      replay_copy(&r);
+    } else if (!(op >= _NGF_TRACE_BIND_GFX_PIPELINE &&
+                 op < _NGF_TRACE_OP_COUNT && replay_cmd(op, &r))) {
+      replay_record(op, &r);
+    }
+    if (r.overrun) {
+      fprintf(stderr, "ngf_replay: malformed record %llu (op %u)\n",
+              (unsigned long long)nrecords, record.op);
+    }
+    ++nrecords;
+  }
+  printf("replayed %llu records, %llu frames, %.3f ms/frame\n",
+         (unsigned long long)nrecords, (unsigned long long)nframes,
+         nframes > 0u ? total_ms / (double)nframes : 0.0);
+  free(payload);
+  free(SCRATCH);
+  fclose(trace);
+  return 0;
+}
+
+#pragma endregion